@@ -29,9 +29,7 @@ layout(set = 1, binding = 2) uniform EmissiveUniformBufferObject {
     vec3 emissiveColor;  // Emissive color of the object
 } eubo;
 
-layout(set = 1, binding = 3) uniform sampler2D normalMap;        // Normal map
-
-layout(set = 1, binding = 4) uniform sampler2D roughnessMap;     // Roughness map
+layout(set = 1, binding = 3) uniform sampler2D normalMap;        // Normal map, roughness in alpha
 
 
 // Direct light
@@ -112,10 +110,11 @@ void main() {
     vec4 texColor = texture(texSampler, fragUV);
     vec3 Albedo = texColor.rgb;
     float alpha = texColor.a;
-    float Roughness = texture(roughnessMap, fragUV).r;
 
-    // Sample the normal map
-    vec3 normalMapSample = texture(normalMap, fragUV).rgb;
+    // Sample the normal map, that carries the roughness too
+    vec4 normalRoughness = texture(normalMap, fragUV);
+    float Roughness = normalRoughness.a;
+    vec3 normalMapSample = normalRoughness.rgb;
 
 	vec3 N = normalize(fragNorm);
 	vec3 Tan = normalize(fragTan.xyz - N * dot(fragTan.xyz, N));
@@ -0,0 +1,10 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Fragment counter of the overdraw view: the pipeline adds this white, scaled by its blend constant,
+// to the counter target, so every fragment adds one to red and the lights it evaluates to green
+layout(location = 0) out vec4 outColor;
+
+void main() {
+	outColor = vec4(1.0f);
+}
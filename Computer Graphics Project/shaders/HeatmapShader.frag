@@ -0,0 +1,16 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec2 fragUV;
+layout(location = 1) in vec4 fragColor;		// weight of every counter, already divided by the count shown as white
+
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform sampler2D counters;
+
+void main() {
+	float t = dot(texture(counters, fragUV), fragColor);
+
+	// black, red, yellow, white
+	outColor = vec4(clamp(vec3(t * 3.0f, t * 3.0f - 1.0f, t * 3.0f - 2.0f), 0.0f, 1.0f), 1.0f);
+}
@@ -9,17 +9,24 @@ layout(set = 1, binding = 0) uniform UniformBufferObject {
 
 layout(location = 0) in vec3 inPos;
 layout(location = 1) in vec2 inUV;
-layout(location = 2) in vec3 inNorm;
+layout(location = 2) in vec2 inNorm;     // octahedral (VertexPacked)
 
 layout(location = 0) out vec2 fragUV;
 layout(location = 1) out vec3 fragNorm;
 layout(location = 2) out vec3 fragPos;
 
+// Unit vector from its octahedral encoding
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    n.xy -= sign(n.xy) * max(-n.z, 0.0);
+    return normalize(n);
+}
+
 void main() {
     vec3 pos = inPos;
 
     fragUV = inUV;
-    fragNorm = mat3(ubo.nMat) * inNorm;  // Transforming normal with the normal matrix
+    fragNorm = mat3(ubo.nMat) * octDecode(inNorm);  // Transforming normal with the normal matrix
     fragPos = vec3(ubo.mMat * vec4(inPos, 1.0)); // Position in world space
 
     gl_Position = ubo.mvpMat * vec4(inPos, 1.0);
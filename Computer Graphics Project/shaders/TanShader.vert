@@ -8,8 +8,8 @@ layout(set = 1, binding = 0) uniform UniformBufferObject {
 } ubo;
 
 layout(location = 0) in vec3 inPos;
-layout(location = 1) in vec3 inNorm;
-layout(location = 2) in vec4 inTan;
+layout(location = 1) in vec2 inNorm;		// octahedral (VertexTanPacked)
+layout(location = 2) in vec4 inTan;		// octahedral in xy, handedness in w
 layout(location = 3) in vec2 inUV;
 
 layout(location = 0) out vec3 fragPos;
@@ -17,10 +17,17 @@ layout(location = 1) out vec3 fragNorm;
 layout(location = 2) out vec4 fragTan;
 layout(location = 3) out vec2 fragUV;
 
+// Unit vector from its octahedral encoding
+vec3 octDecode(vec2 e) {
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	n.xy -= sign(n.xy) * max(-n.z, 0.0);
+	return normalize(n);
+}
+
 void main() {
 	gl_Position = ubo.mvpMat * vec4(inPos, 1.0);
 	fragPos = (ubo.mMat * vec4(inPos, 1.0)).xyz;
-	fragNorm = mat3(ubo.nMat) * inNorm;
-	fragTan = vec4(mat3(ubo.nMat) * inTan.xyz, inTan.w);
+	fragNorm = mat3(ubo.nMat) * octDecode(inNorm);
+	fragTan = vec4(mat3(ubo.nMat) * octDecode(inTan.xy), inTan.w);
 	fragUV = inUV;
 }
\ No newline at end of file
@@ -0,0 +1,18 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Signed distance field of the font: 0.5 is the edge of the glyphs
+layout(set = 0, binding = 0) uniform sampler2D sdf;
+
+layout(location = 0) in vec2 fragUV;
+layout(location = 1) in vec4 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+	float d = texture(sdf, fragUV).r;
+	// Antialias over about one pixel of the screen, whatever the size of the text
+	float w = max(fwidth(d), 0.001f);
+	float a = smoothstep(0.5f - w, 0.5f + w, d);
+	outColor = vec4(fragColor.rgb, fragColor.a * a);
+}
\ No newline at end of file
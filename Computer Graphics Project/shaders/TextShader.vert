@@ -0,0 +1,16 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Glyphs and panels of the text overlay, already in normalized device coordinates
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inUV;
+layout(location = 2) in vec4 inColor;
+
+layout(location = 0) out vec2 outUV;
+layout(location = 1) out vec4 outColor;
+
+void main() {
+	gl_Position = vec4(inPosition, 0.1f, 1.0f);
+	outUV = inUV;
+	outColor = inColor;
+}
\ No newline at end of file
@@ -29,9 +29,7 @@ layout(set = 1, binding = 2) uniform EmissiveUniformBufferObject {
     vec3 emissiveColor;  // Emissive color of the object
 } eubo;
 
-layout(set = 1, binding = 3) uniform sampler2D spet;
-
-layout(set = 1, binding = 4) uniform sampler2D norm;
+layout(set = 1, binding = 3) uniform sampler2D norm;		// Normal map, specular intensity in alpha
 
 // Direct light
 vec3 direct_light_dir(vec3 fragPos, int i) {
@@ -122,8 +120,9 @@ Parameters:
 }
 
 void main() {
-	// Sample the normal map
-    vec3 normalMapSample = texture(norm, fragUV).rgb;
+	// Sample the normal map, that carries the specular intensity too
+    vec4 normalSpecular = texture(norm, fragUV);
+    vec3 normalMapSample = normalSpecular.rgb;
 
 	vec3 Norm = normalize(fragNorm);
 	vec3 Tan = normalize(fragTan.xyz - Norm * dot(fragTan.xyz, Norm));
@@ -133,7 +132,9 @@ void main() {
 
     // Sample textures
 	vec3 albedo  = texture(tex,  fragUV).rgb;
-	vec3 specCol = texture(spet, fragUV).rgb;
+	// The specular map of the knight is grayscale, packed as one channel in the alpha of the normal map: a coloured
+	// one would need its own texture again (see TexturePack.hpp)
+	vec3 specCol = vec3(normalSpecular.a);
 
     // Metallic Factor
     float metallic = 1.0;
@@ -19,4 +19,10 @@ glslc TanShader.vert -o TanVert.spv
 glslc DRN.frag -o DRNFrag.spv
 
 glslc CatShader.frag -o CatFrag.spv
-glslc CatShader.vert -o CatVert.spv
\ No newline at end of file
+glslc CatShader.vert -o CatVert.spv
+
+glslc TextShader.frag -o TextFrag.spv
+glslc TextShader.vert -o TextVert.spv
+
+glslc HeatShader.frag -o HeatFrag.spv
+glslc HeatmapShader.frag -o HeatmapFrag.spv
\ No newline at end of file
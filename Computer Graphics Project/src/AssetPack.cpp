@@ -0,0 +1,254 @@
+#include "AssetPack.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <stdexcept>
+
+#include <sinfl.h>
+#include <sdefl.h>
+
+#include "JobSystem.hpp"
+#include "Logger.hpp"
+
+namespace {
+
+const char PACK_MAGIC[4] = { 'P', 'P', 'A', 'K' };
+
+// Deflated only if at least this fraction is saved: PNG and JPEG files would just be inflated for nothing
+const double MIN_SAVING = 0.1;
+
+uint64_t alignUp(uint64_t v, uint64_t alignment) {
+	return (v + alignment - 1) / alignment * alignment;
+}
+
+}
+
+std::string normalizePath(const std::string& path) {
+	std::vector<std::string> parts;
+	size_t start = 0;
+	while (start <= path.size()) {
+		size_t end = path.find_first_of("/\\", start);
+		if (end == std::string::npos) {
+			end = path.size();
+		}
+		std::string part = path.substr(start, end - start);
+		if (part == "..") {
+			if (!parts.empty() && parts.back() != "..") {
+				parts.pop_back();
+			} else {
+				parts.push_back(part);
+			}
+		} else if (!part.empty() && part != ".") {
+			parts.push_back(part);
+		}
+		start = end + 1;
+	}
+
+	std::string normalized;
+	for (const std::string& part : parts) {
+		if (!normalized.empty()) {
+			normalized += '/';
+		}
+		normalized += part;
+	}
+	return normalized;
+}
+
+void AssetPack::open(const std::string& path) {
+	close();
+	file.open(path);
+
+	const char* base = file.data();
+	size_t size = file.size();
+	Header header;
+	if (size < sizeof(Header)) {
+		throw std::runtime_error("failed to read asset pack header!");
+	}
+	memcpy(&header, base, sizeof(Header));
+	if (memcmp(header.magic, PACK_MAGIC, 4) != 0 || header.version != VERSION) {
+		throw std::runtime_error("failed to read asset pack header!");
+	}
+
+	uint64_t tocEnd = sizeof(Header) + static_cast<uint64_t>(header.entryCount) * sizeof(Entry);
+	if (tocEnd + header.stringsSize > size) {
+		throw std::runtime_error("failed to read asset pack table of contents!");
+	}
+	const Entry* toc = reinterpret_cast<const Entry*>(base + sizeof(Header));
+	for (uint32_t i = 0; i < header.entryCount; i++) {
+		const Entry& e = toc[i];
+		if (e.offset + e.storedSize > size || e.storedSize > e.size ||
+			static_cast<uint64_t>(e.pathOffset) + e.pathLength > header.stringsSize) {
+			throw std::runtime_error("failed to read asset pack table of contents!");
+		}
+	}
+
+	entries = toc;
+	strings = base + tocEnd;
+	count = header.entryCount;
+}
+
+void AssetPack::close() {
+	file.close();
+	entries = nullptr;
+	strings = nullptr;
+	count = 0;
+}
+
+int AssetPack::find(const std::string& path) const {
+	// Binary search of the sorted table of contents
+	int lo = 0, hi = static_cast<int>(count);
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		const Entry& e = entries[mid];
+		int c = path.compare(0, std::string::npos, strings + e.pathOffset, e.pathLength);
+		if (c == 0) {
+			return mid;
+		}
+		if (c < 0) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
+	return -1;
+}
+
+std::string AssetPack::path(int entry) const {
+	return std::string(strings + entries[entry].pathOffset, entries[entry].pathLength);
+}
+
+std::vector<char> AssetPack::read(int entry) const {
+	const Entry& e = entries[entry];
+	std::vector<char> data(static_cast<size_t>(e.size));
+	if (!compressed(entry)) {
+		memcpy(data.data(), storedData(entry), data.size());
+		return data;
+	}
+
+	int inflated = sinflate(data.data(), static_cast<int>(e.size), storedData(entry), static_cast<int>(e.storedSize));
+	if (inflated != static_cast<int>(e.size)) {
+		LOG_ERROR("Corrupted asset pack entry: %s", path(entry).c_str());
+		throw std::runtime_error("failed to inflate asset pack entry!");
+	}
+	return data;
+}
+
+void buildAssetPack(const std::string& path, const std::vector<AssetPackSource>& sources, JobSystem* jobs, std::ostream& out) {
+	// The files, sorted by their path in the pack
+	std::vector<std::string> files;
+	for (const AssetPackSource& source : sources) {
+		if (!std::filesystem::is_directory(source.dir)) {
+			LOG_WARN("Asset pack: no directory %s", source.dir.c_str());
+			continue;
+		}
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(source.dir)) {
+			std::string ext = entry.path().extension().string();
+			if (entry.is_regular_file() && (source.extensions.empty() ||
+				std::find(source.extensions.begin(), source.extensions.end(), ext) != source.extensions.end())) {
+				files.push_back(normalizePath(entry.path().generic_string()));
+			}
+		}
+	}
+	std::sort(files.begin(), files.end());
+	files.erase(std::unique(files.begin(), files.end()), files.end());
+
+	// Read and deflate every file; the stored bytes are either the deflated or the original ones.
+	// Errors are collected per file and reported once every job has finished
+	std::vector<std::vector<char>> stored(files.size());
+	std::vector<uint64_t> sizes(files.size());
+	std::vector<char> failed(files.size());
+	auto compress = [&](int begin, int end) {
+		std::unique_ptr<sdefl> deflater = std::make_unique<sdefl>();
+		for (int i = begin; i < end; i++) {
+			std::ifstream in(files[i], std::ios::binary | std::ios::ate);
+			if (!in) {
+				failed[i] = true;
+				continue;
+			}
+			std::vector<char> data(static_cast<size_t>(in.tellg()));
+			in.seekg(0);
+			in.read(data.data(), data.size());
+			sizes[i] = data.size();
+
+			std::vector<char> deflated(sdefl_bound(static_cast<int>(data.size())));
+			int n = data.empty() ? 0 :
+				sdeflate(deflater.get(), deflated.data(), data.data(), static_cast<int>(data.size()), SDEFL_LVL_MAX);
+			if (n > 0 && n < data.size() * (1.0 - MIN_SAVING)) {
+				deflated.resize(n);
+				stored[i] = std::move(deflated);
+			} else {
+				stored[i] = std::move(data);
+			}
+		}
+	};
+	if (jobs != nullptr) {
+		jobs->parallelFor("buildAssetPack", 0, static_cast<int>(files.size()), 1, compress);
+	} else {
+		compress(0, static_cast<int>(files.size()));
+	}
+
+	bool anyFailed = false;
+	for (size_t i = 0; i < files.size(); i++) {
+		if (failed[i]) {
+			LOG_ERROR("Failed to open: %s", files[i].c_str());
+			anyFailed = true;
+		}
+	}
+	if (anyFailed) {
+		throw std::runtime_error("failed to open file!");
+	}
+
+	// Table of contents and string table, then the data at aligned offsets
+	std::string strings;
+	std::vector<AssetPack::Entry> entries(files.size());
+	for (size_t i = 0; i < files.size(); i++) {
+		entries[i].pathOffset = static_cast<uint32_t>(strings.size());
+		entries[i].pathLength = static_cast<uint32_t>(files[i].size());
+		strings += files[i];
+	}
+	uint64_t offset = sizeof(AssetPack::Header) + entries.size() * sizeof(AssetPack::Entry) + strings.size();
+	for (size_t i = 0; i < files.size(); i++) {
+		offset = alignUp(offset, AssetPack::ALIGNMENT);
+		entries[i].offset = offset;
+		entries[i].storedSize = stored[i].size();
+		entries[i].size = sizes[i];
+		offset += stored[i].size();
+	}
+
+	AssetPack::Header header;
+	memcpy(header.magic, PACK_MAGIC, 4);
+	header.version = AssetPack::VERSION;
+	header.entryCount = static_cast<uint32_t>(entries.size());
+	header.stringsSize = static_cast<uint32_t>(strings.size());
+
+	std::ofstream pack(path, std::ios::binary);
+	if (!pack) {
+		throw std::runtime_error("failed to create asset pack!");
+	}
+	pack.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	pack.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AssetPack::Entry));
+	pack.write(strings.data(), strings.size());
+	uint64_t written = sizeof(header) + entries.size() * sizeof(AssetPack::Entry) + strings.size();
+	const char padding[AssetPack::ALIGNMENT] = {};
+	uint64_t totalSize = 0;
+	size_t compressedCount = 0;
+	for (size_t i = 0; i < files.size(); i++) {
+		pack.write(padding, entries[i].offset - written);
+		pack.write(stored[i].data(), stored[i].size());
+		written = entries[i].offset + stored[i].size();
+
+		totalSize += entries[i].size;
+		compressedCount += entries[i].storedSize != entries[i].size;
+	}
+	if (!pack) {
+		throw std::runtime_error("failed to write asset pack!");
+	}
+
+	out << "Asset pack " << path << ": " << files.size() << " files (" << compressedCount << " deflated), "
+		<< std::fixed << std::setprecision(1) << totalSize / (1024.0 * 1024.0) << " MB -> "
+		<< written / (1024.0 * 1024.0) << " MB\n";
+}
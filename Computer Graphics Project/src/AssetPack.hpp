@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+
+class JobSystem;
+
+// Asset pack: the files the game loads, in a single file that is memory mapped, so that startup opens one file
+// instead of about a hundred. Layout (little endian):
+//   header    magic "PPAK", version, number of entries, size of the string table
+//   entries   the table of contents, sorted by path
+//   strings   the paths, '/' separated and relative to the working directory
+//   data      the files, each starting at a multiple of ALIGNMENT, deflated when that saves enough space
+class AssetPack {
+public:
+	static const uint32_t VERSION = 1;
+	static const uint32_t ALIGNMENT = 64;		// stored files can be read in place, whatever their content
+
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		uint32_t entryCount;
+		uint32_t stringsSize;
+	};
+
+	struct Entry {
+		uint64_t offset;			// of the data, from the start of the pack
+		uint64_t storedSize;		// bytes in the pack: deflated if smaller than size
+		uint64_t size;				// bytes of the file
+		uint32_t pathOffset;		// in the string table
+		uint32_t pathLength;
+	};
+
+	// Map the pack and check its table of contents
+	void open(const std::string& path);
+	void close();
+	bool isOpen() const { return entries != nullptr; }
+
+	uint32_t entryCount() const { return count; }
+	// Index of the entry of path (as given by normalizePath), -1 if the pack does not have it
+	int find(const std::string& path) const;
+	std::string path(int entry) const;
+	const Entry& entry(int entry) const { return entries[entry]; }
+	bool compressed(int entry) const { return entries[entry].storedSize != entries[entry].size; }
+	// The bytes of the entry as stored: the file itself if not compressed
+	const char* storedData(int entry) const { return file.data() + entries[entry].offset; }
+
+	// Copy of the file in the entry, inflated if needed
+	std::vector<char> read(int entry) const;
+
+private:
+	MappedFile file;
+	const Entry* entries = nullptr;
+	const char* strings = nullptr;
+	uint32_t count = 0;
+};
+
+// Directory to pack, recursively, with the extensions of the files to take (empty = every file)
+struct AssetPackSource {
+	std::string dir;
+	std::vector<std::string> extensions;
+};
+
+// Write the files of the sources to a new pack at path, compressing them in parallel if jobs is given,
+// and print a summary to out
+void buildAssetPack(const std::string& path, const std::vector<AssetPackSource>& sources, JobSystem* jobs, std::ostream& out);
+
+// '/' separators, no "." and ".." components: the form the paths have in the pack
+std::string normalizePath(const std::string& path);
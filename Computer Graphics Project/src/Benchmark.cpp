@@ -0,0 +1,338 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+// Same setting of tiny_gltf in Starter.hpp, json.hpp must be compiled the same way everywhere
+#define JSON_NOEXCEPTION
+#include <json.hpp>
+
+#include "Starter.hpp"
+#include "Simulation.hpp"
+#include "Logger.hpp"
+
+namespace {
+
+// Every case is repeated until it has MAX_SAMPLES samples or has run for TIME_BUDGET_S (with at least MIN_SAMPLES)
+const int MIN_SAMPLES = 5;
+const int MAX_SAMPLES = 100;
+const double TIME_BUDGET_S = 0.5;
+
+struct BenchmarkRunner {
+	std::string filter;
+	std::ostream& out;
+	std::vector<BenchmarkResult> results;
+
+	BenchmarkRunner(const std::string& filter, std::ostream& out) : filter(filter), out(out) {}
+
+	bool selected(const std::string& name) const {
+		return filter.empty() || name.find(filter) != std::string::npos;
+	}
+
+	// Time body() called iterations times per sample
+	void run(const std::string& name, int iterations, const std::function<void()>& body) {
+		if (!selected(name)) {
+			return;
+		}
+		using clock = std::chrono::steady_clock;
+
+		body();		// warm up caches and allocators
+
+		std::vector<double> samples;
+		auto start = clock::now();
+		while (samples.size() < MAX_SAMPLES &&
+			(samples.size() < MIN_SAMPLES || std::chrono::duration<double>(clock::now() - start).count() < TIME_BUDGET_S)) {
+			auto t0 = clock::now();
+			for (int i = 0; i < iterations; i++) {
+				body();
+			}
+			samples.push_back(std::chrono::duration<double, std::micro>(clock::now() - t0).count() / iterations);
+		}
+
+		BenchmarkResult r;
+		r.name = name;
+		r.samples = static_cast<int>(samples.size());
+		r.iterationsPerSample = iterations;
+		double sum = 0.0;
+		for (double s : samples) sum += s;
+		r.mean = sum / samples.size();
+		double var = 0.0;
+		for (double s : samples) var += (s - r.mean) * (s - r.mean);
+		r.stddev = samples.size() > 1 ? std::sqrt(var / (samples.size() - 1)) : 0.0;
+		std::sort(samples.begin(), samples.end());
+		auto percentile = [&](double p) { return samples[std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()))]; };
+		r.min = samples.front();
+		r.p50 = percentile(0.50);
+		r.p90 = percentile(0.90);
+		r.p99 = percentile(0.99);
+		r.max = samples.back();
+
+		out << std::left << std::setw(60) << name << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(12) << r.mean << std::setw(10) << r.stddev << std::setw(12) << r.p50
+			<< std::setw(12) << r.p99 << std::setw(8) << r.samples << "\n";
+		out.flush();
+		results.push_back(r);
+	}
+};
+
+// Files under dir with one of the extensions, sorted so that runs list the cases in the same order
+std::vector<std::string> listAssets(const std::string& dir, const std::vector<std::string>& extensions) {
+	std::vector<std::string> files;
+	if (!std::filesystem::is_directory(dir)) {
+		return files;
+	}
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(dir)) {
+		std::string ext = entry.path().extension().string();
+		if (entry.is_regular_file() && std::find(extensions.begin(), extensions.end(), ext) != extensions.end()) {
+			files.push_back(entry.path().generic_string());
+		}
+	}
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+// Keeps the optimizer from dropping a result
+volatile size_t benchmarkSink;
+
+// An OBJ of size x size quads on a sphere, written like Blender does: a stand-in for a scanned prop
+std::string sphereObj(int size) {
+	std::string text;
+	char line[128];
+	for (int i = 0; i <= size; i++) {
+		for (int j = 0; j <= size; j++) {
+			float theta = glm::pi<float>() * i / size, phi = 2.0f * glm::pi<float>() * j / size;
+			glm::vec3 n(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+			snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.4f %.4f %.4f\n", n.x, n.y, n.z,
+				static_cast<float>(j) / size, static_cast<float>(i) / size, n.x, n.y, n.z);
+			text += line;
+		}
+	}
+	for (int i = 0; i < size; i++) {
+		for (int j = 0; j < size; j++) {
+			int a = i * (size + 1) + j + 1, b = a + size + 1;
+			snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, b + 1, b + 1, b + 1, a + 1, a + 1, a + 1);
+			text += line;
+		}
+	}
+	return text;
+}
+
+}
+
+std::vector<BenchmarkResult> runBenchmarks(const std::string& filter, std::ostream& out, const std::string& jsonPath) {
+	// The loaders log every file, keep only the warnings while measuring
+	LogLevel logLevel = Logger::instance().level();
+	Logger::instance().setLevel(LOG_LEVEL_WARN);
+
+	BenchmarkRunner bench(filter, out);
+	out << std::left << std::setw(60) << "case (us per iteration)" << std::right
+		<< std::setw(12) << "mean" << std::setw(10) << "stddev" << std::setw(12) << "p50"
+		<< std::setw(12) << "p99" << std::setw(8) << "samples" << "\n";
+
+	// The layouts of Vertex, VertexPacked and skyBoxVertex, as in PurrfectPotion::localInit
+	VertexDescriptor VD, VD_packed, VD_skyBox;
+	VD.init(nullptr, { {0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX} }, {
+		{0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, pos), sizeof(glm::vec3), POSITION},
+		{0, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, UV), sizeof(glm::vec2), UV},
+		{0, 2, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, norm), sizeof(glm::vec3), NORMAL}
+	});
+	VD_packed.init(nullptr, { {0, sizeof(VertexPacked), VK_VERTEX_INPUT_RATE_VERTEX} }, {
+		{0, 0, VK_FORMAT_R16G16B16A16_SNORM, offsetof(VertexPacked, pos), sizeof(VertexPacked::pos), POSITION},
+		{0, 1, VK_FORMAT_R16G16_SFLOAT, offsetof(VertexPacked, UV), sizeof(VertexPacked::UV), UV},
+		{0, 2, VK_FORMAT_R16G16_SNORM, offsetof(VertexPacked, norm), sizeof(VertexPacked::norm), NORMAL}
+	});
+	VD_skyBox.init(nullptr, { {0, sizeof(skyBoxVertex), VK_VERTEX_INPUT_RATE_VERTEX} }, {
+		{0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(skyBoxVertex, pos), sizeof(glm::vec3), POSITION}
+	});
+
+	// Loading
+	for (const std::string& file : listAssets("models", { ".gltf" })) {
+		bench.run("loadModelGLTF/" + file, 1, [&]() {
+			Model<Vertex> M;
+			M.load(&VD, file, GLTF);
+			benchmarkSink = M.vertices.size();
+		});
+	}
+	for (const std::string& file : listAssets("models", { ".gltf" })) {
+		bench.run("loadModelGLTF-packed/" + file, 1, [&]() {
+			Model<VertexPacked> M;
+			M.load(&VD_packed, file, GLTF);
+			benchmarkSink = M.vertices.size();
+		});
+	}
+	// Just the parsing, up to the accessors ready to be read: tinygltf against the streaming parser of the loader
+	for (const std::string& file : listAssets("models", { ".gltf" })) {
+		std::string baseDir = file.substr(0, file.find_last_of("/\\") + 1);
+		bench.run("parseGltf-tinygltf/" + file, 1, [&]() {
+			FileData data = VirtualFileSystem::instance().read(file);
+			tinygltf::Model model;
+			tinygltf::TinyGLTF loader;
+			std::string warn, err;
+			loader.SetFsCallbacks(virtualFsCallbacks());
+			loader.LoadASCIIFromString(&model, &warn, &err, data.data(), (unsigned int)data.size(), baseDir);
+			benchmarkSink = model.accessors.size();
+		});
+		bench.run("parseGltf-streaming/" + file, 1, [&]() {
+			FileData data = VirtualFileSystem::instance().read(file);
+			GltfDocument doc;
+			std::string error;
+			if (!doc.parse(data.data(), data.size(), error) || !doc.loadBuffers(baseDir, nullptr, 0, error)) {
+				throw std::runtime_error("failed to parse " + file + ": " + error);
+			}
+			benchmarkSink = doc.accessors.size();
+		});
+	}
+	for (const std::string& file : listAssets("models", { ".mgcg" })) {
+		bench.run("loadModelMGCG/" + file, 1, [&]() {
+			Model<Vertex> M;
+			M.load(&VD, file, MGCG);
+			benchmarkSink = M.vertices.size();
+		});
+	}
+	for (const std::string& file : listAssets("models", { ".glb" })) {
+		bench.run("loadModelGLB/" + file, 1, [&]() {
+			Model<Vertex> M;
+			M.load(&VD, file, GLB);
+			benchmarkSink = M.vertices.size();
+		});
+	}
+	for (const std::string& file : listAssets("models", { ".obj" })) {
+		bench.run("loadModelOBJ/" + file, 1, [&]() {
+			Model<skyBoxVertex> M;
+			M.load(&VD_skyBox, file, OBJ);
+			benchmarkSink = M.vertices.size();
+		});
+	}
+	// The only shipped OBJ is a cube: a generated sphere of 512 x 512 quads (about 40 MB) is parsed by tinyobj, the path
+	// before the parallel parser, and by the parallel parser with 1 to N threads for its scaling
+	if (bench.selected("parseObj")) {
+		std::string obj = sphereObj(512);
+		std::string name = "sphere512-" + std::to_string(obj.size() >> 20) + "MB";
+		bench.run("parseObj-tinyobj/" + name, 1, [&]() {
+			tinyobj::attrib_t attrib;
+			std::vector<tinyobj::shape_t> shapes;
+			std::vector<tinyobj::material_t> materials;
+			std::string warn, err;
+			std::istringstream stream(obj);
+			tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &stream);
+			benchmarkSink = shapes.empty() ? 0 : shapes[0].mesh.indices.size();
+		});
+		int maxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+		for (int threads = 1; threads <= maxThreads; threads *= 2) {
+			JobSystem objJobs;
+			objJobs.init(threads - 1);
+			bench.run("parseObj-parallel/" + name + "/" + std::to_string(threads) + "-threads", 1, [&]() {
+				ObjMesh mesh;
+				std::string error;
+				if (!mesh.parse(obj.data(), obj.size(), &objJobs, error)) {
+					throw std::runtime_error("failed to parse OBJ: " + error);
+				}
+				benchmarkSink = mesh.corners.size();
+			});
+			objJobs.cleanup();
+		}
+	}
+	for (const std::string& file : listAssets("textures", { ".png", ".jpg" })) {
+		bench.run("stbi_load/" + file, 1, [&]() {
+			int w, h, ch;
+			stbi_uc* pixels = stbi_load(file.c_str(), &w, &h, &ch, STBI_rgb_alpha);
+			benchmarkSink = static_cast<size_t>(w) * h;
+			stbi_image_free(pixels);
+		});
+	}
+	// The repository ships no .mgcg files: encode the glTF files in memory to time the decryption and the inflate,
+	// on one thread and with the blocks decrypted by the job system
+	JobSystem jobs;
+	jobs.init();
+	for (const std::string& file : listAssets("models", { ".gltf" })) {
+		std::string name = "decodeMGCG/" + file;
+		std::string parallelName = "decodeMGCG-parallel/" + file;
+		if (!bench.selected(name) && !bench.selected(parallelName)) {
+			continue;
+		}
+		std::vector<char> encoded = encodeMGCG(readFile(file));
+		bench.run(name, 1, [&]() {
+			benchmarkSink = decodeMGCG(encoded).size();
+		});
+		bench.run(parallelName, 1, [&]() {
+			benchmarkSink = decodeMGCG(encoded, &jobs).size();
+		});
+	}
+	jobs.cleanup();
+
+	// Game logic: the same world and placement of a headless run
+	GameSimulation sim;
+	sim.verbose = false;
+	sim.placementSeed = 1;
+	sim.init();
+	glm::mat4 ViewPrj = glm::perspective(glm::radians(45.0f), 1.5f, 0.1f, 100.0f) *
+		glm::lookAt(glm::vec3(0.0f, 3.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+	bench.run("placeEntity", 1000, [&]() {
+		sim.placeEntity(sim.objects[OBJ_SOFA], glm::vec3(1.0f, 0.0f, -2.0f), glm::vec3(0.0f, glm::radians(90.0f), 0.0f),
+			glm::vec3(1.0f), glm::vec3(0.0f), ViewPrj, true, 0);
+		benchmarkSink = static_cast<size_t>(sim.objects[OBJ_SOFA].ubo.mvpMat[3][0]);
+	});
+
+	for (int count : { 16, 256, 4096 }) {
+		CounterRng rng(7);
+		std::vector<BoundingBox> boxes;
+		for (int i = 0; i < count; i++) {
+			glm::vec3 center(rng.nextRange(-10.0f, 10.0f), rng.nextRange(0.0f, 2.0f), rng.nextRange(-10.0f, 10.0f));
+			glm::vec3 size(rng.nextRange(0.3f, 3.0f), rng.nextRange(0.3f, 3.0f), rng.nextRange(0.3f, 3.0f));
+			boxes.push_back(BoundingBox("box", center, size));
+		}
+		BoundingBox cat("cat", glm::vec3(0.0f), sim.catDimensions);
+		bench.run("BoundingBox::intersects/" + std::to_string(count), std::max(1, 65536 / count), [&]() {
+			size_t hits = 0;
+			for (BoundingBox& b : boxes) {
+				hits += cat.intersects(b);
+			}
+			benchmarkSink = hits;
+		});
+	}
+
+	uint64_t round = 0;
+	bench.run("fillBBList", 10, [&]() {
+		std::vector<BoundingBox> BBList;
+		glm::vec3 positions[COLLECTIBLES_NUM];
+		CounterRng rng(1, round++ % 64);		// a fixed cycle of layouts, so runs stay comparable
+		fillBBList(&BBList, positions, sim.furnitureBBs, rng);
+		benchmarkSink = BBList.size();
+	});
+
+	Logger::instance().setLevel(logLevel);
+
+	if (!jsonPath.empty()) {
+		nlohmann::json cases = nlohmann::json::array();
+		for (const BenchmarkResult& r : bench.results) {
+			cases.push_back({
+				{ "name", r.name }, { "samples", r.samples }, { "iterationsPerSample", r.iterationsPerSample },
+				{ "mean", r.mean }, { "stddev", r.stddev }, { "min", r.min },
+				{ "p50", r.p50 }, { "p90", r.p90 }, { "p99", r.p99 }, { "max", r.max }
+			});
+		}
+		nlohmann::json doc = {
+			{ "unit", "us" },
+#ifdef NDEBUG
+			{ "build", "release" },
+#else
+			{ "build", "debug" },
+#endif
+			{ "benchmarks", cases }
+		};
+		std::ofstream file(jsonPath);
+		if (!file) {
+			throw std::runtime_error("failed to open benchmark output file!");
+		}
+		file << doc.dump(2) << "\n";
+	}
+	return bench.results;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Timing of one benchmark case, in microseconds per iteration
+struct BenchmarkResult {
+	std::string name;
+	int samples;
+	int iterationsPerSample;
+	double mean, stddev, min, p50, p90, p99, max;
+};
+
+// Microbenchmarks of the CPU hot paths: model and texture loading per asset, MGCG decoding,
+// the matrices of placeEntity, the bounding box tests and the collectibles placement.
+// No window nor GPU is needed; assets are read from the models and textures folders of the working directory.
+// Runs the cases whose name contains filter (all of them if it is empty), prints a table and,
+// if jsonPath is not empty, writes the results as JSON so that two runs can be compared
+std::vector<BenchmarkResult> runBenchmarks(const std::string& filter, std::ostream& out, const std::string& jsonPath);
@@ -1,10 +1,8 @@
 #pragma once
 
-#include <cstdlib>  // For rand() and srand()
-#include <ctime>    // For time() - to seed rand()
+#include <string>
 #include <vector>
 
-#include "Starter.hpp"
 #include "Utils.hpp"
 
 struct BoundingBox {
@@ -32,12 +30,14 @@ struct VertexBoundingBox {
 // Create the vertices and indices for the bounding box model
 void createBBModel(std::vector<VertexBoundingBox>& vDef, std::vector<uint32_t>& vIdx, BoundingBox* bb);
 
-// Draw the bounding box and update the UBO
-void drawBoundingBox(bool hasBoundingBox, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, glm::mat4 ViewPrj,
-	UniformBufferObject UBO_boundingBox, DescriptorSet DS_boundingBox, int currentImage);
+// Compute the UBO of the bounding box (scaled to zero when it is not displayed)
+void updateBoundingBox(bool hasBoundingBox, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, const glm::mat4& ViewPrj,
+	UniformBufferObject& UBO_boundingBox);
 
 // Clear the list of bounding boxes
 void emptyBBList(std::vector<BoundingBox>* BBList);
 
-// Generate random positions for the collectibles, create their bounding boxes and add them to the list
-void fillBBList(std::vector<BoundingBox>* BBList, glm::vec3* BBPosition);
+struct CounterRng;
+
+// Place the collectibles with Poisson-disk sampling around the obstacles, create their bounding boxes and add them to the list
+void fillBBList(std::vector<BoundingBox>* BBList, glm::vec3* BBPosition, const std::vector<BoundingBox>& obstacles, CounterRng& rng);
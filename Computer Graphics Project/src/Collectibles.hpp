@@ -0,0 +1,54 @@
+#pragma once
+
+#include <bitset>
+
+#include "Utils.hpp"
+
+// Every collectible is described by one line of this table: the enum IDs, the HUD slots,
+// the collider sizes, the asset paths and the light slots are all generated from it.
+// The HUD slot, the bounding box index and the position index of a collectible are its ID.
+//
+//   ID,        name,      model,                                      diffuse texture (nullptr = palette),         HUD icon,                        collider size,    emission
+#define COLLECTIBLES_TABLE(X) \
+	X(CRYSTAL,	"crystal",	"models/collectibles/coll_crystal.gltf",	nullptr,									"textures/HUD/coll_crystal.png", 0.7f, 0.7f, 0.7f,	1.0f) \
+	X(EYE,		"eye",		"models/collectibles/coll_eye.gltf",		"textures/collectibles/eye_diffuse.png",	"textures/HUD/coll_eye.png",	 0.5f, 0.5f, 0.5f,	1.0f) \
+	X(FEATHER,	"feather",	"models/collectibles/coll_feather.gltf",	"textures/collectibles/feather_diffuse.png","textures/HUD/coll_feather.png", 0.5f, 0.6f, 0.9f,	1.0f) \
+	X(LEAF,		"leaf",		"models/collectibles/coll_leaf.gltf",		nullptr,									"textures/HUD/coll_leaf.png",	 0.6f, 0.5f, 0.5f,	1.0f) \
+	X(POTION1,	"potion1",	"models/collectibles/coll_potion1.gltf",	nullptr,									"textures/HUD/coll_potion1.png", 0.5f, 1.0f, 0.5f,	1.0f) \
+	X(POTION2,	"potion2",	"models/collectibles/coll_potion2.gltf",	nullptr,									"textures/HUD/coll_potion2.png", 0.5f, 1.0f, 0.5f,	1.0f) \
+	X(BONE,		"bone",		"models/collectibles/coll_bone.gltf",		nullptr,									"textures/HUD/coll_bone.png",	 0.5f, 0.7f, 0.5f,	0.3f)
+
+enum CollectibleId {
+#define COLLECTIBLE_ENUM(id, name, model, texture, hud, sx, sy, sz, emission) COLLECTIBLE_##id,
+	COLLECTIBLES_TABLE(COLLECTIBLE_ENUM)
+#undef COLLECTIBLE_ENUM
+	COLLECTIBLES_NUM
+};
+
+struct CollectibleInfo {
+	const char* name;
+	const char* model;
+	const char* texture;
+	const char* hudIcon;
+	float collider[3];
+	float emission;		// emissive color intensity
+
+	glm::vec3 colliderSize() const { return glm::vec3(collider[0], collider[1], collider[2]); }
+};
+
+inline constexpr CollectibleInfo collectibleRegistry[COLLECTIBLES_NUM] = {
+#define COLLECTIBLE_INFO(id, name, model, texture, hud, sx, sy, sz, emission) { name, model, texture, hud, { sx, sy, sz }, emission },
+	COLLECTIBLES_TABLE(COLLECTIBLE_INFO)
+#undef COLLECTIBLE_INFO
+};
+
+// Lights 0 .. FIXED_LIGHTS_NUM-1 are the room lights, the remaining ones float over the collectibles
+#define FIXED_LIGHTS_NUM 9
+
+// Light slot of a collectible, or -1 if there are more collectibles than free lights
+constexpr int collectibleLightSlot(int id) {
+	return FIXED_LIGHTS_NUM + id < LIGHTS_NUM ? FIXED_LIGHTS_NUM + id : -1;
+}
+
+// Collected state of all the collectibles, indexed by CollectibleId
+using CollectedSet = std::bitset<COLLECTIBLES_NUM>;
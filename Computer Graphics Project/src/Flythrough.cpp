@@ -0,0 +1,170 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "Flythrough.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+// Same setting of tiny_gltf in Starter.hpp, json.hpp must be compiled the same way everywhere
+#define JSON_NOEXCEPTION
+#include <json.hpp>
+
+// Waypoints on the floor (x, z): from the hall into the kitchen, the living room, the witch lair,
+// the bathroom and the bedroom, coming back to the hall between two rooms
+static const glm::vec2 waypoints[] = {
+	{ 6.0f, 0.0f }, { 7.5f, 4.0f }, { 4.0f, 9.0f }, { 1.5f, 3.0f },			// kitchen
+	{ -4.0f, 2.0f }, { -9.0f, 6.0f }, { -4.5f, 8.0f }, { -2.0f, 1.5f },			// living room
+	{ -6.0f, -3.0f }, { -9.5f, -7.5f }, { -4.0f, -10.5f }, { -3.0f, -3.0f },	// witch lair
+	{ -1.0f, -6.0f }, { -0.5f, -9.5f }, { 0.5f, -4.0f },						// bathroom
+	{ 4.0f, -4.0f }, { 8.5f, -7.0f }, { 6.0f, -10.0f }, { 3.5f, -2.0f }			// bedroom
+};
+static const int WAYPOINTS_NUM = sizeof(waypoints) / sizeof(waypoints[0]);
+
+// Point and tangent of the closed Catmull-Rom spline at u in [0, WAYPOINTS_NUM)
+static void splineAt(float u, glm::vec2& point, glm::vec2& tangent) {
+	int i = static_cast<int>(std::floor(u));
+	float t = u - i;
+	const glm::vec2& p0 = waypoints[(i - 1 + WAYPOINTS_NUM) % WAYPOINTS_NUM];
+	const glm::vec2& p1 = waypoints[i % WAYPOINTS_NUM];
+	const glm::vec2& p2 = waypoints[(i + 1) % WAYPOINTS_NUM];
+	const glm::vec2& p3 = waypoints[(i + 2) % WAYPOINTS_NUM];
+
+	float t2 = t * t, t3 = t2 * t;
+	point = 0.5f * (2.0f * p1 + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+	tangent = 0.5f * ((p2 - p0) + 2.0f * (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t + 3.0f * (3.0f * p1 - p0 - 3.0f * p2 + p3) * t2);
+}
+
+bool FlythroughInput::next(FrameInput& in) {
+	if (frame >= frames) {
+		return false;
+	}
+	in = FrameInput();
+	in.deltaT = deltaT;
+	in.start = frame == 0;		// leave the start screen
+	frame++;
+	return true;
+}
+
+void FlythroughInput::apply(GameSimulation& sim) const {
+	if (sim.gameState != GAME_STATE_PLAY) {
+		return;
+	}
+
+	glm::vec2 point, tangent;
+	splineAt(WAYPOINTS_NUM * static_cast<float>(frame - 1) / frames, point, tangent);
+	if (glm::length(tangent) < 1e-4f) {
+		tangent = glm::vec2(0.0f, 1.0f);
+	}
+	glm::vec2 dir = glm::normalize(tangent);
+
+	sim.catPosition = glm::vec3(point.x, 0.05f, point.y);
+	// The camera sits behind the cat (its offset is (sin yaw, 0, cos yaw)), the cat faces away from it
+	sim.camYaw = std::atan2(-dir.x, -dir.y);
+	sim.catYaw = sim.camYaw - glm::radians(90.0f);
+	sim.camPitch = glm::radians(20.0f);
+	sim.camDist = 3.0f;
+
+	// However long the run, the timer must not end the game
+	sim.totalElapsedTime = std::min(sim.totalElapsedTime, sim.GAME_DURATION - 1.0f);
+}
+
+void FlythroughStats::addFrame(double ms, const double* stages) {
+	frames++;
+	if (frames <= WARMUP_FRAMES) {
+		return;
+	}
+	frameMs.push_back(ms);
+	for (int s = 0; s < SIM_STAGES_NUM; s++) {
+		stageMs[s].push_back(stages[s]);
+	}
+}
+
+void FlythroughStats::addEvents(const std::vector<ProfileEvent>& events) {
+	if (frames <= WARMUP_FRAMES) {
+		return;
+	}
+	for (const ProfileEvent& e : events) {
+		(e.track == PROFILER_GPU_TRACK ? gpuMs : cpuMs)[e.name].push_back(e.durationNs / 1e6);
+	}
+}
+
+namespace {
+
+struct Summary {
+	size_t count = 0;
+	double avg = 0, p50 = 0, p95 = 0, p99 = 0, max = 0;
+};
+
+Summary summarize(std::vector<double> samples) {
+	Summary s;
+	if (samples.empty()) {
+		return s;
+	}
+	std::sort(samples.begin(), samples.end());
+	auto percentile = [&](double p) { return samples[std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()))]; };
+	s.count = samples.size();
+	for (double v : samples) s.avg += v;
+	s.avg /= samples.size();
+	s.p50 = percentile(0.50);
+	s.p95 = percentile(0.95);
+	s.p99 = percentile(0.99);
+	s.max = samples.back();
+	return s;
+}
+
+nlohmann::json toJson(const Summary& s) {
+	return { { "count", s.count }, { "avgMs", s.avg }, { "p50Ms", s.p50 }, { "p95Ms", s.p95 }, { "p99Ms", s.p99 }, { "maxMs", s.max } };
+}
+
+void printRow(std::ostream& out, const std::string& name, const Summary& s) {
+	out << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(3)
+		<< std::setw(10) << s.avg << std::setw(10) << s.p50 << std::setw(10) << s.p95 << std::setw(10) << s.p99
+		<< std::setw(9) << s.count << "\n";
+}
+
+}
+
+void FlythroughStats::write(std::ostream& out, const std::string& path, const std::string& deviceName, uint64_t seed) const {
+	Summary frame = summarize(frameMs);
+
+	nlohmann::json stages = nlohmann::json::object(), cpu = nlohmann::json::object(), gpu = nlohmann::json::object();
+	out << "Flythrough on " << deviceName << ": " << frameMs.size() << " frames measured\n";
+	out << std::left << std::setw(28) << "ms" << std::right << std::setw(10) << "avg" << std::setw(10) << "p50"
+		<< std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(9) << "count" << "\n";
+	printRow(out, "frame", frame);
+	for (int s = 0; s < SIM_STAGES_NUM; s++) {
+		Summary sum = summarize(stageMs[s]);
+		stages[simStageNames[s]] = toJson(sum);
+		printRow(out, std::string("sim ") + simStageNames[s], sum);
+	}
+	for (const auto& c : cpuMs) {
+		Summary sum = summarize(c.second);
+		cpu[c.first] = toJson(sum);
+		printRow(out, "cpu " + c.first, sum);
+	}
+	for (const auto& g : gpuMs) {
+		Summary sum = summarize(g.second);
+		gpu[g.first] = toJson(sum);
+		printRow(out, "gpu " + g.first, sum);
+	}
+
+	nlohmann::json doc = {
+		{ "device", deviceName },
+		{ "seed", seed },
+		{ "warmupFrames", WARMUP_FRAMES },
+		{ "frame", toJson(frame) },
+		{ "simStages", stages },
+		{ "cpuPasses", cpu },
+		{ "gpuPasses", gpu }
+	};
+	std::ofstream file(path);
+	if (!file) {
+		throw std::runtime_error("failed to open flythrough report file!");
+	}
+	file << doc.dump(2) << "\n";
+	out << "Flythrough report written to " << path << "\n";
+}
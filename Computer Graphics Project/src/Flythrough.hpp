@@ -0,0 +1,49 @@
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Simulation.hpp"
+#include "Profiler.hpp"
+
+// Scripted tour of the house for the end-to-end benchmark: the first frame skips the start screen,
+// then the cat walks a closed Catmull-Rom spline through the five rooms (once over the whole run)
+// with the camera following behind it
+class FlythroughInput : public InputSource {
+public:
+	FlythroughInput(int frames, float deltaT = 1.0f / 60.0f) : frames(frames), deltaT(deltaT) {}
+
+	bool next(FrameInput& in) override;
+
+	// Put the cat and the camera on the path for the frame returned by the last next(), before the step
+	void apply(GameSimulation& sim) const;
+
+	int framesDone() const { return frame; }
+
+private:
+	int frames;
+	float deltaT;
+	int frame = 0;
+};
+
+// Frame times and CPU/GPU time of every pass of a flythrough
+class FlythroughStats {
+public:
+	// The first frames (loading, pipeline warm up) are left out of the statistics
+	static const int WARMUP_FRAMES = 30;
+
+	void addFrame(double frameMs, const double* stageMs);
+	// Profiler events (CPU scopes, jobs and GPU zones) recorded during the frame
+	void addEvents(const std::vector<ProfileEvent>& events);
+
+	// Print a summary and write everything as JSON to path
+	void write(std::ostream& out, const std::string& path, const std::string& deviceName, uint64_t seed) const;
+
+private:
+	int frames = 0;
+	std::vector<double> frameMs;
+	std::vector<double> stageMs[SIM_STAGES_NUM];
+	std::map<std::string, std::vector<double>> cpuMs, gpuMs;
+};
@@ -0,0 +1,556 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "GltfParser.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "Logger.hpp"
+
+namespace {
+
+// Pull reader of a JSON text: values are read (or skipped) as the caller walks the document, nothing is stored
+class JsonReader {
+public:
+	JsonReader(const char* json, size_t size) : p(json), end(json + size) {}
+
+	bool failed() const { return !ok; }
+	const char* error() const { return message; }
+	void fail(const char* why) {
+		if (ok) {
+			ok = false;
+			message = why;
+		}
+		p = end;
+	}
+
+	// The members of an object: f(key, keyLength) must read or skip the value
+	template <class F>
+	void object(F f) {
+		if (!expect('{')) {
+			return;
+		}
+		if (peek() == '}') {
+			p++;
+			return;
+		}
+		while (ok) {
+			const char* key;
+			size_t keyLength;
+			if (!rawString(key, keyLength) || !expect(':')) {
+				return;
+			}
+			f(key, keyLength);
+			if (peek() == ',') {
+				p++;
+			} else {
+				expect('}');
+				return;
+			}
+		}
+	}
+
+	// The elements of an array: f() must read or skip each of them
+	template <class F>
+	void array(F f) {
+		if (!expect('[')) {
+			return;
+		}
+		if (peek() == ']') {
+			p++;
+			return;
+		}
+		while (ok) {
+			f();
+			if (peek() == ',') {
+				p++;
+			} else {
+				expect(']');
+				return;
+			}
+		}
+	}
+
+	double number() {
+		skipSpace();
+		char buffer[64];
+		size_t n = 0;
+		while (p < end && n + 1 < sizeof(buffer) && (isdigit(static_cast<unsigned char>(*p)) || strchr("+-.eE", *p) != nullptr)) {
+			buffer[n++] = *p++;
+		}
+		buffer[n] = '\0';
+		char* parsed;
+		double v = strtod(buffer, &parsed);
+		if (n == 0 || parsed != buffer + n) {
+			fail("malformed number");
+		}
+		return v;
+	}
+
+	// A non-negative integer (index, count, offset)
+	size_t index() {
+		double v = number();
+		if (v < 0 || v != std::floor(v) || v > 9.0e15) {
+			fail("invalid index");
+			return 0;
+		}
+		return static_cast<size_t>(v);
+	}
+
+	bool boolean() {
+		skipSpace();
+		if (literal("true")) {
+			return true;
+		}
+		if (!literal("false")) {
+			fail("malformed boolean");
+		}
+		return false;
+	}
+
+	std::string string() {
+		const char* s;
+		size_t length;
+		std::string out;
+		if (!rawString(s, length)) {
+			return out;
+		}
+		for (size_t i = 0; i < length; i++) {
+			if (s[i] != '\\') {
+				out += s[i];
+				continue;
+			}
+			char c = s[++i];
+			switch (c) {
+			case 'b': out += '\b'; break;
+			case 'f': out += '\f'; break;
+			case 'n': out += '\n'; break;
+			case 'r': out += '\r'; break;
+			case 't': out += '\t'; break;
+			case 'u': fail("unicode escape in string"); return out;
+			default: out += c; break;
+			}
+		}
+		return out;
+	}
+
+	void numbers(std::vector<double>& out) {
+		out.clear();
+		array([&]() { out.push_back(number()); });
+	}
+
+	void skip() {
+		switch (peek()) {
+		case '{': object([&](const char*, size_t) { skip(); }); break;
+		case '[': array([&]() { skip(); }); break;
+		case '"': { const char* s; size_t n; rawString(s, n); } break;
+		case 't': case 'f': boolean(); break;
+		case 'n':
+			if (!literal("null")) {
+				fail("malformed literal");
+			}
+			break;
+		default: number(); break;
+		}
+	}
+
+private:
+	const char* p;
+	const char* end;
+	bool ok = true;
+	const char* message = "";
+
+	void skipSpace() {
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+			p++;
+		}
+	}
+
+	char peek() {
+		skipSpace();
+		return p < end ? *p : '\0';
+	}
+
+	bool expect(char c) {
+		if (peek() != c) {
+			fail("unexpected character");
+			return false;
+		}
+		p++;
+		return true;
+	}
+
+	bool literal(const char* word) {
+		size_t n = strlen(word);
+		if (static_cast<size_t>(end - p) < n || memcmp(p, word, n) != 0) {
+			return false;
+		}
+		p += n;
+		return true;
+	}
+
+	// The characters between the quotes, escapes left as they are
+	bool rawString(const char*& s, size_t& length) {
+		if (!expect('"')) {
+			return false;
+		}
+		s = p;
+		while (p < end && *p != '"') {
+			p += *p == '\\' ? 2 : 1;
+		}
+		if (p >= end) {
+			fail("unterminated string");
+			return false;
+		}
+		length = p - s;
+		p++;
+		return true;
+	}
+};
+
+bool keyIs(const char* key, size_t length, const char* name) {
+	return strlen(name) == length && memcmp(key, name, length) == 0;
+}
+
+int componentsOf(const std::string& type) {
+	if (type == "SCALAR") return 1;
+	if (type == "VEC2") return 2;
+	if (type == "VEC3") return 3;
+	if (type == "VEC4") return 4;
+	return 0;
+}
+
+bool decodeBase64(const char* s, size_t length, std::vector<unsigned char>& out) {
+	out.clear();
+	out.reserve(length / 4 * 3);
+	uint32_t bits = 0;
+	int count = 0;
+	for (size_t i = 0; i < length && s[i] != '='; i++) {
+		const char c = s[i];
+		int v = c >= 'A' && c <= 'Z' ? c - 'A' : c >= 'a' && c <= 'z' ? c - 'a' + 26 :
+			c >= '0' && c <= '9' ? c - '0' + 52 : c == '+' ? 62 : c == '/' ? 63 : -1;
+		if (v < 0) {
+			return false;
+		}
+		bits = (bits << 6) | static_cast<uint32_t>(v);
+		if (++count == 4) {
+			out.push_back(static_cast<unsigned char>(bits >> 16));
+			out.push_back(static_cast<unsigned char>(bits >> 8));
+			out.push_back(static_cast<unsigned char>(bits));
+			bits = 0;
+			count = 0;
+		}
+	}
+	if (count == 2) {
+		out.push_back(static_cast<unsigned char>(bits >> 4));
+	} else if (count == 3) {
+		out.push_back(static_cast<unsigned char>(bits >> 10));
+		out.push_back(static_cast<unsigned char>(bits >> 2));
+	} else if (count != 0) {
+		return false;
+	}
+	return true;
+}
+
+}
+
+glm::mat4 gltfNodeTransform(const std::vector<double>& matrix, const std::vector<double>& translation,
+							const std::vector<double>& rotation, const std::vector<double>& scale) {
+	glm::mat4 transform(1.0f);
+	if (matrix.size() == 16) {
+		for (int k = 0; k < 16; k++) {
+			transform[k / 4][k % 4] = static_cast<float>(matrix[k]);
+		}
+		return transform;
+	}
+	if (translation.size() == 3) {
+		transform = glm::translate(transform, glm::vec3(translation[0], translation[1], translation[2]));
+	}
+	if (rotation.size() == 4) {
+		transform *= glm::mat4_cast(glm::quat(static_cast<float>(rotation[3]), static_cast<float>(rotation[0]),
+			static_cast<float>(rotation[1]), static_cast<float>(rotation[2])));
+	}
+	if (scale.size() == 3) {
+		transform = glm::scale(transform, glm::vec3(scale[0], scale[1], scale[2]));
+	}
+	return transform;
+}
+
+bool GltfDocument::parse(const char* json, size_t size, std::string& error) {
+	JsonReader in(json, size);
+	std::string unsupported;
+
+	in.object([&](const char* key, size_t length) {
+		if (keyIs(key, length, "buffers")) {
+			in.array([&]() {
+				GltfBuffer buffer;
+				in.object([&](const char* key, size_t length) {
+					if (keyIs(key, length, "uri")) buffer.uri = in.string();
+					else if (keyIs(key, length, "byteLength")) buffer.byteLength = in.index();
+					else in.skip();
+				});
+				buffers.push_back(std::move(buffer));
+			});
+		} else if (keyIs(key, length, "bufferViews")) {
+			in.array([&]() {
+				GltfBufferView view;
+				in.object([&](const char* key, size_t length) {
+					if (keyIs(key, length, "buffer")) view.buffer = static_cast<int>(in.index());
+					else if (keyIs(key, length, "byteOffset")) view.byteOffset = in.index();
+					else if (keyIs(key, length, "byteLength")) view.byteLength = in.index();
+					else if (keyIs(key, length, "byteStride")) view.byteStride = in.index();
+					else in.skip();
+				});
+				bufferViews.push_back(view);
+			});
+		} else if (keyIs(key, length, "accessors")) {
+			in.array([&]() {
+				GltfAccessor accessor;
+				in.object([&](const char* key, size_t length) {
+					if (keyIs(key, length, "bufferView")) accessor.bufferView = static_cast<int>(in.index());
+					else if (keyIs(key, length, "byteOffset")) accessor.byteOffset = in.index();
+					else if (keyIs(key, length, "componentType")) accessor.componentType = static_cast<int>(in.index());
+					else if (keyIs(key, length, "normalized")) accessor.normalized = in.boolean();
+					else if (keyIs(key, length, "count")) accessor.count = in.index();
+					else if (keyIs(key, length, "type")) {
+						std::string type = in.string();
+						accessor.components = componentsOf(type);
+						if (accessor.components == 0) unsupported = "accessor type " + type;
+					}
+					else if (keyIs(key, length, "sparse")) { unsupported = "sparse accessor"; in.skip(); }
+					else in.skip();
+				});
+				if (accessor.bufferView < 0) {
+					unsupported = "accessor without buffer view";
+				}
+				accessors.push_back(accessor);
+			});
+		} else if (keyIs(key, length, "meshes")) {
+			in.array([&]() {
+				GltfMesh mesh;
+				in.object([&](const char* key, size_t length) {
+					if (!keyIs(key, length, "primitives")) {
+						in.skip();
+						return;
+					}
+					in.array([&]() {
+						GltfPrimitive primitive;
+						in.object([&](const char* key, size_t length) {
+							if (keyIs(key, length, "attributes")) {
+								in.object([&](const char* key, size_t length) {
+									if (keyIs(key, length, "POSITION")) primitive.position = static_cast<int>(in.index());
+									else if (keyIs(key, length, "NORMAL")) primitive.normal = static_cast<int>(in.index());
+									else if (keyIs(key, length, "TANGENT")) primitive.tangent = static_cast<int>(in.index());
+									else if (keyIs(key, length, "TEXCOORD_0")) primitive.texCoord0 = static_cast<int>(in.index());
+									else in.skip();
+								});
+							}
+							else if (keyIs(key, length, "indices")) primitive.indices = static_cast<int>(in.index());
+							else in.skip();
+						});
+						mesh.primitives.push_back(primitive);
+					});
+				});
+				meshes.push_back(std::move(mesh));
+			});
+		} else if (keyIs(key, length, "nodes")) {
+			in.array([&]() {
+				GltfNode node;
+				std::vector<double> matrix, translation, rotation, scale;
+				in.object([&](const char* key, size_t length) {
+					if (keyIs(key, length, "mesh")) node.mesh = static_cast<int>(in.index());
+					else if (keyIs(key, length, "matrix")) in.numbers(matrix);
+					else if (keyIs(key, length, "translation")) in.numbers(translation);
+					else if (keyIs(key, length, "rotation")) in.numbers(rotation);
+					else if (keyIs(key, length, "scale")) in.numbers(scale);
+					else in.skip();
+				});
+				node.transform = gltfNodeTransform(matrix, translation, rotation, scale);
+				nodes.push_back(node);
+			});
+		} else if (keyIs(key, length, "extensionsRequired")) {
+			in.array([&]() {
+				std::string extension = in.string();
+				if (extension != "KHR_mesh_quantization") {
+					unsupported = "required extension " + extension;
+				}
+			});
+		} else {
+			in.skip();
+		}
+	});
+
+	if (in.failed()) {
+		error = std::string("malformed JSON: ") + in.error();
+		return false;
+	}
+	if (!unsupported.empty()) {
+		error = unsupported;
+		return false;
+	}
+
+	// References between the sections, so that the loader can follow them without checking
+	for (const GltfBufferView& view : bufferViews) {
+		if (view.buffer < 0 || view.buffer >= static_cast<int>(buffers.size())) {
+			error = "buffer view without buffer";
+			return false;
+		}
+	}
+	for (const GltfAccessor& accessor : accessors) {
+		if (accessor.bufferView >= static_cast<int>(bufferViews.size())) {
+			error = "accessor without buffer view";
+			return false;
+		}
+	}
+	for (const GltfMesh& mesh : meshes) {
+		for (const GltfPrimitive& primitive : mesh.primitives) {
+			for (int a : { primitive.position, primitive.normal, primitive.tangent, primitive.texCoord0, primitive.indices }) {
+				if (a >= static_cast<int>(accessors.size())) {
+					error = "primitive without accessor";
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool GltfDocument::loadBuffers(const std::string& baseDir, const unsigned char* glbBin, size_t glbBinSize, std::string& error) {
+	for (size_t i = 0; i < buffers.size(); i++) {
+		GltfBuffer& buffer = buffers[i];
+		size_t available = 0;
+		if (buffer.uri.empty()) {
+			// The BIN chunk of a .glb is the first buffer
+			if (i != 0 || glbBin == nullptr) {
+				error = "buffer without uri";
+				return false;
+			}
+			buffer.data = glbBin;
+			available = glbBinSize;
+		} else if (buffer.uri.compare(0, 5, "data:") == 0) {
+			size_t comma = buffer.uri.find(',');
+			if (comma == std::string::npos || buffer.uri.rfind(";base64", comma) == std::string::npos) {
+				error = "data uri not in base64";
+				return false;
+			}
+			decoded.emplace_back();
+			if (!decodeBase64(buffer.uri.data() + comma + 1, buffer.uri.size() - comma - 1, decoded.back())) {
+				error = "malformed base64 data uri";
+				return false;
+			}
+			buffer.data = decoded.back().data();
+			available = decoded.back().size();
+		} else if (buffer.uri.find('%') != std::string::npos) {
+			error = "percent-encoded uri";
+			return false;
+		} else {
+			files.push_back(VirtualFileSystem::instance().read(baseDir + buffer.uri));
+			buffer.data = reinterpret_cast<const unsigned char*>(files.back().data());
+			available = files.back().size();
+		}
+		if (available < buffer.byteLength) {
+			error = "buffer shorter than its byteLength";
+			return false;
+		}
+	}
+	return true;
+}
+
+AccessorReader::AccessorReader(const GltfDocument& document, int accessor) {
+	if (accessor < 0 || accessor >= static_cast<int>(document.accessors.size())) {
+		throw std::runtime_error("failed to read GLTF accessor!");
+	}
+	const GltfAccessor& a = document.accessors[accessor];
+	if (a.bufferView < 0 || a.bufferView >= static_cast<int>(document.bufferViews.size()) ||
+		a.components < 1 || a.components > 4) {
+		throw std::runtime_error("failed to read GLTF accessor!");
+	}
+	const GltfBufferView& view = document.bufferViews[a.bufferView];
+	const GltfBuffer& buffer = document.buffers[view.buffer];
+	count = a.count;
+	componentType = a.componentType;
+	components = a.components;
+	normalized = a.normalized;
+
+	size_t componentSize = componentType == GLTF_BYTE || componentType == GLTF_UNSIGNED_BYTE ? 1 :
+		componentType == GLTF_SHORT || componentType == GLTF_UNSIGNED_SHORT ? 2 : 4;
+	stride = view.byteStride != 0 ? view.byteStride : components * componentSize;
+	if (buffer.data == nullptr || view.byteOffset + view.byteLength > buffer.byteLength ||
+		(count > 0 && a.byteOffset + (count - 1) * stride + components * componentSize > view.byteLength)) {
+		throw std::runtime_error("failed to read GLTF accessor!");
+	}
+	data = buffer.data + view.byteOffset + a.byteOffset;
+}
+
+glm::vec4 AccessorReader::operator[](size_t i) const {
+	const unsigned char* element = data + i * stride;
+	glm::vec4 v(0.0f);
+	for (int k = 0; k < components; k++) {
+		switch (componentType) {
+		case GLTF_FLOAT:
+			{
+				float f;
+				memcpy(&f, element + 4 * k, sizeof(f));
+				v[k] = f;
+			}
+			break;
+		case GLTF_BYTE:
+			{
+				int8_t c = static_cast<int8_t>(element[k]);
+				v[k] = normalized ? std::max(c / 127.0f, -1.0f) : c;
+			}
+			break;
+		case GLTF_UNSIGNED_BYTE:
+			v[k] = normalized ? element[k] / 255.0f : element[k];
+			break;
+		case GLTF_SHORT:
+			{
+				int16_t c;
+				memcpy(&c, element + 2 * k, sizeof(c));
+				v[k] = normalized ? std::max(c / 32767.0f, -1.0f) : c;
+			}
+			break;
+		case GLTF_UNSIGNED_SHORT:
+			{
+				uint16_t c;
+				memcpy(&c, element + 2 * k, sizeof(c));
+				v[k] = normalized ? c / 65535.0f : c;
+			}
+			break;
+		default:
+			LOG_ERROR("Attribute component type %d not supported!", componentType);
+			throw std::runtime_error("Error loading GLTF component");
+		}
+	}
+	return v;
+}
+
+uint32_t AccessorReader::index(size_t i) const {
+	const unsigned char* element = data + i * stride;
+	switch (componentType) {
+	case GLTF_UNSIGNED_BYTE:
+		return element[0];
+	case GLTF_UNSIGNED_SHORT:
+		{
+			uint16_t v;
+			memcpy(&v, element, sizeof(v));
+			return v;
+		}
+	case GLTF_UNSIGNED_INT:
+		{
+			uint32_t v;
+			memcpy(&v, element, sizeof(v));
+			return v;
+		}
+	default:
+		LOG_ERROR("Index component type %d not supported!", componentType);
+		throw std::runtime_error("Error loading GLTF component");
+	}
+}
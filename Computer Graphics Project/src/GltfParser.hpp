@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "VirtualFileSystem.hpp"
+
+// Component types of the glTF accessors
+enum GltfComponentType {
+	GLTF_BYTE = 5120,
+	GLTF_UNSIGNED_BYTE = 5121,
+	GLTF_SHORT = 5122,
+	GLTF_UNSIGNED_SHORT = 5123,
+	GLTF_UNSIGNED_INT = 5125,
+	GLTF_FLOAT = 5126
+};
+
+struct GltfBuffer {
+	std::string uri;
+	size_t byteLength = 0;
+	const unsigned char* data = nullptr;	// set by loadBuffers, at least byteLength bytes
+};
+
+struct GltfBufferView {
+	int buffer = -1;
+	size_t byteOffset = 0;
+	size_t byteLength = 0;
+	size_t byteStride = 0;					// 0: tightly packed
+};
+
+struct GltfAccessor {
+	int bufferView = -1;
+	size_t byteOffset = 0;
+	int componentType = 0;
+	int components = 0;						// 1 (SCALAR) to 4 (VEC4)
+	bool normalized = false;
+	size_t count = 0;
+};
+
+// The accessors of the attributes the loader reads, -1 if missing
+struct GltfPrimitive {
+	int position = -1;
+	int normal = -1;
+	int tangent = -1;
+	int texCoord0 = -1;
+	int indices = -1;
+};
+
+struct GltfMesh {
+	std::vector<GltfPrimitive> primitives;
+};
+
+struct GltfNode {
+	int mesh = -1;
+	glm::mat4 transform = glm::mat4(1.0f);	// local: matrix, or translation * rotation * scale
+};
+
+// The part of a glTF document the model loader uses: meshes, accessors, buffer views, buffers (and the nodes, for
+// the transform of quantized meshes). parse reads the JSON in a single pass without building a DOM, skipping every
+// other section; loadBuffers maps the buffers, so accessors point into the files instead of copies of them.
+class GltfDocument {
+public:
+	std::vector<GltfBuffer> buffers;
+	std::vector<GltfBufferView> bufferViews;
+	std::vector<GltfAccessor> accessors;
+	std::vector<GltfMesh> meshes;
+	std::vector<GltfNode> nodes;
+
+	// False, with the reason in error, if the JSON is malformed or uses something this parser does not support
+	// (sparse accessors, matrix attributes, required extensions other than KHR_mesh_quantization): the caller
+	// falls back to tinygltf
+	bool parse(const char* json, size_t size, std::string& error);
+
+	// Read the buffers: external files through the virtual file system (mapped, not copied), base64 data URIs
+	// decoded, the buffer without uri of a .glb from its BIN chunk
+	bool loadBuffers(const std::string& baseDir, const unsigned char* glbBin, size_t glbBinSize, std::string& error);
+
+private:
+	std::vector<FileData> files;
+	std::vector<std::vector<unsigned char>> decoded;
+};
+
+// Local transform of a node from its glTF properties (matrix, else translation, rotation and scale; empty if missing)
+glm::mat4 gltfNodeTransform(const std::vector<double>& matrix, const std::vector<double>& translation,
+							const std::vector<double>& rotation, const std::vector<double>& scale);
+
+// Elements of an accessor as floats, whatever their component type, normalization and stride
+// (quantized attributes, KHR_mesh_quantization)
+struct AccessorReader {
+	const unsigned char* data = nullptr;
+	size_t stride = 0;
+	size_t count = 0;
+	int componentType = 0;
+	int components = 0;
+	bool normalized = false;
+
+	AccessorReader() = default;
+	// Throws if the accessor does not fit in its buffer view and buffer
+	AccessorReader(const GltfDocument& document, int accessor);
+	bool isFloat() const { return componentType == GLTF_FLOAT; }
+	glm::vec4 operator[](size_t i) const;
+	// Element i of an accessor of indices (unsigned byte, short or int)
+	uint32_t index(size_t i) const;
+};
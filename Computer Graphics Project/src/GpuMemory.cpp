@@ -0,0 +1,129 @@
+#include "GpuMemory.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+const char* memoryCategoryNames[MEMORY_CATEGORIES_NUM] = { "mesh", "texture", "uniform", "attachment", "staging" };
+
+static double toMB(VkDeviceSize bytes) {
+	return bytes / (1024.0 * 1024.0);
+}
+
+void GpuMemoryTracker::Usage::add(VkDeviceSize size) {
+	live += size;
+	peak = std::max(peak, live);
+	count++;
+}
+
+void GpuMemoryTracker::Usage::remove(VkDeviceSize size) {
+	live -= size;
+	count--;
+}
+
+void GpuMemoryTracker::init(VkInstance instance, VkPhysicalDevice physDev, bool budgetEnabled) {
+	physicalDevice = physDev;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	// The budget is read through vkGetPhysicalDeviceMemoryProperties2, from VK_KHR_get_physical_device_properties2
+	if (budgetEnabled) {
+		getMemoryProperties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)
+			vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2KHR");
+	}
+}
+
+void GpuMemoryTracker::allocated(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryType,
+								 MemoryCategory category, const std::string& owner) {
+	std::lock_guard<std::mutex> guard(lock);
+	uint32_t heap = memoryProperties.memoryTypes[memoryType].heapIndex;
+	allocations[memory] = Allocation{ size, heap, category, owner };
+	heaps[heap].add(size);
+	categories[category].add(size);
+	total.add(size);
+}
+
+void GpuMemoryTracker::freed(VkDeviceMemory memory) {
+	std::lock_guard<std::mutex> guard(lock);
+	auto it = allocations.find(memory);
+	if (it == allocations.end()) {
+		return;
+	}
+	heaps[it->second.heap].remove(it->second.size);
+	categories[it->second.category].remove(it->second.size);
+	total.remove(it->second.size);
+	allocations.erase(it);
+}
+
+VkDeviceSize GpuMemoryTracker::liveBytes() const {
+	std::lock_guard<std::mutex> guard(lock);
+	return total.live;
+}
+
+void GpuMemoryTracker::report(std::ostream& out) {
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+	budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+	if (getMemoryProperties2 != nullptr) {
+		VkPhysicalDeviceMemoryProperties2KHR properties{};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+		properties.pNext = &budget;
+		getMemoryProperties2(physicalDevice, &properties);
+	}
+
+	std::lock_guard<std::mutex> guard(lock);
+	std::ios oldState(nullptr);
+	oldState.copyfmt(out);
+	out << std::fixed << std::setprecision(2);
+
+	out << "GPU memory: " << toMB(total.live) << " MB in " << total.count << " allocations, peak " << toMB(total.peak) << " MB\n";
+	out << "heap         size MB   live MB   peak MB";
+	if (getMemoryProperties2 != nullptr) {
+		out << "  process MB  budget MB";
+	}
+	out << "\n";
+	for (uint32_t h = 0; h < memoryProperties.memoryHeapCount; h++) {
+		bool local = memoryProperties.memoryHeaps[h].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+		out << std::setw(2) << h << (local ? " device" : " host  ")
+			<< std::setw(13) << toMB(memoryProperties.memoryHeaps[h].size)
+			<< std::setw(10) << toMB(heaps[h].live) << std::setw(10) << toMB(heaps[h].peak);
+		if (getMemoryProperties2 != nullptr) {
+			out << std::setw(12) << toMB(budget.heapUsage[h]) << std::setw(11) << toMB(budget.heapBudget[h]);
+		}
+		out << "\n";
+	}
+
+	out << "category       live MB   peak MB  allocations\n";
+	for (int c = 0; c < MEMORY_CATEGORIES_NUM; c++) {
+		out << std::left << std::setw(10) << memoryCategoryNames[c] << std::right
+			<< std::setw(12) << toMB(categories[c].live) << std::setw(10) << toMB(categories[c].peak)
+			<< std::setw(13) << categories[c].count << "\n";
+	}
+
+	// Live bytes of every owner, largest first
+	std::map<std::pair<std::string, int>, VkDeviceSize> owners;
+	for (const auto& a : allocations) {
+		owners[{ a.second.owner, a.second.category }] += a.second.size;
+	}
+	std::vector<std::pair<VkDeviceSize, std::pair<std::string, int>>> sorted;
+	for (const auto& o : owners) {
+		sorted.push_back({ o.second, o.first });
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+	out << "live MB  category    owner\n";
+	for (const auto& s : sorted) {
+		out << std::setw(7) << toMB(s.first) << "  " << std::left << std::setw(10) << memoryCategoryNames[s.second.second]
+			<< std::right << "  " << s.second.first << "\n";
+	}
+
+	out.copyfmt(oldState);
+}
+
+void GpuMemoryTracker::writeReport(const std::string& path) {
+	std::ofstream file(path);
+	if (!file) {
+		throw std::runtime_error("failed to open memory report file!");
+	}
+	report(file);
+}
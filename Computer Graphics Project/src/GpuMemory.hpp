@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include "VulkanRecorder.hpp"
+
+// What an allocation is used for
+enum MemoryCategory { MEMORY_MESH, MEMORY_TEXTURE, MEMORY_UNIFORM, MEMORY_ATTACHMENT, MEMORY_STAGING, MEMORY_CATEGORIES_NUM };
+extern const char* memoryCategoryNames[MEMORY_CATEGORIES_NUM];
+
+// Bookkeeping of every VkDeviceMemory of the application: category and owning asset of each allocation,
+// live and peak bytes per memory heap and per category. When VK_EXT_memory_budget is enabled the report
+// also shows what the driver says about the whole process and how much it can still allocate.
+class GpuMemoryTracker {
+public:
+	// Read the memory heaps of the device; budgetEnabled tells if VK_EXT_memory_budget was enabled on the device
+	void init(VkInstance instance, VkPhysicalDevice physicalDevice, bool budgetEnabled);
+
+	void allocated(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryType, MemoryCategory category, const std::string& owner);
+	void freed(VkDeviceMemory memory);
+
+	VkDeviceSize liveBytes() const;
+
+	// Heaps, categories and the assets sorted by size
+	void report(std::ostream& out);
+	void writeReport(const std::string& path);
+
+private:
+	struct Allocation {
+		VkDeviceSize size;
+		uint32_t heap;
+		MemoryCategory category;
+		std::string owner;
+	};
+
+	struct Usage {
+		VkDeviceSize live = 0;
+		VkDeviceSize peak = 0;
+		uint32_t count = 0;
+
+		void add(VkDeviceSize size);
+		void remove(VkDeviceSize size);
+	};
+
+	mutable std::mutex lock;
+	std::unordered_map<VkDeviceMemory, Allocation> allocations;
+
+	VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+	VkPhysicalDeviceMemoryProperties memoryProperties{};
+	PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = nullptr;
+
+	Usage heaps[VK_MAX_MEMORY_HEAPS];
+	Usage categories[MEMORY_CATEGORIES_NUM];
+	Usage total;
+};
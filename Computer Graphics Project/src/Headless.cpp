@@ -0,0 +1,102 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "Headless.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <vector>
+
+#include "InputRecording.hpp"
+
+bool ScriptedInput::next(FrameInput& in) {
+	if (frame >= frames) {
+		return false;
+	}
+
+	float t = frame * deltaT;
+	in = FrameInput();
+	in.deltaT = deltaT;
+
+	// Enter is only read on the menu screens: pressing it once a second restarts the game after a win or a loss
+	in.start = (frame % 60) == 0;
+
+	// Walk along a slowly turning path and look around
+	in.m = glm::vec3(std::sin(t * 0.7f), 0.0f, std::cos(t * 0.5f));
+	in.r = glm::vec3(0.1f * std::sin(t * 0.3f), 0.3f * std::sin(t * 0.2f), 0.0f);
+
+	// Sprint every other 5 seconds
+	if ((frame / 300) % 2 == 1) {
+		in.keys |= 1u << SIM_KEY_SHIFT;
+	}
+
+	// Every 97 frames hold one of the toggle keys for 3 frames
+	static const SimKey toggles[] = { SIM_KEY_P, SIM_KEY_O, SIM_KEY_V, SIM_KEY_L, SIM_KEY_1, SIM_KEY_2, SIM_KEY_3, SIM_KEY_4 };
+	const int togglesNum = sizeof(toggles) / sizeof(toggles[0]);
+	if (frame % 97 < 3) {
+		in.keys |= 1u << toggles[(frame / 97) % togglesNum];
+	}
+
+	frame++;
+	return true;
+}
+
+void printTimingRow(std::ostream& out, const char* name, std::vector<double>& samplesMs) {
+	if (samplesMs.empty()) {
+		return;
+	}
+	std::sort(samplesMs.begin(), samplesMs.end());
+	auto percentile = [&](double p) {
+		return samplesMs[std::min(samplesMs.size() - 1, static_cast<size_t>(p * samplesMs.size()))] * 1000.0;
+	};
+	out << std::left << std::setw(14) << name << std::right << std::fixed << std::setprecision(2)
+		<< std::setw(10) << percentile(0.50)
+		<< std::setw(10) << percentile(0.90)
+		<< std::setw(10) << percentile(0.99)
+		<< std::setw(10) << samplesMs.back() * 1000.0 << "\n";
+}
+
+void runHeadless(InputSource& input, uint64_t seed, std::ostream& out, InputRecorder* recorder) {
+	GameSimulation sim;
+	sim.verbose = false;
+	sim.placementSeed = seed;
+	sim.init();
+
+	FrameInput in;
+	int frames = 0;
+
+	// One column per stage plus the whole step
+	std::vector<double> samples[SIM_STAGES_NUM + 1];
+
+	auto start = std::chrono::steady_clock::now();
+	while (input.next(in)) {
+		double stageMs[SIM_STAGES_NUM];
+		auto frameStart = std::chrono::steady_clock::now();
+		sim.step(in, stageMs);
+		samples[SIM_STAGES_NUM].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+		for (int s = 0; s < SIM_STAGES_NUM; s++) {
+			samples[s].push_back(stageMs[s]);
+		}
+
+		uint64_t hash = sim.stateHash();
+		input.verify(hash);
+		if (recorder != nullptr) {
+			recorder->record(in, hash);
+		}
+		frames++;
+	}
+	double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	out << "Headless run: " << frames << " frames, seed " << seed << "\n";
+	out << std::fixed << std::setprecision(1) << "total " << totalMs << " ms, "
+		<< (totalMs > 0.0 ? frames * 1000.0 / totalMs : 0.0) << " frames/s\n";
+	out << "stage              p50 us    p90 us    p99 us    max us\n";
+	for (int s = 0; s < SIM_STAGES_NUM; s++) {
+		printTimingRow(out, simStageNames[s], samples[s]);
+	}
+	printTimingRow(out, "frame", samples[SIM_STAGES_NUM]);
+	out << "game state " << sim.gameState << ", collected " << sim.collected.count() << "/" << COLLECTIBLES_NUM
+		<< ", final state hash " << std::hex << sim.stateHash() << std::dec << std::endl;
+}
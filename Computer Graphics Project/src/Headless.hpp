@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "Simulation.hpp"
+
+// Deterministic input for the headless runs: starts a game, wanders around the house
+// changing direction and camera, and taps the toggle keys from time to time
+class ScriptedInput : public InputSource {
+public:
+	ScriptedInput(int frames, float deltaT = 1.0f / 60.0f) : frames(frames), deltaT(deltaT) {}
+
+	bool next(FrameInput& in) override;
+
+private:
+	int frames;
+	float deltaT;
+	int frame = 0;
+};
+
+class InputRecorder;
+
+// Run the game logic with no window and no Vulkan, as fast as possible, until the input ends,
+// and print the timing percentiles of every stage of the simulation.
+// If a recorder is given, the input and the state hash of every frame are saved too
+void runHeadless(InputSource& input, uint64_t seed, std::ostream& out, InputRecorder* recorder = nullptr);
+
+// Print a line with p50, p90, p99 and max (in microseconds) of timing samples given in ms. Sorts the samples
+void printTimingRow(std::ostream& out, const char* name, std::vector<double>& samplesMs);
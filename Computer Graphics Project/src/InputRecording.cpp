@@ -0,0 +1,123 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "InputRecording.hpp"
+
+#include <stdexcept>
+
+#include "Logger.hpp"
+
+static const char RECORDING_MAGIC[4] = { 'P', 'P', 'I', 'N' };
+static const uint32_t RECORDING_VERSION = 1;
+
+enum RecordFlags : uint8_t {
+	RECORD_FIRE = 1 << 0,
+	RECORD_START = 1 << 1,
+	RECORD_MOTION = 1 << 2,
+	RECORD_ROTATION = 1 << 3
+};
+
+static_assert(SIM_KEYS_NUM <= 16, "held keys are stored in 16 bits");
+
+template <typename T>
+static void write(std::ofstream& f, const T& v) {
+	f.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <typename T>
+static bool read(std::ifstream& f, T& v) {
+	return static_cast<bool>(f.read(reinterpret_cast<char*>(&v), sizeof(T)));
+}
+
+void InputRecorder::open(const std::string& path, uint64_t seed) {
+	file.open(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to create input recording " + path);
+	}
+	file.write(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+	write(file, RECORDING_VERSION);
+	write(file, seed);
+	frames = 0;
+	LOG_INFO("Recording input to %s", path.c_str());
+}
+
+void InputRecorder::record(const FrameInput& in, uint64_t stateHash) {
+	if (!file.is_open()) {
+		return;
+	}
+
+	// Most frames have no motion or no rotation at all: only store the vectors that are used
+	uint8_t flags = (in.fire ? RECORD_FIRE : 0) | (in.start ? RECORD_START : 0) |
+		(in.m != glm::vec3(0.0f) ? RECORD_MOTION : 0) | (in.r != glm::vec3(0.0f) ? RECORD_ROTATION : 0);
+	write(file, flags);
+	write(file, in.deltaT);
+	if (flags & RECORD_MOTION) {
+		write(file, in.m);
+	}
+	if (flags & RECORD_ROTATION) {
+		write(file, in.r);
+	}
+	write(file, static_cast<uint16_t>(in.keys));
+	write(file, stateHash);
+	frames++;
+}
+
+void InputRecorder::close() {
+	if (file.is_open()) {
+		file.close();
+		LOG_INFO("Input recording closed after %llu frames", static_cast<unsigned long long>(frames));
+	}
+}
+
+void ReplayInput::open(const std::string& path) {
+	file.open(path, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to open input recording " + path);
+	}
+
+	char magic[sizeof(RECORDING_MAGIC)];
+	uint32_t version = 0;
+	if (!file.read(magic, sizeof(magic)) || std::string(magic, sizeof(magic)) != std::string(RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) ||
+		!read(file, version) || version != RECORDING_VERSION || !read(file, recordedSeed)) {
+		throw std::runtime_error(path + " is not an input recording of this version");
+	}
+	frame = 0;
+	diverged = 0;
+}
+
+bool ReplayInput::next(FrameInput& in) {
+	uint8_t flags;
+	uint16_t keys;
+	in = FrameInput();
+
+	if (!file.is_open() || !read(file, flags)) {
+		return false;
+	}
+	bool ok = read(file, in.deltaT);
+	if (flags & RECORD_MOTION) {
+		ok = ok && read(file, in.m);
+	}
+	if (flags & RECORD_ROTATION) {
+		ok = ok && read(file, in.r);
+	}
+	ok = ok && read(file, keys) && read(file, expectedHash);
+	if (!ok) {
+		LOG_WARN("Input recording truncated at frame %d", frame);
+		return false;
+	}
+
+	in.fire = (flags & RECORD_FIRE) != 0;
+	in.start = (flags & RECORD_START) != 0;
+	in.keys = keys;
+	frame++;
+	return true;
+}
+
+void ReplayInput::verify(uint64_t stateHash) {
+	if (stateHash != expectedHash) {
+		if (diverged == 0) {
+			LOG_WARN("Replay diverged from the recording at frame %d", frame);
+		}
+		diverged++;
+	}
+}
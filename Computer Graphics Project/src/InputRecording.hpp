@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include "Simulation.hpp"
+
+// Binary log of the input of a session, to replay it frame by frame.
+// Layout (little endian): "PPIN", uint32 version, uint64 placement seed, then one record per frame:
+//   uint8 flags (fire, start, m present, r present), float deltaT, [float m[3]], [float r[3]],
+//   uint16 held keys (bit SimKey), uint64 hash of the game state after the frame
+class InputRecorder {
+public:
+	~InputRecorder() { close(); }
+
+	void open(const std::string& path, uint64_t seed);
+	void record(const FrameInput& in, uint64_t stateHash);
+	void close();
+	bool isOpen() const { return file.is_open(); }
+
+private:
+	std::ofstream file;
+	uint64_t frames = 0;
+};
+
+// Feeds a recording back to the simulation and checks that every frame ends in the recorded state
+class ReplayInput : public InputSource {
+public:
+	void open(const std::string& path);
+	void close() { file.close(); }
+	bool isOpen() const { return file.is_open(); }
+
+	// Placement seed of the recorded session
+	uint64_t seed() const { return recordedSeed; }
+
+	bool next(FrameInput& in) override;
+	void verify(uint64_t stateHash) override;
+
+	int framesRead() const { return frame; }
+	int mismatches() const { return diverged; }
+
+private:
+	std::ifstream file;
+	uint64_t recordedSeed = 0;
+	uint64_t expectedHash = 0;
+	int frame = 0;
+	int diverged = 0;
+};
@@ -0,0 +1,340 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// Index of the queue owned by the current thread (0 for the main thread and any thread not created by a system),
+// and the system that created it: a worker of another system has no queue in this one
+static thread_local int tlsThreadIndex = 0;
+static thread_local const JobSystem* tlsOwner = nullptr;
+
+static uint64_t nowNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int JobSystem::currentThreadIndex() {
+	return tlsThreadIndex;
+}
+
+int JobSystem::localQueue() const {
+	return tlsOwner == this ? tlsThreadIndex : 0;
+}
+
+JobSystem::~JobSystem() {
+	cleanup();
+}
+
+void JobSystem::init(int workerNum) {
+	if (!queues.empty()) {
+		return;
+	}
+
+	if (workerNum < 0) {
+		workerNum = std::max(0, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+	}
+
+	stopping = false;
+	for (int i = 0; i <= workerNum; i++) {
+		queues.push_back(std::make_unique<WorkQueue>());
+	}
+	for (int i = 1; i <= workerNum; i++) {
+		workers.emplace_back(&JobSystem::workerLoop, this, i);
+	}
+}
+
+void JobSystem::cleanup() {
+	if (queues.empty()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> l(sleepLock);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+
+	for (auto& t : workers) {
+		t.join();
+	}
+	workers.clear();
+
+	// Jobs queued after the workers left (or with no workers at all) still have to run
+	while (tryRunOne(0)) {}
+
+	queues.clear();
+	stopping = false;
+}
+
+void JobSystem::run(const char* name, std::function<void()> fn, JobCounter* counter, JobCounter* dependsOn) {
+	Job job{ std::move(fn), name, counter };
+
+	if (counter != nullptr) {
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (dependsOn != nullptr) {
+		std::lock_guard<std::mutex> l(dependsOn->lock);
+		if (!dependsOn->done()) {
+			dependsOn->continuations.push_back(std::move(job));
+			return;
+		}
+	}
+
+	enqueue(std::move(job));
+}
+
+void JobSystem::wait(JobCounter* counter) {
+	int q = localQueue();
+	while (!counter->done()) {
+		if (!tryRunOne(q)) {
+			std::this_thread::yield();
+		}
+	}
+
+	std::exception_ptr e;
+	{
+		std::lock_guard<std::mutex> l(counter->lock);
+		std::swap(e, counter->error);
+	}
+	if (e) {
+		std::rethrow_exception(e);
+	}
+}
+
+void JobSystem::parallelFor(const char* name, int begin, int end, int grain, const std::function<void(int, int)>& fn) {
+	int count = end - begin;
+	grain = std::max(1, grain);
+
+	if (count <= grain || workers.empty()) {
+		if (count > 0) {
+			fn(begin, end);
+		}
+		return;
+	}
+
+	// No more chunks than needed to keep every thread busy with some slack for stealing
+	int chunks = std::min((count + grain - 1) / grain, threadCount() * 4);
+	int chunkSize = (count + chunks - 1) / chunks;
+
+	JobCounter counter;
+	for (int b = begin + chunkSize; b < end; b += chunkSize) {
+		int e = std::min(b + chunkSize, end);
+		run(name, [&fn, b, e]() { fn(b, e); }, &counter);
+	}
+
+	// The caller takes the first chunk itself. If it throws, the other chunks still reference fn and counter:
+	// let them finish before the exception leaves this frame
+	bool trace = tracing.load(std::memory_order_relaxed);
+	uint64_t start = trace ? nowNs() : 0;
+	try {
+		fn(begin, std::min(begin + chunkSize, end));
+	}
+	catch (...) {
+		try {
+			wait(&counter);
+		}
+		catch (...) {
+			// Only the first error is reported, and the caller's came first
+		}
+		throw;
+	}
+	if (trace) {
+		traceHook(name, localQueue(), start, nowNs());
+	}
+
+	wait(&counter);
+}
+
+void JobSystem::enqueue(Job job) {
+	if (queues.empty()) {
+		// Not started: behave as a plain function call
+		execute(job, 0);
+		return;
+	}
+
+	int q = localQueue();
+	{
+		std::lock_guard<std::mutex> l(queues[q]->lock);
+		queues[q]->jobs.push_back(std::move(job));
+	}
+	queuedJobs.fetch_add(1, std::memory_order_release);
+
+	{
+		std::lock_guard<std::mutex> l(sleepLock);
+	}
+	wakeUp.notify_one();
+}
+
+bool JobSystem::popOrSteal(int threadIndex, Job& job) {
+	int n = static_cast<int>(queues.size());
+	if (n == 0 || queuedJobs.load(std::memory_order_acquire) == 0) {
+		return false;
+	}
+
+	// Own queue first, newest job (still hot in cache)
+	{
+		WorkQueue& own = *queues[threadIndex];
+		std::lock_guard<std::mutex> l(own.lock);
+		if (!own.jobs.empty()) {
+			job = std::move(own.jobs.back());
+			own.jobs.pop_back();
+			queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	// Then steal the oldest job of somebody else
+	for (int i = 1; i < n; i++) {
+		WorkQueue& victim = *queues[(threadIndex + i) % n];
+		std::lock_guard<std::mutex> l(victim.lock);
+		if (!victim.jobs.empty()) {
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool JobSystem::tryRunOne(int threadIndex) {
+	Job job;
+	if (!popOrSteal(threadIndex, job)) {
+		return false;
+	}
+	execute(job, threadIndex);
+	return true;
+}
+
+void JobSystem::execute(Job& job, int threadIndex) {
+	bool trace = tracing.load(std::memory_order_relaxed);
+	uint64_t start = trace ? nowNs() : 0;
+
+	try {
+		job.fn();
+	}
+	catch (...) {
+		if (job.counter != nullptr) {
+			std::lock_guard<std::mutex> l(job.counter->lock);
+			if (!job.counter->error) {
+				job.counter->error = std::current_exception();
+			}
+		}
+	}
+
+	if (trace) {
+		traceHook(job.name, threadIndex, start, nowNs());
+	}
+
+	finish(job.counter);
+}
+
+void JobSystem::finish(JobCounter* counter) {
+	if (counter == nullptr) {
+		return;
+	}
+
+	// The decrement happens under the lock: wait() takes it too before returning, so the
+	// counter (often a local of the waiting function) is never touched after it goes out of scope
+	std::vector<Job> ready;
+	{
+		std::lock_guard<std::mutex> l(counter->lock);
+		if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			ready.swap(counter->continuations);
+		}
+	}
+	for (auto& job : ready) {
+		enqueue(std::move(job));
+	}
+}
+
+void JobSystem::workerLoop(int threadIndex) {
+	tlsThreadIndex = threadIndex;
+	tlsOwner = this;
+
+	while (true) {
+		if (tryRunOne(threadIndex)) {
+			continue;
+		}
+
+		std::unique_lock<std::mutex> l(sleepLock);
+		wakeUp.wait(l, [this]() { return stopping || queuedJobs.load(std::memory_order_acquire) > 0; });
+		if (stopping && queuedJobs.load(std::memory_order_acquire) == 0) {
+			return;
+		}
+	}
+}
+
+// SCALING BENCHMARK
+
+void JobSystem::runScalingBenchmark(std::ostream& out) {
+	// Same math placeEntity() does for every object, on a lot more objects
+	const int ITEMS = 1 << 17;
+	const int REPEAT = 5;
+
+	std::vector<glm::vec3> pos(ITEMS), rot(ITEMS);
+	std::vector<glm::mat4> mvp(ITEMS), nMat(ITEMS);
+	for (int i = 0; i < ITEMS; i++) {
+		pos[i] = glm::vec3(i % 24 - 12.0f, 0.0f, (i / 24) % 24 - 12.0f);
+		rot[i] = glm::vec3(0.0f, i * 0.01f, 0.0f);
+	}
+	glm::mat4 ViewPrj = glm::perspective(glm::radians(60.0f), 1.5f, 0.1f, 30.0f) *
+		glm::lookAt(glm::vec3(0, 5, 10), glm::vec3(0), glm::vec3(0, 1, 0));
+
+	auto transforms = [&](int b, int e) {
+		for (int i = b; i < e; i++) {
+			glm::mat4 World = glm::translate(glm::mat4(1), pos[i]) *
+				glm::rotate(glm::mat4(1), rot[i].x, glm::vec3(1, 0, 0)) *
+				glm::rotate(glm::mat4(1), rot[i].y, glm::vec3(0, 1, 0)) *
+				glm::rotate(glm::mat4(1), rot[i].z, glm::vec3(0, 0, 1));
+			mvp[i] = ViewPrj * World;
+			nMat[i] = glm::transpose(glm::inverse(World));
+		}
+	};
+
+	int maxThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	double baseMs = 0.0;
+
+	out << "Job system scaling: " << ITEMS << " transforms, best of " << REPEAT << " runs\n";
+	out << "threads        ms   speedup  efficiency\n";
+	for (int threads = 1; threads <= maxThreads; threads++) {
+		JobSystem js;
+		js.init(threads - 1);
+
+		double bestMs = 1e30;
+		for (int r = 0; r <= REPEAT; r++) {
+			auto start = std::chrono::steady_clock::now();
+			js.parallelFor("transforms", 0, ITEMS, 512, transforms);
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			if (r > 0) {	// run 0 warms up caches and threads
+				bestMs = std::min(bestMs, ms);
+			}
+		}
+		js.cleanup();
+
+		if (threads == 1) {
+			baseMs = bestMs;
+		}
+		double speedup = baseMs / bestMs;
+		out << std::setw(7) << threads << std::fixed << std::setprecision(3)
+			<< std::setw(10) << bestMs
+			<< std::setw(10) << speedup
+			<< std::setw(11) << std::setprecision(1) << 100.0 * speedup / threads << "%\n";
+	}
+
+	// Keep the results alive so the optimizer cannot drop the work
+	float checksum = 0.0f;
+	for (int i = 0; i < ITEMS; i += 4096) {
+		checksum += mvp[i][3][3] + nMat[i][0][0];
+	}
+	out << "checksum " << checksum << std::endl;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+struct JobCounter;
+
+// A unit of work: the function to run, a name for the trace and the counter to signal when done
+struct Job {
+	std::function<void()> fn;
+	const char* name = nullptr;
+	JobCounter* counter = nullptr;
+};
+
+// Counts the jobs still pending in a group. Jobs submitted with a counter as dependency
+// are parked here and released on the queues when the counter drops to zero.
+struct JobCounter {
+	std::atomic<int> pending{0};
+	std::mutex lock;
+	std::vector<Job> continuations;
+	std::exception_ptr error;			// first exception thrown by a job of the group
+
+	bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+// Called after every job with its name, the thread that ran it (0 = main) and its start/end time in ns
+using JobTraceHook = std::function<void(const char* name, int threadIndex, uint64_t startNs, uint64_t endNs)>;
+
+// Work-stealing job system: every thread owns a deque, pushes and pops at the back of its own
+// and steals from the front of the others when it runs out of work.
+// The thread calling wait() helps executing jobs, so waiting never blocks a core.
+// It runs the loading (OBJ parsing, MGCG decoding) and the offline tools (asset and texture packs, tangent bake).
+// A frame has a few dozen transforms and collision tests, cheaper inline than split into jobs.
+class JobSystem {
+public:
+	~JobSystem();
+
+	// Start the workers (-1 = one per hardware thread minus the main one, 0 = everything runs inside wait())
+	void init(int workers = -1);
+	// Drain the queues and join the workers
+	void cleanup();
+
+	// Queue a job. If dependsOn is given, the job is started only once that counter reaches zero
+	void run(const char* name, std::function<void()> fn, JobCounter* counter = nullptr, JobCounter* dependsOn = nullptr);
+
+	// Execute jobs until the counter reaches zero, then rethrow the first error of the group (if any)
+	void wait(JobCounter* counter);
+
+	// Split [begin, end) into chunks of at least grain elements and run fn(chunkBegin, chunkEnd) on them.
+	// Ranges no larger than grain are executed inline on the calling thread.
+	void parallelFor(const char* name, int begin, int end, int grain, const std::function<void(int, int)>& fn);
+
+	int workerCount() const { return static_cast<int>(workers.size()); }
+	int threadCount() const { return workerCount() + 1; }
+
+	// The hook is installed before init() and called only while tracing is on, which can change at any time:
+	// with tracing off a job pays a relaxed load instead of two clock reads and a call
+	void setTraceHook(JobTraceHook hook) { traceHook = std::move(hook); }
+	void setTracing(bool on) { tracing.store(on && traceHook, std::memory_order_relaxed); }
+
+	// Index of the calling thread: 0 for the main thread (and threads not owned by a job system), 1..N for the workers
+	static int currentThreadIndex();
+
+	// Time a CPU-bound transform workload with 1 to N threads and print the speedup table
+	static void runScalingBenchmark(std::ostream& out);
+
+private:
+	struct WorkQueue {
+		std::deque<Job> jobs;
+		std::mutex lock;
+	};
+
+	std::vector<std::thread> workers;
+	std::vector<std::unique_ptr<WorkQueue>> queues;		// queues[0] is used by the main thread and external callers
+
+	std::atomic<int> queuedJobs{0};
+	std::atomic<bool> stopping{false};
+	std::mutex sleepLock;
+	std::condition_variable wakeUp;
+
+	JobTraceHook traceHook;
+	std::atomic<bool> tracing{false};
+
+	// Queue of the calling thread in this system: its own for the workers, 0 for everybody else
+	int localQueue() const;
+	void enqueue(Job job);
+	bool tryRunOne(int threadIndex);
+	bool popOrSteal(int threadIndex, Job& job);
+	void execute(Job& job, int threadIndex);
+	void finish(JobCounter* counter);
+	void workerLoop(int threadIndex);
+};
@@ -0,0 +1,177 @@
+#include "Logger.hpp"
+
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+static const char* levelNames[] = { "DEBUG", "INFO ", "WARN ", "ERROR" };
+
+Logger& Logger::instance() {
+	static Logger logger;
+	return logger;
+}
+
+Logger::Logger() {
+	for (size_t i = 0; i < CAPACITY; i++) {
+		slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+	startNs = nowNs();
+	running.store(true);
+	writer = std::thread(&Logger::writerLoop, this);
+}
+
+Logger::~Logger() {
+	shutdown();
+}
+
+uint64_t Logger::nowNs() {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool Logger::rateLimit(uint64_t hash, uint64_t now, uint32_t& suppressedBefore) {
+	RateEntry& r = rates[hash % RATE_ENTRIES];
+	suppressedBefore = 0;
+
+	// Two messages sharing an entry just reset each other's window
+	if (r.hash.exchange(hash, std::memory_order_relaxed) != hash) {
+		r.windowStart.store(now, std::memory_order_relaxed);
+		r.count.store(0, std::memory_order_relaxed);
+		r.suppressed.store(0, std::memory_order_relaxed);
+	}
+
+	uint64_t windowStart = r.windowStart.load(std::memory_order_relaxed);
+	if (now - windowStart > RATE_WINDOW_NS &&
+		r.windowStart.compare_exchange_strong(windowStart, now, std::memory_order_relaxed)) {
+		r.count.store(0, std::memory_order_relaxed);
+		suppressedBefore = r.suppressed.exchange(0, std::memory_order_relaxed);
+	}
+
+	if (r.count.fetch_add(1, std::memory_order_relaxed) >= RATE_BURST) {
+		r.suppressed.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	return true;
+}
+
+void Logger::log(LogLevel level, const char* fmt, ...) {
+	if (level < minLevel.load(std::memory_order_relaxed)) return;
+
+	uint64_t now = nowNs();
+	char text[MESSAGE_SIZE];
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(text, MESSAGE_SIZE, fmt, args);
+	va_end(args);
+
+	// FNV-1a of the text, to recognize repeated messages
+	uint64_t hash = 14695981039346656037ull;
+	for (const char* c = text; *c; c++) {
+		hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ull;
+	}
+	uint32_t suppressedBefore;
+	if (!rateLimit(hash, now, suppressedBefore)) return;
+
+	// Claim a slot: it is free when its sequence equals the write position
+	uint64_t pos = writeIndex.load(std::memory_order_relaxed);
+	Slot* slot;
+	for (;;) {
+		slot = &slots[pos % CAPACITY];
+		uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+		int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+		if (diff == 0) {
+			if (writeIndex.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+		} else if (diff < 0) {
+			// Still holding a message from the previous lap: the ring is full
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		} else {
+			pos = writeIndex.load(std::memory_order_relaxed);
+		}
+	}
+
+	slot->timeNs = now;
+	slot->level = level;
+	slot->suppressed = suppressedBefore;
+	memcpy(slot->text, text, MESSAGE_SIZE);
+
+	// Publish it to the writer
+	slot->sequence.store(pos + 1, std::memory_order_release);
+}
+
+void Logger::openFile(const std::string& path) {
+	// The file is opened by the writer thread, the only one touching it
+	filePath = path;
+	fileRequested.store(true, std::memory_order_release);
+}
+
+bool Logger::writePending() {
+	if (fileRequested.exchange(false, std::memory_order_acquire)) {
+		file.open(filePath);
+		if (!file) {
+			std::cerr << "Failed to open log file " << filePath << "\n";
+		}
+	}
+
+	bool wrote = false;
+	uint64_t pos = readIndex.load(std::memory_order_relaxed);
+	char line[MESSAGE_SIZE + 64];
+	for (;;) {
+		Slot& slot = slots[pos % CAPACITY];
+		if (slot.sequence.load(std::memory_order_acquire) != pos + 1) break;
+
+		double seconds = (slot.timeNs - startNs) * 1e-9;
+		int n = snprintf(line, sizeof(line), "[%10.3f] %s %s", seconds, levelNames[slot.level], slot.text);
+		if (slot.suppressed > 0 && n > 0 && n < (int)sizeof(line)) {
+			snprintf(line + n, sizeof(line) - n, " (%u similar messages suppressed)", slot.suppressed);
+		}
+		LogLevel level = slot.level;
+
+		// Hand the slot back to the producers, one lap ahead
+		slot.sequence.store(pos + CAPACITY, std::memory_order_release);
+		pos++;
+		readIndex.store(pos, std::memory_order_release);
+
+		(level == LOG_LEVEL_ERROR ? std::cerr : std::cout) << line << "\n";
+		if (file.is_open()) file << line << "\n";
+		wrote = true;
+	}
+
+	uint64_t lost = dropped.exchange(0, std::memory_order_relaxed);
+	if (lost > 0) {
+		std::cout << "[logger] " << lost << " messages dropped, the log ring was full\n";
+		if (file.is_open()) file << "[logger] " << lost << " messages dropped, the log ring was full\n";
+		wrote = true;
+	}
+
+	if (wrote) {
+		std::cout.flush();
+		if (file.is_open()) file.flush();
+	}
+	return wrote;
+}
+
+void Logger::writerLoop() {
+	while (running.load(std::memory_order_acquire)) {
+		if (!writePending()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		}
+	}
+	writePending();
+}
+
+void Logger::flush() {
+	uint64_t target = writeIndex.load(std::memory_order_acquire);
+	while (running.load(std::memory_order_acquire) && readIndex.load(std::memory_order_acquire) < target) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+void Logger::shutdown() {
+	if (running.exchange(false)) {
+		writer.join();
+		if (file.is_open()) file.close();
+	}
+}
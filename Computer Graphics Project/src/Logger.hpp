@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+
+enum LogLevel { LOG_LEVEL_DEBUG, LOG_LEVEL_INFO, LOG_LEVEL_WARN, LOG_LEVEL_ERROR };
+
+// Asynchronous logger: any thread formats its message straight into a slot of a lock-free ring
+// (bounded MPSC queue with per-slot sequence numbers) and a background thread writes them out,
+// so a slow terminal or log file never stalls the frame. When the ring is full messages are dropped and counted.
+// The same message repeated more than RATE_BURST times per second is suppressed,
+// the next copy that gets through reports how many were skipped.
+class Logger {
+public:
+	static const size_t CAPACITY = 1024;			// messages in flight
+	static const size_t MESSAGE_SIZE = 240;			// longer messages are truncated
+	static const uint32_t RATE_BURST = 5;
+	static const uint64_t RATE_WINDOW_NS = 1000000000ull;
+
+	static Logger& instance();
+
+	// printf-style
+	void log(LogLevel level, const char* fmt, ...);
+
+	void setLevel(LogLevel level) { minLevel.store(level, std::memory_order_relaxed); }
+	LogLevel level() const { return static_cast<LogLevel>(minLevel.load(std::memory_order_relaxed)); }
+	// Also write the log to a file
+	void openFile(const std::string& path);
+	// Wait until every message logged so far has been written
+	void flush();
+	// Write the pending messages and stop the writer thread
+	void shutdown();
+
+private:
+	Logger();
+	~Logger();
+
+	struct Slot {
+		std::atomic<uint64_t> sequence;
+		uint64_t timeNs;
+		LogLevel level;
+		uint32_t suppressed;		// copies of this message skipped before it
+		char text[MESSAGE_SIZE];
+	};
+
+	struct RateEntry {
+		std::atomic<uint64_t> hash{0};
+		std::atomic<uint64_t> windowStart{0};
+		std::atomic<uint32_t> count{0};
+		std::atomic<uint32_t> suppressed{0};
+	};
+	static const size_t RATE_ENTRIES = 64;
+
+	Slot slots[CAPACITY];
+	std::atomic<uint64_t> writeIndex{0};
+	std::atomic<uint64_t> readIndex{0};
+	std::atomic<uint64_t> dropped{0};
+	std::atomic<int> minLevel{LOG_LEVEL_DEBUG};
+	RateEntry rates[RATE_ENTRIES];
+
+	uint64_t startNs;
+	std::ofstream file;
+	std::atomic<bool> fileRequested{false};
+	std::string filePath;
+	std::thread writer;
+	std::atomic<bool> running{false};
+
+	static uint64_t nowNs();
+	bool rateLimit(uint64_t hash, uint64_t now, uint32_t& suppressedBefore);
+	bool writePending();
+	void writerLoop();
+};
+
+#define LOG_DEBUG(...) Logger::instance().log(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) Logger::instance().log(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...) Logger::instance().log(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) Logger::instance().log(LOG_LEVEL_ERROR, __VA_ARGS__)
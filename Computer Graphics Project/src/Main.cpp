@@ -2,19 +2,293 @@
 #include <iostream>
 #include <exception>
 #include <memory>
+#include <cstring>
+#include <filesystem>
 
 #include "PurrfectPotion.hpp"
+#include "Headless.hpp"
+#include "Benchmark.hpp"
+#include "Logger.hpp"
+#include "AssetPack.hpp"
+#include "TangentBake.hpp"
+#include "TexturePack.hpp"
+
+int main(int argc, char* argv[]) {
+	// --bench-jobs: measure how the job system scales with the number of threads, without opening a window
+	if (argc > 1 && strcmp(argv[1], "--bench-jobs") == 0) {
+		JobSystem::runScalingBenchmark(std::cout);
+		return EXIT_SUCCESS;
+	}
+
+	// --bench: time the loading, math and collision hot paths, without window nor GPU
+	// (--bench-filter TEXT: only the cases whose name contains TEXT; --bench-json FILE: save the results)
+	bool bench = false;
+	const char* benchFilter = "";
+	const char* benchJsonPath = "";
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--bench") == 0) {
+			bench = true;
+		} else if (i + 1 < argc && strcmp(argv[i], "--bench-filter") == 0) {
+			benchFilter = argv[i + 1];
+		} else if (i + 1 < argc && strcmp(argv[i], "--bench-json") == 0) {
+			benchJsonPath = argv[i + 1];
+		}
+	}
+	if (bench) {
+		try {
+			runBenchmarks(benchFilter, std::cout, benchJsonPath);
+		}
+		catch (const std::exception& e) {
+			Logger::instance().flush();
+			std::cerr << e.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+
+	// --build-pack FILE: pack the models, textures and compiled shaders into FILE, to be loaded with --pack
+	for (int i = 1; i + 1 < argc; i++) {
+		if (strcmp(argv[i], "--build-pack") == 0) {
+			try {
+				JobSystem jobs;
+				jobs.init();
+				buildAssetPack(argv[i + 1], { { "models", {} }, { "textures", {} }, { "shaders", { ".spv" } } }, &jobs, std::cout);
+			}
+			catch (const std::exception& e) {
+				Logger::instance().flush();
+				std::cerr << e.what() << std::endl;
+				return EXIT_FAILURE;
+			}
+			return EXIT_SUCCESS;
+		}
+	}
+
+	// --pack-textures: write the normal maps with the roughness (or specular) map of their material in alpha,
+	// that the game loads instead of packing them at startup
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--pack-textures") == 0) {
+			try {
+				JobSystem jobs;
+				jobs.init();
+				packTextures({
+					{ "textures/wall/wall_normal.jpg", "textures/wall/wall_roughness.jpg", "textures/wall/wall_normal_roughness.png" },
+					{ "textures/floor/floor_normal.jpg", "textures/floor/floor_roughness.jpg", "textures/floor/floor_normal_roughness.png" },
+					{ "textures/knight/knight_normal.png", "textures/knight/knight_specular.png", "textures/knight/knight_normal_specular.png" },
+					{ "textures/cat/cat_normal.jpg", "textures/cat/cat_roughness.jpg", "textures/cat/cat_normal_roughness.png" }
+				}, &jobs, std::cout);
+			}
+			catch (const std::exception& e) {
+				Logger::instance().flush();
+				std::cerr << e.what() << std::endl;
+				return EXIT_FAILURE;
+			}
+			return EXIT_SUCCESS;
+		}
+	}
+
+	// --bake-tangents FILE...: add the tangents the normal mapped .gltf/.glb files lack, rewriting them in place
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--bake-tangents") == 0) {
+			std::vector<std::string> files;
+			for (int j = i + 1; j < argc && strncmp(argv[j], "--", 2) != 0; j++) {
+				files.push_back(argv[j]);
+			}
+			try {
+				JobSystem jobs;
+				jobs.init();
+				bakeTangents(files, &jobs, std::cout);
+			}
+			catch (const std::exception& e) {
+				Logger::instance().flush();
+				std::cerr << e.what() << std::endl;
+				return EXIT_FAILURE;
+			}
+			return EXIT_SUCCESS;
+		}
+	}
+
+	// --pack FILE: read the assets from the pack FILE (assets.pack, if it exists), the disk for the files it does not have;
+	// --no-pack: only from the disk
+	const char* packPath = "assets.pack";
+	bool usePack = true;
+	// --seed N: reproducible collectibles placement
+	bool hasSeed = false;
+	uint64_t seed = 0;
+	// --headless N: run N frames of the game logic with a scripted input, without window and Vulkan device
+	// (the simulation builds without the GLFW and Vulkan headers, but this executable still links GLFW and the Vulkan
+	// loader: vulkan-1.dll must be installed, even where there is no GPU)
+	int headlessFrames = 0;
+	// --record FILE: save the input of every frame; --replay FILE: play it back instead of the devices
+	// (with --headless the whole recording is replayed and N is ignored)
+	const char* recordPath = nullptr;
+	const char* replayPath = nullptr;
+	// --profile FILE: profile from the first frame and write a Chrome trace to FILE on exit (F1/F2 toggle and export at any time)
+	const char* profilePath = nullptr;
+	// --memory-report FILE: write the GPU memory usage by heap, category and asset to FILE on exit
+	const char* memoryReportPath = nullptr;
+	// --flythrough N: tour the house for N frames and write the frame and pass times to --flythrough-report FILE (flythrough.json)
+	int flythroughFrames = 0;
+	const char* flythroughReportPath = "flythrough.json";
+	// --offscreen N: render at most N frames (0 = until the flythrough or the replay ends) without a window;
+	// --capture FILE: save the last frame as PNG, or every --capture-every K frames if FILE contains a %d (e.g. frame%05d.png)
+	int offscreenFrames = -1;
+	const char* capturePath = "";
+	int captureEvery = 1;
+	// --vk-record: count and time every Vulkan call; --vk-null: the same on a null device that renders nothing
+	// (offscreen, 300 frames unless --offscreen says otherwise); --vk-report FILE: write the counts as JSON;
+	// --vk-budget FILE: fail if the calls per frame exceed the maximums in FILE
+	const char* vkReportPath = nullptr;
+	const char* vkBudgetPath = nullptr;
+	// --stats: show the stats panel (FPS, CPU/GPU time, draws, uploads, memory, index savings) from the first frame, F4 toggles it
+	bool stats = false;
+	// --overdraw FILE: start with the overdraw heatmap (H cycles the heatmaps) and write the fragments and (at most) the
+	// lights per pixel of every frame to FILE as CSV
+	const char* overdrawPath = nullptr;
+	// --log FILE: also write the log to FILE; --quiet: only warnings and errors
+	for (int i = 1; i + 1 < argc; i++) {
+		if (strcmp(argv[i], "--seed") == 0) {
+			hasSeed = true;
+			seed = strtoull(argv[i + 1], nullptr, 10);
+		} else if (strcmp(argv[i], "--headless") == 0) {
+			headlessFrames = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "--record") == 0) {
+			recordPath = argv[i + 1];
+		} else if (strcmp(argv[i], "--replay") == 0) {
+			replayPath = argv[i + 1];
+		} else if (strcmp(argv[i], "--profile") == 0) {
+			profilePath = argv[i + 1];
+		} else if (strcmp(argv[i], "--memory-report") == 0) {
+			memoryReportPath = argv[i + 1];
+		} else if (strcmp(argv[i], "--flythrough") == 0) {
+			flythroughFrames = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "--flythrough-report") == 0) {
+			flythroughReportPath = argv[i + 1];
+		} else if (strcmp(argv[i], "--offscreen") == 0) {
+			offscreenFrames = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "--capture") == 0) {
+			capturePath = argv[i + 1];
+		} else if (strcmp(argv[i], "--capture-every") == 0) {
+			captureEvery = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "--vk-report") == 0) {
+			vkReportPath = argv[i + 1];
+		} else if (strcmp(argv[i], "--vk-budget") == 0) {
+			vkBudgetPath = argv[i + 1];
+		} else if (strcmp(argv[i], "--overdraw") == 0) {
+			overdrawPath = argv[i + 1];
+		} else if (strcmp(argv[i], "--pack") == 0) {
+			packPath = argv[i + 1];
+		} else if (strcmp(argv[i], "--log") == 0) {
+			Logger::instance().openFile(argv[i + 1]);
+		}
+	}
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--quiet") == 0) {
+			Logger::instance().setLevel(LOG_LEVEL_WARN);
+		} else if (strcmp(argv[i], "--vk-record") == 0) {
+			VulkanRecorder::instance().setMode(VULKAN_MODE_RECORD);
+		} else if (strcmp(argv[i], "--vk-null") == 0) {
+			VulkanRecorder::instance().setMode(VULKAN_MODE_NULL);
+		} else if (strcmp(argv[i], "--stats") == 0) {
+			stats = true;
+		} else if (strcmp(argv[i], "--no-pack") == 0) {
+			usePack = false;
+		}
+	}
+
+	if (usePack && std::filesystem::exists(packPath)) {
+		try {
+			VirtualFileSystem::instance().mount(packPath);
+		}
+		catch (const std::exception& e) {
+			LOG_WARN("Ignoring the asset pack %s: %s", packPath, e.what());
+		}
+	}
+
+	if (headlessFrames > 0) {
+		try {
+			InputRecorder recorder;
+			if (replayPath != nullptr) {
+				ReplayInput input;
+				input.open(replayPath);
+				if (recordPath != nullptr) {
+					recorder.open(recordPath, input.seed());
+				}
+				runHeadless(input, input.seed(), std::cout, recordPath != nullptr ? &recorder : nullptr);
+				std::cout << "Replay: " << input.mismatches() << " of " << input.framesRead() << " frames diverged from the recording" << std::endl;
+				return input.mismatches() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+			}
+
+			ScriptedInput input(headlessFrames);
+			if (recordPath != nullptr) {
+				recorder.open(recordPath, hasSeed ? seed : 1);
+			}
+			runHeadless(input, hasSeed ? seed : 1, std::cout, recordPath != nullptr ? &recorder : nullptr);
+		}
+		catch (const std::exception& e) {
+			Logger::instance().flush();
+			std::cerr << e.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
 
-int main() {
 	std::unique_ptr<PurrfectPotion> app = std::make_unique<PurrfectPotion>();
+	if (hasSeed) {
+		app->setPlacementSeed(seed);
+	} else if (flythroughFrames > 0) {
+		app->setPlacementSeed(1);
+	}
 
 	try {
+		if (recordPath != nullptr) {
+			app->recordInput(recordPath);
+		}
+		if (replayPath != nullptr) {
+			app->replayInput(replayPath);
+		}
+		if (flythroughFrames > 0) {
+			app->runFlythrough(flythroughFrames, flythroughReportPath);
+		}
+		if (profilePath != nullptr) {
+			app->enableProfiler(profilePath);
+		}
+		if (stats) {
+			app->showStats();
+		}
+		if (overdrawPath != nullptr) {
+			app->reportOverdraw(overdrawPath);
+		}
+		if (VulkanRecorder::instance().mode() == VULKAN_MODE_NULL && offscreenFrames < 0) {
+			offscreenFrames = 300;
+		}
+		if (offscreenFrames >= 0) {
+			app->enableOffscreen(offscreenFrames, capturePath, captureEvery);
+		}
+		if (memoryReportPath != nullptr) {
+			app->enableMemoryReport(memoryReportPath);
+		}
 		app->run();
+
+		VulkanRecorder& vulkanRecorder = VulkanRecorder::instance();
+		if (vulkanRecorder.mode() != VULKAN_MODE_DIRECT) {
+			Logger::instance().flush();
+			vulkanRecorder.report(std::cout);
+			if (vkReportPath != nullptr) {
+				vulkanRecorder.writeReport(vkReportPath);
+			}
+			if (vkBudgetPath != nullptr && !vulkanRecorder.checkBudget(vkBudgetPath, std::cerr)) {
+				std::cerr << "Vulkan calls over budget" << std::endl;
+				Logger::instance().shutdown();
+				return EXIT_FAILURE;
+			}
+		}
 	}
 	catch (const std::exception& e) {
+		Logger::instance().flush();
 		std::cerr << e.what() << std::endl;
 		return EXIT_FAILURE;
 	}
 
+	Logger::instance().shutdown();
 	return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "MappedFile.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#include "Logger.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& filename) {
+	open(filename);
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if (this != &other) {
+		close();
+		std::swap(mapped, other.mapped);
+		std::swap(fileSize, other.fileSize);
+#ifdef _WIN32
+		std::swap(fileHandle, other.fileHandle);
+		std::swap(mappingHandle, other.mappingHandle);
+#endif
+	}
+	return *this;
+}
+
+#ifdef _WIN32
+
+void MappedFile::open(const std::string& filename) {
+	close();
+
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		LOG_ERROR("Failed to open: %s", filename.c_str());
+		throw std::runtime_error("failed to open file!");
+	}
+	fileHandle = file;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		close();
+		throw std::runtime_error("failed to read file size!");
+	}
+	fileSize = static_cast<size_t>(size.QuadPart);
+	if (fileSize == 0) {
+		return;
+	}
+
+	mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle == nullptr) {
+		close();
+		throw std::runtime_error("failed to map file!");
+	}
+	mapped = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (mapped == nullptr) {
+		close();
+		throw std::runtime_error("failed to map file!");
+	}
+}
+
+void MappedFile::close() {
+	if (mapped != nullptr) {
+		UnmapViewOfFile(mapped);
+	}
+	if (mappingHandle != nullptr) {
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle != nullptr) {
+		CloseHandle(fileHandle);
+	}
+	mapped = nullptr;
+	fileSize = 0;
+	fileHandle = mappingHandle = nullptr;
+}
+
+#else
+
+void MappedFile::open(const std::string& filename) {
+	close();
+
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) {
+		LOG_ERROR("Failed to open: %s", filename.c_str());
+		throw std::runtime_error("failed to open file!");
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		::close(fd);
+		throw std::runtime_error("failed to read file size!");
+	}
+	if (st.st_size == 0) {
+		::close(fd);
+		return;
+	}
+
+	// The mapping keeps the file referenced, the descriptor is not needed anymore
+	void* address = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (address == MAP_FAILED) {
+		throw std::runtime_error("failed to map file!");
+	}
+	madvise(address, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+	mapped = static_cast<const char*>(address);
+	fileSize = static_cast<size_t>(st.st_size);
+}
+
+void MappedFile::close() {
+	if (mapped != nullptr) {
+		munmap(const_cast<char*>(mapped), fileSize);
+	}
+	mapped = nullptr;
+	fileSize = 0;
+}
+
+#endif
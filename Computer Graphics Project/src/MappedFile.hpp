@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file: the OS pages it in on demand, nothing is copied to the heap.
+// The mapping lives as long as the object; an empty file maps to data() == nullptr and size() == 0.
+class MappedFile {
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::string& filename);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	// Map filename, unmapping the current file first
+	void open(const std::string& filename);
+	void close();
+
+	const char* data() const { return mapped; }
+	size_t size() const { return fileSize; }
+
+private:
+	const char* mapped = nullptr;
+	size_t fileSize = 0;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+};
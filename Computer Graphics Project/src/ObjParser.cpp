@@ -0,0 +1,382 @@
+#include "ObjParser.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+#include "JobSystem.hpp"
+
+namespace {
+
+// Files are split in pieces of at least this size: smaller ones are parsed on the calling thread
+const size_t MIN_PIECE_SIZE = 256 * 1024;
+
+// The powers of ten that are exact in a double
+const double POW10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// A corner as written in the file: positive indices already made 0-based, negative ones counted back from the
+// attributes seen so far in the piece (the relative bit of the component), resolved once the pieces are merged
+struct RawCorner {
+	int index[3] = { -1, -1, -1 };		// position, texture coordinate, normal
+	uint8_t relative = 0;
+};
+
+// A piece of the file, between two line boundaries, and what was parsed from it
+struct Piece {
+	const char* begin = nullptr;
+	const char* end = nullptr;
+
+	std::vector<float> positions, colors, texCoords, normals;
+	std::vector<RawCorner> corners;
+	std::vector<uint8_t> faceSizes;		// 3 or 4 corners
+	size_t triangleCorners = 0;
+
+	// Offsets of the attributes and of the triangle corners of the piece in the merged arrays
+	size_t positionBase = 0, texCoordBase = 0, normalBase = 0, cornerBase = 0;
+
+	const char* error = nullptr;
+};
+
+bool isSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+void skipSpace(const char*& p, const char* end) {
+	while (p < end && isSpace(*p)) {
+		p++;
+	}
+}
+
+bool isDigit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+// Decimal number to float. With at most 19 significant digits and a power of ten up to 1e22 both are exact in a
+// double, so the product (or quotient) is rounded once, like strtod would; anything else goes through strtod
+bool parseFloat(const char*& p, const char* end, float& out) {
+	const char* start = p;
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) {
+		negative = *p == '-';
+		p++;
+	}
+
+	uint64_t mantissa = 0;
+	int digits = 0, exponent = 0;
+	bool any = false;
+	for (; p < end && isDigit(*p); p++) {
+		mantissa = mantissa * 10 + (*p - '0');
+		digits += mantissa != 0;
+		any = true;
+	}
+	if (p < end && *p == '.') {
+		for (p++; p < end && isDigit(*p); p++) {
+			mantissa = mantissa * 10 + (*p - '0');
+			digits += mantissa != 0;
+			exponent--;
+			any = true;
+		}
+	}
+	if (!any) {
+		p = start;
+		return false;
+	}
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		p++;
+		bool negativeExponent = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negativeExponent = *p == '-';
+			p++;
+		}
+		if (p == end || !isDigit(*p)) {
+			return false;
+		}
+		int e = 0;
+		for (; p < end && isDigit(*p); p++) {
+			e = std::min(e * 10 + (*p - '0'), 100000);
+		}
+		exponent += negativeExponent ? -e : e;
+	}
+
+	double value;
+	if (mantissa == 0) {
+		value = 0.0;
+	} else if (digits <= 19 && mantissa < (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+		value = exponent < 0 ? static_cast<double>(mantissa) / POW10[-exponent] : static_cast<double>(mantissa) * POW10[exponent];
+	} else {
+		char buffer[64];
+		size_t length = p - start;
+		if (length >= sizeof(buffer)) {
+			return false;
+		}
+		memcpy(buffer, start, length);
+		buffer[length] = '\0';
+		value = std::fabs(strtod(buffer, nullptr));
+	}
+	out = static_cast<float>(negative ? -value : value);
+	return true;
+}
+
+bool parseInt(const char*& p, const char* end, int& out) {
+	bool negative = p < end && *p == '-';
+	if (negative) {
+		p++;
+	}
+	if (p == end || !isDigit(*p)) {
+		return false;
+	}
+	int64_t v = 0;
+	for (; p < end && isDigit(*p); p++) {
+		v = std::min<int64_t>(v * 10 + (*p - '0'), INT_MAX);
+	}
+	out = static_cast<int>(negative ? -v : v);
+	return true;
+}
+
+// Up to max numbers separated by spaces, the rest of the line ignored; the count read
+int parseFloats(const char*& p, const char* end, float* values, int max, const char*& error) {
+	int n = 0;
+	for (skipSpace(p, end); p < end && n < max; skipSpace(p, end)) {
+		if (!parseFloat(p, end, values[n]) || (p < end && !isSpace(*p))) {
+			error = "malformed number";
+			return n;
+		}
+		n++;
+	}
+	return n;
+}
+
+void parseLine(Piece& piece, const char* p, const char* end) {
+	skipSpace(p, end);
+	if (p + 1 >= end) {
+		return;
+	}
+
+	if (p[0] == 'v' && isSpace(p[1])) {
+		float v[6] = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+		p += 2;
+		if (parseFloats(p, end, v, 6, piece.error) < 6) {
+			v[3] = v[4] = v[5] = 1.0f;		// colors only if all three are there, like tinyobj
+		}
+		piece.positions.insert(piece.positions.end(), v, v + 3);
+		piece.colors.insert(piece.colors.end(), v + 3, v + 6);
+	} else if (p[0] == 'v' && p[1] == 't' && p + 2 < end && isSpace(p[2])) {
+		float v[3] = { 0.0f, 0.0f, 0.0f };
+		p += 3;
+		parseFloats(p, end, v, 3, piece.error);
+		piece.texCoords.insert(piece.texCoords.end(), v, v + 2);
+	} else if (p[0] == 'v' && p[1] == 'n' && p + 2 < end && isSpace(p[2])) {
+		float v[3] = { 0.0f, 0.0f, 0.0f };
+		p += 3;
+		parseFloats(p, end, v, 3, piece.error);
+		piece.normals.insert(piece.normals.end(), v, v + 3);
+	} else if (p[0] == 'f' && isSpace(p[1])) {
+		// v, v/t, v//n or v/t/n per corner
+		const int counts[3] = {
+			static_cast<int>(piece.positions.size() / 3),
+			static_cast<int>(piece.texCoords.size() / 2),
+			static_cast<int>(piece.normals.size() / 3)
+		};
+		RawCorner face[4];
+		int n = 0;
+		p += 2;
+		for (skipSpace(p, end); p < end; skipSpace(p, end)) {
+			if (n == 4) {
+				piece.error = "polygon of more than four vertices";
+				return;
+			}
+			RawCorner& corner = face[n++];
+			for (int c = 0; c < 3; c++) {
+				if (c > 0) {
+					if (p == end || *p != '/') {
+						break;
+					}
+					p++;
+					if (c == 1 && p < end && *p == '/') {
+						continue;		// v//n
+					}
+				}
+				int index;
+				if (!parseInt(p, end, index) || index == 0) {
+					piece.error = "malformed face";
+					return;
+				}
+				if (index > 0) {
+					corner.index[c] = index - 1;
+				} else {
+					corner.index[c] = counts[c] + index;
+					corner.relative |= 1 << c;
+				}
+			}
+			if (p < end && !isSpace(*p)) {
+				piece.error = "malformed face";
+				return;
+			}
+		}
+		if (n < 3) {
+			return;		// degenerate, skipped like tinyobj does
+		}
+		piece.corners.insert(piece.corners.end(), face, face + n);
+		piece.faceSizes.push_back(static_cast<uint8_t>(n));
+		piece.triangleCorners += n == 3 ? 3 : 6;
+	}
+	// Anything else (comments, groups, materials, smoothing groups, lines, points) is not used by the loader
+}
+
+void parsePiece(Piece& piece) {
+	for (const char* p = piece.begin; p < piece.end && piece.error == nullptr; ) {
+		const char* eol = static_cast<const char*>(memchr(p, '\n', piece.end - p));
+		if (eol == nullptr) {
+			eol = piece.end;
+		}
+		parseLine(piece, p, eol);
+		p = eol + 1;
+	}
+}
+
+// The triangle corners of a piece, written at its place in the merged array
+void expandPiece(Piece& piece, const ObjMesh& mesh, ObjCorner* out) {
+	const size_t bases[3] = { piece.positionBase, piece.texCoordBase, piece.normalBase };
+	const size_t counts[3] = { mesh.positions.size() / 3, mesh.texCoords.size() / 2, mesh.normals.size() / 3 };
+
+	ObjCorner face[4];
+	const RawCorner* raw = piece.corners.data();
+	for (uint8_t size : piece.faceSizes) {
+		for (int k = 0; k < size; k++, raw++) {
+			int resolved[3];
+			for (int c = 0; c < 3; c++) {
+				int64_t index = raw->index[c];
+				if (raw->relative & (1 << c)) {
+					index += static_cast<int64_t>(bases[c]);
+				} else if (index < 0) {
+					resolved[c] = -1;		// not in the file
+					continue;
+				}
+				if (index < 0 || static_cast<size_t>(index) >= counts[c]) {
+					piece.error = "index out of range";
+					return;
+				}
+				resolved[c] = static_cast<int>(index);
+			}
+			face[k].position = resolved[0];
+			face[k].texCoord = resolved[1];
+			face[k].normal = resolved[2];
+		}
+
+		if (size == 3) {
+			out[0] = face[0];
+			out[1] = face[1];
+			out[2] = face[2];
+			out += 3;
+			continue;
+		}
+
+		// Quads are split on the shorter diagonal, with the same float arithmetic as tinyobj
+		if (face[0].position < 0 || face[1].position < 0 || face[2].position < 0 || face[3].position < 0) {
+			piece.error = "face without position";
+			return;
+		}
+		const float* v0 = &mesh.positions[3 * face[0].position];
+		const float* v1 = &mesh.positions[3 * face[1].position];
+		const float* v2 = &mesh.positions[3 * face[2].position];
+		const float* v3 = &mesh.positions[3 * face[3].position];
+		float e02x = v2[0] - v0[0], e02y = v2[1] - v0[1], e02z = v2[2] - v0[2];
+		float e13x = v3[0] - v1[0], e13y = v3[1] - v1[1], e13z = v3[2] - v1[2];
+		float sqr02 = e02x * e02x + e02y * e02y + e02z * e02z;
+		float sqr13 = e13x * e13x + e13y * e13y + e13z * e13z;
+		static const int split02[6] = { 0, 1, 2, 0, 2, 3 };
+		static const int split13[6] = { 0, 1, 3, 1, 2, 3 };
+		const int* split = sqr02 < sqr13 ? split02 : split13;
+		for (int k = 0; k < 6; k++) {
+			out[k] = face[split[k]];
+		}
+		out += 6;
+	}
+}
+
+}
+
+bool ObjMesh::parse(const char* text, size_t size, JobSystem* jobs, std::string& error) {
+	// Pieces of about the same size, each ending after a newline
+	size_t pieceCount = 1;
+	if (jobs != nullptr) {
+		pieceCount = std::max<size_t>(1, std::min<size_t>(jobs->threadCount() * 4, size / MIN_PIECE_SIZE));
+	}
+	std::vector<Piece> pieces(pieceCount);
+	const char* end = text + size;
+	const char* begin = text;
+	for (size_t i = 0; i < pieceCount; i++) {
+		const char* split = i + 1 == pieceCount ? end : text + size * (i + 1) / pieceCount;
+		if (split < begin) {
+			split = begin;
+		}
+		const char* eol = static_cast<const char*>(memchr(split, '\n', end - split));
+		pieces[i].begin = begin;
+		pieces[i].end = eol != nullptr ? eol + 1 : end;
+		begin = pieces[i].end;
+	}
+
+	auto forEachPiece = [&](const char* name, const std::function<void(Piece&)>& fn) {
+		auto range = [&](int b, int e) {
+			for (int i = b; i < e; i++) {
+				fn(pieces[i]);
+			}
+		};
+		if (jobs != nullptr) {
+			jobs->parallelFor(name, 0, static_cast<int>(pieces.size()), 1, range);
+		} else {
+			range(0, static_cast<int>(pieces.size()));
+		}
+	};
+	auto failed = [&]() {
+		for (const Piece& piece : pieces) {
+			if (piece.error != nullptr) {
+				error = piece.error;
+				return true;
+			}
+		}
+		return false;
+	};
+
+	forEachPiece("parseObj", parsePiece);
+	if (failed()) {
+		return false;
+	}
+
+	// Where every piece goes in the merged arrays: the arrays are sized once and filled in parallel
+	size_t positionCount = 0, texCoordCount = 0, normalCount = 0, cornerCount = 0;
+	for (Piece& piece : pieces) {
+		piece.positionBase = positionCount;
+		piece.texCoordBase = texCoordCount;
+		piece.normalBase = normalCount;
+		piece.cornerBase = cornerCount;
+		positionCount += piece.positions.size() / 3;
+		texCoordCount += piece.texCoords.size() / 2;
+		normalCount += piece.normals.size() / 3;
+		cornerCount += piece.triangleCorners;
+	}
+	positions.resize(3 * positionCount);
+	colors.resize(3 * positionCount);
+	texCoords.resize(2 * texCoordCount);
+	normals.resize(3 * normalCount);
+	corners.resize(cornerCount);
+
+	forEachPiece("mergeObj", [&](Piece& piece) {
+		std::copy(piece.positions.begin(), piece.positions.end(), positions.begin() + 3 * piece.positionBase);
+		std::copy(piece.colors.begin(), piece.colors.end(), colors.begin() + 3 * piece.positionBase);
+		std::copy(piece.texCoords.begin(), piece.texCoords.end(), texCoords.begin() + 2 * piece.texCoordBase);
+		std::copy(piece.normals.begin(), piece.normals.end(), normals.begin() + 3 * piece.normalBase);
+	});
+	// Quads need the merged positions to be split
+	forEachPiece("triangulateObj", [&](Piece& piece) {
+		expandPiece(piece, *this, corners.data() + piece.cornerBase);
+	});
+	return !failed();
+}
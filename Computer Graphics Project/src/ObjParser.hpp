@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// A triangle corner of an OBJ: indices of its position (and color), texture coordinate and normal, -1 if missing
+struct ObjCorner {
+	int position = -1;
+	int texCoord = -1;
+	int normal = -1;
+};
+
+// The geometry of an OBJ as the model loader reads it: the attribute arrays and the corners of the triangles,
+// in the order of the file. Groups, materials, smoothing groups, lines and points are skipped.
+class ObjMesh {
+public:
+	std::vector<float> positions;		// xyz
+	std::vector<float> colors;			// rgb per position (white if the file has none)
+	std::vector<float> texCoords;		// uv
+	std::vector<float> normals;			// xyz
+	std::vector<ObjCorner> corners;		// three per triangle, quads split on their shorter diagonal like tinyobj
+
+	// The text is split at line boundaries across the threads of jobs (if given), the pieces parsed on their own and
+	// then merged. False, with the reason in error, for what this parser does not support (polygons of more than four
+	// vertices, indices out of range, malformed lines): the caller falls back to tinyobj
+	bool parse(const char* text, size_t size, JobSystem* jobs, std::string& error);
+};
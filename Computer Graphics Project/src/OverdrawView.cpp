@@ -0,0 +1,338 @@
+#include "OverdrawView.hpp"
+
+#include <array>
+#include <cstring>
+#include <glm/gtc/packing.hpp>
+
+namespace {
+
+const VkFormat COUNTERS_FORMAT = VK_FORMAT_R16G16_SFLOAT;	// blendable everywhere, exact up to 2048
+const uint32_t COUNTERS_PIXEL_SIZE = 4;
+
+}
+
+void OverdrawView::init(BaseProject* bp) {
+	BP = bp;
+
+	depthFormat = BP->findDepthFormat();
+
+	// The counters are cleared, and left ready to be copied to the readback buffer
+	VkAttachmentDescription colorAttachment{};
+	colorAttachment.format = COUNTERS_FORMAT;
+	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+	VkAttachmentReference colorAttachmentRef{};
+	colorAttachmentRef.attachment = 0;
+	colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentDescription depthAttachment{};
+	depthAttachment.format = depthFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference depthAttachmentRef{};
+	depthAttachmentRef.attachment = 1;
+	depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colorAttachmentRef;
+	subpass.pDepthStencilAttachment = &depthAttachmentRef;
+
+	// The same target serves every frame in flight: wait for the heatmap and the copy of the previous frame
+	VkSubpassDependency dependency{};
+	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependency.dstSubpass = 0;
+	dependency.srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependency.srcAccessMask = 0;
+	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
+
+	VkRenderPassCreateInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	renderPassInfo.pAttachments = attachments.data();
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = 1;
+	renderPassInfo.pDependencies = &dependency;
+
+	VkResult result = vkCreateRenderPass(BP->device, &renderPassInfo, nullptr, &renderPass);
+	if (result != VK_SUCCESS) {
+		PrintVkError(result);
+		throw std::runtime_error("failed to create overdraw render pass!");
+	}
+	BP->setObjectName(VK_OBJECT_TYPE_RENDER_PASS, renderPass, "overdraw counters");
+
+	DSL.init(bp, {
+		{0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT}
+	});
+
+	VD.init(bp, {
+		{0, sizeof(VertexText), VK_VERTEX_INPUT_RATE_VERTEX}
+	}, {
+		{0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(VertexText, pos),
+			sizeof(glm::vec2), OTHER},
+		{0, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(VertexText, UV),
+			sizeof(glm::vec2), UV},
+		{0, 2, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(VertexText, color),
+			sizeof(glm::vec4), COLOR}
+	});
+
+	// Over the whole screen, whatever was drawn before
+	P.init(bp, &VD, "shaders/TextVert.spv", "shaders/HeatmapFrag.spv", { &DSL });
+	P.setAdvancedFeatures(VK_COMPARE_OP_ALWAYS, VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, false);
+
+	halfToFloat.resize(1 << 16);
+	for (uint32_t h = 0; h < halfToFloat.size(); h++) {
+		halfToFloat[h] = glm::unpackHalf1x16(static_cast<glm::uint16>(h));
+	}
+}
+
+void OverdrawView::addPipeline(Pipeline& scene, const std::string& VertShader, float lights) {
+	pipelines.push_back(Counting{ &scene, Pipeline() });
+	Pipeline& counter = pipelines.back().P;
+	counter.init(BP, scene.VD, VertShader, "shaders/HeatFrag.spv", scene.D);
+	counter.setAdvancedFeatures(scene.compareOp, scene.polyModel, scene.CM, false);
+	counter.setTarget(renderPass, VK_SAMPLE_COUNT_1_BIT);
+	counter.setAdditiveBlend(glm::vec4(1.0f, lights, 0.0f, 0.0f));
+}
+
+Pipeline& OverdrawView::counting(Pipeline& scene) {
+	for (Counting& c : pipelines) {
+		if (c.scene == &scene) {
+			return c.P;
+		}
+	}
+	throw std::runtime_error("failed to find the counting pipeline!");
+}
+
+void OverdrawView::create() {
+	uint32_t width = BP->swapChainExtent.width;
+	uint32_t height = BP->swapChainExtent.height;
+
+	for (Counting& c : pipelines) {
+		c.P.create();
+	}
+	P.create();
+
+	counters.BP = BP;
+	counters.mipLevels = 1;
+	counters.imgs = 1;
+	counters.name = "overdraw counters";
+	BP->createImage(width, height, 1, 1, VK_SAMPLE_COUNT_1_BIT, COUNTERS_FORMAT, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 0,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, counters.textureImage, counters.textureImageMemory,
+		MEMORY_ATTACHMENT, counters.name);
+	counters.createTextureImageView(COUNTERS_FORMAT);
+	counters.createTextureSampler(VK_FILTER_NEAREST, VK_FILTER_NEAREST,
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		VK_SAMPLER_MIPMAP_MODE_NEAREST, VK_FALSE, 1.0f, 0.0f);
+
+	BP->createImage(width, height, 1, 1, VK_SAMPLE_COUNT_1_BIT, depthFormat, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		depthImage, depthImageMemory, MEMORY_ATTACHMENT, "overdraw depth");
+	depthImageView = BP->createImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1,
+		VK_IMAGE_VIEW_TYPE_2D, 1);
+
+	std::array<VkImageView, 2> attachments = { counters.textureImageView, depthImageView };
+	VkFramebufferCreateInfo framebufferInfo{};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = renderPass;
+	framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	framebufferInfo.pAttachments = attachments.data();
+	framebufferInfo.width = width;
+	framebufferInfo.height = height;
+	framebufferInfo.layers = 1;
+
+	VkResult result = vkCreateFramebuffer(BP->device, &framebufferInfo, nullptr, &framebuffer);
+	if (result != VK_SUCCESS) {
+		PrintVkError(result);
+		throw std::runtime_error("failed to create overdraw framebuffer!");
+	}
+
+	DS.init(BP, &DSL, {
+		{0, TEXTURE, 0, &counters}
+	}, "overdraw heatmap");
+
+	// One quad per channel, the counter weights in the color
+	glm::vec4 weights[2] = {
+		glm::vec4(1.0f / FRAGMENTS_WHITE, 0.0f, 0.0f, 0.0f),
+		glm::vec4(0.0f, 1.0f / LIGHTS_WHITE, 0.0f, 0.0f)
+	};
+	std::vector<VertexText> quads;
+	for (const glm::vec4& w : weights) {
+		quads.push_back({ { -1.0f, -1.0f }, { 0.0f, 0.0f }, w });
+		quads.push_back({ {  1.0f, -1.0f }, { 1.0f, 0.0f }, w });
+		quads.push_back({ { -1.0f,  1.0f }, { 0.0f, 1.0f }, w });
+		quads.push_back({ {  1.0f, -1.0f }, { 1.0f, 0.0f }, w });
+		quads.push_back({ {  1.0f,  1.0f }, { 1.0f, 1.0f }, w });
+		quads.push_back({ { -1.0f,  1.0f }, { 0.0f, 1.0f }, w });
+	}
+	VkDeviceSize quadSize = quads.size() * sizeof(VertexText);
+	BP->createBuffer(quadSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		quadBuffer, quadBufferMemory, MEMORY_MESH, "overdraw heatmap");
+	void* data;
+	vkMapMemory(BP->device, quadBufferMemory, 0, quadSize, 0, &data);
+	memcpy(data, quads.data(), static_cast<size_t>(quadSize));
+	vkUnmapMemory(BP->device, quadBufferMemory);
+
+	size_t images = BP->swapChainImages.size();
+	readbackBuffers.resize(images);
+	readbackBuffersMemory.resize(images);
+	readbackMapped.resize(images);
+	submitted.assign(images, false);
+	VkDeviceSize readbackSize = static_cast<VkDeviceSize>(width) * height * COUNTERS_PIXEL_SIZE;
+	for (size_t i = 0; i < images; i++) {
+		BP->createBuffer(readbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			readbackBuffers[i], readbackBuffersMemory[i], MEMORY_STAGING, "overdraw readback");
+		// Read every frame the view is on, so it stays mapped
+		vkMapMemory(BP->device, readbackBuffersMemory[i], 0, readbackSize, 0, &readbackMapped[i]);
+	}
+}
+
+void OverdrawView::cleanup() {
+	for (Counting& c : pipelines) {
+		c.P.cleanup();
+	}
+	P.cleanup();
+	DS.cleanup();
+
+	vkDestroyFramebuffer(BP->device, framebuffer, nullptr);
+	vkDestroyImageView(BP->device, depthImageView, nullptr);
+	vkDestroyImage(BP->device, depthImage, nullptr);
+	BP->freeMemory(depthImageMemory);
+	counters.cleanup();
+
+	vkDestroyBuffer(BP->device, quadBuffer, nullptr);
+	BP->freeMemory(quadBufferMemory);
+
+	for (size_t i = 0; i < readbackBuffers.size(); i++) {
+		vkUnmapMemory(BP->device, readbackBuffersMemory[i]);
+		vkDestroyBuffer(BP->device, readbackBuffers[i], nullptr);
+		BP->freeMemory(readbackBuffersMemory[i]);
+	}
+	readbackBuffers.clear();
+	readbackBuffersMemory.clear();
+	readbackMapped.clear();
+	submitted.clear();
+}
+
+void OverdrawView::destroy() {
+	for (Counting& c : pipelines) {
+		c.P.destroy();
+	}
+	P.destroy();
+	DSL.cleanup();
+	vkDestroyRenderPass(BP->device, renderPass, nullptr);
+}
+
+void OverdrawView::beginPass(VkCommandBuffer commandBuffer) {
+	std::array<VkClearValue, 2> clearValues{};
+	clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+	clearValues[1].depthStencil = { 1.0f, 0 };
+
+	VkRenderPassBeginInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = renderPass;
+	renderPassInfo.framebuffer = framebuffer;
+	renderPassInfo.renderArea.offset = { 0, 0 };
+	renderPassInfo.renderArea.extent = BP->swapChainExtent;
+	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+	renderPassInfo.pClearValues = clearValues.data();
+
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void OverdrawView::endPass(VkCommandBuffer commandBuffer, int currentImage) {
+	vkCmdEndRenderPass(commandBuffer);
+
+	VkBufferImageCopy region{};
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { BP->swapChainExtent.width, BP->swapChainExtent.height, 1 };
+	vkCmdCopyImageToBuffer(commandBuffer, counters.textureImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		readbackBuffers[currentImage], 1, &region);
+
+	// The copy is read by the CPU once the fence of the submission is signaled, the counters by the heatmap
+	VkBufferMemoryBarrier bufferBarrier{};
+	bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.buffer = readbackBuffers[currentImage];
+	bufferBarrier.offset = 0;
+	bufferBarrier.size = VK_WHOLE_SIZE;
+
+	VkImageMemoryBarrier imageBarrier{};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = counters.textureImage;
+	imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageBarrier.subresourceRange.baseMipLevel = 0;
+	imageBarrier.subresourceRange.levelCount = 1;
+	imageBarrier.subresourceRange.baseArrayLayer = 0;
+	imageBarrier.subresourceRange.layerCount = 1;
+	imageBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0,
+		0, nullptr, 1, &bufferBarrier, 1, &imageBarrier);
+}
+
+void OverdrawView::draw(VkCommandBuffer commandBuffer, int currentImage, Channel channel) {
+	P.bind(commandBuffer);
+	DS.bind(commandBuffer, P, 0, currentImage);
+
+	VkDeviceSize offsets[] = { 0 };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &quadBuffer, offsets);
+	vkCmdDraw(commandBuffer, 6, 1, channel * 6, 0);
+	BP->drawCalls++;
+}
+
+bool OverdrawView::read(int currentImage, float& fragments, float& lights) {
+	if (!submitted[currentImage]) {
+		// The command buffer is about to be submitted: its copy can be read next time
+		submitted[currentImage] = true;
+		return false;
+	}
+
+	size_t pixels = static_cast<size_t>(BP->swapChainExtent.width) * BP->swapChainExtent.height;
+	const uint16_t* data = static_cast<const uint16_t*>(readbackMapped[currentImage]);
+	double sumFragments = 0.0, sumLights = 0.0;
+	for (size_t i = 0; i < pixels; i++) {
+		sumFragments += halfToFloat[data[2 * i]];
+		sumLights += halfToFloat[data[2 * i + 1]];
+	}
+	fragments = static_cast<float>(sumFragments / pixels);
+	lights = static_cast<float>(sumLights / pixels);
+	return true;
+}
+
+void OverdrawView::restart() {
+	submitted.assign(submitted.size(), false);
+}
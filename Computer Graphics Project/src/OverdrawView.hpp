@@ -0,0 +1,83 @@
+#pragma once
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include "Starter.hpp"
+#include "TextRenderer.hpp"
+
+// Heatmaps of the fragments shaded for every pixel and of the lights they evaluate, to see where fragment work is wasted.
+// A copy of each scene pipeline, with its vertex shader, layouts, depth test and culling, draws into a counter target
+// with additive blending: every fragment adds one to red and the number of lights of its shader to green (an upper
+// bound of the lights that actually reach it, since the shaders do not skip the ones out of range).
+// The counters are then shown as a heatmap and read back for the averages over the screen.
+class OverdrawView {
+public:
+	enum Channel { FRAGMENTS, LIGHTS };
+
+	// Counts shown as white
+	static constexpr float FRAGMENTS_WHITE = 8.0f;
+	static constexpr float LIGHTS_WHITE = 64.0f;
+
+	// Render pass and heatmap pipeline (in localInit)
+	void init(BaseProject* bp);
+	// Counting copy of a scene pipeline, after its init and setAdvancedFeatures:
+	// lights is the number of lights its fragment shader loops over (an upper bound of those that reach a fragment)
+	void addPipeline(Pipeline& scene, const std::string& VertShader, float lights);
+	// The counting copy of a scene pipeline, to bind it and the descriptor sets in the counter pass
+	Pipeline& counting(Pipeline& scene);
+
+	// Counter target, pipelines, descriptor set and readback buffers, rebuilt with the swap chain
+	void create();
+	void cleanup();
+	// Everything else (in localCleanup)
+	void destroy();
+
+	// Counter pass, recorded before the main render pass: the scene is drawn with the counting pipelines in between
+	void beginPass(VkCommandBuffer commandBuffer);
+	void endPass(VkCommandBuffer commandBuffer, int currentImage);
+	// Heatmap of a counter over the whole screen (in the main render pass)
+	void draw(VkCommandBuffer commandBuffer, int currentImage, Channel channel);
+
+	// Average fragments and lights per pixel of the last submission of the image (call once its fence has been
+	// waited); false if the image has not been submitted with the counter pass yet
+	bool read(int currentImage, float& fragments, float& lights);
+	// Forget the submissions, after the command buffers have been recorded again with the counter pass
+	void restart();
+
+private:
+	BaseProject* BP = nullptr;
+
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	VkFormat depthFormat;
+
+	struct Counting {
+		Pipeline* scene;
+		Pipeline P;
+	};
+	std::list<Counting> pipelines;			// stable addresses
+
+	// Counter target, sampled by the heatmap
+	Texture counters;
+	VkImage depthImage;
+	VkDeviceMemory depthImageMemory;
+	VkImageView depthImageView;
+	VkFramebuffer framebuffer;
+
+	// Heatmap: a full screen quad per channel, its weights in the vertex color
+	DescriptorSetLayout DSL;
+	VertexDescriptor VD;
+	Pipeline P;
+	DescriptorSet DS;
+	VkBuffer quadBuffer;
+	VkDeviceMemory quadBufferMemory;
+
+	// Per swap chain image: copy of the counters, and whether the image has been submitted with it since create
+	std::vector<VkBuffer> readbackBuffers;
+	std::vector<VkDeviceMemory> readbackBuffersMemory;
+	std::vector<void*> readbackMapped;
+	std::vector<bool> submitted;
+
+	std::vector<float> halfToFloat;			// every 16 bit float, to sum the counters quickly
+};
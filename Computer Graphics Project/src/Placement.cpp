@@ -0,0 +1,141 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "Placement.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "Logger.hpp"
+
+CounterRng::CounterRng(uint64_t seed, uint64_t stream) {
+	key = mix(seed ^ mix(stream + 0x632BE59BD9B4E019ull));
+}
+
+uint64_t CounterRng::mix(uint64_t x) {
+	x += 0x9E3779B97F4A7C15ull;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	return x ^ (x >> 31);
+}
+
+static bool isBlocked(glm::vec2 p, const std::vector<BoundingBox>& obstacles, float clearance) {
+	for (const auto& o : obstacles) {
+		if (p.x >= o.min.x - clearance && p.x <= o.max.x + clearance &&
+			p.y >= o.min.z - clearance && p.y <= o.max.z + clearance) {
+			return true;
+		}
+	}
+	return false;
+}
+
+std::vector<glm::vec2> poissonDiskSample(CounterRng& rng, glm::vec2 lo, glm::vec2 hi, float minDist,
+	const std::vector<BoundingBox>& obstacles, float clearance, int k) {
+	std::vector<glm::vec2> points;
+
+	// Background grid: with cells of minDist/sqrt(2) every cell holds at most one point,
+	// so a candidate only has to be checked against the 5x5 cells around it
+	const float cell = minDist / std::sqrt(2.0f);
+	const int gw = std::max(1, static_cast<int>(std::ceil((hi.x - lo.x) / cell)));
+	const int gh = std::max(1, static_cast<int>(std::ceil((hi.y - lo.y) / cell)));
+	std::vector<int> grid(gw * gh, -1);
+	std::vector<int> active;
+
+	auto cellOf = [&](glm::vec2 p, int& cx, int& cy) {
+		cx = std::min(gw - 1, static_cast<int>((p.x - lo.x) / cell));
+		cy = std::min(gh - 1, static_cast<int>((p.y - lo.y) / cell));
+	};
+
+	auto isFree = [&](glm::vec2 p) {
+		if (p.x < lo.x || p.x > hi.x || p.y < lo.y || p.y > hi.y || isBlocked(p, obstacles, clearance)) {
+			return false;
+		}
+		int cx, cy;
+		cellOf(p, cx, cy);
+		for (int y = std::max(0, cy - 2); y <= std::min(gh - 1, cy + 2); y++) {
+			for (int x = std::max(0, cx - 2); x <= std::min(gw - 1, cx + 2); x++) {
+				int idx = grid[y * gw + x];
+				if (idx >= 0) {
+					glm::vec2 d = points[idx] - p;
+					if (glm::dot(d, d) < minDist * minDist) {
+						return false;
+					}
+				}
+			}
+		}
+		return true;
+	};
+
+	auto add = [&](glm::vec2 p) {
+		int cx, cy;
+		cellOf(p, cx, cy);
+		grid[cy * gw + cx] = static_cast<int>(points.size());
+		active.push_back(static_cast<int>(points.size()));
+		points.push_back(p);
+	};
+
+	// First point: any free spot (bounded number of attempts, the domain may be fully blocked)
+	for (int attempt = 0; attempt < gw * gh * k && points.empty(); attempt++) {
+		glm::vec2 p(rng.nextRange(lo.x, hi.x), rng.nextRange(lo.y, hi.y));
+		if (isFree(p)) {
+			add(p);
+		}
+	}
+
+	while (!active.empty()) {
+		int a = rng.nextBelow(static_cast<uint32_t>(active.size()));
+		glm::vec2 center = points[active[a]];
+		bool found = false;
+
+		for (int i = 0; i < k; i++) {
+			// Uniform by area in the annulus [minDist, 2 minDist]
+			float angle = rng.nextFloat() * 6.28318530718f;
+			float radius = minDist * std::sqrt(1.0f + 3.0f * rng.nextFloat());
+			glm::vec2 p = center + radius * glm::vec2(std::cos(angle), std::sin(angle));
+			if (isFree(p)) {
+				add(p);
+				found = true;
+				break;
+			}
+		}
+
+		if (!found) {
+			active[a] = active.back();
+			active.pop_back();
+		}
+	}
+
+	return points;
+}
+
+std::vector<glm::vec2> placeItems(CounterRng& rng, int count, glm::vec2 lo, glm::vec2 hi, float minDist,
+	const std::vector<BoundingBox>& obstacles, float clearance) {
+	std::vector<glm::vec2> points = poissonDiskSample(rng, lo, hi, minDist, obstacles, clearance);
+
+	// The points that fit go with the free area over minDist^2: shrink the spacing by the square root of what is
+	// missing (and a little more, the sampling is not perfectly dense) until count of them fit
+	float spacing = minDist;
+	const int fitting = static_cast<int>(points.size());
+	const float minSpacing = 1e-3f * std::max(hi.x - lo.x, hi.y - lo.y);
+	while (static_cast<int>(points.size()) < count) {
+		if (points.empty() || spacing <= minSpacing) {
+			throw std::runtime_error("Not enough room to place " + std::to_string(count) +
+				" items (only " + std::to_string(points.size()) + " fit)");
+		}
+		spacing = std::max(minSpacing, 0.9f * spacing * std::sqrt(static_cast<float>(points.size()) / count));
+		points = poissonDiskSample(rng, lo, hi, spacing, obstacles, clearance);
+	}
+	if (spacing < minDist) {
+		LOG_WARN("Only %d items fit %.2f apart, %d placed %.2f apart", fitting, minDist, count, spacing);
+	}
+
+	// Bridson grows outwards from the first point, so take a random subset instead of the first ones
+	for (int i = 0; i < count; i++) {
+		int j = i + rng.nextBelow(static_cast<uint32_t>(points.size() - i));
+		std::swap(points[i], points[j]);
+	}
+	points.resize(count);
+
+	return points;
+}
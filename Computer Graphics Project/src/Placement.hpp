@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "BoundingBox.hpp"
+
+// Counter-based random number generator: the n-th number of a stream is a pure function of
+// (key, n), so a run can be reproduced from its seed and any item can be regenerated on its own.
+// The mixing function is SplitMix64.
+struct CounterRng {
+	uint64_t key;
+	uint64_t counter = 0;
+
+	explicit CounterRng(uint64_t seed, uint64_t stream = 0);
+
+	static uint64_t mix(uint64_t x);
+
+	// Random value at a given position of the stream, without advancing it
+	uint64_t at(uint64_t index) const { return mix(key + index * 0x9E3779B97F4A7C15ull); }
+
+	uint64_t next() { return at(counter++); }
+	uint32_t nextU32() { return static_cast<uint32_t>(next() >> 32); }
+	// Uniform in [0, n)
+	uint32_t nextBelow(uint32_t n) { return static_cast<uint32_t>((static_cast<uint64_t>(nextU32()) * n) >> 32); }
+	// Uniform in [0, 1)
+	float nextFloat() { return (next() >> 40) * (1.0f / 16777216.0f); }
+	float nextRange(float lo, float hi) { return lo + (hi - lo) * nextFloat(); }
+};
+
+// Bridson's Poisson-disk sampling on the XZ plane: returns points in [lo, hi] that are at least
+// minDist apart and at least clearance away (in XZ) from every obstacle.
+// Runs in time linear in the number of generated points; k is the number of candidates tried
+// around each active point before retiring it.
+std::vector<glm::vec2> poissonDiskSample(CounterRng& rng, glm::vec2 lo, glm::vec2 hi, float minDist,
+	const std::vector<BoundingBox>& obstacles, float clearance, int k = 30);
+
+// Pick count positions, minDist apart, avoiding the obstacles. When that many do not fit, the spacing is reduced
+// (with a warning) until they do, so more items crowd the same room instead of failing; throws only if the
+// obstacles leave no free spot at all.
+std::vector<glm::vec2> placeItems(CounterRng& rng, int count, glm::vec2 lo, glm::vec2 hi, float minDist,
+	const std::vector<BoundingBox>& obstacles, float clearance);
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+// Apart from Profiler.hpp, so that the simulation can be timed without the GLFW and Vulkan headers
+class Profiler;
+
+// Records the time between its construction and its destruction, if the profiler is enabled
+class ProfileScope {
+public:
+	ProfileScope(Profiler* profiler, const char* name);
+	~ProfileScope();
+
+private:
+	Profiler* profiler;
+	const char* name;
+	uint64_t startNs;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(profiler, name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(profiler, name)
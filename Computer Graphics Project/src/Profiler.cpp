@@ -0,0 +1,234 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+
+// Same setting of tiny_gltf in Starter.hpp, json.hpp must be compiled the same way everywhere
+#define JSON_NOEXCEPTION
+#include <json.hpp>
+
+#include "JobSystem.hpp"
+#include "Logger.hpp"
+
+uint64_t Profiler::nowNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::setEnabled(bool on) {
+	std::lock_guard<std::mutex> guard(enableLock);
+	if (on && storage == nullptr) {
+		storage.reset(new Slot[CAPACITY]);
+		slots.store(storage.get(), std::memory_order_release);
+	}
+	enabled.store(on, std::memory_order_relaxed);
+}
+
+void Profiler::record(const char* name, uint64_t startNs, uint64_t endNs, int track) {
+	Slot* ring = slots.load(std::memory_order_acquire);
+	if (ring == nullptr) {
+		return;
+	}
+	uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+	Slot& slot = ring[index % CAPACITY];
+
+	// Readers that see 0, or a different sequence before and after their copy, drop the slot
+	slot.sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.startNs.store(startNs, std::memory_order_relaxed);
+	slot.durationNs.store(endNs > startNs ? endNs - startNs : 0, std::memory_order_relaxed);
+	slot.track.store(track, std::memory_order_relaxed);
+	slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+uint64_t Profiler::recordedCount() {
+	return head.load(std::memory_order_acquire);
+}
+
+std::vector<ProfileEvent> Profiler::eventsSince(uint64_t count) {
+	std::vector<ProfileEvent> result;
+	Slot* ring = slots.load(std::memory_order_acquire);
+	if (ring == nullptr) {
+		return result;
+	}
+
+	uint64_t last = head.load(std::memory_order_acquire);
+	uint64_t first = std::max<uint64_t>(count, last - std::min<uint64_t>(last, CAPACITY));
+	result.reserve(last > first ? last - first : 0);
+	for (uint64_t i = first; i < last; i++) {
+		const Slot& slot = ring[i % CAPACITY];
+		// Still being written, or already overwritten by a newer event: skip it
+		if (slot.sequence.load(std::memory_order_acquire) != i + 1) {
+			continue;
+		}
+		ProfileEvent e{ slot.name.load(std::memory_order_relaxed), slot.startNs.load(std::memory_order_relaxed),
+			slot.durationNs.load(std::memory_order_relaxed), slot.track.load(std::memory_order_relaxed) };
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) == i + 1) {
+			result.push_back(e);
+		}
+	}
+	return result;
+}
+
+void Profiler::exportChromeTrace(const std::string& path) {
+	std::vector<ProfileEvent> snapshot = eventsSince(0);
+
+	nlohmann::json traceEvents = nlohmann::json::array();
+	std::vector<int> tracks;
+	uint64_t origin = snapshot.empty() ? 0 : snapshot.front().startNs;
+	for (const ProfileEvent& e : snapshot) {
+		origin = std::min(origin, e.startNs);
+	}
+
+	for (const ProfileEvent& e : snapshot) {
+		traceEvents.push_back({
+			{ "name", e.name },
+			{ "cat", e.track == PROFILER_GPU_TRACK ? "gpu" : "cpu" },
+			{ "ph", "X" },
+			{ "ts", (e.startNs - origin) / 1000.0 },
+			{ "dur", e.durationNs / 1000.0 },
+			{ "pid", 1 },
+			{ "tid", e.track }
+		});
+		if (std::find(tracks.begin(), tracks.end(), e.track) == tracks.end()) {
+			tracks.push_back(e.track);
+		}
+	}
+
+	// Name the tracks
+	for (int t : tracks) {
+		std::string name = t == PROFILER_GPU_TRACK ? "GPU" : (t == 0 ? "Main thread" : "Worker " + std::to_string(t));
+		traceEvents.push_back({
+			{ "name", "thread_name" }, { "ph", "M" }, { "pid", 1 }, { "tid", t }, { "args", { { "name", name } } }
+		});
+	}
+
+	std::ofstream file(path);
+	if (!file.is_open()) {
+		throw std::runtime_error("failed to create trace file " + path);
+	}
+	file << nlohmann::json{ { "traceEvents", traceEvents }, { "displayTimeUnit", "ms" } }.dump();
+	LOG_INFO("Trace with %zu events written to %s", snapshot.size(), path.c_str());
+}
+
+void Profiler::initGpu(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily) {
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> families(familyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+	if (queueFamily >= familyCount || families[queueFamily].timestampValidBits == 0 || properties.limits.timestampPeriod == 0.0f) {
+		LOG_WARN("GPU timestamps not supported by the graphics queue, GPU profiling disabled");
+		return;
+	}
+	timestampPeriod = properties.limits.timestampPeriod;
+	uint32_t validBits = families[queueFamily].timestampValidBits;
+	timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+	VkQueryPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	poolInfo.queryCount = MAX_GPU_IMAGES * MAX_GPU_ZONES * 2;
+
+	if (vkCreateQueryPool(device, &poolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create timestamp query pool!");
+	}
+	this->device = device;
+}
+
+void Profiler::cleanupGpu() {
+	if (queryPool != VK_NULL_HANDLE) {
+		vkDestroyQueryPool(device, queryPool, nullptr);
+		queryPool = VK_NULL_HANDLE;
+	}
+}
+
+void Profiler::beginCommandBuffer(VkCommandBuffer commandBuffer, uint32_t image) {
+	if (!gpuReady(image)) {
+		return;
+	}
+	gpuImages[image] = GpuImage();
+	if (isEnabled()) {
+		vkCmdResetQueryPool(commandBuffer, queryPool, image * MAX_GPU_ZONES * 2, MAX_GPU_ZONES * 2);
+	}
+}
+
+void Profiler::gpuZoneBegin(VkCommandBuffer commandBuffer, uint32_t image, const char* name) {
+	if (!isEnabled() || !gpuReady(image)) {
+		return;
+	}
+	GpuImage& g = gpuImages[image];
+	if (g.open) {
+		gpuZoneEnd(commandBuffer, image);
+	}
+	if (g.zones.size() >= MAX_GPU_ZONES) {
+		return;
+	}
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool,
+		static_cast<uint32_t>((image * MAX_GPU_ZONES + g.zones.size()) * 2));
+	g.zones.push_back(name);
+	g.open = true;
+}
+
+void Profiler::gpuZoneEnd(VkCommandBuffer commandBuffer, uint32_t image) {
+	if (!gpuReady(image) || !gpuImages[image].open) {
+		return;
+	}
+	GpuImage& g = gpuImages[image];
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool,
+		static_cast<uint32_t>((image * MAX_GPU_ZONES + g.zones.size() - 1) * 2 + 1));
+	g.open = false;
+}
+
+void Profiler::markSubmit(uint32_t image) {
+	if (!gpuReady(image)) {
+		return;
+	}
+	gpuImages[image].submitted = true;
+	gpuImages[image].submitNs = nowNs();
+}
+
+void Profiler::collectGpu(uint32_t image) {
+	if (!isEnabled() || !gpuReady(image)) {
+		return;
+	}
+	GpuImage& g = gpuImages[image];
+	if (!g.submitted || g.zones.empty() || g.open) {
+		return;
+	}
+
+	uint64_t ticks[MAX_GPU_ZONES * 2];
+	uint32_t count = static_cast<uint32_t>(g.zones.size() * 2);
+	// No WAIT flag: the fence of the submission has already been waited, if the results are not there skip the frame
+	if (vkGetQueryPoolResults(device, queryPool, image * MAX_GPU_ZONES * 2, count, sizeof(ticks), ticks,
+		sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+		return;
+	}
+
+	// GPU ticks have their own origin: line the first zone up with the submission on the CPU clock.
+	// Only the valid bits count, and masking the difference also keeps it right when the counter wraps
+	for (size_t z = 0; z < g.zones.size(); z++) {
+		uint64_t start = g.submitNs + static_cast<uint64_t>(((ticks[z * 2] - ticks[0]) & timestampMask) * timestampPeriod);
+		uint64_t end = g.submitNs + static_cast<uint64_t>(((ticks[z * 2 + 1] - ticks[0]) & timestampMask) * timestampPeriod);
+		record(g.zones[z], start, end, PROFILER_GPU_TRACK);
+	}
+	g.submitted = false;
+}
+
+ProfileScope::ProfileScope(Profiler* profiler, const char* name)
+	: profiler(profiler != nullptr && profiler->isEnabled() ? profiler : nullptr), name(name),
+	  startNs(this->profiler != nullptr ? Profiler::nowNs() : 0) {
+}
+
+ProfileScope::~ProfileScope() {
+	if (profiler != nullptr) {
+		profiler->record(name, startNs, Profiler::nowNs(), JobSystem::currentThreadIndex());
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+#include "VulkanRecorder.hpp"
+#include "ProfileScope.hpp"
+
+// Track of the GPU events in the trace (CPU events use the thread index of the job system)
+#define PROFILER_GPU_TRACK 100
+
+// A timed interval of the trace
+struct ProfileEvent {
+	const char* name;		// string literal, it must outlive the profiler
+	uint64_t startNs;
+	uint64_t durationNs;
+	int track;
+};
+
+// Collects CPU scopes and GPU timestamps into a ring buffer and exports them as a Chrome trace
+// (open it in chrome://tracing or ui.perfetto.dev). When disabled a scope costs a single relaxed load.
+// The ring buffer is lock-free: a writer claims a slot with an atomic increment and publishes it with a sequence
+// number, a reader copies a slot and keeps it only if the sequence has not changed meanwhile (a seqlock per slot).
+class Profiler {
+public:
+	static const size_t CAPACITY = 1 << 16;		// events kept, the oldest ones are overwritten
+
+	// Allocates the ring buffer the first time (call it from one thread at a time)
+	void setEnabled(bool on);
+	bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+	// Nanoseconds on the steady clock, the same time base of the job system trace hook
+	static uint64_t nowNs();
+
+	void record(const char* name, uint64_t startNs, uint64_t endNs, int track);
+
+	// Write the events currently in the ring buffer, oldest first
+	void exportChromeTrace(const std::string& path);
+
+	// Number of events recorded so far, and the events from the given count on that are still in the ring buffer,
+	// oldest first: a caller polling with its last count sees every event once, as long as it keeps up
+	// (events still being written by another thread when it polls are skipped)
+	uint64_t recordedCount();
+	std::vector<ProfileEvent> eventsSince(uint64_t count);
+
+	// GPU timestamps. The command buffers are recorded once and submitted many times, so every
+	// command buffer resets its own range of queries at the beginning and writes a pair per zone
+	// Nothing is written while the profiler is disabled, so the command buffers have to be recorded again when it is
+	// turned on or off
+	void initGpu(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily);
+	void cleanupGpu();
+	// To be recorded outside the render pass, before the zones of the image
+	void beginCommandBuffer(VkCommandBuffer commandBuffer, uint32_t image);
+	void gpuZoneBegin(VkCommandBuffer commandBuffer, uint32_t image, const char* name);
+	void gpuZoneEnd(VkCommandBuffer commandBuffer, uint32_t image);
+	// Read the timestamps of the previous submission of the image (call once its fence has been waited)
+	void collectGpu(uint32_t image);
+	// Remember when the command buffer of the image is submitted, to place its GPU zones on the CPU timeline
+	void markSubmit(uint32_t image);
+
+private:
+	// An event with its sequence: index + 1 once written, 0 while a writer is filling it
+	struct Slot {
+		std::atomic<uint64_t> sequence{0};
+		std::atomic<const char*> name{nullptr};
+		std::atomic<uint64_t> startNs{0};
+		std::atomic<uint64_t> durationNs{0};
+		std::atomic<int> track{0};
+	};
+
+	std::unique_ptr<Slot[]> storage;
+	std::atomic<Slot*> slots{nullptr};			// published once storage is allocated
+	std::atomic<uint64_t> head{0};				// total number of events claimed
+	std::mutex enableLock;
+	std::atomic<bool> enabled{false};
+
+	static const uint32_t MAX_GPU_IMAGES = 8;
+	static const uint32_t MAX_GPU_ZONES = 32;
+
+	struct GpuImage {
+		std::vector<const char*> zones;
+		bool open = false;			// a zone has begun and not ended yet
+		bool submitted = false;
+		uint64_t submitNs = 0;
+	};
+
+	VkDevice device = VK_NULL_HANDLE;
+	VkQueryPool queryPool = VK_NULL_HANDLE;
+	float timestampPeriod = 1.0f;	// ns per tick
+	uint64_t timestampMask = ~0ull;	// the bits of a timestamp the queue actually writes
+	GpuImage gpuImages[MAX_GPU_IMAGES];
+
+	bool gpuReady(uint32_t image) const { return queryPool != VK_NULL_HANDLE && image < MAX_GPU_IMAGES; }
+};
@@ -1,8 +1,5 @@
 #include "PurrfectPotion.hpp"
-
-static bool debounce = false;
-static int curDebounce = 0;
-static bool showInstruction = false;
+#include "Headless.hpp"
 
 // Here you set the main application parameters
 void PurrfectPotion::setWindowParameters() {
@@ -14,42 +11,50 @@ void PurrfectPotion::setWindowParameters() {
 	initialBackgroundColor = { 0.5f, 0.5f, 0.5f, 1.0f };
 
 	// Descriptor pool sizes
-	uniformBlocksInPool = 97;  //105 with all furniture BBs
-	texturesInPool = 61;	   //61
-	setsInPool = 63;		   //71 with all furniture BBs
+	// every collectible takes 3 sets (model, HUD icon, bounding box), 4 uniform blocks and 2 textures,
+	// the text overlay a set with the font atlas, the overdraw heatmap one with the counters
+	uniformBlocksInPool = 69 + 4 * COLLECTIBLES_NUM;  //105 with all furniture BBs
+	texturesInPool = 45 + 2 * COLLECTIBLES_NUM;	   //59
+	setsInPool = 44 + 3 * COLLECTIBLES_NUM;		   //73 with all furniture BBs
 
-	Ar = (float)windowWidth / (float)windowHeight;
+	sim.Ar = (float)windowWidth / (float)windowHeight;
 }
 
 // What to do when the window changes size
 void PurrfectPotion::onWindowResize(int w, int h) {
-	std::cout << "Window resized to: " << w << " x " << h << "\n";
-	Ar = (float)w / (float)h;
+	LOG_INFO("Window resized to: %d x %d", w, h);
+	sim.Ar = (float)w / (float)h;
 }
 
 // Here you load and setup all your Vulkan Models and Texutures.
 // Here you also create your Descriptor set layouts and load the shaders for the pipelines
 void PurrfectPotion::localInit() {
 		
-	// Create bounding boxes for collectibles and furniture
-	fillBBList(&collectiblesBBs, collectiblesRandomPosition);
-
-	furnitureBBs.push_back(BoundingBox("cauldron", cauldron.pos, glm::vec3(1.f, 1.5f, 1.f)));
-	/*
-	furnitureBBs.push_back(BoundingBox("closet", closet.pos, glm::vec3(5.6f, 6.f, 1.f)));
-	furnitureBBs.push_back(BoundingBox("bed",		bed.pos, glm::vec3(2.f, 1.2f, 4.5f)));
-	furnitureBBs.push_back(BoundingBox("nightTable",nightTable.pos, glm::vec3(0.88, 1.3f, 1.1f)));
-	furnitureBBs.push_back(BoundingBox("kitchen",	kitchen.pos, glm::vec3(5.f, 3.f, 1.72f)));
-	furnitureBBs.push_back(BoundingBox("fridge",	fridge.pos, glm::vec3(1.5f, 3.5f, 1.6f)));
-	furnitureBBs.push_back(BoundingBox("sofa",		sofa.pos, glm::vec3(1.f, 1.5f, 3.f)));
-	furnitureBBs.push_back(BoundingBox("chest",		chest.pos, glm::vec3(1.4f, 1.4f, 0.7f)));
-	furnitureBBs.push_back(BoundingBox("bathtub",	bathtub.pos, glm::vec3(3.3f, 1.7f, 1.4f)));
-	*/
-
-	// Create ubo needed for the bounding boxes (debug)
-	for (int i = 0; i < collectiblesBBs.size() + furnitureBBs.size() + 1; i++) {
-		UBO_boundingBox.push_back(UniformBufferObject());
-	}
+	// Create the colliders and place the collectibles
+	sim.init(&profiler);
+	if (!recordPath.empty()) {
+		recorder.open(recordPath, sim.placementSeed);
+	}
+
+	DescriptorSet* ds[SCENE_OBJECTS_NUM] = {
+		&DS_floor, &DS_walls,
+		&DS_closet, &DS_bed, &DS_nighttable,
+		&DS_kitchen, &DS_fridge, &DS_kitchentable, &DS_chair,
+		&DS_sofa, &DS_table, &DS_tv, &DS_knight,
+		&DS_chest, &DS_stonetable, &DS_stonechair, &DS_cauldron, &DS_shelf1, &DS_shelf2, &DS_web, &DS_catFainted,
+		&DS_bathtub, &DS_toilet, &DS_bidet, &DS_sink
+	};
+	std::copy(ds, ds + SCENE_OBJECTS_NUM, objectDS);
+	const glm::mat4* dequantization[SCENE_OBJECTS_NUM] = {
+		&M_floor.dequantization, &M_walls.dequantization,
+		&M_closet.dequantization, &M_bed.dequantization, &M_nighttable.dequantization,
+		&M_kitchen.dequantization, &M_fridge.dequantization, &M_kitchentable.dequantization, &M_chair.dequantization,
+		&M_sofa.dequantization, &M_table.dequantization, &M_tv.dequantization, &M_knight.dequantization,
+		&M_chest.dequantization, &M_stonetable.dequantization, &M_stonechair.dequantization, &M_cauldron.dequantization,
+		&M_shelf1.dequantization, &M_shelf2.dequantization, &M_web.dequantization, &M_catFainted.dequantization,
+		&M_bathtub.dequantization, &M_toilet.dequantization, &M_bidet.dequantization, &M_sink.dequantization
+	};
+	std::copy(dequantization, dequantization + SCENE_OBJECTS_NUM, objectDequantization);
 
 	// Descriptor Layouts [what will be passed to the shaders]
 	DSL_global.init(this, {
@@ -90,16 +95,14 @@ void PurrfectPotion::localInit() {
 		{0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS},
 		{1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT},
 		{2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS},
-		{3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT},
-		{4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT}
+		{3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT}	// normal map, specular in alpha
 	});
 
 	DSL_DRN.init(this, {
 		{0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS},
 		{1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT},	
 		{2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS},
-		{3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT},
-		{4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT}
+		{3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT}	// normal map, roughness in alpha
 	});
 
 	// Vertex descriptors
@@ -135,6 +138,18 @@ void PurrfectPotion::localInit() {
 			sizeof(glm::vec3), NORMAL}
 	});
 
+	// The static models: 16-bit positions, octahedral normals, half float UVs (16 bytes instead of 32)
+	VD_packed.init(this, {
+		{0, sizeof(VertexPacked), VK_VERTEX_INPUT_RATE_VERTEX}
+	}, {
+		{0, 0, VK_FORMAT_R16G16B16A16_SNORM, offsetof(VertexPacked, pos),
+			sizeof(VertexPacked::pos), POSITION},
+		{0, 1, VK_FORMAT_R16G16_SFLOAT, offsetof(VertexPacked, UV),
+			sizeof(VertexPacked::UV), UV},
+		{0, 2, VK_FORMAT_R16G16_SNORM, offsetof(VertexPacked, norm),
+			sizeof(VertexPacked::norm), NORMAL}
+	});
+
 	VD_skyBox.init(this, {
 		{0, sizeof(skyBoxVertex), VK_VERTEX_INPUT_RATE_VERTEX}
 	}, {
@@ -158,24 +173,25 @@ void PurrfectPotion::localInit() {
 			sizeof(glm::vec2), UV}
 	});
 
+	// 24 bytes instead of 48: the tangent is octahedral too, with its handedness in the fourth component
 	VD_tangent.init(this, {
-		{0, sizeof(VertexTan), VK_VERTEX_INPUT_RATE_VERTEX}
+		{0, sizeof(VertexTanPacked), VK_VERTEX_INPUT_RATE_VERTEX}
 	}, {
-		{0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexTan, pos),
-			sizeof(glm::vec3), POSITION},
-		{0, 1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(VertexTan, normal),
-			sizeof(glm::vec3), NORMAL},
-		{0, 2, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(VertexTan, tangent),
-			sizeof(glm::vec4), TANGENT},
-		{0, 3, VK_FORMAT_R32G32_SFLOAT, offsetof(VertexTan, UV),
-			sizeof(glm::vec2), UV}
+		{0, 0, VK_FORMAT_R16G16B16A16_SNORM, offsetof(VertexTanPacked, pos),
+			sizeof(VertexTanPacked::pos), POSITION},
+		{0, 1, VK_FORMAT_R16G16_SNORM, offsetof(VertexTanPacked, normal),
+			sizeof(VertexTanPacked::normal), NORMAL},
+		{0, 2, VK_FORMAT_R16G16B16A16_SNORM, offsetof(VertexTanPacked, tangent),
+			sizeof(VertexTanPacked::tangent), TANGENT},
+		{0, 3, VK_FORMAT_R16G16_SFLOAT, offsetof(VertexTanPacked, UV),
+			sizeof(VertexTanPacked::UV), UV}
 	});
 
 	// Pipelines [Shader couples]
 	// The second parameter is the pointer to the vertex definition
 	// Third and fourth parameters are respectively the vertex and fragment shaders
 	// The last array, is a vector of pointer to the layouts of the sets that will be used in this pipeline. The first element will be set 0, and so on..
-	P.init(this, &VD, "shaders/PhongVert.spv", "shaders/PhongFrag.spv", { &DSL_global, &DSL });
+	P.init(this, &VD_packed, "shaders/PhongVert.spv", "shaders/PhongFrag.spv", { &DSL_global, &DSL });
 	P.setAdvancedFeatures(VK_COMPARE_OP_LESS_OR_EQUAL, VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, false);
 
 	P_skyBox.init(this, &VD_skyBox, "shaders/SkyBoxVert.spv", "shaders/SkyBoxFrag.spv", { &DSL_skyBox });
@@ -199,47 +215,58 @@ void PurrfectPotion::localInit() {
 	P_cat.init(this, &VD, "shaders/CatVert.spv", "shaders/CatFrag.spv", { &DSL_global, &DSL });
 	P_cat.setAdvancedFeatures(VK_COMPARE_OP_LESS_OR_EQUAL, VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, true);
 
+	// The text overlay has its own layout, vertex format, pipeline and font atlas
+	text.init(this);
+
+	// Counting copies of the scene pipelines for the heatmaps, with the lights their fragment shaders loop over:
+	// the point lights, the directional light and the collectibles spots (the cauldron spot only at game over).
+	// A constant per pipeline, so the lights channel is an upper bound: fragments outside a spot cone count it too
+	overdraw.init(this);
+	overdraw.addPipeline(P_DRN, "shaders/TanVert.spv", LIGHTS_NUM - 1);
+	overdraw.addPipeline(P_ward, "shaders/TanVert.spv", LIGHTS_NUM - 1);
+	overdraw.addPipeline(P_skyBox, "shaders/SkyBoxVert.spv", 0);
+	overdraw.addPipeline(P, "shaders/PhongVert.spv", LIGHTS_NUM - 1);
+	overdraw.addPipeline(P_cat, "shaders/CatVert.spv", LIGHTS_NUM - 1);
+	overdraw.addPipeline(P_animated, "shaders/AnimatedVert.spv", 0);
+	recordedHeatmap = sim.HEATMAP;
+
 	// Models, textures and Descriptors (values assigned to the uniforms)
 
 	// Create models
 	// The second parameter is the pointer to the vertex definition for this model
 	// The third parameter is the file name
-	// The last is a constant specifying the file type: currently only OBJ or GLTF
-	M_bathtub.init(this,	&VD, "models/bathroom/bathroom_bathtub.gltf", GLTF);
-	M_bidet.init(this,		&VD, "models/bathroom/bathroom_bidet.gltf", GLTF);
-	M_sink.init(this,		&VD, "models/bathroom/bathroom_sink.gltf", GLTF);
-	M_toilet.init(this,		&VD, "models/bathroom/bathroom_toilet.gltf", GLTF);
-
-	M_bed.init(this,		&VD, "models/bedroom/bedroom_bed.gltf", GLTF);
-	M_closet.init(this,		&VD, "models/bedroom/bedroom_closet.gltf", GLTF);
-	M_nighttable.init(this, &VD, "models/bedroom/bedroom_night_table.gltf", GLTF);
-
-	M_bone.init(this,		&VD, "models/collectibles/coll_bone.gltf", GLTF);
-	M_crystal.init(this,	&VD, "models/collectibles/coll_crystal.gltf", GLTF);
-	M_eye.init(this,		&VD, "models/collectibles/coll_eye.gltf", GLTF);
-	M_feather.init(this,	&VD, "models/collectibles/coll_feather.gltf", GLTF);
-	M_leaf.init(this,		&VD, "models/collectibles/coll_leaf.gltf", GLTF);
-	M_potion1.init(this,	&VD, "models/collectibles/coll_potion1.gltf", GLTF);
-	M_potion2.init(this,	&VD, "models/collectibles/coll_potion2.gltf", GLTF);
-
-	M_chair.init(this,		 &VD, "models/kitchen/kitchen_chair.gltf", GLTF);
-	M_fridge.init(this,		 &VD, "models/kitchen/kitchen_fridge.gltf", GLTF);
-	M_kitchen.init(this,	 &VD, "models/kitchen/kitchen_kitchen.gltf", GLTF);
-	M_kitchentable.init(this,&VD, "models/kitchen/kitchen_table.gltf", GLTF);
-
-	M_cauldron.init(this,	&VD, "models/lair/lair_cauldron.gltf", GLTF);
-	M_stonechair.init(this, &VD, "models/lair/lair_chair.gltf", GLTF);
-	M_chest.init(this,		&VD, "models/lair/lair_chest.gltf", GLTF);
-	M_shelf1.init(this,		&VD, "models/lair/lair_shelf1.gltf", GLTF);
-	M_shelf2.init(this,		&VD, "models/lair/lair_shelf2.gltf", GLTF);
-	M_stonetable.init(this, &VD, "models/lair/lair_table.gltf", GLTF);
-	M_web.init(this,		&VD, "models/lair/lair_web.gltf", GLTF);
+	// The last is a constant specifying the file type: OBJ, GLTF, MGCG (encrypted glTF) or GLB (binary glTF)
+	M_bathtub.init(this,	&VD_packed, "models/bathroom/bathroom_bathtub.gltf", GLTF);
+	M_bidet.init(this,		&VD_packed, "models/bathroom/bathroom_bidet.gltf", GLTF);
+	M_sink.init(this,		&VD_packed, "models/bathroom/bathroom_sink.gltf", GLTF);
+	M_toilet.init(this,		&VD_packed, "models/bathroom/bathroom_toilet.gltf", GLTF);
+
+	M_bed.init(this,		&VD_packed, "models/bedroom/bedroom_bed.gltf", GLTF);
+	M_closet.init(this,		&VD_packed, "models/bedroom/bedroom_closet.gltf", GLTF);
+	M_nighttable.init(this, &VD_packed, "models/bedroom/bedroom_night_table.gltf", GLTF);
+
+	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
+		M_item[i].init(this, &VD_packed, collectibleRegistry[i].model, GLTF);
+	}
+
+	M_chair.init(this,		 &VD_packed, "models/kitchen/kitchen_chair.gltf", GLTF);
+	M_fridge.init(this,		 &VD_packed, "models/kitchen/kitchen_fridge.gltf", GLTF);
+	M_kitchen.init(this,	 &VD_packed, "models/kitchen/kitchen_kitchen.gltf", GLTF);
+	M_kitchentable.init(this,&VD_packed, "models/kitchen/kitchen_table.gltf", GLTF);
+
+	M_cauldron.init(this,	&VD_packed, "models/lair/lair_cauldron.gltf", GLTF);
+	M_stonechair.init(this, &VD_packed, "models/lair/lair_chair.gltf", GLTF);
+	M_chest.init(this,		&VD_packed, "models/lair/lair_chest.gltf", GLTF);
+	M_shelf1.init(this,		&VD_packed, "models/lair/lair_shelf1.gltf", GLTF);
+	M_shelf2.init(this,		&VD_packed, "models/lair/lair_shelf2.gltf", GLTF);
+	M_stonetable.init(this, &VD_packed, "models/lair/lair_table.gltf", GLTF);
+	M_web.init(this,		&VD_packed, "models/lair/lair_web.gltf", GLTF);
 	M_steam.init(this,		&VD, "models/lair/lair_steamPlane.gltf", GLTF);
 	M_fire.init(this,		&VD, "models/lair/lair_firePlane.gltf", GLTF);
 
-	M_sofa.init(this,		&VD, "models/livingroom/livingroom_sofa.gltf", GLTF);
-	M_table.init(this,		&VD, "models/livingroom/livingroom_table.gltf", GLTF);
-	M_tv.init(this,			&VD, "models/livingroom/livingroom_tv.gltf", GLTF);
+	M_sofa.init(this,		&VD_packed, "models/livingroom/livingroom_sofa.gltf", GLTF);
+	M_table.init(this,		&VD_packed, "models/livingroom/livingroom_table.gltf", GLTF);
+	M_tv.init(this,			&VD_packed, "models/livingroom/livingroom_tv.gltf", GLTF);
 
 	M_cat.init(this,		&VD, "models/other/cat.gltf", GLTF);
 
@@ -250,21 +277,21 @@ void PurrfectPotion::localInit() {
 
 	M_skyBox.init(this,		&VD_skyBox, "models/sky/SkyBoxCube.obj", OBJ);
 
-	for (int i = 0; i < collectiblesBBs.size(); i++) {
+	for (int i = 0; i < sim.collectiblesBBs.size(); i++) {
 		M_boundingBox.push_back(Model<VertexBoundingBox>());
-		createBBModel(M_boundingBox[i].vertices, M_boundingBox[i].indices, &collectiblesBBs[i]);
+		createBBModel(M_boundingBox[i].vertices, M_boundingBox[i].indices, &sim.collectiblesBBs[i]);
 		M_boundingBox[i].initMesh(this, &VD_boundingBox);
 	}
 
-	for (int i = 0; i < furnitureBBs.size(); i++) {
+	for (int i = 0; i < sim.furnitureBBs.size(); i++) {
 		M_boundingBox.push_back(Model<VertexBoundingBox>());
-		createBBModel(M_boundingBox[i + COLLECTIBLES_NUM].vertices, M_boundingBox[i + COLLECTIBLES_NUM].indices, &furnitureBBs[i]);
+		createBBModel(M_boundingBox[i + COLLECTIBLES_NUM].vertices, M_boundingBox[i + COLLECTIBLES_NUM].indices, &sim.furnitureBBs[i]);
 		M_boundingBox[i + COLLECTIBLES_NUM].initMesh(this, &VD_boundingBox);
 	}
 
 	M_boundingBox.push_back(Model<VertexBoundingBox>());
-	createBBModel(M_boundingBox[COLLECTIBLES_NUM + furnitureBBs.size()].vertices, M_boundingBox[COLLECTIBLES_NUM + furnitureBBs.size()].indices, &catBox);
-	M_boundingBox[COLLECTIBLES_NUM + furnitureBBs.size()].initMesh(this, &VD_boundingBox);
+	createBBModel(M_boundingBox[sim.catBoundingBox()].vertices, M_boundingBox[sim.catBoundingBox()].indices, &sim.catBox);
+	M_boundingBox[sim.catBoundingBox()].initMesh(this, &VD_boundingBox);
 
 
 	// Create HUD screens
@@ -281,13 +308,14 @@ void PurrfectPotion::localInit() {
 	// Create HUD timer
 	anchor = glm::vec2(0.8f, -0.95f);
 	w = 0.15f;						// Respect the aspect ratio since it is a square pic
-	h = w * Ar;
+	h = w * sim.Ar;
 	for (int i = 0; i < 5; i++) {
 		M_timer[i].vertices = { {{anchor.x, anchor.y}, {0.0f,0.0f}}, {{anchor.x, anchor.y + h}, {0.0f,1.0f}},
 								{{anchor.x + w, anchor.y}, {1.0f,0.0f}}, {{ anchor.x + w, anchor.y + h}, {1.0f,1.0f}} };
 		M_timer[i].indices = { 0, 1, 2,    1, 2, 3 };
 		M_timer[i].initMesh(this, &VD_overlay);
 	}
+	timerBottom = glm::vec2(anchor.x + w / 2, anchor.y + h);
 
 	// Create HUD scroll
 	anchor = glm::vec2(-1.005f, -0.9f);
@@ -301,7 +329,7 @@ void PurrfectPotion::localInit() {
 	// Create HUD collectibles
 	anchor = glm::vec2(-1.01f, -0.92f);
 	w = 0.15f;
-	h = w * Ar;
+	h = w * sim.Ar;
 	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
 		anchor = anchor + (glm::vec2(0.f, 0.2f));	// vertically shifting the anchor for each collectible
 
@@ -315,27 +343,31 @@ void PurrfectPotion::localInit() {
 	// The second parameter is the file name
 	T_textures.init(this,	"textures/palette.png");
 	T_closet.init(this,		"textures/closet.png");
-	T_eye.init(this,		"textures/collectibles/eye_diffuse.png");
-	T_feather.init(this,	"textures/collectibles/feather_diffuse.png");
+	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
+		if (collectibleRegistry[i].texture != nullptr) {
+			T_item[i].init(this, collectibleRegistry[i].texture);
+		}
+	}
 	T_steam.init(this,		"textures/lair/steam.png");
 	T_fire.init(this,		"textures/lair/fire.png");
 
+	// The normal maps carry the roughness (the specular intensity for the knight) in alpha
 	T_wall[0].init(this,	"textures/wall/wall_diffuse.jpg");
-	T_wall[1].init(this,	"textures/wall/wall_normal.jpg", VK_FORMAT_R8G8B8A8_UNORM);
-	T_wall[2].init(this,	"textures/wall/wall_roughness.jpg");
+	T_wall[1].initPacked(this, "textures/wall/wall_normal_roughness.png",
+		"textures/wall/wall_normal.jpg", "textures/wall/wall_roughness.jpg", VK_FORMAT_R8G8B8A8_UNORM);
 
 	T_floor[0].init(this,	"textures/floor/floor_diffuse.jpg");
-	T_floor[1].init(this,	"textures/floor/floor_normal.jpg", VK_FORMAT_R8G8B8A8_UNORM);
-	T_floor[2].init(this,	"textures/floor/floor_roughness.jpg");
+	T_floor[1].initPacked(this, "textures/floor/floor_normal_roughness.png",
+		"textures/floor/floor_normal.jpg", "textures/floor/floor_roughness.jpg", VK_FORMAT_R8G8B8A8_UNORM);
 
 	T_knight[0].init(this, "textures/knight/knight_diffuse.png");
-	T_knight[1].init(this, "textures/knight/knight_specular.png");
-	T_knight[2].init(this, "textures/knight/knight_normal.png", VK_FORMAT_R8G8B8A8_UNORM);
+	T_knight[1].initPacked(this, "textures/knight/knight_normal_specular.png",
+		"textures/knight/knight_normal.png", "textures/knight/knight_specular.png", VK_FORMAT_R8G8B8A8_UNORM);
 
 	T_catDiffuseGhost.init(this,"textures/cat/cat_diffuse_ghost.png");
 	T_cat[0].init(this,			"textures/cat/cat_diffuse.png");
-	T_cat[1].init(this,			"textures/cat/cat_normal.jpg", VK_FORMAT_R8G8B8A8_UNORM);
-	T_cat[2].init(this,			"textures/cat/cat_roughness.jpg");
+	T_cat[1].initPacked(this, "textures/cat/cat_normal_roughness.png",
+		"textures/cat/cat_normal.jpg", "textures/cat/cat_roughness.jpg", VK_FORMAT_R8G8B8A8_UNORM);
 
 	T_skyBox.init(this,		"textures/sky_Texture.jpg");
 
@@ -352,13 +384,9 @@ void PurrfectPotion::localInit() {
 
 	T_scroll.init(this, "textures/HUD/scroll.png");
 
-	T_collectibles[collectiblesHUD["crystal"]].init(this,	"textures/HUD/coll_crystal.png");
-	T_collectibles[collectiblesHUD["eye"]].init(this,		"textures/HUD/coll_eye.png");
-	T_collectibles[collectiblesHUD["feather"]].init(this,	"textures/HUD/coll_feather.png");
-	T_collectibles[collectiblesHUD["leaf"]].init(this,		"textures/HUD/coll_leaf.png");
-	T_collectibles[collectiblesHUD["potion1"]].init(this,	"textures/HUD/coll_potion1.png");
-	T_collectibles[collectiblesHUD["potion2"]].init(this,	"textures/HUD/coll_potion2.png");
-	T_collectibles[collectiblesHUD["bone"]].init(this,		"textures/HUD/coll_bone.png");
+	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
+		T_collectibles[i].init(this, collectibleRegistry[i].hudIcon);
+	}
 }
 
 // Here you create your pipelines and Descriptor Sets!
@@ -372,6 +400,8 @@ void PurrfectPotion::pipelinesAndDescriptorSetsInit() {
 	P_ward.create();
 	P_DRN.create();
 	P_cat.create();
+	text.create();
+	overdraw.create();
 
 	// Here you define the data set
 	// the second parameter, is a pointer to the Uniform Set Layout of this set
@@ -382,235 +412,203 @@ void PurrfectPotion::pipelinesAndDescriptorSetsInit() {
 		// third  element : only for UNIFORMs, the size of the corresponding C++ object. For texture, just put 0
 		// fourth element : only for TEXTUREs, the pointer to the corresponding texture object. For uniforms, use nullptr
 		{0, UNIFORM, sizeof(GlobalUniformBufferObject), nullptr}
-	});
+	}, "DS_global");
 
 	DS_skyBox.init(this, &DSL_skyBox, {
 		{0, UNIFORM, sizeof(SkyBoxUniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_skyBox},
 		{2, UNIFORM, sizeof(float), nullptr}
-	});
+	}, "DS_skyBox");
 
 	DS_bed.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},		 
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}  // Emissive color binding
-	});
+	}, "DS_bed");
 	DS_closet.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_closet},
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_closet");
 	DS_nighttable.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_nighttable");
 
 	DS_bathtub.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_bathtub");
 
 	DS_bidet.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_bidet");
 	DS_sink.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},	 
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_sink");
 	DS_toilet.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_toilet");
 
-	DS_bone.init(this, &DSL, {
-		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
-		{1, TEXTURE, 0, &T_textures},	 
-		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
-	DS_crystal.init(this, &DSL, {
-		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
-		{1, TEXTURE, 0, &T_textures},
-		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
-	DS_eye.init(this, &DSL, {
-		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
-		{1, TEXTURE, 0, &T_eye},	 
-		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
-	DS_feather.init(this, &DSL, {
-		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
-		{1, TEXTURE, 0, &T_feather},
-		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
-	DS_leaf.init(this, &DSL, {
-		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
-		{1, TEXTURE, 0, &T_textures},
-		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
-	DS_potion1.init(this, &DSL, {
-		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
-		{1, TEXTURE, 0, &T_textures},
-		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
-	DS_potion2.init(this, &DSL, {
-		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
-		{1, TEXTURE, 0, &T_textures},
-		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
+		DS_item[i].init(this, &DSL, {
+			{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
+			{1, TEXTURE, 0, collectibleRegistry[i].texture != nullptr ? &T_item[i] : &T_textures},
+			{2, UNIFORM, sizeof(glm::vec3), nullptr}
+		}, "DS_item[" + std::to_string(i) + "]");
+	}
 
 	DS_chair.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_chair");
 	DS_fridge.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_fridge");
 	DS_kitchen.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_kitchen");
 	DS_kitchentable.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures}, 
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_kitchentable");
 
 	DS_cauldron.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},	 
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_cauldron");
 	DS_stonechair.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},		 
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_stonechair");
 	DS_chest.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_chest");
 	DS_shelf1.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},	 
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_shelf1");
 	DS_shelf2.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_shelf2");
 	DS_stonetable.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_stonetable");
 	DS_web.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_web");
 	DS_steam.init(this, &DSL_animated, {
 		{0, UNIFORM, sizeof(AnimatedUniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_steam}
-	});
+	}, "DS_steam");
 	DS_fire.init(this, &DSL_animated, {
 		{0, UNIFORM, sizeof(AnimatedUniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_fire}
-	});
+	}, "DS_fire");
 
 	DS_sofa.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},	 
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_sofa");
 	DS_table.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_table");
 	DS_tv.init(this, &DSL, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_textures},
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_tv");
 	DS_knight.init(this, &DSL_ward, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_knight[0]},
 		{2, UNIFORM, sizeof(glm::vec3), nullptr},
-		{3, TEXTURE, 0, &T_knight[1]},
-		{4, TEXTURE, 0, &T_knight[2]}
-	});
+		{3, TEXTURE, 0, &T_knight[1]}
+	}, "DS_knight");
 
 	DS_cat.init(this, &DSL, {
 		{0, UNIFORM, sizeof(AnimatedUniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_catDiffuseGhost},	 
 		{2, UNIFORM, sizeof(glm::vec3), nullptr}
-	});
+	}, "DS_cat");
 	DS_catFainted.init(this, &DSL_DRN, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_cat[0]},	 
 		{2, UNIFORM, sizeof(glm::vec3), nullptr},
-		{3, TEXTURE, 0, &T_cat[1]},
-		{4, TEXTURE, 0, &T_cat[2]}
-	});
+		{3, TEXTURE, 0, &T_cat[1]}
+	}, "DS_catFainted");
 
 	DS_floor.init(this, &DSL_DRN, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_floor[0]},	 
 		{2, UNIFORM, sizeof(glm::vec3), nullptr},
-		{3, TEXTURE, 0, &T_floor[1]},
-		{4, TEXTURE, 0, &T_floor[2]}
-	});
+		{3, TEXTURE, 0, &T_floor[1]}
+	}, "DS_floor");
 	DS_walls.init(this, &DSL_DRN, {
 		{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
 		{1, TEXTURE, 0, &T_wall[0]},	 
 		{2, UNIFORM, sizeof(glm::vec3), nullptr},
-		{3, TEXTURE, 0, &T_wall[1]},
-		{4, TEXTURE, 0, &T_wall[2]}
-	});
+		{3, TEXTURE, 0, &T_wall[1]}
+	}, "DS_walls");
 
-	for (int i = 0; i < collectiblesBBs.size() + furnitureBBs.size() + 1; i++) {
+	for (int i = 0; i < sim.UBO_boundingBox.size(); i++) {
 		DS_boundingBox.push_back(DescriptorSet());
 		DS_boundingBox[i].init(this, &DSL_boundingBox, {
 				{0, UNIFORM, sizeof(UniformBufferObject), nullptr},
-		});
+		}, "DS_boundingBox[" + std::to_string(i) + "]");
 	}
 
 	for (int i = 0; i < 4; i++) {
 		DS_screens[i].init(this, &DSL_overlay, {
 			{0, UNIFORM, sizeof(OverlayUniformBlock), nullptr},
 			{1, TEXTURE, 0, &T_screens[i]}
-		});
+		}, "DS_screens[" + std::to_string(i) + "]");
 	}
 
 	for (int i = 0; i < 5; i++) {
 		DS_timer[i].init(this, &DSL_overlay, {
 			{0, UNIFORM, sizeof(OverlayUniformBlock), nullptr},
 			{1, TEXTURE, 0, &T_timer[i]}
-		});
+		}, "DS_timer[" + std::to_string(i) + "]");
 	}
 
 	DS_scroll.init(this, &DSL_overlay, {
 		{0, UNIFORM, sizeof(OverlayUniformBlock), nullptr},
 		{1, TEXTURE, 0, &T_scroll}
-	});
+	}, "DS_scroll");
 
 	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
 		DS_collectibles[i].init(this, &DSL_overlay, {
 			{0, UNIFORM, sizeof(OverlayUniformBlock), nullptr},
 			{1, TEXTURE, 0, &T_collectibles[i]}
-		});
+		}, "DS_collectibles[" + std::to_string(i) + "]");
 	}
 }
 
@@ -626,6 +624,8 @@ void PurrfectPotion::pipelinesAndDescriptorSetsCleanup() {
 	P_ward.cleanup();
 	P_DRN.cleanup();
 	P_cat.cleanup();
+	text.cleanup();
+	overdraw.cleanup();
 
 	// Cleanup datasets
 	DS_bathtub.cleanup();
@@ -637,13 +637,9 @@ void PurrfectPotion::pipelinesAndDescriptorSetsCleanup() {
 	DS_closet.cleanup();
 	DS_nighttable.cleanup();
 
-	DS_bone.cleanup();
-	DS_crystal.cleanup();
-	DS_eye.cleanup();
-	DS_feather.cleanup();
-	DS_leaf.cleanup();
-	DS_potion1.cleanup();
-	DS_potion2.cleanup();
+	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
+		DS_item[i].cleanup();
+	}
 
 	DS_chair.cleanup();
 	DS_fridge.cleanup();
@@ -673,7 +669,7 @@ void PurrfectPotion::pipelinesAndDescriptorSetsCleanup() {
 	DS_skyBox.cleanup();
 	DS_global.cleanup();
 
-	for (int i = 0; i < COLLECTIBLES_NUM + furnitureBBs.size() + 1; i++) {
+	for (int i = 0; i < DS_boundingBox.size(); i++) {
 		DS_boundingBox[i].cleanup();
 	}
 
@@ -696,11 +692,16 @@ void PurrfectPotion::pipelinesAndDescriptorSetsCleanup() {
 // All the object classes defined in Starter.hpp have a method .cleanup() for this purpose
 // You also have to destroy the pipelines: since they need to be rebuilt, they have two methods: .cleanup() recreates them, while .destroy() delete them completely
 void PurrfectPotion::localCleanup() {
+	recorder.close();
+
 	// Cleanup textures
 	T_textures.cleanup();
-	T_eye.cleanup();
 	T_closet.cleanup();
-	T_feather.cleanup();
+	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
+		if (collectibleRegistry[i].texture != nullptr) {
+			T_item[i].cleanup();
+		}
+	}
 	T_steam.cleanup();
 	T_fire.cleanup();
 
@@ -708,7 +709,7 @@ void PurrfectPotion::localCleanup() {
 
 	T_skyBox.cleanup();
 
-	for (int i = 0; i < 3; i++) {
+	for (int i = 0; i < 2; i++) {
 		T_wall[i].cleanup();
 		T_floor[i].cleanup();
 		T_cat[i].cleanup();
@@ -739,13 +740,9 @@ void PurrfectPotion::localCleanup() {
 	M_closet.cleanup();
 	M_nighttable.cleanup();
 
-	M_bone.cleanup();
-	M_crystal.cleanup();
-	M_eye.cleanup();
-	M_feather.cleanup();
-	M_leaf.cleanup();
-	M_potion1.cleanup();
-	M_potion2.cleanup();
+	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
+		M_item[i].cleanup();
+	}
 
 	M_chair.cleanup();
 	M_fridge.cleanup();
@@ -774,7 +771,7 @@ void PurrfectPotion::localCleanup() {
 
 	M_skyBox.cleanup();
 
-	for (int i = 0; i < COLLECTIBLES_NUM + furnitureBBs.size() + 1; i++) {
+	for (int i = 0; i < M_boundingBox.size(); i++) {
 		M_boundingBox[i].cleanup();
 	}
 
@@ -811,13 +808,21 @@ void PurrfectPotion::localCleanup() {
 	P_ward.destroy();
 	P_DRN.destroy();
 	P_cat.destroy();
-}
 
-// Here it is the creation of the command buffer:
-// You send to the GPU all the objects you want to draw, with their buffers and textures
-void PurrfectPotion::populateCommandBuffer(VkCommandBuffer commandBuffer, int currentImage) {
+	text.destroy();
+	overdraw.destroy();
 
+	if (overdrawFrames > 0) {
+		LOG_INFO("Overdraw: %.2f fragments and at most %.2f lights per pixel on average over %d frames",
+			overdrawFragmentsSum / overdrawFrames, overdrawLightsSum / overdrawFrames, overdrawFrames);
+	}
+}
+
+// The scene, without the HUD: in the main render pass, or with the counting pipelines in the overdraw pass
+void PurrfectPotion::drawScene(VkCommandBuffer commandBuffer, int currentImage, bool counting) {
 	// P_DRN pipeline
+	beginRegion(commandBuffer, currentImage, counting ? "overdraw P_DRN" : "P_DRN");
+	Pipeline& P_DRN = counting ? overdraw.counting(this->P_DRN) : this->P_DRN;
 	P_DRN.bind(commandBuffer);
 
 	// DS_global is binded to P_DRN with set = 0
@@ -825,17 +830,19 @@ void PurrfectPotion::populateCommandBuffer(VkCommandBuffer commandBuffer, int cu
 
 	DS_catFainted.bind(commandBuffer, P_DRN, 1, currentImage);
 	M_catFainted.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_catFainted.indices.size()), 1, 0, 0, 0);
+	M_catFainted.draw(commandBuffer);
 
 	DS_floor.bind(commandBuffer, P_DRN, 1, currentImage);
 	M_floor.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_floor.indices.size()), 1, 0, 0, 0);
+	M_floor.draw(commandBuffer);
 
 	DS_walls.bind(commandBuffer, P_DRN, 1, currentImage);
 	M_walls.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_walls.indices.size()), 1, 0, 0, 0);
+	M_walls.draw(commandBuffer);
 
 	// P_ward pipeline
+	beginRegion(commandBuffer, currentImage, counting ? "overdraw P_ward" : "P_ward");
+	Pipeline& P_ward = counting ? overdraw.counting(this->P_ward) : this->P_ward;
 	P_ward.bind(commandBuffer);
 
 	// DS_global is binded to P_ward with set = 0
@@ -843,23 +850,30 @@ void PurrfectPotion::populateCommandBuffer(VkCommandBuffer commandBuffer, int cu
 
 	DS_knight.bind(commandBuffer, P_ward, 1, currentImage);
 	M_knight.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_knight.indices.size()), 1, 0, 0, 0);
+	M_knight.draw(commandBuffer);
 
 	// P_skyBox pipeline
+	beginRegion(commandBuffer, currentImage, counting ? "overdraw P_skyBox" : "P_skyBox");
+	Pipeline& P_skyBox = counting ? overdraw.counting(this->P_skyBox) : this->P_skyBox;
 	P_skyBox.bind(commandBuffer);
 	M_skyBox.bind(commandBuffer);
 	DS_skyBox.bind(commandBuffer, P_skyBox, 0, currentImage);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_skyBox.indices.size()), 1, 0, 0, 0);
-
-	// P_boundingBox pipeline
-	P_boundingBox.bind(commandBuffer);
-	for (int i = 0; i < collectiblesBBs.size() + furnitureBBs.size() + 1; i++) {
-		M_boundingBox[i].bind(commandBuffer);
-		DS_boundingBox[i].bind(commandBuffer, P_boundingBox, 0, currentImage);
-		vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_boundingBox[i].indices.size()), 1, 0, 0, 0);
+	M_skyBox.draw(commandBuffer);
+
+	// P_boundingBox pipeline, not counted: the boxes are a debugging aid
+	if (!counting) {
+		beginRegion(commandBuffer, currentImage, "P_boundingBox");
+		P_boundingBox.bind(commandBuffer);
+		for (int i = 0; i < M_boundingBox.size(); i++) {
+			M_boundingBox[i].bind(commandBuffer);
+			DS_boundingBox[i].bind(commandBuffer, P_boundingBox, 0, currentImage);
+			M_boundingBox[i].draw(commandBuffer);
+		}
 	}
 
 	// P pipeline
+	beginRegion(commandBuffer, currentImage, counting ? "overdraw P" : "P");
+	Pipeline& P = counting ? overdraw.counting(this->P) : this->P;
 	P.bind(commandBuffer);
 	// For a pipeline object, this command binds the corresponing pipeline to the command buffer passed in its parameter binds the data set
 
@@ -874,119 +888,98 @@ void PurrfectPotion::populateCommandBuffer(VkCommandBuffer commandBuffer, int cu
 	M_bed.bind(commandBuffer);
 	// For a Model object, this command binds the corresponing index and vertex buffer
 	// to the command buffer passed in its parameter
-	// record the drawing command in the command buffer
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_bed.indices.size()), 1, 0, 0, 0);
-	// the second parameter is the number of indexes to be drawn. For a Model object, this can be retrieved with the .indices.size() method
+	// record the drawing command in the command buffer: all the indices of the model, counted in drawCalls
+	M_bed.draw(commandBuffer);
 
 	DS_closet.bind(commandBuffer, P, 1, currentImage);
 	M_closet.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_closet.indices.size()), 1, 0, 0, 0);
+	M_closet.draw(commandBuffer);
 
 	DS_nighttable.bind(commandBuffer, P, 1, currentImage);
 	M_nighttable.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_nighttable.indices.size()), 1, 0, 0, 0);
+	M_nighttable.draw(commandBuffer);
 
 	DS_bathtub.bind(commandBuffer, P, 1, currentImage);
 	M_bathtub.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_bathtub.indices.size()), 1, 0, 0, 0);
+	M_bathtub.draw(commandBuffer);
 
 	DS_bidet.bind(commandBuffer, P, 1, currentImage);
 	M_bidet.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_bidet.indices.size()), 1, 0, 0, 0);
+	M_bidet.draw(commandBuffer);
 
 	DS_sink.bind(commandBuffer, P, 1, currentImage);
 	M_sink.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_sink.indices.size()), 1, 0, 0, 0);
+	M_sink.draw(commandBuffer);
 
 	DS_toilet.bind(commandBuffer, P, 1, currentImage);
 	M_toilet.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_toilet.indices.size()), 1, 0, 0, 0);
-
-	DS_bone.bind(commandBuffer, P, 1, currentImage);
-	M_bone.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_bone.indices.size()), 1, 0, 0, 0);
-
-	DS_crystal.bind(commandBuffer, P, 1, currentImage);
-	M_crystal.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_crystal.indices.size()), 1, 0, 0, 0);
-
-	DS_eye.bind(commandBuffer, P, 1, currentImage);
-	M_eye.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_eye.indices.size()), 1, 0, 0, 0);
-
-	DS_feather.bind(commandBuffer, P, 1, currentImage);
-	M_feather.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_feather.indices.size()), 1, 0, 0, 0);
-
-	DS_leaf.bind(commandBuffer, P, 1, currentImage);
-	M_leaf.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_leaf.indices.size()), 1, 0, 0, 0);
+	M_toilet.draw(commandBuffer);
 
-	DS_potion1.bind(commandBuffer, P, 1, currentImage);
-	M_potion1.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_potion1.indices.size()), 1, 0, 0, 0);
-
-	DS_potion2.bind(commandBuffer, P, 1, currentImage);
-	M_potion2.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_potion2.indices.size()), 1, 0, 0, 0);
+	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
+		DS_item[i].bind(commandBuffer, P, 1, currentImage);
+		M_item[i].bind(commandBuffer);
+		M_item[i].draw(commandBuffer);
+	}
 
 	DS_chair.bind(commandBuffer, P, 1, currentImage);
 	M_chair.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_chair.indices.size()), 1, 0, 0, 0);
+	M_chair.draw(commandBuffer);
 
 	DS_fridge.bind(commandBuffer, P, 1, currentImage);
 	M_fridge.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_fridge.indices.size()), 1, 0, 0, 0);
+	M_fridge.draw(commandBuffer);
 
 	DS_kitchen.bind(commandBuffer, P, 1, currentImage);
 	M_kitchen.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_kitchen.indices.size()), 1, 0, 0, 0);
+	M_kitchen.draw(commandBuffer);
 
 	DS_kitchentable.bind(commandBuffer, P, 1, currentImage);
 	M_kitchentable.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_kitchentable.indices.size()), 1, 0, 0, 0);
+	M_kitchentable.draw(commandBuffer);
 
 	DS_cauldron.bind(commandBuffer, P, 1, currentImage);
 	M_cauldron.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_cauldron.indices.size()), 1, 0, 0, 0);
+	M_cauldron.draw(commandBuffer);
 
 	DS_stonechair.bind(commandBuffer, P, 1, currentImage);
 	M_stonechair.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_stonechair.indices.size()), 1, 0, 0, 0);
+	M_stonechair.draw(commandBuffer);
 
 	DS_chest.bind(commandBuffer, P, 1, currentImage);
 	M_chest.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_chest.indices.size()), 1, 0, 0, 0);
+	M_chest.draw(commandBuffer);
 
 	DS_shelf1.bind(commandBuffer, P, 1, currentImage);
 	M_shelf1.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_shelf1.indices.size()), 1, 0, 0, 0);
+	M_shelf1.draw(commandBuffer);
 
 	DS_shelf2.bind(commandBuffer, P, 1, currentImage);
 	M_shelf2.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_shelf2.indices.size()), 1, 0, 0, 0);
+	M_shelf2.draw(commandBuffer);
 
 	DS_stonetable.bind(commandBuffer, P, 1, currentImage);
 	M_stonetable.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_stonetable.indices.size()), 1, 0, 0, 0);
+	M_stonetable.draw(commandBuffer);
 
 	DS_web.bind(commandBuffer, P, 1, currentImage);
 	M_web.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_web.indices.size()), 1, 0, 0, 0);
+	M_web.draw(commandBuffer);
 
 	DS_sofa.bind(commandBuffer, P, 1, currentImage);
 	M_sofa.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_sofa.indices.size()), 1, 0, 0, 0);
+	M_sofa.draw(commandBuffer);
 
 	DS_table.bind(commandBuffer, P, 1, currentImage);
 	M_table.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_table.indices.size()), 1, 0, 0, 0);
+	M_table.draw(commandBuffer);
 
 	DS_tv.bind(commandBuffer, P, 1, currentImage);
 	M_tv.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_tv.indices.size()), 1, 0, 0, 0);
+	M_tv.draw(commandBuffer);
 
 	// P_cat pipeline
+	beginRegion(commandBuffer, currentImage, counting ? "overdraw P_cat" : "P_cat");
+	Pipeline& P_cat = counting ? overdraw.counting(this->P_cat) : this->P_cat;
 	P_cat.bind(commandBuffer);
 
 	// DS_global is binded to P_cat with set = 0
@@ -994,744 +987,422 @@ void PurrfectPotion::populateCommandBuffer(VkCommandBuffer commandBuffer, int cu
 
 	DS_cat.bind(commandBuffer, P_cat, 1, currentImage);
 	M_cat.bind(commandBuffer);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_cat.indices.size()), 1, 0, 0, 0);
+	M_cat.draw(commandBuffer);
 
 	// P_animated pipeline
+	beginRegion(commandBuffer, currentImage, counting ? "overdraw P_animated" : "P_animated");
+	Pipeline& P_animated = counting ? overdraw.counting(this->P_animated) : this->P_animated;
 	P_animated.bind(commandBuffer);
 	M_steam.bind(commandBuffer);
 	DS_steam.bind(commandBuffer, P_animated, 0, currentImage);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_steam.indices.size()), 1, 0, 0, 0);
+	M_steam.draw(commandBuffer);
 
 	M_fire.bind(commandBuffer);
 	DS_fire.bind(commandBuffer, P_animated, 0, currentImage);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_fire.indices.size()), 1, 0, 0, 0);
-
-
-	// P_overlay pipeline
-	P_overlay.bind(commandBuffer);
-	for (int i = 0; i < 4; i++) {
-		M_screens[i].bind(commandBuffer);
-		DS_screens[i].bind(commandBuffer, P_overlay, 0, currentImage);
-		vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_screens[i].indices.size()), 1, 0, 0, 0);
-	}
-
-	for (int i = 0; i < 5; i++) {
-		M_timer[i].bind(commandBuffer);
-		DS_timer[i].bind(commandBuffer, P_overlay, 0, currentImage);
-		vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_timer[i].indices.size()), 1, 0, 0, 0);
-	}
-
-	M_scroll.bind(commandBuffer);
-	DS_scroll.bind(commandBuffer, P_overlay, 0, currentImage);
-	vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_scroll.indices.size()), 1, 0, 0, 0);
-
-	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
-		M_collectibles[i].bind(commandBuffer);
-		DS_collectibles[i].bind(commandBuffer, P_overlay, 0, currentImage);
-		vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(M_collectibles[i].indices.size()), 1, 0, 0, 0);
-	}
-
+	M_fire.draw(commandBuffer);
 }
 
-// Here is where you update the uniforms. Very likely this will be where you will be writing the logic of your application.
-void PurrfectPotion::updateUniformBuffer(uint32_t currentImage) {
-	// Standard procedure to quit when the ESC key is pressed
-	if (glfwGetKey(window, GLFW_KEY_ESCAPE)) {
-		glfwSetWindowShouldClose(window, GL_TRUE);
-	}
-
-	// Integration with the timers and the controllers
-	float deltaT;
-	glm::vec3 m = glm::vec3(0.0f), r = glm::vec3(0.0f);
-	bool fire = false;
-	bool start = false;
-	getSixAxis(deltaT, m, r, fire, start);
-	// getSixAxis() is defined in Starter.hpp in the base class.
-	// It fills the float point variable passed in its first parameter with the time since the last call to the procedure.
-	// It fills vec3 in the second parameters, with three values in the -1,1 range corresponding to motion (with left stick of the gamepad, or ASWD + RF keys on the keyboard)
-	// It fills vec3 in the third parameters, with three values in the -1,1 range corresponding to motion (with right stick of the gamepad, or Arrow keys + QE keys on the keyboard, or mouse)
-	// If fills the fourth boolean variable with true if fire has been pressed: SPACE on the keyboard, A or B button on the Gamepad, Right mouse button
-	// If fills the last boolean variable with true if start has been pressed: ENTER on the keyboard or Start button on the Gamepad
-
-	glm::mat4 World;
-	glm::mat4 ViewPrj;
-	glm::mat4 Mv;
-
-	// Parameters for camera movement and rotation
-	ROT_SPEED = glm::radians(150.0f);
-	MOVE_SPEED = 6.0f;
-
-	totalElapsedTime += deltaT;
-
-	if (gameState == GAME_STATE_START_SCREEN || gameState == GAME_STATE_GAME_WIN || gameState == GAME_STATE_GAME_LOSE) {
-		updateMenuScene(start, currentImage);
-	} else if (gameState == GAME_STATE_PLAY) {
-		updateGame(debounce, curDebounce, deltaT, m, r, currentImage);
-	}
-	
-	// Press I to show instruction screen
-	if (glfwGetKey(window, GLFW_KEY_I)) {
-		if (!debounce) {
-			debounce = true;
-			curDebounce = GLFW_KEY_I;
-			UBO_screens[3].visible = 1.0f - UBO_screens[3].visible;
-			UBO_screens[0].visible = UBO_screens[1].visible = UBO_screens[2].visible = 0.f;
-			showInstruction = !showInstruction;
-			OVERLAY = (gameState == GAME_STATE_PLAY) ? !OVERLAY : false;
-			cursorShowed = !cursorShowed;
-		}
-	} else if ((curDebounce == GLFW_KEY_I) && debounce) {
-		debounce = false;
-		curDebounce = 0;
-	}
-
-	// Limit the cat's movement to the house
-	catPosition.x = glm::clamp(catPosition.x, -11.8f, 11.8f);
-	catPosition.z = glm::clamp(catPosition.z, -11.8f, 11.8f);
-
-	// Parameters
-	// Camera FOV-y, Near Plane and Far Plane
-	// Set up the view and projection matrices
-	const float FOVy = FIRST_PERSON ? glm::radians(25.0f) : glm::radians(60.0f);
-	const float nearPlane = 0.1f;
-	const float farPlane = 30.0f;
-
-	glm::mat4 M = glm::perspective(FOVy, Ar, nearPlane, farPlane);
-	M[1][1] *= -1;
-
-	// View matrix for camera following the cat
-	if (FIRST_PERSON || gameState != GAME_STATE_PLAY) {
-		Mv = glm::rotate(glm::mat4(1.0f), -camRoll, glm::vec3(0, 0, 1)) *
-				glm::rotate(glm::mat4(1.0f), -camPitch, glm::vec3(1, 0, 0)) *
-				glm::rotate(glm::mat4(1.0f), -camYaw, glm::vec3(0, 1, 0)) *
-				glm::translate(glm::mat4(1.0f), -camPos);
-		ViewPrj = M * Mv;
-	} else if (!FIRST_PERSON && gameState == GAME_STATE_PLAY) {
-		Mv = glm::rotate(glm::mat4(1.0f), -camRoll, glm::vec3(0, 0, 1)) *
-				glm::lookAt(camPos, catPosition, glm::vec3(0, 1, 0));
-		ViewPrj = M * Mv;
-	}
-
-	// Update rotation angle of the collectibles
-	collectibleRotationAngle = fmod(collectibleRotationAngle + deltaT, 2 * M_PI);
-
-	// Update the collectibles' vertical position for floating effect
-	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
-		collectiblesRandomPosition[i].y = 0.3f + 0.05f * sin((totalElapsedTime + i) * 3);
+// Counter pass of the heatmaps, before the main render pass
+void PurrfectPotion::populateCommandBufferPrePass(VkCommandBuffer commandBuffer, int currentImage) {
+	if (recordedHeatmap == GameSimulation::HEATMAP_OFF) {
+		return;
 	}
-
-	updateLights(currentImage);
-
-	// Sky Box UBO update
-	UBO_skyBox.mvpMat = M * glm::mat4(glm::mat3(Mv));
-	UBO_skyBox.time = totalElapsedTime;
-	DS_skyBox.map(currentImage, &UBO_skyBox, sizeof(UBO_skyBox), 0);
-
-	updateSteamAndFire(World, ViewPrj, currentImage);
-
-	updateOverlay(currentImage);
-
-	worldSetUp(catPosition, ViewPrj, currentImage);
-
-	checkCollisions(currentImage, m, deltaT);
+	overdraw.beginPass(commandBuffer);
+	drawScene(commandBuffer, currentImage, true);
+	endRegion(commandBuffer, currentImage);
+	overdraw.endPass(commandBuffer, currentImage);
 }
 
-void PurrfectPotion::checkCollisions(uint32_t currentImage, glm::vec3& m, float deltaT) {
-	// Collectibles
-	for (int i = 0; i < collectiblesBBs.size(); i++) {
-		if (catBox.intersects(collectiblesBBs[i])) {
-			collectiblesMap[collectiblesBBs[i].getName()] = true;
-
-			int collectibleIndex = collectiblesHUD[collectiblesBBs[i].getName()];
-
-			UBO_collectibles[collectibleIndex].visible = 0.f;
-			DS_collectibles[collectibleIndex].map(currentImage, &UBO_collectibles[collectibleIndex], sizeof(UBO_collectibles[collectibleIndex]), 0);
+// Here it is the creation of the command buffer:
+// You send to the GPU all the objects you want to draw, with their buffers and textures
+void PurrfectPotion::populateCommandBuffer(VkCommandBuffer commandBuffer, int currentImage) {
 
-			if (collectiblesMap["crystal"] && collectiblesMap["eye"] && collectiblesMap["feather"] &&
-				collectiblesMap["leaf"] && collectiblesMap["potion1"] && collectiblesMap["potion2"] && collectiblesMap["bone"]) {
+	if (recordedHeatmap != GameSimulation::HEATMAP_OFF) {
+		// The counters instead of the scene, under the text
+		beginRegion(commandBuffer, currentImage, "overdraw heatmap");
+		overdraw.draw(commandBuffer, currentImage,
+			recordedHeatmap == GameSimulation::HEATMAP_OVERDRAW ? OverdrawView::FRAGMENTS : OverdrawView::LIGHTS);
+	} else {
+		drawScene(commandBuffer, currentImage, false);
+
+		// P_overlay pipeline
+		beginRegion(commandBuffer, currentImage, "P_overlay");
+		P_overlay.bind(commandBuffer);
+		for (int i = 0; i < 4; i++) {
+			M_screens[i].bind(commandBuffer);
+			DS_screens[i].bind(commandBuffer, P_overlay, 0, currentImage);
+			M_screens[i].draw(commandBuffer);
+		}
 
-				std::cout << "\nALL COLLECTIBLES COLLECTED! Now go to the cauldron!" << std::endl;
-				gameOver = true;
-			}
+		for (int i = 0; i < 5; i++) {
+			M_timer[i].bind(commandBuffer);
+			DS_timer[i].bind(commandBuffer, P_overlay, 0, currentImage);
+			M_timer[i].draw(commandBuffer);
 		}
-	}
 
-	// Furniture
-	for (int j = 0; j < furnitureBBs.size(); j++) {
-		if (catBox.intersects(furnitureBBs[j])) {
-			if (furnitureBBs[j].getName() == "cauldron") {
-				if (gameOver) {
-					gameState = GAME_STATE_GAME_WIN;
-				} else {
-					break;
-				}
-			}
-			catPosition += cameraForward * m.z * MOVE_SPEED * deltaT;
-			catPosition -= cameraRight * m.x * MOVE_SPEED * deltaT;
+		M_scroll.bind(commandBuffer);
+		DS_scroll.bind(commandBuffer, P_overlay, 0, currentImage);
+		M_scroll.draw(commandBuffer);
 
-			std::cout << "Collision with " << furnitureBBs[j].getName() << std::endl;
+		for (int i = 0; i < COLLECTIBLES_NUM; i++) {
+			M_collectibles[i].bind(commandBuffer);
+			DS_collectibles[i].bind(commandBuffer, P_overlay, 0, currentImage);
+			M_collectibles[i].draw(commandBuffer);
 		}
 	}
-}
-
-void PurrfectPotion::worldSetUp(const glm::vec3& catPosition, const glm::mat4& ViewPrj, uint32_t currentImage) {
-
-	// Placing ghost cat
-	placeGhostCat(UBO_cat, catPosition, glm::vec3(0, catYaw, 0), FIRST_PERSON ? glm::vec3(0.0f) : glm::vec3(1.f), glm::vec3(3.0f), ViewPrj, DS_cat, currentImage, DEBUG, 8); // 16);
-	catBox = BoundingBox("cat", catPosition, catDimensions);
-
-	// House
-	placeEntity(UBO_floor, houseFloor.pos, houseFloor.rot, houseFloor.scale, glm::vec3(0.0f), ViewPrj, DS_floor, currentImage, false);
-	placeEntity(UBO_walls, walls.pos, walls.rot, walls.scale, glm::vec3(0.0f), ViewPrj, DS_walls, currentImage, false);
-
-	// Bedroom
-	placeEntity(UBO_closet, closet.pos, closet.rot, closet.scale, glm::vec3(0.0f), ViewPrj, DS_closet, currentImage, false); //, DEBUG, 8);
-	placeEntity(UBO_bed, bed.pos, bed.rot, bed.scale, glm::vec3(0.0f), ViewPrj, DS_bed, currentImage, false); // , DEBUG, 9);
-	placeEntity(UBO_nightTable, nightTable.pos, nightTable.rot, nightTable.scale, glm::vec3(0.0f), ViewPrj, DS_nighttable, currentImage, false); // , DEBUG, 10);
-
-	// Kitchen
-	placeEntity(UBO_kitchen, kitchen.pos, kitchen.rot, kitchen.scale, glm::vec3(0.0f), ViewPrj, DS_kitchen, currentImage, false); // , DEBUG, 11);
-	placeEntity(UBO_fridge, fridge.pos, fridge.rot, fridge.scale, glm::vec3(0.0f), ViewPrj, DS_fridge, currentImage, false); // DEBUG, 12);
-	placeEntity(UBO_kitchenTable, kitchenTable.pos, kitchenTable.rot, kitchenTable.scale, glm::vec3(0.0f), ViewPrj, DS_kitchentable, currentImage, false);
-	placeEntity(UBO_chair, chair.pos, chair.rot, chair.scale, glm::vec3(0.0f), ViewPrj, DS_chair, currentImage, false);
-
-	// Living room
-	placeEntity(UBO_sofa, sofa.pos, sofa.rot, sofa.scale, glm::vec3(0.0f), ViewPrj, DS_sofa, currentImage, false); // DEBUG, 13);
-	placeEntity(UBO_table, table.pos, table.rot, table.scale, glm::vec3(0.0f), ViewPrj, DS_table, currentImage, false);
-	placeEntity(UBO_tv, tv.pos, tv.rot, tv.scale, glm::vec3(0.0f), ViewPrj, DS_tv, currentImage, false);
-	placeEntity(UBO_knight, knight.pos, knight.rot, knight.scale, glm::vec3(0.0f), ViewPrj, DS_knight, currentImage, false);
-
-	// Witch lair
-	placeEntity(UBO_chest, chest.pos, chest.rot, chest.scale, glm::vec3(0.0f), ViewPrj, DS_chest, currentImage, false); // DEBUG, 14);
-	placeEntity(UBO_stoneTable, stoneTable.pos, stoneTable.rot, stoneTable.scale, glm::vec3(0.0f), ViewPrj, DS_stonetable, currentImage, false);
-	placeEntity(UBO_stoneChair, stoneChair.pos, stoneChair.rot, stoneChair.scale, glm::vec3(0.0f), ViewPrj, DS_stonechair, currentImage, false);
-	placeEntity(UBO_cauldron, cauldron.pos, cauldron.rot, cauldron.scale, glm::vec3(0.0f), ViewPrj, DS_cauldron, currentImage, DEBUG, 7);
-	placeEntity(UBO_shelf1, shelf1.pos, shelf1.rot, shelf1.scale, glm::vec3(0.0f), ViewPrj, DS_shelf1, currentImage, false);
-	placeEntity(UBO_shelf2, shelf2.pos, shelf2.rot, shelf2.scale, glm::vec3(0.0f), ViewPrj, DS_shelf2, currentImage, false);
-	placeEntity(UBO_web, web.pos, web.rot, web.scale, glm::vec3(0.0f), ViewPrj, DS_web, currentImage, false);
-	placeEntity(UBO_catFainted, catFainted.pos, catFainted.rot, catFainted.scale, glm::vec3(0.0f), ViewPrj, DS_catFainted, currentImage, false);
-
-	// Bathroom
-	placeEntity(UBO_bathtub, bathtub.pos, bathtub.rot, bathtub.scale, glm::vec3(0.0f), ViewPrj, DS_bathtub, currentImage, false); // DEBUG, 15);
-	placeEntity(UBO_toilet, toilet.pos, toilet.rot, toilet.scale, glm::vec3(0.0f), ViewPrj, DS_toilet, currentImage, false);
-	placeEntity(UBO_bidet, bidet.pos, bidet.rot, bidet.scale, glm::vec3(0.0f), ViewPrj, DS_bidet, currentImage, false);
-	placeEntity(UBO_sink, sink.pos, sink.rot, sink.scale, glm::vec3(0.0f), ViewPrj, DS_sink, currentImage, false);
-
-	// Collectibles
-	if (!collectiblesMap["crystal"]) {
-		placeEntity(UBO_crystal, collectiblesRandomPosition[0], glm::vec3(0, collectibleRotationAngle, 0), glm::vec3(gameState == GAME_STATE_PLAY), glm::vec3(1.0f), ViewPrj, DS_crystal, currentImage, DEBUG, 0);
-	}
-	else {
-		removeCollectible(UBO_crystal, ViewPrj, DS_crystal, currentImage, 0);
-	}
-	if (!collectiblesMap["eye"]) {
-		placeEntity(UBO_eye, collectiblesRandomPosition[1], glm::vec3(0, collectibleRotationAngle, 0), glm::vec3(gameState == GAME_STATE_PLAY), glm::vec3(1.0f), ViewPrj, DS_eye, currentImage, DEBUG, 1);
-	}
-	else {
-		removeCollectible(UBO_eye, ViewPrj, DS_eye, currentImage, 1);
-	}
-	if (!collectiblesMap["feather"]) {
-		placeEntity(UBO_feather, collectiblesRandomPosition[2], glm::vec3(0, collectibleRotationAngle, 0), glm::vec3(gameState == GAME_STATE_PLAY), glm::vec3(1.0f), ViewPrj, DS_feather, currentImage, DEBUG, 2);
-	}
-	else {
-		removeCollectible(UBO_feather, ViewPrj, DS_feather, currentImage, 2);
-	}
-	if (!collectiblesMap["leaf"]) {
-		placeEntity(UBO_leaf, collectiblesRandomPosition[3], glm::vec3(0, collectibleRotationAngle, 0), glm::vec3(gameState == GAME_STATE_PLAY), glm::vec3(1.0f), ViewPrj, DS_leaf, currentImage, DEBUG, 3);
-	}
-	else {
-		removeCollectible(UBO_leaf, ViewPrj, DS_leaf, currentImage, 3);
-	}
-	if (!collectiblesMap["potion1"]) {
-		placeEntity(UBO_potion1, collectiblesRandomPosition[4], glm::vec3(0, collectibleRotationAngle, 0), glm::vec3(gameState == GAME_STATE_PLAY), glm::vec3(1.0f), ViewPrj, DS_potion1, currentImage, DEBUG, 4);
-	}
-	else {
-		removeCollectible(UBO_potion1, ViewPrj, DS_potion1, currentImage, 4);
-	}
-	if (!collectiblesMap["potion2"]) {
-		placeEntity(UBO_potion2, collectiblesRandomPosition[5], glm::vec3(0, collectibleRotationAngle, 0), glm::vec3(gameState == GAME_STATE_PLAY), glm::vec3(1.0f), ViewPrj, DS_potion2, currentImage, DEBUG, 5);
-	}
-	else {
-		removeCollectible(UBO_potion2, ViewPrj, DS_potion2, currentImage, 5);
-	}
-	if (!collectiblesMap["bone"]) {
-		placeEntity(UBO_bone, collectiblesRandomPosition[6], glm::vec3(0, collectibleRotationAngle, 0), glm::vec3(gameState == GAME_STATE_PLAY), glm::vec3(0.3f), ViewPrj, DS_bone, currentImage, DEBUG, 6);
-	}
-	else {
-		removeCollectible(UBO_bone, ViewPrj, DS_bone, currentImage, 6);
-	}
-}
-
-// Position ghost cat, draw its bounding box (if DEBUG) and update its uniform
-void PurrfectPotion::placeGhostCat(AnimatedUniformBufferObject ubo, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, glm::vec3 emissiveColor,
-	glm::mat4 ViewPrj, DescriptorSet ds, int currentImage, bool hasBoundingBox, int id)
-{
-
-	glm::mat4 World = glm::translate(glm::mat4(1), position) *
-		glm::rotate(glm::mat4(1), rotation.x, glm::vec3(1, 0, 0)) *
-		glm::rotate(glm::mat4(1), rotation.y, glm::vec3(0, 1, 0)) *
-		glm::rotate(glm::mat4(1), rotation.z, glm::vec3(0, 0, 1)) *
-		glm::scale(glm::mat4(1), scale);
-	ubo.mvpMat = ViewPrj * World;
-	ubo.mMat = World;
-	ubo.nMat = glm::transpose(glm::inverse(World));
-	ubo.time = totalElapsedTime;
-	ubo.speed = 2.0f;
-
-	drawBoundingBox(hasBoundingBox, position, rotation, scale, ViewPrj, UBO_boundingBox[id], DS_boundingBox[id], currentImage);
-
-	ds.map(currentImage, &ubo, sizeof(ubo), 0);
-	ds.map(currentImage, &emissiveColor, sizeof(emissiveColor), 2);
-}
-
-// Position objects (furniture, collectibles, fainted cat), draw their bounding box (if DEBUG) and update their uniforms
-void PurrfectPotion::placeEntity(UniformBufferObject ubo, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale,
-	glm::vec3 emissiveColor, glm::mat4 ViewPrj, DescriptorSet ds, int currentImage, bool hasBoundingBox, int id) {
-
-	glm::mat4 World = glm::translate(glm::mat4(1), position) *
-		glm::rotate(glm::mat4(1), rotation.x, glm::vec3(1, 0, 0)) *
-		glm::rotate(glm::mat4(1), rotation.y, glm::vec3(0, 1, 0)) *
-		glm::rotate(glm::mat4(1), rotation.z, glm::vec3(0, 0, 1)) *
-		glm::scale(glm::mat4(1), scale);
-	ubo.mvpMat = ViewPrj * World;
-	ubo.mMat = World;
-	ubo.nMat = glm::transpose(glm::inverse(World));
-
-	drawBoundingBox(hasBoundingBox, position, rotation, scale, ViewPrj, UBO_boundingBox[id], DS_boundingBox[id], currentImage);
-
-	ds.map(currentImage, &ubo, sizeof(ubo), 0);
-	// the .map() method of a DataSet object, requires the current image of the swap chain as first parameter
-	// the second parameter is the pointer to the C++ data structure to transfer to the GPU
-	// the third parameter is its size
-	// the fourth parameter is the location inside the descriptor set of this uniform block
 
-	ds.map(currentImage, &emissiveColor, sizeof(emissiveColor), 2);
+	// Text overlay, in a single draw
+	beginRegion(commandBuffer, currentImage, "text");
+	text.draw(commandBuffer, currentImage);
+	endRegion(commandBuffer, currentImage);
 }
 
-void PurrfectPotion::removeCollectible(UniformBufferObject ubo, glm::mat4 ViewPrj, DescriptorSet ds, int currentImage, int id) {
-	glm::mat4 World = glm::mat4(0.f);
-	ubo.mvpMat = ViewPrj * World;
-	ubo.mMat = World;
-	ubo.nMat = glm::transpose(glm::inverse(World));
-
-	ds.map(currentImage, &ubo, sizeof(ubo), 0);
-
-	// Update bounding box matrices
-	UBO_boundingBox[id].mvpMat = ViewPrj * World;
-	UBO_boundingBox[id].mMat = World;
-	UBO_boundingBox[id].nMat = glm::transpose(glm::inverse(World));
-	DS_boundingBox[id].map(currentImage, &UBO_boundingBox[id], sizeof(UBO_boundingBox[id]), 0);
-
-	// Remove bounding box from the array of BBs
-	collectiblesBBs[id].erase();
-}
+// Here is where you update the uniforms. Very likely this will be where you will be writing the logic of your application.
+void PurrfectPotion::updateUniformBuffer(uint32_t currentImage) {
+	auto updateStart = std::chrono::steady_clock::now();
 
-void PurrfectPotion::updateOverlay(uint32_t currentImage) {
+	// Offscreen there is no window, nor keys to read
+	if (window != nullptr) {
+		// Standard procedure to quit when the ESC key is pressed
+		if (glfwGetKey(window, GLFW_KEY_ESCAPE)) {
+			glfwSetWindowShouldClose(window, GL_TRUE);
+		}
 
-	if (OVERLAY) {
-		// Timer
-		if (timeLeft >= GAME_DURATION * 3 / 4) {
-			UBO_timer[0].visible = 1.f;
-			UBO_timer[1].visible = UBO_timer[2].visible = UBO_timer[3].visible = UBO_timer[4].visible = 0.f;
+		// F1 starts/stops the profiler, F2 writes what it has collected to trace.json, F3 writes the GPU memory usage
+		// to memory.txt (both to the files given on the command line, if any), F4 shows/hides the stats panel
+		bool f1 = glfwGetKey(window, GLFW_KEY_F1), f2 = glfwGetKey(window, GLFW_KEY_F2), f3 = glfwGetKey(window, GLFW_KEY_F3);
+		bool f4 = glfwGetKey(window, GLFW_KEY_F4);
+		if (f1 && !debugKeys[0]) {
+			setProfiling(!profiler.isEnabled());
+			LOG_INFO("Profiler %s", profiler.isEnabled() ? "on" : "off");
 		}
-		else if (timeLeft >= GAME_DURATION / 2) {
-			UBO_timer[1].visible = 1.f;
-			UBO_timer[0].visible = UBO_timer[2].visible = UBO_timer[3].visible = UBO_timer[4].visible = 0.f;
+		if (f2 && !debugKeys[1]) {
+			profiler.exportChromeTrace(profilerTracePath.empty() ? "trace.json" : profilerTracePath);
 		}
-		else if (timeLeft >= GAME_DURATION / 4) {
-			UBO_timer[2].visible = 1.f;
-			UBO_timer[0].visible = UBO_timer[1].visible = UBO_timer[3].visible = UBO_timer[4].visible = 0.f;
+		if (f3 && !debugKeys[2]) {
+			std::string path = memoryReportPath.empty() ? "memory.txt" : memoryReportPath;
+			memoryTracker.writeReport(path);
+			LOG_INFO("GPU memory report written to %s", path.c_str());
 		}
-		else if (timeLeft > 3.0f) {
-			UBO_timer[3].visible = 1.f;
-			UBO_timer[0].visible = UBO_timer[1].visible = UBO_timer[2].visible = UBO_timer[4].visible = 0.f;
+		if (f4 && !debugKeys[3]) {
+			statsVisible = !statsVisible;
+			statsText.clear();
 		}
-		else {
-			UBO_timer[4].visible = 1.f;
-			UBO_timer[0].visible = UBO_timer[1].visible = UBO_timer[2].visible = UBO_timer[3].visible = 0.f;
+		debugKeys[0] = f1;
+		debugKeys[1] = f2;
+		debugKeys[2] = f3;
+		debugKeys[3] = f4;
+	}
+
+	FrameInput in;
+	if (flythrough) {
+		// Scripted frames use a fixed deltaT, the real frame time is only measured
+		auto now = std::chrono::steady_clock::now();
+		double frameMs = std::chrono::duration<double, std::milli>(now - lastFrameTime).count();
+		bool firstFrame = flythrough->framesDone() == 0;
+		lastFrameTime = now;
+
+		if (!firstFrame) {
+			flythroughStats.addFrame(frameMs, flythroughStageMs);
+			flythroughStats.addEvents(profiler.eventsSince(flythroughEventsRead));
 		}
+		flythroughEventsRead = profiler.recordedCount();
 
-		// Scroll
-		UBO_scroll.visible = 1.f;
-
-		// Collectibles
-		UBO_collectibles[collectiblesHUD["crystal"]].visible = !collectiblesMap["crystal"] ? 1.f : 0.f;
-		UBO_collectibles[collectiblesHUD["eye"]].visible = !collectiblesMap["eye"] ? 1.f : 0.f;
-		UBO_collectibles[collectiblesHUD["feather"]].visible = !collectiblesMap["feather"] ? 1.f : 0.f;
-		UBO_collectibles[collectiblesHUD["leaf"]].visible = !collectiblesMap["leaf"] ? 1.f : 0.f;
-		UBO_collectibles[collectiblesHUD["potion1"]].visible = !collectiblesMap["potion1"] ? 1.f : 0.f;
-		UBO_collectibles[collectiblesHUD["potion2"]].visible = !collectiblesMap["potion2"] ? 1.f : 0.f;
-		UBO_collectibles[collectiblesHUD["bone"]].visible = !collectiblesMap["bone"] ? 1.f : 0.f;
-
-	} else {
-		// Hide all overlay elements
-		UBO_timer[0].visible = UBO_timer[1].visible = UBO_timer[2].visible = UBO_timer[3].visible = UBO_timer[4].visible = 0.f;
-		UBO_scroll.visible = 0.f;
-		for (int i = 0; i < COLLECTIBLES_NUM; i++) {
-			UBO_collectibles[i].visible = 0.f;
+		if (!flythrough->next(in)) {
+			reportFlythrough();
+			flythrough.reset();
+			requestClose();
+			return;
 		}
-	}
+		flythrough->apply(sim);
+	} else if (replay.isOpen()) {
+		// Replayed frames use the recorded deltaT, the real frame time is only measured
+		auto now = std::chrono::steady_clock::now();
+		if (replay.framesRead() > 0) {
+			replayFrameMs.push_back(std::chrono::duration<double, std::milli>(now - lastFrameTime).count());
+		}
+		lastFrameTime = now;
 
-	// Map the updated UBOs
-	for (int i = 0; i < 5; i++) {
-		DS_timer[i].map(currentImage, &UBO_timer[i], sizeof(UBO_timer[i]), 0);
+		if (!replay.next(in)) {
+			replay.close();
+			reportReplay();
+			requestClose();
+			return;
+		}
+	} else {
+		readInput(in);
 	}
 
-	DS_scroll.map(currentImage, &UBO_scroll, sizeof(UBO_scroll), 0);
+	sim.step(in, flythrough ? flythroughStageMs : nullptr);
 
-	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
-		DS_collectibles[i].map(currentImage, &UBO_collectibles[i], sizeof(UBO_collectibles[i]), 0);
+	if (replay.isOpen() || recorder.isOpen()) {
+		uint64_t hash = sim.stateHash();
+		if (replay.isOpen()) {
+			replay.verify(hash);
+		}
+		recorder.record(in, hash);
 	}
-}
-
-void PurrfectPotion::updateSteamAndFire(glm::mat4& World, glm::mat4& ViewPrj, uint32_t currentImage) {
-	// Steam
-	World = glm::translate(glm::mat4(1.0f), cauldron.pos + glm::vec3(0, 1.7f, 0)) *		// Steam plane position - over the cauldron
-			glm::rotate(glm::mat4(1.0f), camYaw, glm::vec3(0, 1, 0));					// Steam plane rotation - always face the camera
-	UBO_steam.mvpMat = ViewPrj * World;
-	UBO_steam.mMat = World;
-	UBO_steam.nMat = glm::transpose(glm::inverse(World));
-	UBO_steam.time = totalElapsedTime;
-	UBO_steam.speed = 0.7f;
-	DS_steam.map(currentImage, &UBO_steam, sizeof(UBO_steam), 0);
-
-	// Fire
-	World = glm::translate(glm::mat4(1.0f), cauldron.pos + glm::vec3(0, 0.3f, 0.1f)) *	// Fire plane position - under the cauldron
-			glm::rotate(glm::mat4(1.0f), camYaw, glm::vec3(0, 1, 0));					// Fire plane rotation - always face the camera
-	UBO_fire.mvpMat = ViewPrj * World;
-	UBO_fire.mMat = World;
-	UBO_fire.nMat = glm::transpose(glm::inverse(World));
-	UBO_fire.time = totalElapsedTime;
-	UBO_fire.speed = 4.f;
-	DS_fire.map(currentImage, &UBO_fire, sizeof(UBO_fire), 0);
-}
-
-void PurrfectPotion::updateLights(uint32_t currentImage) {
-	GUBO.lightPos[0] = glm::vec3(6.0f, 2.0f, 8.0f);							// position: kitchen
-	GUBO.lightColor[0] = glm::vec4(glm::vec3(1.4f), 2.0f);					// color: white
-
-	GUBO.lightPos[1] = glm::vec3(-8.f, 2.0f, -8.f);							// position: witch lair
-	GUBO.lightColor[1] = glm::vec4(glm::vec3(0.4f, 0.f, 0.8f), 2.0f);		// color: purple
-
-	GUBO.lightPos[2] = glm::vec3(-6.0f, 1.3f, -8.3f);						// position: witch lair - cauldron potion
-	GUBO.lightColor[2] = glm::vec4(glm::vec3(0.02f, 0.07f, 0.02f), 2.0f);	// color: green
-	GUBO.lightPos[3] = glm::vec3(-6.0f, 0.2f, -8.3f);						// position: witch lair - cauldron fire
-	GUBO.lightColor[3] = glm::vec4(glm::vec3(0.14f, 0.08f, 0.f), 2.0f);		// color: orange
 
-	GUBO.lightPos[4] = glm::vec3(11.9f, 1.0f, -4.f);						// position: bedroom
-	GUBO.lightColor[4] = glm::vec4(glm::vec3(0.6f, 0.5f, 0.f), 2.0f);		// color: yellow
-
-	GUBO.lightPos[5] = glm::vec3(-7.0f, 2.0f, 7.f);							// position: living room
-	GUBO.lightColor[5] = glm::vec4(glm::vec3(0.2f, 1.0f, 0.2f), 2.0f);		// color: green
-
-	GUBO.lightPos[6] = glm::vec3(0.f, 2.5f, -8.f);							// position: bathroom
-	GUBO.lightColor[6] = glm::vec4(glm::vec3(0.50f, 0.25f, 0.f), 2.0f);		// color: orange
-
-	GUBO.lightDir[7] = glm::vec3(-0.5, 1.0, 0.5);							// (sun) light from outside
-	GUBO.lightColor[7] = glm::vec4(glm::vec3(0.2f), 2.0f);					// color: white
-
-	GUBO.lightPos[8] = glm::vec3(-6.0f, 1.5f, -8.3f);						// position: witch lair - cauldron
-	GUBO.lightColor[8] = glm::vec4(glm::vec3(0.1f, 0.1f, 1.0f), 20.0f);		// color: blue
-	GUBO.lightDir[8] = glm::vec3(0, 1, 0);									// light from above
-
-	GUBO.cosIn = glm::cos(glm::radians(35.0f));								// cos of the inner angle of the spot light
-	GUBO.cosOut = glm::cos(glm::radians(45.0f));							// cos of the outer angle of the spot light
-
-	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
-		GUBO.lightPos[i + LIGHTS_NUM - COLLECTIBLES_NUM] = collectiblesRandomPosition[i] + glm::vec3(0.f, 0.5f, 0.f);	// position: over the collectibles
-		GUBO.lightDir[i + LIGHTS_NUM - COLLECTIBLES_NUM] = glm::vec3(0, 1, 0);											// light from above
-		GUBO.lightColor[i + LIGHTS_NUM - COLLECTIBLES_NUM] = collectiblesMap[collectiblesNames[i]] ? glm::vec4(glm::vec3(0.0f), 0.0f) : glm::vec4(glm::vec3(0.7f, 0.1f, 1.0f), 10.0f);
+	// The heatmaps change what the command buffers record
+	if (sim.HEATMAP != recordedHeatmap) {
+		recordedHeatmap = sim.HEATMAP;
+		rebuildCommandBuffers();
+		overdraw.restart();
 	}
-
-	GUBO.eyePos = camPos; // Camera position
-
-	GUBO.lightOn = lightOn;
-	GUBO.gameOver = gameOver;
-
-	DS_global.map(currentImage, &GUBO, sizeof(GUBO), 0);
-}
-
-// Create menu scenes placing the cat and the camera in a fixed position
-void PurrfectPotion::updateMenuScene(bool start, uint32_t currentImage) {
-	camPos = glm::vec3(-5.5f, 2.6f, -2.8f);
-	camYaw = glm::radians(40.0f);
-	camPitch = glm::radians(-20.0f);
-	camRoll = 0.0f;
-
-	catPosition = glm::vec3(-7.2f, 0.05f, -9.0f);
-	catYaw = glm::radians(110.0f);
-
-	FIRST_PERSON = false;
-	OVERLAY = false;
-	DEBUG = false;
-	gameOver = false;
-
-	showCursor();
-
-	lightOn = glm::vec4(1, 1, 0, 1);	// Turn off all spot lights
-
-	if (gameState == GAME_STATE_START_SCREEN && !showInstruction) {
-		UBO_screens[0].visible = 1.f;
-		UBO_screens[1].visible = UBO_screens[2].visible = UBO_screens[3].visible = 0.f;
-	} else if (gameState == GAME_STATE_GAME_WIN) {
-		UBO_screens[1].visible = 1.f;
-		UBO_screens[0].visible = UBO_screens[2].visible = UBO_screens[3].visible = 0.f;
-	} else if (gameState == GAME_STATE_GAME_LOSE) {
-		UBO_screens[2].visible = 1.f;
-		UBO_screens[0].visible = UBO_screens[1].visible = UBO_screens[3].visible = 0.f;
+	if (recordedHeatmap != GameSimulation::HEATMAP_OFF) {
+		readOverdraw(currentImage);
 	}
 
-	// Set all the elements to not_collected
-	for (auto& element : collectiblesMap) {
-		element.second = false;
+	if (sim.cursorRequest == CURSOR_SHOW) {
+		showCursor();
+	} else if (sim.cursorRequest == CURSOR_HIDE) {
+		hideCursor();
 	}
 
-	if (start) {	// Setting the variables ready to start the game
-		OVERLAY = true;
-
-		UBO_screens[0].visible = UBO_screens[1].visible = UBO_screens[2].visible = UBO_screens[3].visible = 0.f;
-
-		camPos = glm::vec3(0.0f, 1.5f, 7.0f);
-		camYaw = glm::radians(90.0f);
-		camPitch = glm::radians(-10.0f);
-		camRoll = 0.0f;
-		camDist = 3.0f;
-		CamTargetDelta = glm::vec3(0.0f, 1.5f, 0.0f);
-
-		catPosition = glm::vec3(6.0f, 0.05f, 0.0f);
-		catYaw = 0.0f;
-
-		totalElapsedTime = 0.0f;
-
-		emptyBBList(&collectiblesBBs);
+	uploadUniforms(currentImage);
+	updateText(currentImage, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - updateStart).count());
+}
 
-		if (collectiblesBBs.size() == 0) {
-			fillBBList(&collectiblesBBs, collectiblesRandomPosition);
-		}
+void PurrfectPotion::replayInput(const std::string& path) {
+	replay.open(path);
+	sim.placementSeed = replay.seed();
+	std::cout << "Replaying " << path << " (seed " << replay.seed() << ")\n";
+}
 
-		lightOn = glm::vec4(1, 1, 1, 1);
+void PurrfectPotion::runFlythrough(int frames, const std::string& reportPath) {
+	flythrough = std::make_unique<FlythroughInput>(frames);
+	flythroughReportPath = reportPath;
+	validationEnabled = false;
+	vsync = false;
+	profiler.setEnabled(true);
+	LOG_INFO("Flythrough of %d frames, report in %s", frames, reportPath.c_str());
+}
 
-		hideCursor();
+void PurrfectPotion::reportFlythrough() {
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	flythroughStats.write(std::cout, flythroughReportPath, properties.deviceName, sim.placementSeed);
+}
 
-		gameState = GAME_STATE_PLAY;
+void PurrfectPotion::reportOverdraw(const std::string& path) {
+	sim.HEATMAP = GameSimulation::HEATMAP_OVERDRAW;
+	overdrawReport.open(path);
+	if (!overdrawReport) {
+		throw std::runtime_error("failed to open overdraw report file!");
 	}
+	// The lights are those the shaders loop over, not those that reach the fragment: an upper bound
+	overdrawReport << "frame,fragments_per_pixel,max_lights_per_pixel\n";
+}
 
-	// Update screens overlay
-	for (int i = 0; i < 4; i++) {
-		DS_screens[i].map(currentImage, &UBO_screens[i], sizeof(UBO_screens[i]), 0);
+void PurrfectPotion::readOverdraw(uint32_t currentImage) {
+	if (!overdraw.read(currentImage, overdrawFragments, overdrawLights)) {
+		return;
+	}
+	overdrawFragmentsSum += overdrawFragments;
+	overdrawLightsSum += overdrawLights;
+	if (overdrawReport.is_open()) {
+		overdrawReport << overdrawFrames << "," << overdrawFragments << "," << overdrawLights << "\n";
 	}
+	overdrawFrames++;
 }
 
-// Update all the game elements (cat and camera position, time), also based on buttons pressed
-void PurrfectPotion::updateGame(bool& debounce, int& curDebounce, float& deltaT, glm::vec3& m, glm::vec3& r, uint32_t currentImage) {
-
-	// Update DS screens overlay
-	for (int i = 0; i < 4; i++) {
-		DS_screens[i].map(currentImage, &UBO_screens[i], sizeof(UBO_screens[i]), 0);
+void PurrfectPotion::reportReplay() {
+	std::cout << "Replay finished: " << replay.framesRead() << " frames, ";
+	if (replay.mismatches() == 0) {
+		std::cout << "state matches the recording\n";
+	} else {
+		std::cout << replay.mismatches() << " frames diverged from the recording\n";
 	}
+	std::cout << "                   p50 us    p90 us    p99 us    max us\n";
+	printTimingRow(std::cout, "frame", replayFrameMs);
+}
 
-	timeLeft = GAME_DURATION - totalElapsedTime;
-
-	checkPressedButton(&debounce, &curDebounce);
-
-	// Update camera yaw, pitch, and roll
-	int yawFactor = FIRST_PERSON ? -1 : 1;
-	camYaw += ROT_SPEED * deltaT * r.y * yawFactor;
-	camPitch -= ROT_SPEED * deltaT * r.x;
-	camRoll -= ROT_SPEED * deltaT * r.z;
-	camDist -= MOVE_SPEED * deltaT * m.y;
-
-	// Limit the distance from the cat and the pitch to avoid gimbal lock
-	camDist = glm::clamp(camDist, 1.5f, 4.0f);
-	camPitch = glm::clamp(camPitch, minPitch, maxPitch);
-	camRoll = glm::clamp(camRoll, minRoll, maxRoll);
-
-	// Redefine camera forward and right vectors when camera rotates
-	cameraForward = glm::normalize(glm::vec3(sin(camYaw), 0.0f, cos(camYaw)));
-	cameraRight = glm::normalize(glm::vec3(cos(camYaw), 0.0f, -sin(camYaw)));
-
-	// Cat movement
-	if ((m.x != 0) || (m.z != 0)) {
-		catPosition -= cameraForward * m.z * MOVE_SPEED * deltaT;
-		catPosition += cameraRight * m.x * MOVE_SPEED * deltaT;
-
-		// Cat rotation based on the movement vector
-		float targetYaw = atan2(m.z, m.x);
-		targetYaw += glm::radians(-180.0f);
-		catYaw = glm::mix(catYaw, targetYaw + fmod(camYaw, glm::radians(360.0f)), deltaT * 6.0f);	// 6.0 is the damping factor
+void PurrfectPotion::readInput(FrameInput& in) {
+	// Offscreen, without a script nor a recording, the game just runs at 60 fps on the start screen
+	if (window == nullptr) {
+		in.deltaT = 1.0f / 60.0f;
+		return;
 	}
 
-	if (FIRST_PERSON) {
-		// First person camera position
-		glm::vec3 ux = glm::rotate(glm::mat4(1.0f), camYaw, glm::vec3(0, 1, 0)) * glm::vec4(1, 0, 0, 1);
-		glm::vec3 uz = glm::rotate(glm::mat4(1.0f), camYaw, glm::vec3(0, 1, 0)) * glm::vec4(0, 0, -1, 1);
-
-		camPos = catPosition + MOVE_SPEED * m.x * ux * deltaT;
-		camPos = camPos + MOVE_SPEED * m.z * uz * deltaT;
+	// Integration with the timers and the controllers
+	getSixAxis(in.deltaT, in.m, in.r, in.fire, in.start);
+	// getSixAxis() is defined in Starter.hpp in the base class.
+	// It fills the float point variable passed in its first parameter with the time since the last call to the procedure.
+	// It fills vec3 in the second parameters, with three values in the -1,1 range corresponding to motion (with left stick of the gamepad, or ASWD + RF keys on the keyboard)
+	// It fills vec3 in the third parameters, with three values in the -1,1 range corresponding to motion (with right stick of the gamepad, or Arrow keys + QE keys on the keyboard, or mouse)
+	// If fills the fourth boolean variable with true if fire has been pressed: SPACE on the keyboard, A or B button on the Gamepad, Right mouse button
+	// If fills the last boolean variable with true if start has been pressed: ENTER on the keyboard or Start button on the Gamepad
 
-		camPos.y += 0.9f;
-	} else {
-		// Third person camera position
-		glm::vec3 camTarget = catPosition + CamTargetDelta;
-		camPos = camTarget + glm::vec3(glm::rotate(glm::mat4(1), camYaw, glm::vec3(0, 1, 0)) *
-				glm::rotate(glm::mat4(1), -camPitch, glm::vec3(1, 0, 0)) *
-				glm::vec4(0, 0, camDist, 1));
+	static const int keyCodes[SIM_KEYS_NUM] = {
+		GLFW_KEY_P, GLFW_KEY_O, GLFW_KEY_L, GLFW_KEY_K, GLFW_KEY_V, GLFW_KEY_LEFT_SHIFT, GLFW_KEY_N, GLFW_KEY_M, GLFW_KEY_Z, GLFW_KEY_I,
+		GLFW_KEY_1, GLFW_KEY_2, GLFW_KEY_3, GLFW_KEY_4, GLFW_KEY_H
+	};
+	in.keys = 0;
+	for (int k = 0; k < SIM_KEYS_NUM; k++) {
+		if (glfwGetKey(window, keyCodes[k])) {
+			in.keys |= 1u << k;
+		}
 	}
+}
 
-	// Check if game is over because time has run out
-	if (totalElapsedTime >= GAME_DURATION) {
-		gameState = GAME_STATE_GAME_LOSE;
-	} else if (static_cast<int>(timeLeft) != lastDisplayedTime) {
-		std::cout << "Time remaining: " << static_cast<int>(timeLeft) << std::endl;
-		lastDisplayedTime = static_cast<int>(timeLeft);
-	}
+// Matrices of a model with quantized positions: they are mapped back to the model space first.
+// The normals are not quantized, nMat stays the same.
+static UniformBufferObject dequantized(UniformBufferObject ubo, const glm::mat4& dequantization) {
+	ubo.mvpMat = ubo.mvpMat * dequantization;
+	ubo.mMat = ubo.mMat * dequantization;
+	return ubo;
 }
 
-void PurrfectPotion::checkPressedButton(bool* debounce, int* curDebounce) {
-	// Press P to toggle debug mode
-	if (glfwGetKey(window, GLFW_KEY_P)) {
-		if (!*debounce) {
-			*debounce = true;
-			*curDebounce = GLFW_KEY_P;
-			DEBUG = !DEBUG;
-		}
-	} else if ((*curDebounce == GLFW_KEY_P) && *debounce) {
-		*debounce = false;
-		*curDebounce = 0;
-	}
+void PurrfectPotion::uploadUniforms(uint32_t currentImage) {
+	// the .map() method of a DataSet object, requires the current image of the swap chain as first parameter
+	// the second parameter is the pointer to the C++ data structure to transfer to the GPU
+	// the third parameter is its size
+	// the fourth parameter is the location inside the descriptor set of this uniform block
+	DS_global.map(currentImage, &sim.GUBO, sizeof(sim.GUBO), 0);
+	DS_skyBox.map(currentImage, &sim.UBO_skyBox, sizeof(sim.UBO_skyBox), 0);
+	DS_steam.map(currentImage, &sim.UBO_steam, sizeof(sim.UBO_steam), 0);
+	DS_fire.map(currentImage, &sim.UBO_fire, sizeof(sim.UBO_fire), 0);
 
-	// Press O to toggle overlay
-	if (glfwGetKey(window, GLFW_KEY_O)) {
-		if (!*debounce) {
-			*debounce = true;
-			*curDebounce = GLFW_KEY_O;
-			OVERLAY = !OVERLAY;
-		}
-	} else if ((*curDebounce == GLFW_KEY_O) && *debounce) {
-		*debounce = false;
-		*curDebounce = 0;
-	}
+	DS_cat.map(currentImage, &sim.UBO_cat, sizeof(sim.UBO_cat), 0);
+	DS_cat.map(currentImage, &sim.catEmissiveColor, sizeof(sim.catEmissiveColor), 2);
 
-	// Press L to reset the camera view
-	if (glfwGetKey(window, GLFW_KEY_L)) {
-		if (!*debounce) {
-			*debounce = true;
-			*curDebounce = GLFW_KEY_L;
-			camRoll = 0.0f;
-			camPitch = glm::radians(-10.0f);
-			camDist = 3.0f;
-			camYaw = catYaw + glm::radians(90.0f);
-		}
-	} else if ((*curDebounce == GLFW_KEY_L) && *debounce) {
-		*debounce = false;
-		*curDebounce = 0;
+	for (int i = 0; i < SCENE_OBJECTS_NUM; i++) {
+		UniformBufferObject ubo = dequantized(sim.objects[i].ubo, *objectDequantization[i]);
+		objectDS[i]->map(currentImage, &ubo, sizeof(ubo), 0);
+		objectDS[i]->map(currentImage, &sim.objects[i].emissiveColor, sizeof(sim.objects[i].emissiveColor), 2);
 	}
 
-	// Press K to reset the game
-	if (glfwGetKey(window, GLFW_KEY_K)) {
-		gameState = GAME_STATE_START_SCREEN;
+	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
+		UniformBufferObject ubo = dequantized(sim.items[i].ubo, M_item[i].dequantization);
+		DS_item[i].map(currentImage, &ubo, sizeof(ubo), 0);
+		DS_item[i].map(currentImage, &sim.items[i].emissiveColor, sizeof(sim.items[i].emissiveColor), 2);
 	}
 
-	// Press V to switch between 1st and 3rd person view
-	if (glfwGetKey(window, GLFW_KEY_V)) {
-		if (!*debounce) {
-			*debounce = true;
-			*curDebounce = GLFW_KEY_V;
-			FIRST_PERSON = !FIRST_PERSON;
-		}
-	} else if ((*curDebounce == GLFW_KEY_V) && *debounce) {
-		*debounce = false;
-		*curDebounce = 0;
+	for (int i = 0; i < DS_boundingBox.size(); i++) {
+		DS_boundingBox[i].map(currentImage, &sim.UBO_boundingBox[i], sizeof(sim.UBO_boundingBox[i]), 0);
 	}
 
-	// Press SHIFT key to sprint
-	if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT)) {
-		MOVE_SPEED = 12.0f;
-		ROT_SPEED = glm::radians(200.0f);
+	// Overlay
+	for (int i = 0; i < 4; i++) {
+		DS_screens[i].map(currentImage, &sim.UBO_screens[i], sizeof(sim.UBO_screens[i]), 0);
 	}
 
-	// Press N to reach win screen
-	if (glfwGetKey(window, GLFW_KEY_N)) {
-		gameState = GAME_STATE_GAME_WIN;
+	for (int i = 0; i < 5; i++) {
+		DS_timer[i].map(currentImage, &sim.UBO_timer[i], sizeof(sim.UBO_timer[i]), 0);
 	}
 
-	// Press M to reach lose screen
-	if (glfwGetKey(window, GLFW_KEY_M)) {
-		gameState = GAME_STATE_GAME_LOSE;
-	}
+	DS_scroll.map(currentImage, &sim.UBO_scroll, sizeof(sim.UBO_scroll), 0);
 
-	// Press Z to toggle the cursor
-	if (glfwGetKey(window, GLFW_KEY_Z)) {
-		if (!*debounce) {
-			*debounce = true;
-			*curDebounce = GLFW_KEY_Z;
-			if (cursorShowed) {
-				hideCursor();
-			} else {
-				showCursor();
-			}
-			cursorShowed = !cursorShowed;
-		}
-	} else if ((*curDebounce == GLFW_KEY_Z) && *debounce) {
-		*debounce = false;
-		*curDebounce = 0;
+	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
+		DS_collectibles[i].map(currentImage, &sim.UBO_collectibles[i], sizeof(sim.UBO_collectibles[i]), 0);
 	}
+}
 
-	// Press 1 to turn on/off point lights
-	if (glfwGetKey(window, GLFW_KEY_1)) {
-		if (!*debounce) {
-			*debounce = true;
-			*curDebounce = GLFW_KEY_1;
-			lightOn.x = 1 - lightOn.x;
-		}
-	} else if ((*curDebounce == GLFW_KEY_1) && *debounce) {
-		*debounce = false;
-		*curDebounce = 0;
-	}
+void PurrfectPotion::updateText(uint32_t currentImage, double cpuMs) {
+	auto now = std::chrono::steady_clock::now();
+	float width = static_cast<float>(swapChainExtent.width);
+	float height = static_cast<float>(swapChainExtent.height);
+	text.begin();
+
+	// Exact countdown, centered under the timer icon
+	if (sim.OVERLAY) {
+		int tenths = static_cast<int>(std::max(sim.timeLeft, 0.0f) * 10.0f);
+		char countdown[16];
+		snprintf(countdown, sizeof(countdown), "%d:%02d.%d", tenths / 600, tenths / 10 % 60, tenths % 10);
+
+		float size = 0.03f * height;
+		glm::vec2 extent = TextRenderer::measure(size, countdown);
+		glm::vec4 color = tenths < 100 ? glm::vec4(1.0f, 0.3f, 0.3f, 1.0f) : glm::vec4(1.0f);
+		text.addText((timerBottom.x + 1.0f) / 2.0f * width - extent.x / 2.0f, (timerBottom.y + 1.0f) / 2.0f * height + 0.3f * size,
+			size, color, countdown);
+	}
+
+	// Averages of the heatmap shown, top left
+	if (sim.HEATMAP != GameSimulation::HEATMAP_OFF) {
+		char averages[96];
+		snprintf(averages, sizeof(averages), "%s  %.2f fragments/px  <= %.2f lights/px",
+			sim.HEATMAP == GameSimulation::HEATMAP_OVERDRAW ? "Overdraw" : "Lights", overdrawFragments, overdrawLights);
+		float size = std::max(10.0f, 0.018f * height);
+		glm::vec2 extent = TextRenderer::measure(size, averages);
+		text.addRect(size / 2.0f, size / 2.0f, extent.x + size, extent.y + size, glm::vec4(0.0f, 0.0f, 0.0f, 0.6f));
+		text.addText(size, size, size, glm::vec4(1.0f), averages);
+	}
+
+	if (statsVisible) {
+		if (statsText.empty()) {
+			// Just shown: start measuring from this frame
+			statsText = "Measuring...";
+			statsFrames = 0;
+			statsFrameMs = statsCpuMs = statsGpuMs = 0.0;
+			statsGpuEventsRead = profiler.recordedCount();
+			statsUploadedBytes = uploadedBytes;
+			statsRefreshTime = now;
+		} else {
+			statsFrames++;
+			statsFrameMs += std::chrono::duration<double, std::milli>(now - statsFrameTime).count();
+			statsCpuMs += cpuMs;
+			// The GPU zones arrive when the frames they belong to are done, a few frames late
+			for (const ProfileEvent& e : profiler.eventsSince(statsGpuEventsRead)) {
+				if (e.track == PROFILER_GPU_TRACK) {
+					statsGpuMs += e.durationNs / 1e6;
+				}
+			}
+			statsGpuEventsRead = profiler.recordedCount();
 
-	// Press 2 to turn on/off directional lights
-	if (glfwGetKey(window, GLFW_KEY_2)) {
-		if (!*debounce) {
-			*debounce = true;
-			*curDebounce = GLFW_KEY_2;
-			lightOn.y = 1 - lightOn.y;
+			if (now - statsRefreshTime >= std::chrono::milliseconds(500)) {
+				double frameMs = statsFrameMs / statsFrames;
+				char gpu[32];
+				if (profiler.isEnabled()) {
+					snprintf(gpu, sizeof(gpu), "%8.2f ms", statsGpuMs / statsFrames);
+				} else {
+					snprintf(gpu, sizeof(gpu), "  F1 to time");
+				}
+				char panel[256];
+				snprintf(panel, sizeof(panel),
+					"FPS    %8.1f\n"
+					"Frame  %8.2f ms\n"
+					"CPU    %8.2f ms\n"
+					"GPU    %s\n"
+					"Draws  %8u\n"
+					"Upload %8.1f KB\n"
+					"Memory %8.1f MB\n"
+					"Index  %8.1f KB saved",
+					1000.0 / frameMs, frameMs, statsCpuMs / statsFrames, gpu, drawCalls,
+					(uploadedBytes - statsUploadedBytes) / 1024.0 / statsFrames, memoryTracker.liveBytes() / (1024.0 * 1024.0),
+					indexBytesSaved / 1024.0);
+				statsText = panel;
+
+				statsFrames = 0;
+				statsFrameMs = statsCpuMs = statsGpuMs = 0.0;
+				statsUploadedBytes = uploadedBytes;
+				statsRefreshTime = now;
+			}
 		}
-	} else if ((*curDebounce == GLFW_KEY_2) && *debounce) {
-		*debounce = false;
-		*curDebounce = 0;
-	}
+		statsFrameTime = now;
 
-	// Press 3 to turn on/off spot lights
-	if (glfwGetKey(window, GLFW_KEY_3)) {
-		if (!*debounce) {
-			*debounce = true;
-			*curDebounce = GLFW_KEY_3;
-			lightOn.z = 1 - lightOn.z;
-		}
-	} else if ((*curDebounce == GLFW_KEY_3) && *debounce) {
-		*debounce = false;
-		*curDebounce = 0;
+		// Bottom right corner, on a dark panel
+		float size = std::max(10.0f, 0.018f * height);
+		glm::vec2 extent = TextRenderer::measure(size, statsText);
+		float x = width - extent.x - 2.0f * size, y = height - extent.y - 2.0f * size;
+		text.addRect(x - size / 2.0f, y - size / 2.0f, extent.x + size, extent.y + size, glm::vec4(0.0f, 0.0f, 0.0f, 0.6f));
+		text.addText(x, y, size, glm::vec4(1.0f), statsText);
 	}
 
-	// Press 4 to turn on/off ambient lights
-	if (glfwGetKey(window, GLFW_KEY_4)) {
-		if (!*debounce) {
-			*debounce = true;
-			*curDebounce = GLFW_KEY_4;
-			lightOn.w = 1 - lightOn.w;
-		}
-	} else if ((*curDebounce == GLFW_KEY_4) && *debounce) {
-		*debounce = false;
-		*curDebounce = 0;
-	}
+	text.upload(currentImage);
 }
 
 void PurrfectPotion::showCursor() {
+	if (window == nullptr) {
+		return;
+	}
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
 	glfwSetInputMode(window, GLFW_STICKY_MOUSE_BUTTONS, GLFW_FALSE);
 }
 
 void PurrfectPotion::hideCursor() {
+	if (window == nullptr) {
+		return;
+	}
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 	glfwSetInputMode(window, GLFW_STICKY_MOUSE_BUTTONS, GLFW_TRUE);
 }
@@ -3,77 +3,68 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <chrono>
+#include <memory>
+#include <fstream>
 
 #include "Starter.hpp"
 #include "BoundingBox.hpp"
 #include "Utils.hpp"
 #include "World.hpp"
+#include "Placement.hpp"
+#include "Collectibles.hpp"
+#include "Simulation.hpp"
+#include "InputRecording.hpp"
+#include "Flythrough.hpp"
+#include "TextRenderer.hpp"
+#include "OverdrawView.hpp"
 
 class PurrfectPotion : public BaseProject {
 protected:
-	// Current aspect ratio (used by the callback that resizes the window)
-	float Ar;
-
-	// Other application parameters
-	// Camera position, orientation, distance from target
-	glm::vec3 camPos;
-	float camYaw;
-	float camPitch;
-	float camRoll;
-	float camDist;
-	glm::vec3 CamTargetDelta = glm::vec3(0.0f);
-	float minPitch = glm::radians(-20.0f);
-	float maxPitch = M_PI_2 - 0.1f;
-	float minRoll = -M_PI_2;
-	float maxRoll = M_PI_2;
-	glm::vec3 cameraForward;
-	glm::vec3 cameraRight;
-
-	float ROT_SPEED = glm::radians(150.0f);
-	float MOVE_SPEED = 6.0f;
-
-	// Cat position and orientation
-	glm::vec3 catPosition;
-	glm::vec3 catDimensions = glm::vec3(1.2f, 1.2f, 0.3f);
-	float catYaw;
-
-	// Timer setup
-	const float GAME_DURATION = 180.0f;		// 3 minutes = 180 seconds
-	float totalElapsedTime = 0.0f;			// in seconds
-	float timeLeft = GAME_DURATION;
-	int lastDisplayedTime = static_cast<int>(GAME_DURATION);
-
-	// Game state variables
-	bool DEBUG = false;							// to display bounding boxes for debugging
-	bool OVERLAY = false;						// to display the overlay
-	bool FIRST_PERSON = false;					// to switch between first and third person view
-	bool gameOver = false;						// to determine when all the collectibles have been collected
-	bool cursorShowed = false;					// to show/hide the cursor
-	int gameState = GAME_STATE_START_SCREEN;	// initially state of the game = start screen
-	glm::vec4 lightOn = glm::vec4(1, 1, 0, 1);	// initially all types of light are on, except spot
-
-	// Collectibles parameters
-	float collectibleRotationAngle = 0.0f;						 // rotation angle
-	const float collectibleRotationSpeed = glm::radians(45.0f);  // rotation speed: 45 degrees per second
-	glm::vec3 collectiblesRandomPosition[COLLECTIBLES_NUM];		 // position
-
-	std::map<std::string, bool> collectiblesMap;
-	std::vector<BoundingBox> collectiblesBBs;
-	std::map<std::string, int> collectiblesHUD = {
-		{"crystal", 0},
-		{"eye",		1},
-		{"feather", 2},
-		{"leaf",	3},
-		{"potion1", 4},
-		{"potion2", 5},
-		{"bone",	6}
-	};
+	// Game logic and state, independent from the window and from Vulkan
+	GameSimulation sim;
+
+	// Input recording and replay
+	std::string recordPath;
+	InputRecorder recorder;
+	ReplayInput replay;
+	std::vector<double> replayFrameMs;					// wall-clock time of every replayed frame
+	std::chrono::steady_clock::time_point lastFrameTime;
+
+	// Scripted flythrough benchmark
+	std::unique_ptr<FlythroughInput> flythrough;
+	FlythroughStats flythroughStats;
+	std::string flythroughReportPath;
+	uint64_t flythroughEventsRead = 0;					// profiler events already added to the statistics
+	double flythroughStageMs[SIM_STAGES_NUM] = {};		// simulation stages of the last frame
+
+	bool debugKeys[4] = { false, false, false, false };	// F1, F2, F3 and F4 held in the last frame
+
+	// Text overlay: the exact countdown under the timer and the stats panel (F4)
+	TextRenderer text;
+	glm::vec2 timerBottom;								// middle of the lower edge of the timer icon, in NDC
+	bool statsVisible = false;
+	std::string statsText;								// refreshed twice a second
+	// Frames since the last refresh of the panel
+	int statsFrames = 0;
+	double statsFrameMs = 0.0, statsCpuMs = 0.0, statsGpuMs = 0.0;
+	uint64_t statsGpuEventsRead = 0;
+	uint64_t statsUploadedBytes = 0;					// uploadedBytes at the last refresh
+	std::chrono::steady_clock::time_point statsFrameTime, statsRefreshTime;
+
+	// Heatmaps of the fragments and of the lights per pixel (H)
+	OverdrawView overdraw;
+	int recordedHeatmap;								// heatmap the command buffers were recorded with
+	float overdrawFragments = 0.0f, overdrawLights = 0.0f;	// averages over the screen of the last frame read back
+	double overdrawFragmentsSum = 0.0, overdrawLightsSum = 0.0;
+	int overdrawFrames = 0;
+	std::ofstream overdrawReport;						// CSV of the averages of every frame
 
 	// Descriptor Layouts ["classes" of what will be passed to the shaders]
 	DescriptorSetLayout DSL, DSL_skyBox, DSL_animated, DSL_overlay, DSL_ward, DSL_boundingBox, DSL_DRN, DSL_global;
 
 	// Vertex formats
-	VertexDescriptor VD, VD_skyBox, VD_overlay, VD_tangent, VD_boundingBox;
+	VertexDescriptor VD, VD_packed, VD_skyBox, VD_overlay, VD_tangent, VD_boundingBox;
 
 	// Pipelines [Shader couples]
 	Pipeline P, P_skyBox, P_animated, P_overlay, P_ward, P_boundingBox, P_DRN, P_cat;
@@ -82,22 +73,23 @@ protected:
 	// Please note that Model objects depends on the corresponding vertex structure
 
 	// Models
-	Model<Vertex>   // Bathroom
+	// Compact vertices for the static models; the cat and the animated planes keep the float ones,
+	// because their shaders animate them in model space
+	Model<VertexPacked>   // Bathroom
 		M_bathtub, M_bidet, M_sink, M_toilet,
 		// Bedroom
 		M_bed, M_closet, M_nighttable,
 		// Collectibles
-		M_bone, M_crystal, M_eye, M_feather, M_leaf, M_potion1, M_potion2,
+		M_item[COLLECTIBLES_NUM],
 		// Kitchen		  
 		M_chair, M_fridge, M_kitchen, M_kitchentable,
 		// Lair
-		M_cauldron, M_stonechair, M_chest, M_shelf1, M_shelf2, M_stonetable, M_steam, M_fire, M_web,
+		M_cauldron, M_stonechair, M_chest, M_shelf1, M_shelf2, M_stonetable, M_web,
 		// Living room
-		M_sofa, M_table, M_tv,
-		// Other
-		M_cat;
+		M_sofa, M_table, M_tv;
 
-	Model<VertexTan> M_knight, M_floor, M_walls, M_catFainted;
+	Model<Vertex> M_cat, M_steam, M_fire;
+	Model<VertexTanPacked> M_knight, M_floor, M_walls, M_catFainted;
 	Model<skyBoxVertex> M_skyBox;
 	Model<VertexOverlay> M_timer[5], M_screens[4], M_scroll, M_collectibles[COLLECTIBLES_NUM];
 	std::vector<Model<VertexBoundingBox>> M_boundingBox;
@@ -108,7 +100,7 @@ protected:
 		// Bedroom
 		DS_bed, DS_closet, DS_nighttable,
 		// Collectibles
-		DS_bone, DS_crystal, DS_eye, DS_feather, DS_leaf, DS_potion1, DS_potion2,
+		DS_item[COLLECTIBLES_NUM],
 		// Kitchen
 		DS_chair, DS_fridge, DS_kitchen, DS_kitchentable,
 		// Lair
@@ -123,34 +115,13 @@ protected:
 	std::vector<DescriptorSet> DS_boundingBox;
 
 	// Textures
-	Texture T_textures, T_eye, T_closet, T_feather, T_knight[3], T_skyBox, T_steam, T_fire, T_timer[5], T_screens[4], T_scroll, T_collectibles[COLLECTIBLES_NUM],
-		T_catDiffuseGhost, T_cat[3], T_wall[3], T_floor[3];
-
-	// C++ storage for uniform variables
-	UniformBufferObject // Bathroom
-		UBO_bathtub, UBO_bidet, UBO_sink, UBO_toilet,
-		// Bedroom
-		UBO_bed, UBO_closet, UBO_nightTable,
-		// Collectibles
-		UBO_bone, UBO_crystal, UBO_eye, UBO_feather, UBO_leaf, UBO_potion1, UBO_potion2,
-		// Kitchen
-		UBO_chair, UBO_fridge, UBO_kitchen, UBO_kitchenTable,
-		// Lair
-		UBO_cauldron, UBO_stoneChair, UBO_chest, UBO_shelf1, UBO_shelf2, UBO_stoneTable, UBO_web, UBO_catFainted,
-		// Living room
-		UBO_sofa, UBO_table, UBO_tv, UBO_knight,
-		// Other
-		UBO_floor, UBO_walls;
+	Texture T_textures, T_item[COLLECTIBLES_NUM], T_closet, T_knight[2], T_skyBox, T_steam, T_fire, T_timer[5], T_screens[4], T_scroll, T_collectibles[COLLECTIBLES_NUM],
+		T_catDiffuseGhost, T_cat[2], T_wall[2], T_floor[2];
 
-	std::vector<UniformBufferObject> UBO_boundingBox;
-	AnimatedUniformBufferObject UBO_steam, UBO_fire, UBO_cat;
-	SkyBoxUniformBufferObject UBO_skyBox;
-	OverlayUniformBlock UBO_timer[5], UBO_screens[4], UBO_scroll, UBO_collectibles[COLLECTIBLES_NUM];
-	GlobalUniformBufferObject GUBO;
-
-	// To display the bounding boxes for debugging
-	std::vector<BoundingBox> furnitureBBs;
-	BoundingBox catBox = BoundingBox("cat", catPosition, catDimensions);
+	// Descriptor set of every SceneObject, in the same order
+	DescriptorSet* objectDS[SCENE_OBJECTS_NUM];
+	// Dequantization of the model of every SceneObject, in the same order (see Model::dequantization)
+	const glm::mat4* objectDequantization[SCENE_OBJECTS_NUM];
 
 	// Here you set the main application parameters
 	void setWindowParameters();
@@ -177,48 +148,56 @@ protected:
 	// Here it is the creation of the command buffer:
 	// You send to the GPU all the objects you want to draw, with their buffers and textures
 	void populateCommandBuffer(VkCommandBuffer commandBuffer, int currentImage);
+	void populateCommandBufferPrePass(VkCommandBuffer commandBuffer, int currentImage);
+
+	// The scene without the HUD, with the counting pipelines of the heatmaps if counting
+	void drawScene(VkCommandBuffer commandBuffer, int currentImage, bool counting);
 
 	// Here is where you update the uniforms. Very likely this will be where you will be writing the logic of your application.
 	void updateUniformBuffer(uint32_t currentImage);
 
-	// Check for collisions with collectibles and furniture
-	void checkCollisions(uint32_t currentImage, glm::vec3& m, float deltaT);
+	// Read the devices into the input of the simulation
+	void readInput(FrameInput& in);
 
-	// Position all the objects in the world
-	void worldSetUp(const glm::vec3& catNewPos, const glm::mat4& ViewPrj, uint32_t currentImage);
+	// Print the frame times of a replay and whether it matched the recording
+	void reportReplay();
 
-	// Position ghost cat, draw its bounding box (if DEBUG) and update its uniform
-	void placeGhostCat(AnimatedUniformBufferObject ubo, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, glm::vec3 emissiveColor,
-									glm::mat4 ViewPrj, DescriptorSet ds, int currentImage, bool hasBoundingBox, int id);
+	// Write the statistics of the flythrough to its report
+	void reportFlythrough();
 
-	// Position objects (furniture, collectibles, fainted cat), draw their bounding box (if DEBUG) and update their uniforms
-	void placeEntity(UniformBufferObject ubo, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale,
-		glm::vec3 emissiveColor, glm::mat4 ViewPrj, DescriptorSet ds, int currentImage, bool hasBoundingBox, int id = 0);
+	// Read back the averages of the heatmap from the last submission of the image
+	void readOverdraw(uint32_t currentImage);
 
-	// Remove a collectible from the scene
-	void removeCollectible(UniformBufferObject ubo, glm::mat4 ViewPrj, DescriptorSet ds, int currentImage, int id);
+	// Send the uniforms computed by the simulation to the GPU
+	void uploadUniforms(uint32_t currentImage);
 
-	// Update overlay elements
-	void updateOverlay(uint32_t currentImage);
+	// Lay out the text of the frame: cpuMs is the time spent in this update so far
+	void updateText(uint32_t currentImage, double cpuMs);
 
-	// Update steam and fire UBOs
-	void updateSteamAndFire(glm::mat4& World, glm::mat4& ViewPrj, uint32_t currentImage);
+	// Show the cursor, unlocking it from the window
+	void showCursor();
 
-	// Setup all the lights in the scene
-	void updateLights(uint32_t currentImage);
+	// Hide the cursor, locking it to the window
+	void hideCursor();
 
-	// Create menu scenes placing the cat and the camera in a fixed position
-	void updateMenuScene(bool start, uint32_t currentImage);
+public:
+	// Use a fixed seed for the collectibles placement (to be called before run())
+	void setPlacementSeed(uint64_t seed) { sim.placementSeed = seed; }
 
-	// Update all the game elements (cat and camera position, time), also based on buttons pressed
-	void updateGame(bool& debounce, int& curDebounce, float& deltaT, glm::vec3& m, glm::vec3& r, uint32_t currentImage);
+	// Save the input of every frame to a file (to be called before run())
+	void recordInput(const std::string& path) { recordPath = path; }
 
-	// Check whether a button is pressed and update the game elements accordingly
-	void checkPressedButton(bool* debounce, int* curDebounce);
+	// Play a recorded session instead of reading the devices, with its placement seed (to be called before run())
+	void replayInput(const std::string& path);
 
-	// Show the cursor, unlocking it from the window
-	void showCursor();
+	// Tour the house for the given number of frames without vsync nor validation, then write the frame and pass times
+	// to reportPath and quit (to be called before run())
+	void runFlythrough(int frames, const std::string& reportPath);
 
-	// Hide the cursor, locking it to the window
-	void hideCursor();
+	// Show the stats panel from the first frame (F4 toggles it)
+	void showStats() { statsVisible = true; }
+
+	// Start with the overdraw heatmap, writing the fragments and lights per pixel of every frame to a CSV file
+	// (to be called before run())
+	void reportOverdraw(const std::string& path);
 };
@@ -0,0 +1,236 @@
+#include "ResourceRegistry.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "AssetPack.hpp"
+#include "Logger.hpp"
+#include "VulkanRecorder.hpp"
+
+namespace {
+
+// Bytes of the values added, one after the other
+struct KeyBuilder {
+	std::string bytes;
+
+	template <class T> void add(const T& value) {
+		bytes.append(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+};
+
+// The settings that make a sampler, field by field (the padding of the create info is not to be trusted)
+std::string samplerKey(const VkSamplerCreateInfo& info) {
+	KeyBuilder key;
+	key.add(info.flags);
+	key.add(info.magFilter);
+	key.add(info.minFilter);
+	key.add(info.mipmapMode);
+	key.add(info.addressModeU);
+	key.add(info.addressModeV);
+	key.add(info.addressModeW);
+	key.add(info.mipLodBias);
+	key.add(info.anisotropyEnable);
+	key.add(info.maxAnisotropy);
+	key.add(info.compareEnable);
+	key.add(info.compareOp);
+	key.add(info.minLod);
+	key.add(info.maxLod);
+	key.add(info.borderColor);
+	key.add(info.unnormalizedCoordinates);
+	return key.bytes;
+}
+
+}
+
+ResourceRegistry& ResourceRegistry::instance() {
+	static ResourceRegistry registry;
+	return registry;
+}
+
+void ResourceRegistry::init(VkDevice device) {
+	this->device = device;
+}
+
+void ResourceRegistry::cleanup() {
+	std::unordered_map<std::string, Object> leftovers;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		for (auto& [sampler, handle] : samplerReferences) {
+			LOG_WARN("Sampler still used %u times at cleanup", handle.references);
+			vkDestroySampler(device, sampler, nullptr);
+		}
+		for (auto& [module, handle] : shaderModuleReferences) {
+			LOG_WARN("Shader module still used %u times at cleanup", handle.references);
+			vkDestroyShaderModule(device, module, nullptr);
+		}
+		samplers.clear();
+		samplerReferences.clear();
+		shaderPaths.clear();
+		shaderModules.clear();
+		shaderModuleReferences.clear();
+		leftovers.swap(objects);
+		files.clear();
+	}
+
+	// Outside of the lock, like in release
+	for (auto& [key, object] : leftovers) {
+		LOG_WARN("%s still used %u times at cleanup", key.c_str(), object.references);
+		if (object.destroy) {
+			object.destroy();
+		}
+	}
+	device = VK_NULL_HANDLE;
+}
+
+std::shared_ptr<const FileData> ResourceRegistry::file(const std::string& path) {
+	std::string key = normalizePath(path);
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		auto it = files.find(key);
+		if (it != files.end()) {
+			if (std::shared_ptr<const FileData> held = it->second.lock()) {
+				stats.filesShared++;
+				return held;
+			}
+		}
+	}
+
+	// Read outside of the lock: another thread asking for the same file at the same time reads it too,
+	// and the first one to finish is kept
+	auto data = std::make_shared<const FileData>(VirtualFileSystem::instance().read(path));
+	std::lock_guard<std::mutex> guard(lock);
+	std::weak_ptr<const FileData>& entry = files[key];
+	if (std::shared_ptr<const FileData> held = entry.lock()) {
+		stats.filesShared++;
+		return held;
+	}
+	entry = data;
+	stats.fileReads++;
+	return data;
+}
+
+VkSampler ResourceRegistry::acquireSampler(const VkSamplerCreateInfo& info) {
+	std::lock_guard<std::mutex> guard(lock);
+	std::string key = samplerKey(info);
+	auto it = samplers.find(key);
+	if (it != samplers.end()) {
+		samplerReferences[it->second].references++;
+		stats.samplersShared++;
+		return it->second;
+	}
+
+	VkSampler sampler;
+	if (vkCreateSampler(device, &info, nullptr, &sampler) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create texture sampler!");
+	}
+	it = samplers.emplace(std::move(key), sampler).first;
+	samplerReferences[sampler] = { &it->first, 1, {} };
+	stats.samplersCreated++;
+	return sampler;
+}
+
+void ResourceRegistry::releaseSampler(VkSampler sampler) {
+	std::lock_guard<std::mutex> guard(lock);
+	auto it = samplerReferences.find(sampler);
+	if (it == samplerReferences.end()) {
+		return;
+	}
+	if (--it->second.references == 0) {
+		samplers.erase(*it->second.key);
+		samplerReferences.erase(it);
+		vkDestroySampler(device, sampler, nullptr);
+	}
+}
+
+VkShaderModule ResourceRegistry::acquireShaderModule(const std::string& path) {
+	std::string name = normalizePath(path);
+	std::unique_lock<std::mutex> guard(lock);
+	auto known = shaderPaths.find(name);
+	if (known != shaderPaths.end()) {
+		shaderModuleReferences[known->second].references++;
+		stats.shaderModulesShared++;
+		return known->second;
+	}
+	guard.unlock();
+
+	std::shared_ptr<const FileData> data = file(path);
+	std::string code(data->data(), data->size());
+
+	guard.lock();
+	auto it = shaderModules.find(code);
+	if (it != shaderModules.end()) {
+		// A copy of a module already loaded from another path (or from this one by another thread meanwhile)
+		Handle& handle = shaderModuleReferences[it->second];
+		handle.references++;
+		if (std::find(handle.paths.begin(), handle.paths.end(), name) == handle.paths.end()) {
+			handle.paths.push_back(name);
+			shaderPaths[name] = it->second;
+		}
+		stats.shaderModulesShared++;
+		return it->second;
+	}
+
+	// The code is copied to make sure it is aligned as SPIR-V words
+	std::vector<uint32_t> words((code.size() + 3) / 4);
+	memcpy(words.data(), code.data(), code.size());
+	VkShaderModuleCreateInfo createInfo{};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.codeSize = code.size();
+	createInfo.pCode = words.data();
+
+	VkShaderModule module;
+	if (vkCreateShaderModule(device, &createInfo, nullptr, &module) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create shader module!");
+	}
+	it = shaderModules.emplace(std::move(code), module).first;
+	shaderModuleReferences[module] = { &it->first, 1, { name } };
+	shaderPaths[name] = module;
+	stats.shaderModulesCreated++;
+	return module;
+}
+
+void ResourceRegistry::releaseShaderModule(VkShaderModule module) {
+	std::lock_guard<std::mutex> guard(lock);
+	auto it = shaderModuleReferences.find(module);
+	if (it == shaderModuleReferences.end()) {
+		return;
+	}
+	if (--it->second.references == 0) {
+		// The handle may be reused for another module: no path must lead to it any more
+		for (const std::string& path : it->second.paths) {
+			shaderPaths.erase(path);
+		}
+		shaderModules.erase(*it->second.key);
+		shaderModuleReferences.erase(it);
+		vkDestroyShaderModule(device, module, nullptr);
+	}
+}
+
+bool ResourceRegistry::release(const std::string& key) {
+	std::function<void()> destroy;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		auto it = objects.find(key);
+		if (it == objects.end()) {
+			return false;
+		}
+		if (--it->second.references > 0) {
+			return true;
+		}
+		destroy = std::move(it->second.destroy);
+		objects.erase(it);
+	}
+
+	// Outside of the lock: destroying may free memory through code that takes other locks
+	if (destroy) {
+		destroy();
+	}
+	return true;
+}
+
+ResourceRegistry::Stats ResourceRegistry::statistics() const {
+	std::lock_guard<std::mutex> guard(lock);
+	return stats;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "VirtualFileSystem.hpp"
+
+// Resources shared by the textures, models and pipelines, counted by reference so that asking twice for the same
+// file, image, sampler or shader module gives the same one instead of a copy:
+//  - files are read once through the virtual file system while someone holds them
+//  - samplers are keyed by their settings, shader modules by their code (and by path, not to read them again), byte
+//    by byte: equal keys are the same object; the registry creates and destroys both
+//  - the GPU objects of the textures and models (images, vertex and index buffers) are created by their first owner
+//    and handed to the next ones, with the function that destroys them: the registry calls it on the last release
+// Files can be requested from any thread, the GPU objects from the thread that creates them.
+class ResourceRegistry {
+public:
+	static ResourceRegistry& instance();
+
+	// Device of the samplers and shader modules (before any is requested)
+	void init(VkDevice device);
+	// Destroy what is still referenced, with a warning for each (before the device is destroyed, as the destroy
+	// functions of the objects may need it)
+	void cleanup();
+
+	// Contents of the file, shared with the other holders
+	std::shared_ptr<const FileData> file(const std::string& path);
+
+	VkSampler acquireSampler(const VkSamplerCreateInfo& info);
+	void releaseSampler(VkSampler sampler);
+
+	VkShaderModule acquireShaderModule(const std::string& path);
+	void releaseShaderModule(VkShaderModule module);
+
+	// The object under key with one more reference, false if nobody has added it yet
+	template <class T> bool acquire(const std::string& key, T& object) {
+		std::lock_guard<std::mutex> guard(lock);
+		auto it = objects.find(key);
+		if (it == objects.end()) {
+			stats.objectsCreated++;
+			return false;
+		}
+		it->second.references++;
+		object = *std::static_pointer_cast<T>(it->second.object);
+		stats.objectsShared++;
+		return true;
+	}
+	// Register the object just created under key, with the reference of its creator and the function that destroys it
+	template <class T> void add(const std::string& key, const T& object, std::function<void()> destroy) {
+		std::lock_guard<std::mutex> guard(lock);
+		objects[key] = { std::make_shared<T>(object), 1, std::move(destroy) };
+	}
+	// One reference less, the last one destroys the object. False if nothing is registered under key (the caller
+	// still owns what it created)
+	bool release(const std::string& key);
+
+	struct Stats {
+		uint32_t fileReads = 0, filesShared = 0;
+		uint32_t samplersCreated = 0, samplersShared = 0;
+		uint32_t shaderModulesCreated = 0, shaderModulesShared = 0;
+		uint32_t objectsCreated = 0, objectsShared = 0;
+	};
+	Stats statistics() const;
+
+private:
+	struct Handle {
+		const std::string* key;				// the settings of the sampler or the code of the module, in its map
+		uint32_t references;
+		std::vector<std::string> paths;		// shader modules: the paths they have been loaded from
+	};
+
+	struct Object {
+		std::shared_ptr<void> object;
+		uint32_t references;
+		std::function<void()> destroy;
+	};
+
+	mutable std::mutex lock;
+	VkDevice device = VK_NULL_HANDLE;
+	Stats stats;
+
+	std::unordered_map<std::string, std::weak_ptr<const FileData>> files;
+	std::unordered_map<std::string, VkSampler> samplers;				// by settings
+	std::unordered_map<VkSampler, Handle> samplerReferences;
+	std::unordered_map<std::string, VkShaderModule> shaderPaths;		// by path
+	std::unordered_map<std::string, VkShaderModule> shaderModules;		// by code
+	std::unordered_map<VkShaderModule, Handle> shaderModuleReferences;
+	std::unordered_map<std::string, Object> objects;
+};
@@ -0,0 +1,645 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "Simulation.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Logger.hpp"
+#include "ProfileScope.hpp"
+
+const char* simStageNames[SIM_STAGES_NUM] = {
+	"logic", "camera", "lights", "transforms", "overlay", "collisions"
+};
+
+// Transform of every scene object and the index of its collider in furnitureBBs (-1 = none)
+struct SceneObjectInfo {
+	const Transform* transform;
+	int furnitureBB;
+};
+
+static const SceneObjectInfo sceneObjects[SCENE_OBJECTS_NUM] = {
+	// House
+	{ &houseFloor, -1 }, { &walls, -1 },
+	// Bedroom
+	{ &closet, -1 }, { &bed, -1 }, { &nightTable, -1 },
+	// Kitchen
+	{ &kitchen, -1 }, { &fridge, -1 }, { &kitchenTable, -1 }, { &chair, -1 },
+	// Living room
+	{ &sofa, -1 }, { &table, -1 }, { &tv, -1 }, { &knight, -1 },
+	// Witch lair
+	{ &chest, -1 }, { &stoneTable, -1 }, { &stoneChair, -1 }, { &cauldron, 0 }, { &shelf1, -1 }, { &shelf2, -1 }, { &web, -1 }, { &catFainted, -1 },
+	// Bathroom
+	{ &bathtub, -1 }, { &toilet, -1 }, { &bidet, -1 }, { &sink, -1 }
+};
+
+void GameSimulation::init(Profiler* prof) {
+	profiler = prof;
+
+	// Create bounding boxes for furniture and collectibles (which are placed around the furniture)
+	furnitureBBs.push_back(BoundingBox("cauldron", cauldron.pos, glm::vec3(1.f, 1.5f, 1.f)));
+	/*
+	furnitureBBs.push_back(BoundingBox("closet", closet.pos, glm::vec3(5.6f, 6.f, 1.f)));
+	furnitureBBs.push_back(BoundingBox("bed",		bed.pos, glm::vec3(2.f, 1.2f, 4.5f)));
+	furnitureBBs.push_back(BoundingBox("nightTable",nightTable.pos, glm::vec3(0.88, 1.3f, 1.1f)));
+	furnitureBBs.push_back(BoundingBox("kitchen",	kitchen.pos, glm::vec3(5.f, 3.f, 1.72f)));
+	furnitureBBs.push_back(BoundingBox("fridge",	fridge.pos, glm::vec3(1.5f, 3.5f, 1.6f)));
+	furnitureBBs.push_back(BoundingBox("sofa",		sofa.pos, glm::vec3(1.f, 1.5f, 3.f)));
+	furnitureBBs.push_back(BoundingBox("chest",		chest.pos, glm::vec3(1.4f, 1.4f, 0.7f)));
+	furnitureBBs.push_back(BoundingBox("bathtub",	bathtub.pos, glm::vec3(3.3f, 1.7f, 1.4f)));
+	*/
+
+	placeCollectibles();
+	if (verbose) {
+		LOG_INFO("Collectibles placed with seed %llu", static_cast<unsigned long long>(placementSeed));
+	}
+
+	// Create ubo needed for the bounding boxes (debug)
+	UBO_boundingBox.assign(collectiblesBBs.size() + furnitureBBs.size() + 1, UniformBufferObject());
+}
+
+void GameSimulation::placeCollectibles() {
+	emptyBBList(&collectiblesBBs);
+	CounterRng placementRng(placementSeed, placementRound);
+	fillBBList(&collectiblesBBs, collectiblesRandomPosition, furnitureBBs, placementRng);
+}
+
+void GameSimulation::step(const FrameInput& in, double* stageMs) {
+	using clock = std::chrono::steady_clock;
+	clock::time_point stageStart = clock::now();
+	auto endStage = [&](SimStage s) {
+		if (stageMs != nullptr) {
+			clock::time_point now = clock::now();
+			stageMs[s] = std::chrono::duration<double, std::milli>(now - stageStart).count();
+			stageStart = now;
+		}
+	};
+
+	float deltaT = in.deltaT;
+	glm::vec3 m = in.m;
+	glm::mat4 ViewPrj;
+	glm::mat4 Mv;
+
+	cursorRequest = CURSOR_KEEP;
+
+	// Parameters for camera movement and rotation
+	ROT_SPEED = glm::radians(150.0f);
+	MOVE_SPEED = 6.0f;
+
+	totalElapsedTime += deltaT;
+
+	if (gameState == GAME_STATE_START_SCREEN || gameState == GAME_STATE_GAME_WIN || gameState == GAME_STATE_GAME_LOSE) {
+		updateMenuScene(in);
+	} else if (gameState == GAME_STATE_PLAY) {
+		updateGame(in);
+	}
+
+	// Press I to show instruction screen
+	if (keyToggled(in, SIM_KEY_I)) {
+		UBO_screens[3].visible = 1.0f - UBO_screens[3].visible;
+		UBO_screens[0].visible = UBO_screens[1].visible = UBO_screens[2].visible = 0.f;
+		showInstruction = !showInstruction;
+		OVERLAY = (gameState == GAME_STATE_PLAY) ? !OVERLAY : false;
+		cursorShowed = !cursorShowed;
+	}
+
+	// Limit the cat's movement to the house
+	catPosition.x = glm::clamp(catPosition.x, -HOUSE_HALF_SIZE, HOUSE_HALF_SIZE);
+	catPosition.z = glm::clamp(catPosition.z, -HOUSE_HALF_SIZE, HOUSE_HALF_SIZE);
+
+	// Update rotation angle of the collectibles
+	collectibleRotationAngle = fmod(collectibleRotationAngle + deltaT, 2 * M_PI);
+
+	// Update the collectibles' vertical position for floating effect
+	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
+		collectiblesRandomPosition[i].y = 0.3f + 0.05f * sin((totalElapsedTime + i) * 3);
+	}
+	endStage(SIM_STAGE_LOGIC);
+
+	// Parameters
+	// Camera FOV-y, Near Plane and Far Plane
+	// Set up the view and projection matrices
+	const float FOVy = FIRST_PERSON ? glm::radians(25.0f) : glm::radians(60.0f);
+	const float nearPlane = 0.1f;
+	const float farPlane = 30.0f;
+
+	glm::mat4 M = glm::perspective(FOVy, Ar, nearPlane, farPlane);
+	M[1][1] *= -1;
+
+	// View matrix for camera following the cat
+	if (FIRST_PERSON || gameState != GAME_STATE_PLAY) {
+		Mv = glm::rotate(glm::mat4(1.0f), -camRoll, glm::vec3(0, 0, 1)) *
+				glm::rotate(glm::mat4(1.0f), -camPitch, glm::vec3(1, 0, 0)) *
+				glm::rotate(glm::mat4(1.0f), -camYaw, glm::vec3(0, 1, 0)) *
+				glm::translate(glm::mat4(1.0f), -camPos);
+		ViewPrj = M * Mv;
+	} else {
+		Mv = glm::rotate(glm::mat4(1.0f), -camRoll, glm::vec3(0, 0, 1)) *
+				glm::lookAt(camPos, catPosition, glm::vec3(0, 1, 0));
+		ViewPrj = M * Mv;
+	}
+
+	// Sky Box UBO update
+	UBO_skyBox.mvpMat = M * glm::mat4(glm::mat3(Mv));
+	UBO_skyBox.time = totalElapsedTime;
+	endStage(SIM_STAGE_CAMERA);
+
+	updateLights();
+	endStage(SIM_STAGE_LIGHTS);
+
+	updateSteamAndFire(ViewPrj);
+	worldSetUp(ViewPrj);
+	endStage(SIM_STAGE_TRANSFORMS);
+
+	updateOverlay();
+	endStage(SIM_STAGE_OVERLAY);
+
+	checkCollisions(m, deltaT);
+	endStage(SIM_STAGE_COLLISIONS);
+}
+
+uint64_t GameSimulation::stateHash() const {
+	// FNV-1a on the raw bytes: a replay must reproduce every bit of the state, not just approximate it
+	uint64_t h = 0xCBF29CE484222325ull;
+	auto add = [&h](const void* data, size_t size) {
+		const unsigned char* p = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; i++) {
+			h = (h ^ p[i]) * 0x100000001B3ull;
+		}
+	};
+
+	add(&camPos, sizeof(camPos));
+	add(&camYaw, sizeof(camYaw));
+	add(&camPitch, sizeof(camPitch));
+	add(&camRoll, sizeof(camRoll));
+	add(&camDist, sizeof(camDist));
+	add(&catPosition, sizeof(catPosition));
+	add(&catYaw, sizeof(catYaw));
+	add(&totalElapsedTime, sizeof(totalElapsedTime));
+	add(&gameState, sizeof(gameState));
+	add(&lightOn, sizeof(lightOn));
+	add(&collectibleRotationAngle, sizeof(collectibleRotationAngle));
+	add(collectiblesRandomPosition, sizeof(collectiblesRandomPosition));
+	add(&placementRound, sizeof(placementRound));
+
+	uint8_t flags = DEBUG | (OVERLAY << 1) | (FIRST_PERSON << 2) | (gameOver << 3) | (cursorShowed << 4) | (showInstruction << 5);
+	add(&flags, sizeof(flags));
+	// The collected set 64 bits at a time (to_ullong would throw past 64 collectibles, std::hash differs by platform)
+	for (size_t first = 0; first < collected.size(); first += 64) {
+		uint64_t word = 0;
+		for (size_t b = first; b < std::min(first + 64, collected.size()); b++) {
+			word |= static_cast<uint64_t>(collected[b]) << (b - first);
+		}
+		add(&word, sizeof(word));
+	}
+
+	return h;
+}
+
+// Debounced key press: true only on the frame the key goes down, while no other toggle key is held
+bool GameSimulation::keyToggled(const FrameInput& in, SimKey k) {
+	if (in.key(k)) {
+		if (!debounce) {
+			debounce = true;
+			curDebounce = k;
+			return true;
+		}
+	} else if ((curDebounce == k) && debounce) {
+		debounce = false;
+		curDebounce = -1;
+	}
+	return false;
+}
+
+void GameSimulation::checkCollisions(const glm::vec3& m, float deltaT) {
+	PROFILE_SCOPE(profiler, "checkCollisions");
+
+	// Collectibles
+	for (size_t i = 0; i < collectiblesBBs.size(); i++) {
+		if (catBox.intersects(collectiblesBBs[i])) {
+			collected.set(i);
+			UBO_collectibles[i].visible = 0.f;
+
+			if (collected.all()) {
+				if (verbose) {
+					LOG_INFO("ALL COLLECTIBLES COLLECTED! Now go to the cauldron!");
+				}
+				gameOver = true;
+			}
+		}
+	}
+
+	// Furniture
+	for (size_t j = 0; j < furnitureBBs.size(); j++) {
+		if (catBox.intersects(furnitureBBs[j])) {
+			if (furnitureBBs[j].getName() == "cauldron") {
+				if (gameOver) {
+					gameState = GAME_STATE_GAME_WIN;
+				} else {
+					break;
+				}
+			}
+			catPosition += cameraForward * m.z * MOVE_SPEED * deltaT;
+			catPosition -= cameraRight * m.x * MOVE_SPEED * deltaT;
+
+			if (verbose) {
+				LOG_INFO("Collision with %s", furnitureBBs[j].getName().c_str());
+			}
+		}
+	}
+}
+
+void GameSimulation::worldSetUp(const glm::mat4& ViewPrj) {
+	PROFILE_SCOPE(profiler, "worldSetUp");
+
+	// Placing ghost cat
+	placeGhostCat(catPosition, glm::vec3(0, catYaw, 0), FIRST_PERSON ? glm::vec3(0.0f) : glm::vec3(1.f), ViewPrj, DEBUG);
+	catBox = BoundingBox("cat", catPosition, catDimensions);
+
+	// House, bedroom, kitchen, living room, witch lair and bathroom
+	for (int i = 0; i < SCENE_OBJECTS_NUM; i++) {
+		const Transform& t = *sceneObjects[i].transform;
+		int bb = sceneObjects[i].furnitureBB;
+		placeEntity(objects[i], t.pos, t.rot, t.scale, glm::vec3(0.0f), ViewPrj,
+			bb >= 0 && DEBUG, bb >= 0 ? COLLECTIBLES_NUM + bb : -1);
+	}
+
+	// Collectibles
+	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
+		if (!collected[i]) {
+			placeEntity(items[i], collectiblesRandomPosition[i], glm::vec3(0, collectibleRotationAngle, 0), glm::vec3(gameState == GAME_STATE_PLAY), glm::vec3(collectibleRegistry[i].emission), ViewPrj, DEBUG, i);
+		}
+		else {
+			removeCollectible(items[i], ViewPrj, i);
+		}
+	}
+}
+
+// Position ghost cat and its bounding box (if DEBUG)
+void GameSimulation::placeGhostCat(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, const glm::mat4& ViewPrj, bool hasBoundingBox) {
+	glm::mat4 World = glm::translate(glm::mat4(1), position) *
+		glm::rotate(glm::mat4(1), rotation.x, glm::vec3(1, 0, 0)) *
+		glm::rotate(glm::mat4(1), rotation.y, glm::vec3(0, 1, 0)) *
+		glm::rotate(glm::mat4(1), rotation.z, glm::vec3(0, 0, 1)) *
+		glm::scale(glm::mat4(1), scale);
+	UBO_cat.mvpMat = ViewPrj * World;
+	UBO_cat.mMat = World;
+	UBO_cat.nMat = glm::transpose(glm::inverse(World));
+	UBO_cat.time = totalElapsedTime;
+	UBO_cat.speed = 2.0f;
+
+	updateBoundingBox(hasBoundingBox, position, rotation, scale, ViewPrj, UBO_boundingBox[catBoundingBox()]);
+}
+
+// Position objects (furniture, collectibles, fainted cat) and their bounding box (if DEBUG); id < 0 means no bounding box
+void GameSimulation::placeEntity(EntityUniforms& e, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale,
+	glm::vec3 emissiveColor, const glm::mat4& ViewPrj, bool hasBoundingBox, int id) {
+
+	glm::mat4 World = glm::translate(glm::mat4(1), position) *
+		glm::rotate(glm::mat4(1), rotation.x, glm::vec3(1, 0, 0)) *
+		glm::rotate(glm::mat4(1), rotation.y, glm::vec3(0, 1, 0)) *
+		glm::rotate(glm::mat4(1), rotation.z, glm::vec3(0, 0, 1)) *
+		glm::scale(glm::mat4(1), scale);
+	e.ubo.mvpMat = ViewPrj * World;
+	e.ubo.mMat = World;
+	e.ubo.nMat = glm::transpose(glm::inverse(World));
+	e.emissiveColor = emissiveColor;
+
+	if (id >= 0) {
+		updateBoundingBox(hasBoundingBox, position, rotation, scale, ViewPrj, UBO_boundingBox[id]);
+	}
+}
+
+void GameSimulation::removeCollectible(EntityUniforms& e, const glm::mat4& ViewPrj, int id) {
+	glm::mat4 World = glm::mat4(0.f);
+	e.ubo.mvpMat = ViewPrj * World;
+	e.ubo.mMat = World;
+	e.ubo.nMat = glm::transpose(glm::inverse(World));
+
+	// Update bounding box matrices
+	UBO_boundingBox[id].mvpMat = ViewPrj * World;
+	UBO_boundingBox[id].mMat = World;
+	UBO_boundingBox[id].nMat = glm::transpose(glm::inverse(World));
+
+	// Remove bounding box from the array of BBs
+	collectiblesBBs[id].erase();
+}
+
+void GameSimulation::updateOverlay() {
+
+	if (OVERLAY) {
+		// Timer
+		if (timeLeft >= GAME_DURATION * 3 / 4) {
+			UBO_timer[0].visible = 1.f;
+			UBO_timer[1].visible = UBO_timer[2].visible = UBO_timer[3].visible = UBO_timer[4].visible = 0.f;
+		}
+		else if (timeLeft >= GAME_DURATION / 2) {
+			UBO_timer[1].visible = 1.f;
+			UBO_timer[0].visible = UBO_timer[2].visible = UBO_timer[3].visible = UBO_timer[4].visible = 0.f;
+		}
+		else if (timeLeft >= GAME_DURATION / 4) {
+			UBO_timer[2].visible = 1.f;
+			UBO_timer[0].visible = UBO_timer[1].visible = UBO_timer[3].visible = UBO_timer[4].visible = 0.f;
+		}
+		else if (timeLeft > 3.0f) {
+			UBO_timer[3].visible = 1.f;
+			UBO_timer[0].visible = UBO_timer[1].visible = UBO_timer[2].visible = UBO_timer[4].visible = 0.f;
+		}
+		else {
+			UBO_timer[4].visible = 1.f;
+			UBO_timer[0].visible = UBO_timer[1].visible = UBO_timer[2].visible = UBO_timer[3].visible = 0.f;
+		}
+
+		// Scroll
+		UBO_scroll.visible = 1.f;
+
+		// Collectibles
+		for (int i = 0; i < COLLECTIBLES_NUM; i++) {
+			UBO_collectibles[i].visible = !collected[i] ? 1.f : 0.f;
+		}
+
+	} else {
+		// Hide all overlay elements
+		UBO_timer[0].visible = UBO_timer[1].visible = UBO_timer[2].visible = UBO_timer[3].visible = UBO_timer[4].visible = 0.f;
+		UBO_scroll.visible = 0.f;
+		for (int i = 0; i < COLLECTIBLES_NUM; i++) {
+			UBO_collectibles[i].visible = 0.f;
+		}
+	}
+}
+
+void GameSimulation::updateSteamAndFire(const glm::mat4& ViewPrj) {
+	glm::mat4 World;
+
+	// Steam
+	World = glm::translate(glm::mat4(1.0f), cauldron.pos + glm::vec3(0, 1.7f, 0)) *		// Steam plane position - over the cauldron
+			glm::rotate(glm::mat4(1.0f), camYaw, glm::vec3(0, 1, 0));					// Steam plane rotation - always face the camera
+	UBO_steam.mvpMat = ViewPrj * World;
+	UBO_steam.mMat = World;
+	UBO_steam.nMat = glm::transpose(glm::inverse(World));
+	UBO_steam.time = totalElapsedTime;
+	UBO_steam.speed = 0.7f;
+
+	// Fire
+	World = glm::translate(glm::mat4(1.0f), cauldron.pos + glm::vec3(0, 0.3f, 0.1f)) *	// Fire plane position - under the cauldron
+			glm::rotate(glm::mat4(1.0f), camYaw, glm::vec3(0, 1, 0));					// Fire plane rotation - always face the camera
+	UBO_fire.mvpMat = ViewPrj * World;
+	UBO_fire.mMat = World;
+	UBO_fire.nMat = glm::transpose(glm::inverse(World));
+	UBO_fire.time = totalElapsedTime;
+	UBO_fire.speed = 4.f;
+}
+
+void GameSimulation::updateLights() {
+	GUBO.lightPos[0] = glm::vec3(6.0f, 2.0f, 8.0f);							// position: kitchen
+	GUBO.lightColor[0] = glm::vec4(glm::vec3(1.4f), 2.0f);					// color: white
+
+	GUBO.lightPos[1] = glm::vec3(-8.f, 2.0f, -8.f);							// position: witch lair
+	GUBO.lightColor[1] = glm::vec4(glm::vec3(0.4f, 0.f, 0.8f), 2.0f);		// color: purple
+
+	GUBO.lightPos[2] = glm::vec3(-6.0f, 1.3f, -8.3f);						// position: witch lair - cauldron potion
+	GUBO.lightColor[2] = glm::vec4(glm::vec3(0.02f, 0.07f, 0.02f), 2.0f);	// color: green
+	GUBO.lightPos[3] = glm::vec3(-6.0f, 0.2f, -8.3f);						// position: witch lair - cauldron fire
+	GUBO.lightColor[3] = glm::vec4(glm::vec3(0.14f, 0.08f, 0.f), 2.0f);		// color: orange
+
+	GUBO.lightPos[4] = glm::vec3(11.9f, 1.0f, -4.f);						// position: bedroom
+	GUBO.lightColor[4] = glm::vec4(glm::vec3(0.6f, 0.5f, 0.f), 2.0f);		// color: yellow
+
+	GUBO.lightPos[5] = glm::vec3(-7.0f, 2.0f, 7.f);							// position: living room
+	GUBO.lightColor[5] = glm::vec4(glm::vec3(0.2f, 1.0f, 0.2f), 2.0f);		// color: green
+
+	GUBO.lightPos[6] = glm::vec3(0.f, 2.5f, -8.f);							// position: bathroom
+	GUBO.lightColor[6] = glm::vec4(glm::vec3(0.50f, 0.25f, 0.f), 2.0f);		// color: orange
+
+	GUBO.lightDir[7] = glm::vec3(-0.5, 1.0, 0.5);							// (sun) light from outside
+	GUBO.lightColor[7] = glm::vec4(glm::vec3(0.2f), 2.0f);					// color: white
+
+	GUBO.lightPos[8] = glm::vec3(-6.0f, 1.5f, -8.3f);						// position: witch lair - cauldron
+	GUBO.lightColor[8] = glm::vec4(glm::vec3(0.1f, 0.1f, 1.0f), 20.0f);		// color: blue
+	GUBO.lightDir[8] = glm::vec3(0, 1, 0);									// light from above
+
+	GUBO.cosIn = glm::cos(glm::radians(35.0f));								// cos of the inner angle of the spot light
+	GUBO.cosOut = glm::cos(glm::radians(45.0f));							// cos of the outer angle of the spot light
+
+	for (int i = 0; i < COLLECTIBLES_NUM; i++) {
+		int slot = collectibleLightSlot(i);
+		if (slot < 0) {
+			break;
+		}
+		GUBO.lightPos[slot] = collectiblesRandomPosition[i] + glm::vec3(0.f, 0.5f, 0.f);	// position: over the collectibles
+		GUBO.lightDir[slot] = glm::vec3(0, 1, 0);											// light from above
+		GUBO.lightColor[slot] = collected[i] ? glm::vec4(glm::vec3(0.0f), 0.0f) : glm::vec4(glm::vec3(0.7f, 0.1f, 1.0f), 10.0f);
+	}
+
+	GUBO.eyePos = camPos; // Camera position
+
+	GUBO.lightOn = lightOn;
+	GUBO.gameOver = gameOver;
+}
+
+// Create menu scenes placing the cat and the camera in a fixed position
+void GameSimulation::updateMenuScene(const FrameInput& in) {
+	camPos = glm::vec3(-5.5f, 2.6f, -2.8f);
+	camYaw = glm::radians(40.0f);
+	camPitch = glm::radians(-20.0f);
+	camRoll = 0.0f;
+
+	catPosition = glm::vec3(-7.2f, 0.05f, -9.0f);
+	catYaw = glm::radians(110.0f);
+
+	FIRST_PERSON = false;
+	OVERLAY = false;
+	DEBUG = false;
+	gameOver = false;
+
+	cursorRequest = CURSOR_SHOW;
+
+	lightOn = glm::vec4(1, 1, 0, 1);	// Turn off all spot lights
+
+	if (gameState == GAME_STATE_START_SCREEN && !showInstruction) {
+		UBO_screens[0].visible = 1.f;
+		UBO_screens[1].visible = UBO_screens[2].visible = UBO_screens[3].visible = 0.f;
+	} else if (gameState == GAME_STATE_GAME_WIN) {
+		UBO_screens[1].visible = 1.f;
+		UBO_screens[0].visible = UBO_screens[2].visible = UBO_screens[3].visible = 0.f;
+	} else if (gameState == GAME_STATE_GAME_LOSE) {
+		UBO_screens[2].visible = 1.f;
+		UBO_screens[0].visible = UBO_screens[1].visible = UBO_screens[3].visible = 0.f;
+	}
+
+	// Set all the elements to not_collected
+	collected.reset();
+
+	if (in.start) {	// Setting the variables ready to start the game
+		OVERLAY = true;
+
+		UBO_screens[0].visible = UBO_screens[1].visible = UBO_screens[2].visible = UBO_screens[3].visible = 0.f;
+
+		camPos = glm::vec3(0.0f, 1.5f, 7.0f);
+		camYaw = glm::radians(90.0f);
+		camPitch = glm::radians(-10.0f);
+		camRoll = 0.0f;
+		camDist = 3.0f;
+		CamTargetDelta = glm::vec3(0.0f, 1.5f, 0.0f);
+
+		catPosition = glm::vec3(6.0f, 0.05f, 0.0f);
+		catYaw = 0.0f;
+
+		totalElapsedTime = 0.0f;
+
+		placementRound++;
+		placeCollectibles();
+
+		lightOn = glm::vec4(1, 1, 1, 1);
+
+		cursorRequest = CURSOR_HIDE;
+
+		gameState = GAME_STATE_PLAY;
+	}
+}
+
+// Update all the game elements (cat and camera position, time), also based on buttons pressed
+void GameSimulation::updateGame(const FrameInput& in) {
+	float deltaT = in.deltaT;
+	const glm::vec3& m = in.m;
+	const glm::vec3& r = in.r;
+
+	timeLeft = GAME_DURATION - totalElapsedTime;
+
+	checkPressedButton(in);
+
+	// Update camera yaw, pitch, and roll
+	int yawFactor = FIRST_PERSON ? -1 : 1;
+	camYaw += ROT_SPEED * deltaT * r.y * yawFactor;
+	camPitch -= ROT_SPEED * deltaT * r.x;
+	camRoll -= ROT_SPEED * deltaT * r.z;
+	camDist -= MOVE_SPEED * deltaT * m.y;
+
+	// Limit the distance from the cat and the pitch to avoid gimbal lock
+	camDist = glm::clamp(camDist, 1.5f, 4.0f);
+	camPitch = glm::clamp(camPitch, minPitch, maxPitch);
+	camRoll = glm::clamp(camRoll, minRoll, maxRoll);
+
+	// Redefine camera forward and right vectors when camera rotates
+	cameraForward = glm::normalize(glm::vec3(sin(camYaw), 0.0f, cos(camYaw)));
+	cameraRight = glm::normalize(glm::vec3(cos(camYaw), 0.0f, -sin(camYaw)));
+
+	// Cat movement
+	if ((m.x != 0) || (m.z != 0)) {
+		catPosition -= cameraForward * m.z * MOVE_SPEED * deltaT;
+		catPosition += cameraRight * m.x * MOVE_SPEED * deltaT;
+
+		// Cat rotation based on the movement vector
+		float targetYaw = atan2(m.z, m.x);
+		targetYaw += glm::radians(-180.0f);
+		catYaw = glm::mix(catYaw, targetYaw + std::fmod(camYaw, glm::radians(360.0f)), deltaT * 6.0f);	// 6.0 is the damping factor
+	}
+
+	if (FIRST_PERSON) {
+		// First person camera position
+		glm::vec3 ux = glm::rotate(glm::mat4(1.0f), camYaw, glm::vec3(0, 1, 0)) * glm::vec4(1, 0, 0, 1);
+		glm::vec3 uz = glm::rotate(glm::mat4(1.0f), camYaw, glm::vec3(0, 1, 0)) * glm::vec4(0, 0, -1, 1);
+
+		camPos = catPosition + MOVE_SPEED * m.x * ux * deltaT;
+		camPos = camPos + MOVE_SPEED * m.z * uz * deltaT;
+
+		camPos.y += 0.9f;
+	} else {
+		// Third person camera position
+		glm::vec3 camTarget = catPosition + CamTargetDelta;
+		camPos = camTarget + glm::vec3(glm::rotate(glm::mat4(1), camYaw, glm::vec3(0, 1, 0)) *
+				glm::rotate(glm::mat4(1), -camPitch, glm::vec3(1, 0, 0)) *
+				glm::vec4(0, 0, camDist, 1));
+	}
+
+	// Check if game is over because time has run out
+	if (totalElapsedTime >= GAME_DURATION) {
+		gameState = GAME_STATE_GAME_LOSE;
+	} else if (static_cast<int>(timeLeft) != lastDisplayedTime) {
+		if (verbose) {
+			LOG_INFO("Time remaining: %d", static_cast<int>(timeLeft));
+		}
+		lastDisplayedTime = static_cast<int>(timeLeft);
+	}
+}
+
+void GameSimulation::checkPressedButton(const FrameInput& in) {
+	// Press P to toggle debug mode
+	if (keyToggled(in, SIM_KEY_P)) {
+		DEBUG = !DEBUG;
+	}
+
+	// Press H to cycle the heatmaps: overdraw, lights per fragment, off
+	if (keyToggled(in, SIM_KEY_H)) {
+		HEATMAP = (HEATMAP + 1) % HEATMAP_VIEWS_NUM;
+	}
+
+	// Press O to toggle overlay
+	if (keyToggled(in, SIM_KEY_O)) {
+		OVERLAY = !OVERLAY;
+	}
+
+	// Press L to reset the camera view
+	if (keyToggled(in, SIM_KEY_L)) {
+		camRoll = 0.0f;
+		camPitch = glm::radians(-10.0f);
+		camDist = 3.0f;
+		camYaw = catYaw + glm::radians(90.0f);
+	}
+
+	// Press K to reset the game
+	if (in.key(SIM_KEY_K)) {
+		gameState = GAME_STATE_START_SCREEN;
+	}
+
+	// Press V to switch between 1st and 3rd person view
+	if (keyToggled(in, SIM_KEY_V)) {
+		FIRST_PERSON = !FIRST_PERSON;
+	}
+
+	// Press SHIFT key to sprint
+	if (in.key(SIM_KEY_SHIFT)) {
+		MOVE_SPEED = 12.0f;
+		ROT_SPEED = glm::radians(200.0f);
+	}
+
+	// Press N to reach win screen
+	if (in.key(SIM_KEY_N)) {
+		gameState = GAME_STATE_GAME_WIN;
+	}
+
+	// Press M to reach lose screen
+	if (in.key(SIM_KEY_M)) {
+		gameState = GAME_STATE_GAME_LOSE;
+	}
+
+	// Press Z to toggle the cursor
+	if (keyToggled(in, SIM_KEY_Z)) {
+		cursorRequest = cursorShowed ? CURSOR_HIDE : CURSOR_SHOW;
+		cursorShowed = !cursorShowed;
+	}
+
+	// Press 1 to turn on/off point lights
+	if (keyToggled(in, SIM_KEY_1)) {
+		lightOn.x = 1 - lightOn.x;
+	}
+
+	// Press 2 to turn on/off directional lights
+	if (keyToggled(in, SIM_KEY_2)) {
+		lightOn.y = 1 - lightOn.y;
+	}
+
+	// Press 3 to turn on/off spot lights
+	if (keyToggled(in, SIM_KEY_3)) {
+		lightOn.z = 1 - lightOn.z;
+	}
+
+	// Press 4 to turn on/off ambient lights
+	if (keyToggled(in, SIM_KEY_4)) {
+		lightOn.w = 1 - lightOn.w;
+	}
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+#include "BoundingBox.hpp"
+#include "Utils.hpp"
+#include "World.hpp"
+#include "Placement.hpp"
+#include "Collectibles.hpp"
+
+class Profiler;
+
+// Keys the game reacts to, as bits of FrameInput::keys
+enum SimKey {
+	SIM_KEY_P, SIM_KEY_O, SIM_KEY_L, SIM_KEY_K, SIM_KEY_V, SIM_KEY_SHIFT, SIM_KEY_N, SIM_KEY_M, SIM_KEY_Z, SIM_KEY_I,
+	SIM_KEY_1, SIM_KEY_2, SIM_KEY_3, SIM_KEY_4, SIM_KEY_H,
+	SIM_KEYS_NUM
+};
+
+// Everything the simulation reads from the player in one frame
+struct FrameInput {
+	float deltaT = 0.0f;
+	glm::vec3 m = glm::vec3(0.0f);		// motion, as returned by getSixAxis()
+	glm::vec3 r = glm::vec3(0.0f);		// rotation, as returned by getSixAxis()
+	bool fire = false;
+	bool start = false;
+	uint32_t keys = 0;					// bit (1 << SimKey) set while the key is held
+
+	bool key(SimKey k) const { return (keys >> k) & 1u; }
+};
+
+// Where the per-frame input comes from (devices, a script, a recording)
+class InputSource {
+public:
+	virtual ~InputSource() = default;
+	// Fill the input of the next frame, return false when there is no more input
+	virtual bool next(FrameInput& in) = 0;
+	// Called after the step with the hash of the resulting game state (replays compare it with the recorded one)
+	virtual void verify(uint64_t) {}
+};
+
+// Parts of a simulation step, timed separately
+enum SimStage { SIM_STAGE_LOGIC, SIM_STAGE_CAMERA, SIM_STAGE_LIGHTS, SIM_STAGE_TRANSFORMS, SIM_STAGE_OVERLAY, SIM_STAGE_COLLISIONS, SIM_STAGES_NUM };
+extern const char* simStageNames[SIM_STAGES_NUM];
+
+// Static objects of the house, placed every frame
+enum SceneObject {
+	OBJ_FLOOR, OBJ_WALLS,
+	OBJ_CLOSET, OBJ_BED, OBJ_NIGHT_TABLE,
+	OBJ_KITCHEN, OBJ_FRIDGE, OBJ_KITCHEN_TABLE, OBJ_CHAIR,
+	OBJ_SOFA, OBJ_TABLE, OBJ_TV, OBJ_KNIGHT,
+	OBJ_CHEST, OBJ_STONE_TABLE, OBJ_STONE_CHAIR, OBJ_CAULDRON, OBJ_SHELF1, OBJ_SHELF2, OBJ_WEB, OBJ_CAT_FAINTED,
+	OBJ_BATHTUB, OBJ_TOILET, OBJ_BIDET, OBJ_SINK,
+	SCENE_OBJECTS_NUM
+};
+
+// Uniforms of an object: its matrices (slot 0) and its emission color (slot 2)
+struct EntityUniforms {
+	UniformBufferObject ubo;
+	glm::vec3 emissiveColor;
+};
+
+// What the simulation asks the window to do with the cursor
+enum CursorRequest { CURSOR_KEEP, CURSOR_SHOW, CURSOR_HIDE };
+
+// The whole game logic of Purrfect Potion: state, rules and the uniforms to send to the GPU.
+// It does not touch the window nor Vulkan, so it can also run headless.
+class GameSimulation {
+public:
+	// Current aspect ratio
+	float Ar = 1.5f;
+
+	// Camera position, orientation, distance from target
+	glm::vec3 camPos = glm::vec3(0.0f);
+	float camYaw = 0.0f;
+	float camPitch = 0.0f;
+	float camRoll = 0.0f;
+	float camDist = 3.0f;
+	glm::vec3 CamTargetDelta = glm::vec3(0.0f);
+	float minPitch = glm::radians(-20.0f);
+	float maxPitch = M_PI_2 - 0.1f;
+	float minRoll = -M_PI_2;
+	float maxRoll = M_PI_2;
+	glm::vec3 cameraForward = glm::vec3(0.0f, 0.0f, 1.0f);
+	glm::vec3 cameraRight = glm::vec3(1.0f, 0.0f, 0.0f);
+
+	float ROT_SPEED = glm::radians(150.0f);
+	float MOVE_SPEED = 6.0f;
+
+	// Cat position and orientation
+	glm::vec3 catPosition = glm::vec3(0.0f);
+	glm::vec3 catDimensions = glm::vec3(1.2f, 1.2f, 0.3f);
+	float catYaw = 0.0f;
+
+	// Timer setup
+	const float GAME_DURATION = 180.0f;		// 3 minutes = 180 seconds
+	float totalElapsedTime = 0.0f;			// in seconds
+	float timeLeft = GAME_DURATION;
+	int lastDisplayedTime = static_cast<int>(GAME_DURATION);
+
+	// Game state variables
+	bool DEBUG = false;							// to display bounding boxes for debugging
+	enum { HEATMAP_OFF, HEATMAP_OVERDRAW, HEATMAP_LIGHTS, HEATMAP_VIEWS_NUM };
+	int HEATMAP = HEATMAP_OFF;					// heatmap of the fragments or of the lights per pixel, instead of the scene
+	bool OVERLAY = false;						// to display the overlay
+	bool FIRST_PERSON = false;					// to switch between first and third person view
+	bool gameOver = false;						// to determine when all the collectibles have been collected
+	bool cursorShowed = false;					// to show/hide the cursor
+	int gameState = GAME_STATE_START_SCREEN;	// initially state of the game = start screen
+	glm::vec4 lightOn = glm::vec4(1, 1, 0, 1);	// initially all types of light are on, except spot
+	bool verbose = true;						// print game events on the console
+
+	// Key debouncing
+	bool debounce = false;
+	int curDebounce = -1;
+	bool showInstruction = false;
+
+	// Collectibles parameters
+	float collectibleRotationAngle = 0.0f;						 // rotation angle
+	const float collectibleRotationSpeed = glm::radians(45.0f);  // rotation speed: 45 degrees per second
+	glm::vec3 collectiblesRandomPosition[COLLECTIBLES_NUM];		 // position
+
+	// Seed of the collectibles placement: every new game takes the next stream of the same seed,
+	// so a whole session can be reproduced
+	uint64_t placementSeed = static_cast<uint64_t>(time(nullptr));
+	uint64_t placementRound = 0;
+
+	CollectedSet collected;							// indexed by CollectibleId
+	std::vector<BoundingBox> collectiblesBBs;		// indexed by CollectibleId
+	std::vector<BoundingBox> furnitureBBs;
+	BoundingBox catBox = BoundingBox("cat", glm::vec3(0.0f), catDimensions);
+
+	// Output of the last step: the values of all the uniforms
+	EntityUniforms objects[SCENE_OBJECTS_NUM];
+	EntityUniforms items[COLLECTIBLES_NUM];
+	std::vector<UniformBufferObject> UBO_boundingBox;	// collectibles, then furniture, then the cat
+	AnimatedUniformBufferObject UBO_steam, UBO_fire, UBO_cat;
+	glm::vec3 catEmissiveColor = glm::vec3(3.0f);
+	SkyBoxUniformBufferObject UBO_skyBox;
+	OverlayUniformBlock UBO_timer[5], UBO_screens[4], UBO_scroll, UBO_collectibles[COLLECTIBLES_NUM];
+	GlobalUniformBufferObject GUBO;
+	CursorRequest cursorRequest = CURSOR_KEEP;
+
+	// Build the colliders and place the collectibles. The profiler (optional) receives the scopes of the heaviest steps
+	void init(Profiler* prof = nullptr);
+
+	// Advance the game by one frame. If stageMs is given, it receives the time spent in each stage
+	void step(const FrameInput& in, double* stageMs = nullptr);
+
+	// Hash of the state that drives the game (camera, cat, timer, flags, collectibles), to detect when two runs diverge
+	uint64_t stateHash() const;
+
+	// Index of the bounding box of the cat in UBO_boundingBox
+	int catBoundingBox() const { return static_cast<int>(collectiblesBBs.size() + furnitureBBs.size()); }
+
+	// Compute the matrices of an object and of its bounding box (if DEBUG); id < 0 means no bounding box
+	void placeEntity(EntityUniforms& e, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale,
+		glm::vec3 emissiveColor, const glm::mat4& ViewPrj, bool hasBoundingBox, int id);
+
+private:
+	Profiler* profiler = nullptr;
+
+	void updateMenuScene(const FrameInput& in);
+	void updateGame(const FrameInput& in);
+	void checkPressedButton(const FrameInput& in);
+	bool keyToggled(const FrameInput& in, SimKey k);
+	void updateLights();
+	void updateSteamAndFire(const glm::mat4& ViewPrj);
+	void updateOverlay();
+	void worldSetUp(const glm::mat4& ViewPrj);
+	void checkCollisions(const glm::vec3& m, float deltaT);
+	void placeGhostCat(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, const glm::mat4& ViewPrj, bool hasBoundingBox);
+	void removeCollectible(EntityUniforms& e, const glm::mat4& ViewPrj, int id);
+	void placeCollectibles();
+};
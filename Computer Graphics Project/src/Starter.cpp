@@ -3,6 +3,7 @@
 #define TINYGLTF_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #define SINFL_IMPLEMENTATION
+#define SDEFL_IMPLEMENTATION
 #include "Starter.hpp"
 
 const int MAX_FRAMES_IN_FLIGHT = 2;
@@ -89,40 +90,320 @@ void PrintVkError(VkResult result) {
 			break;
 		}
 	}
-	std::cout << "Error: " << result << ", " << meaning << "\n";
+	LOG_ERROR("Error: %d, %s", static_cast<int>(result), meaning.c_str());
 }
 
 std::vector<char> readFile(const std::string& filename) {
-	std::ifstream file(filename, std::ios::ate | std::ios::binary);
-	if (!file.is_open()) {
-		std::cout << "Failed to open: " << filename << "\n";
-		throw std::runtime_error("failed to open file!");
+	return VirtualFileSystem::instance().read(filename).copy();
+}
+
+tinygltf::FsCallbacks virtualFsCallbacks() {
+	tinygltf::FsCallbacks callbacks;
+	callbacks.FileExists = [](const std::string& path, void*) {
+		return VirtualFileSystem::instance().exists(path);
+	};
+	callbacks.ExpandFilePath = [](const std::string& path, void*) {
+		return path;
+	};
+	callbacks.ReadWholeFile = [](std::vector<unsigned char>* out, std::string* err, const std::string& path, void*) {
+		try {
+			FileData data = VirtualFileSystem::instance().read(path);
+			out->assign(data.data(), data.data() + data.size());
+			return true;
+		}
+		catch (const std::exception& e) {
+			if (err != nullptr) {
+				*err += e.what();
+			}
+			return false;
+		}
+	};
+	callbacks.WriteWholeFile = &tinygltf::WriteWholeFile;
+	callbacks.user_data = nullptr;
+	return callbacks;
+}
+
+static const std::vector<unsigned char> mgcgKey = plusaes::key_from_string(&"CG2023SkelKey128"); // 16-char = 128-bit
+static const unsigned char mgcgIv[16] = {
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+	0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
+};
+
+std::vector<char> decodeMGCG(const char* encoded, size_t size, JobSystem* jobs) {
+	const size_t BLOCK = 16;
+	if (size < 2 * BLOCK || size % BLOCK != 0 || size / BLOCK > static_cast<size_t>(INT_MAX)) {
+		throw std::runtime_error("failed to decrypt MGCG file!");
+	}
+
+	// CBC decryption: every plain block is the decrypted cipher block xor the previous cipher block (the IV for the first),
+	// so the blocks are independent and are decrypted in parallel, straight from the mapped file
+	const plusaes::detail::RoundKeys roundKeys = plusaes::detail::expand_key(&mgcgKey[0], static_cast<int>(mgcgKey.size()));
+	const unsigned char* cipher = reinterpret_cast<const unsigned char*>(encoded);
+	std::unique_ptr<unsigned char[]> decrypted(new unsigned char[size]);
+	auto decryptBlocks = [&](int begin, int end) {
+		for (int b = begin; b < end; b++) {
+			const unsigned char* previous = b == 0 ? mgcgIv : cipher + (b - 1) * BLOCK;
+			unsigned char* plain = decrypted.get() + b * BLOCK;
+			plusaes::detail::decrypt_state(roundKeys, cipher + b * BLOCK, plain);
+			for (size_t i = 0; i < BLOCK; i++) {
+				plain[i] ^= previous[i];
+			}
+		}
+	};
+	int blocks = static_cast<int>(size / BLOCK);
+	if (jobs != nullptr) {
+		jobs->parallelFor("decodeMGCG", 0, blocks, 4096, decryptBlocks);
+	} else {
+		decryptBlocks(0, blocks);
+	}
+
+	// PKCS padding
+	unsigned char padding = decrypted[size - 1];
+	if (padding == 0 || padding > BLOCK) {
+		throw std::runtime_error("failed to decrypt MGCG file!");
+	}
+	for (size_t i = size - padding; i < size; i++) {
+		if (decrypted[i] != padding) {
+			throw std::runtime_error("failed to decrypt MGCG file!");
+		}
+	}
+	size_t payload = size - padding;
+
+	// the first 16 bytes hold the size of the inflated data as text, the deflate stream follows
+	long long inflatedSize = 0;
+	for (size_t i = 0; i < BLOCK && decrypted[i] >= '0' && decrypted[i] <= '9'; i++) {
+		inflatedSize = inflatedSize * 10 + (decrypted[i] - '0');
+	}
+	if (inflatedSize <= 0 || inflatedSize > INT_MAX || payload < BLOCK) {
+		throw std::runtime_error("failed to decode MGCG file!");
+	}
+
+	// Inflated straight into the buffer handed to the glTF parser
+	std::vector<char> decomp(static_cast<size_t>(inflatedSize));
+	int inflated = sinflate(decomp.data(), static_cast<int>(inflatedSize), decrypted.get() + BLOCK, static_cast<int>(payload - BLOCK));
+	if (inflated != inflatedSize) {
+		throw std::runtime_error("failed to decode MGCG file!");
+	}
+	return decomp;
+}
+
+std::vector<char> decodeMGCG(const std::vector<char>& encoded, JobSystem* jobs) {
+	return decodeMGCG(encoded.data(), encoded.size(), jobs);
+}
+
+std::vector<char> loadMGCG(const std::string& filename, JobSystem* jobs) {
+	FileData file = VirtualFileSystem::instance().read(filename);
+	return decodeMGCG(file.data(), file.size(), jobs);
+}
+
+void GlbFile::open(const std::string& filename) {
+	file = VirtualFileSystem::instance().read(filename);
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(file.data());
+	size_t size = file.size();
+
+	// 12 bytes header (magic, version, length), then chunks of 8 bytes header (length, type) and data
+	auto read32 = [&](size_t offset) {
+		uint32_t v;
+		memcpy(&v, bytes + offset, 4);
+		return v;
+	};
+	if (size < 20 || memcmp(bytes, "glTF", 4) != 0 || read32(4) != 2 || read32(8) > size) {
+		throw std::runtime_error("failed to read GLB header!");
+	}
+	size = read32(8);
+
+	for (size_t offset = 12; offset + 8 <= size; ) {
+		size_t length = read32(offset);
+		uint32_t type = read32(offset + 4);
+		if (offset + 8 + length > size) {
+			throw std::runtime_error("failed to read GLB chunk!");
+		}
+		if (type == 0x4E4F534A && json == nullptr) {			// JSON
+			json = reinterpret_cast<const char*>(bytes + offset + 8);
+			jsonSize = length;
+		} else if (type == 0x004E4942 && bin == nullptr) {		// BIN
+			bin = bytes + offset + 8;
+			binSize = length;
+		}
+		offset += 8 + ((length + 3) & ~static_cast<size_t>(3));
+	}
+	if (json == nullptr) {
+		throw std::runtime_error("failed to read GLB JSON chunk!");
+	}
+}
+
+static const char glbBinPlaceholder[] = "data:application/octet-stream;base64,AA==";
+
+std::string GlbFile::tinygltfJson() const {
+	// The BIN chunk is the first buffer, the one without uri: a tiny data URI keeps tinygltf from copying it
+	nlohmann::json document = nlohmann::json::parse(json, json + jsonSize, nullptr, false);
+	if (document.is_discarded()) {
+		throw std::runtime_error("failed to parse GLB JSON chunk!");
+	}
+	auto buffers = document.find("buffers");
+	if (bin != nullptr && buffers != document.end() && buffers->is_array() && !buffers->empty() &&
+		!(*buffers)[0].contains("uri")) {
+		(*buffers)[0]["uri"] = glbBinPlaceholder;
+		(*buffers)[0]["byteLength"] = 1;
+	}
+	return document.dump();
+}
+
+ObjMesh objMeshFromTinyobj(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes) {
+	ObjMesh mesh;
+	mesh.positions = attrib.vertices;
+	mesh.colors = attrib.colors;
+	mesh.colors.resize(mesh.positions.size(), 1.0f);
+	mesh.texCoords = attrib.texcoords;
+	mesh.normals = attrib.normals;
+	// tinyobj only warns about indices out of range: they are dropped like the missing ones
+	auto valid = [](int index, size_t count) {
+		return index >= 0 && static_cast<size_t>(index) < count ? index : -1;
+	};
+	for (const tinyobj::shape_t& shape : shapes) {
+		for (const tinyobj::index_t& index : shape.mesh.indices) {
+			ObjCorner corner;
+			corner.position = valid(index.vertex_index, mesh.positions.size() / 3);
+			corner.texCoord = valid(index.texcoord_index, mesh.texCoords.size() / 2);
+			corner.normal = valid(index.normal_index, mesh.normals.size() / 3);
+			mesh.corners.push_back(corner);
+		}
+	}
+	return mesh;
+}
+
+GltfDocument gltfDocumentFromTinygltf(const tinygltf::Model& model, const unsigned char* glbBin, size_t glbBinSize) {
+	GltfDocument doc;
+	for (size_t i = 0; i < model.buffers.size(); i++) {
+		const tinygltf::Buffer& b = model.buffers[i];
+		GltfBuffer buffer;
+		buffer.uri = b.uri;
+		if (i == 0 && glbBin != nullptr && b.uri == glbBinPlaceholder) {
+			buffer.data = glbBin;
+			buffer.byteLength = glbBinSize;
+		} else {
+			buffer.data = b.data.data();
+			buffer.byteLength = b.data.size();
+		}
+		doc.buffers.push_back(buffer);
+	}
+	for (const tinygltf::BufferView& v : model.bufferViews) {
+		GltfBufferView view;
+		view.buffer = v.buffer;
+		view.byteOffset = v.byteOffset;
+		view.byteLength = v.byteLength;
+		view.byteStride = v.byteStride;
+		doc.bufferViews.push_back(view);
+	}
+	for (const tinygltf::Accessor& a : model.accessors) {
+		GltfAccessor accessor;
+		accessor.bufferView = a.bufferView;
+		accessor.byteOffset = a.byteOffset;
+		accessor.componentType = a.componentType;
+		accessor.components = tinygltf::GetNumComponentsInType(static_cast<uint32_t>(a.type));
+		accessor.normalized = a.normalized;
+		accessor.count = a.count;
+		doc.accessors.push_back(accessor);
+	}
+	auto attribute = [](const tinygltf::Primitive& primitive, const char* name) {
+		auto it = primitive.attributes.find(name);
+		return it == primitive.attributes.end() ? -1 : it->second;
+	};
+	for (const tinygltf::Mesh& m : model.meshes) {
+		GltfMesh mesh;
+		for (const tinygltf::Primitive& p : m.primitives) {
+			GltfPrimitive primitive;
+			primitive.position = attribute(p, "POSITION");
+			primitive.normal = attribute(p, "NORMAL");
+			primitive.tangent = attribute(p, "TANGENT");
+			primitive.texCoord0 = attribute(p, "TEXCOORD_0");
+			primitive.indices = p.indices;
+			mesh.primitives.push_back(primitive);
+		}
+		doc.meshes.push_back(mesh);
+	}
+	for (const tinygltf::Node& n : model.nodes) {
+		GltfNode node;
+		node.mesh = n.mesh;
+		node.transform = gltfNodeTransform(n.matrix, n.translation, n.rotation, n.scale);
+		doc.nodes.push_back(node);
 	}
+	return doc;
+}
 
-	size_t fileSize = (size_t)file.tellg();
-	std::vector<char> buffer(fileSize);
-	//std::cout << filename << " -> " << fileSize << " B\n";	 
-	file.seekg(0);
-	file.read(buffer.data(), fileSize);
+std::vector<char> encodeMGCG(const std::vector<char>& data) {
+	std::vector<unsigned char> plain(16 + sdefl_bound((int)data.size()));
+	snprintf(reinterpret_cast<char*>(plain.data()), 16, "%d", (int)data.size());
 
-	file.close();
+	std::unique_ptr<sdefl> deflater = std::make_unique<sdefl>();
+	int n = sdeflate(deflater.get(), &plain[16], data.data(), (int)data.size(), SDEFL_LVL_MAX);
+	plain.resize(16 + n);
 
-	return buffer;
+	std::vector<char> encoded(plusaes::get_padded_encrypted_size((unsigned long)plain.size()));
+	plusaes::encrypt_cbc(plain.data(), (unsigned long)plain.size(), &mgcgKey[0], (unsigned long)mgcgKey.size(), &mgcgIv,
+		reinterpret_cast<unsigned char*>(encoded.data()), (unsigned long)encoded.size(), true);
+	return encoded;
 }
 
 
 void BaseProject::run() {
 	windowResizable = GLFW_FALSE;
 
+	jobSystem.init();
+	LOG_INFO("Job system: %d threads", jobSystem.threadCount());
+	jobSystem.setTraceHook([this](const char* name, int threadIndex, uint64_t startNs, uint64_t endNs) {
+		profiler.record(name, startNs, endNs, threadIndex);
+	});
+	jobSystem.setTracing(profiler.isEnabled());
+
 	setWindowParameters();
 	initWindow();
 	initVulkan();
 	mainLoop();
+	if (!memoryReportPath.empty()) {
+		memoryTracker.writeReport(memoryReportPath);
+	}
 	cleanup();
+
+	jobSystem.cleanup();
+
+	if (!profilerTracePath.empty()) {
+		profiler.exportChromeTrace(profilerTracePath);
+	}
+}
+
+void BaseProject::enableProfiler(const std::string& tracePath) {
+	profilerTracePath = tracePath;
+	profiler.setEnabled(true);
+}
+
+void BaseProject::setProfiling(bool on) {
+	profiler.setEnabled(on);
+	jobSystem.setTracing(on);
+	// The timestamps are written by the command buffers only while profiling
+	if (!commandBuffers.empty()) {
+		rebuildCommandBuffers();
+	}
+}
+
+void BaseProject::enableMemoryReport(const std::string& reportPath) {
+	memoryReportPath = reportPath;
+}
+
+void BaseProject::enableOffscreen(int frames, const std::string& path, int interval) {
+	offscreen = true;
+	offscreenFrames = frames;
+	capturePath = path;
+	captureInterval = std::max(interval, 1);
 }
 
 
 void BaseProject::initWindow() {
+	if (offscreen) {
+		window = nullptr;
+		return;
+	}
+
 	glfwInit();
 
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -148,20 +429,37 @@ void BaseProject::framebufferResizeCallback(GLFWwindow* window, int width, int h
 void BaseProject::initVulkan() {
 	createInstance();
 	setupDebugMessenger();
+	loadDebugUtils();
 	createSurface();
 	pickPhysicalDevice();
 	createLogicalDevice();
+	memoryTracker.init(instance, physicalDevice, memoryBudgetEnabled);
+	ResourceRegistry::instance().init(device);
 	createSwapChain();
 	createImageViews();
 	createRenderPass();
 	createCommandPool();
+	profiler.initGpu(physicalDevice, device, findQueueFamilies(physicalDevice).graphicsFamily.value());
 	createColorResources();
 	createDepthResources();
 	createFramebuffers();
 	createDescriptorPool();
 
-	localInit();
-	pipelinesAndDescriptorSetsInit();
+	{
+		PROFILE_SCOPE(&profiler, "localInit");
+		localInit();
+	}
+	{
+		PROFILE_SCOPE(&profiler, "pipelinesAndDescriptorSetsInit");
+		pipelinesAndDescriptorSetsInit();
+	}
+	LOG_INFO("Assets read: %u from the pack, %u from disk",
+		VirtualFileSystem::instance().packReads(), VirtualFileSystem::instance().diskReads());
+	LOG_INFO("Index buffers: %.1f KB saved by 16-bit indices", indexBytesSaved / 1024.0);
+	ResourceRegistry::Stats shared = ResourceRegistry::instance().statistics();
+	LOG_INFO("Shared resources: files %u read + %u shared, samplers %u + %u, shader modules %u + %u, images and meshes %u + %u",
+		shared.fileReads, shared.filesShared, shared.samplersCreated, shared.samplersShared,
+		shared.shaderModulesCreated, shared.shaderModulesShared, shared.objectsCreated, shared.objectsShared);
 
 	createCommandBuffers();
 	createSyncObjects();
@@ -181,13 +479,6 @@ void BaseProject::createInstance() {
 	createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 	createInfo.pApplicationInfo = &appInfo;
 
-	uint32_t glfwExtensionCount = 0;
-	const char** glfwExtensions;
-	glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-	//		createInfo.enabledExtensionCount = glfwExtensionCount;
-	//		createInfo.ppEnabledExtensionNames = glfwExtensions;
-
 	createInfo.enabledLayerCount = 0;
 
 	auto extensions = getRequiredExtensions();
@@ -197,18 +488,22 @@ void BaseProject::createInstance() {
 
 	createInfo.flags |= VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
 
-	if (!checkValidationLayerSupport()) {
-		throw std::runtime_error("validation layers requested, but not available!");
+	// Machines with only a software driver often lack the SDK layers: run without them rather than not at all
+	if (validationEnabled && !checkValidationLayerSupport()) {
+		LOG_WARN("validation layers requested, but not available: running without them");
+		validationEnabled = false;
 	}
 
 	VkDebugUtilsMessengerCreateInfoEXT debugCreateInfo;
-	createInfo.enabledLayerCount =
-		static_cast<uint32_t>(validationLayers.size());
-	createInfo.ppEnabledLayerNames = validationLayers.data();
+	if (validationEnabled) {
+		createInfo.enabledLayerCount =
+			static_cast<uint32_t>(validationLayers.size());
+		createInfo.ppEnabledLayerNames = validationLayers.data();
 
-	populateDebugMessengerCreateInfo(debugCreateInfo);
-	createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT*)
-		&debugCreateInfo;
+		populateDebugMessengerCreateInfo(debugCreateInfo);
+		createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT*)
+			&debugCreateInfo;
+	}
 
 	VkResult result = vkCreateInstance(&createInfo, nullptr, &instance);
 
@@ -219,13 +514,14 @@ void BaseProject::createInstance() {
 }
 
 std::vector<const char*> BaseProject::getRequiredExtensions() {
-	uint32_t glfwExtensionCount = 0;
-	const char** glfwExtensions;
-	glfwExtensions =
-		glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-	std::vector<const char*> extensions(glfwExtensions,
-		glfwExtensions + glfwExtensionCount);
+	// The surface extensions, only with a window: offscreen GLFW is not even initialized
+	std::vector<const char*> extensions;
+	if (!offscreen) {
+		uint32_t glfwExtensionCount = 0;
+		const char** glfwExtensions =
+			glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+	}
 
 	extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
@@ -329,6 +625,9 @@ VKAPI_ATTR VkBool32 VKAPI_CALL BaseProject::debugCallback(
 }
 
 void BaseProject::setupDebugMessenger() {
+	if (!validationEnabled) {
+		return;
+	}
 
 	VkDebugUtilsMessengerCreateInfoEXT createInfo{};
 	populateDebugMessengerCreateInfo(createInfo);
@@ -339,7 +638,66 @@ void BaseProject::setupDebugMessenger() {
 	}
 }
 
+void BaseProject::loadDebugUtils() {
+#ifdef VK_EXT_debug_utils
+	setDebugUtilsObjectName = (PFN_vkSetDebugUtilsObjectNameEXT)
+		vkGetInstanceProcAddr(instance, "vkSetDebugUtilsObjectNameEXT");
+	cmdBeginDebugUtilsLabel = (PFN_vkCmdBeginDebugUtilsLabelEXT)
+		vkGetInstanceProcAddr(instance, "vkCmdBeginDebugUtilsLabelEXT");
+	cmdEndDebugUtilsLabel = (PFN_vkCmdEndDebugUtilsLabelEXT)
+		vkGetInstanceProcAddr(instance, "vkCmdEndDebugUtilsLabelEXT");
+	if (setDebugUtilsObjectName == nullptr || cmdBeginDebugUtilsLabel == nullptr || cmdEndDebugUtilsLabel == nullptr) {
+		setDebugUtilsObjectName = nullptr;
+		cmdBeginDebugUtilsLabel = nullptr;
+		cmdEndDebugUtilsLabel = nullptr;
+		LOG_INFO("debug utils not available: GPU captures will show unnamed objects");
+	}
+#endif
+}
+
+void BaseProject::setObjectName(VkObjectType type, uint64_t handle, const std::string& name) {
+#ifdef VK_EXT_debug_utils
+	if (setDebugUtilsObjectName == nullptr || handle == 0) {
+		return;
+	}
+	VkDebugUtilsObjectNameInfoEXT nameInfo{};
+	nameInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+	nameInfo.objectType = type;
+	nameInfo.objectHandle = handle;
+	nameInfo.pObjectName = name.c_str();
+	setDebugUtilsObjectName(device, &nameInfo);
+#endif
+}
+
+void BaseProject::beginRegion(VkCommandBuffer commandBuffer, int currentImage, const char* name) {
+	endRegion(commandBuffer, currentImage);
+	profiler.gpuZoneBegin(commandBuffer, static_cast<uint32_t>(currentImage), name);
+#ifdef VK_EXT_debug_utils
+	if (cmdBeginDebugUtilsLabel != nullptr) {
+		VkDebugUtilsLabelEXT label{};
+		label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+		label.pLabelName = name;
+		cmdBeginDebugUtilsLabel(commandBuffer, &label);
+		regionOpen = true;
+	}
+#endif
+}
+
+void BaseProject::endRegion(VkCommandBuffer commandBuffer, int currentImage) {
+	profiler.gpuZoneEnd(commandBuffer, static_cast<uint32_t>(currentImage));
+#ifdef VK_EXT_debug_utils
+	if (regionOpen) {
+		cmdEndDebugUtilsLabel(commandBuffer);
+		regionOpen = false;
+	}
+#endif
+}
+
 void BaseProject::createSurface() {
+	if (offscreen) {
+		surface = VK_NULL_HANDLE;
+		return;
+	}
 	if (glfwCreateWindowSurface(instance, window, nullptr, &surface)
 		!= VK_SUCCESS) {
 		throw std::runtime_error("failed to create window surface!");
@@ -374,6 +732,12 @@ void BaseProject::pickPhysicalDevice() {
 
 	std::cout << "Physical devices found: " << deviceCount << "\n";
 
+	// Nothing is presented offscreen
+	if (offscreen) {
+		deviceExtensions.erase(std::remove(deviceExtensions.begin(), deviceExtensions.end(),
+			std::string(VK_KHR_SWAPCHAIN_EXTENSION_NAME)), deviceExtensions.end());
+	}
+
 	for (const auto& device : devices) {
 		if (checkIfItHasDeviceExtension(device, "VK_KHR_portability_subset")) {
 			deviceExtensions.push_back("VK_KHR_portability_subset");
@@ -402,8 +766,8 @@ bool BaseProject::isDeviceSuitable(VkPhysicalDevice device, deviceReport& devRep
 
 	devRep.extensionsSupported = checkDeviceExtensionSupport(device, devRep);
 
-	devRep.swapChainAdequate = false;
-	if (devRep.extensionsSupported) {
+	devRep.swapChainAdequate = offscreen;
+	if (devRep.extensionsSupported && !offscreen) {
 		SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
 		devRep.swapChainFormatSupport = swapChainSupport.formats.empty();
 		devRep.swapChainPresentModeSupport = swapChainSupport.presentModes.empty();
@@ -438,9 +802,14 @@ QueueFamilyIndices BaseProject::findQueueFamilies(VkPhysicalDevice device) {
 			indices.graphicsFamily = i;
 		}
 
+		// Offscreen there is no surface: the graphics queue stands for the present one
 		VkBool32 presentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface,
-			&presentSupport);
+		if (offscreen) {
+			presentSupport = indices.graphicsFamily.has_value();
+		} else {
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface,
+				&presentSupport);
+		}
 		if (presentSupport) {
 			indices.presentFamily = i;
 		}
@@ -551,13 +920,23 @@ void BaseProject::createLogicalDevice() {
 		static_cast<uint32_t>(queueCreateInfos.size());
 
 	createInfo.pEnabledFeatures = &deviceFeatures;
+	// Optional: the driver's view of the memory usage and budget, for the memory report
+	std::vector<const char*> extensions = deviceExtensions;
+	memoryBudgetEnabled = checkIfItHasExtension(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) &&
+		checkIfItHasDeviceExtension(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	if (memoryBudgetEnabled) {
+		extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	}
+
 	createInfo.enabledExtensionCount =
-		static_cast<uint32_t>(deviceExtensions.size());
-	createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+		static_cast<uint32_t>(extensions.size());
+	createInfo.ppEnabledExtensionNames = extensions.data();
 
-	createInfo.enabledLayerCount =
-		static_cast<uint32_t>(validationLayers.size());
-	createInfo.ppEnabledLayerNames = validationLayers.data();
+	if (validationEnabled) {
+		createInfo.enabledLayerCount =
+			static_cast<uint32_t>(validationLayers.size());
+		createInfo.ppEnabledLayerNames = validationLayers.data();
+	}
 
 	VkResult result = vkCreateDevice(physicalDevice, &createInfo, nullptr, &device);
 
@@ -571,6 +950,11 @@ void BaseProject::createLogicalDevice() {
 }
 
 void BaseProject::createSwapChain() {
+	if (offscreen) {
+		createOffscreenImages();
+		return;
+	}
+
 	SwapChainSupportDetails swapChainSupport =
 		querySwapChainSupport(physicalDevice);
 	VkSurfaceFormatKHR surfaceFormat =
@@ -646,6 +1030,14 @@ VkSurfaceFormatKHR BaseProject::chooseSwapSurfaceFormat(
 
 VkPresentModeKHR BaseProject::chooseSwapPresentMode(
 	const std::vector<VkPresentModeKHR>& availablePresentModes) {
+	// Without vsync the frame rate is not capped by the display
+	if (!vsync) {
+		for (const auto& availablePresentMode : availablePresentModes) {
+			if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
+				return availablePresentMode;
+			}
+		}
+	}
 	for (const auto& availablePresentMode : availablePresentModes) {
 		if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
 			return availablePresentMode;
@@ -674,6 +1066,26 @@ VkExtent2D BaseProject::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabil
 	}
 }
 
+void BaseProject::createOffscreenImages() {
+	// One render target per frame in flight, in a format stb_image_write takes as it is
+	swapChainImageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+	swapChainExtent = { windowWidth, windowHeight };
+	swapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+	offscreenImagesMemory.resize(MAX_FRAMES_IN_FLIGHT);
+	for (size_t i = 0; i < swapChainImages.size(); i++) {
+		createImage(swapChainExtent.width, swapChainExtent.height, 1, 1,
+			VK_SAMPLE_COUNT_1_BIT, swapChainImageFormat, VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 0,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			swapChainImages[i], offscreenImagesMemory[i], MEMORY_ATTACHMENT, "offscreen target");
+	}
+
+	createBuffer(static_cast<VkDeviceSize>(swapChainExtent.width) * swapChainExtent.height * 4,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		readbackBuffer, readbackBufferMemory, MEMORY_STAGING, "frame readback");
+}
+
 void BaseProject::createImageViews() {
 	swapChainImageViews.resize(swapChainImages.size());
 
@@ -719,7 +1131,7 @@ void BaseProject::createRenderPass() {
 	colorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	colorAttachmentResolve.finalLayout = offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
 	VkAttachmentReference colorAttachmentResolveRef{};
 	colorAttachmentResolveRef.attachment = 2;
@@ -845,7 +1257,7 @@ void BaseProject::createColorResources() {
 		VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT |
 		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, 0,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		colorImage, colorImageMemory);
+		colorImage, colorImageMemory, MEMORY_ATTACHMENT, "color attachment");
 	colorImageView = createImageView(colorImage, colorFormat,
 		VK_IMAGE_ASPECT_COLOR_BIT, 1,
 		VK_IMAGE_VIEW_TYPE_2D, 1);
@@ -858,7 +1270,7 @@ void BaseProject::createDepthResources() {
 		msaaSamples, depthFormat, VK_IMAGE_TILING_OPTIMAL,
 		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, 0,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		depthImage, depthImageMemory);
+		depthImage, depthImageMemory, MEMORY_ATTACHMENT, "depth attachment");
 	depthImageView = createImageView(depthImage, depthFormat,
 		VK_IMAGE_ASPECT_DEPTH_BIT, 1,
 		VK_IMAGE_VIEW_TYPE_2D, 1);
@@ -906,7 +1318,8 @@ void BaseProject::createImage(uint32_t width, uint32_t height,
 	VkImageTiling tiling, VkImageUsageFlags usage,
 	VkImageCreateFlags cflags,
 	VkMemoryPropertyFlags properties, VkImage& image,
-	VkDeviceMemory& imageMemory) {
+	VkDeviceMemory& imageMemory,
+	MemoryCategory category, const std::string& owner) {
 	VkImageCreateInfo imageInfo{};
 	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 	imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -941,8 +1354,11 @@ void BaseProject::createImage(uint32_t width, uint32_t height,
 		VK_SUCCESS) {
 		throw std::runtime_error("failed to allocate image memory!");
 	}
+	memoryTracker.allocated(imageMemory, allocInfo.allocationSize, allocInfo.memoryTypeIndex, category, owner);
 
 	vkBindImageMemory(device, image, imageMemory, 0);
+	setObjectName(VK_OBJECT_TYPE_IMAGE, image, owner);
+	setObjectName(VK_OBJECT_TYPE_DEVICE_MEMORY, imageMemory, owner);
 }
 
 void BaseProject::generateMipmaps(VkImage image, VkFormat imageFormat,
@@ -1152,7 +1568,8 @@ void BaseProject::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
 
 void BaseProject::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
 	VkMemoryPropertyFlags properties,
-	VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
+	VkBuffer& buffer, VkDeviceMemory& bufferMemory,
+	MemoryCategory category, const std::string& owner) {
 	VkBufferCreateInfo bufferInfo{};
 	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	bufferInfo.size = size;
@@ -1181,8 +1598,16 @@ void BaseProject::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
 		PrintVkError(result);
 		throw std::runtime_error("failed to allocate vertex buffer memory!");
 	}
+	memoryTracker.allocated(bufferMemory, allocInfo.allocationSize, allocInfo.memoryTypeIndex, category, owner);
 
 	vkBindBufferMemory(device, buffer, bufferMemory, 0);
+	setObjectName(VK_OBJECT_TYPE_BUFFER, buffer, owner);
+	setObjectName(VK_OBJECT_TYPE_DEVICE_MEMORY, bufferMemory, owner);
+}
+
+void BaseProject::freeMemory(VkDeviceMemory memory) {
+	memoryTracker.freed(memory);
+	vkFreeMemory(device, memory, nullptr);
 }
 
 uint32_t BaseProject::findMemoryType(uint32_t typeFilter,
@@ -1241,6 +1666,8 @@ void BaseProject::createCommandBuffers() {
 	}
 
 	for (size_t i = 0; i < commandBuffers.size(); i++) {
+		setObjectName(VK_OBJECT_TYPE_COMMAND_BUFFER, commandBuffers[i], "frame image " + std::to_string(i));
+
 		VkCommandBufferBeginInfo beginInfo{};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		beginInfo.flags = 0; // Optional
@@ -1266,11 +1693,19 @@ void BaseProject::createCommandBuffers() {
 			static_cast<uint32_t>(clearValues.size());
 		renderPassInfo.pClearValues = clearValues.data();
 
+		// GPU timestamps of this command buffer are reset every time it is submitted
+		profiler.beginCommandBuffer(commandBuffers[i], static_cast<uint32_t>(i));
+
+		drawCalls = 0;
+		populateCommandBufferPrePass(commandBuffers[i], i);
+		endRegion(commandBuffers[i], static_cast<int>(i));
+
 		vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo,
 			VK_SUBPASS_CONTENTS_INLINE);
 
 
 		populateCommandBuffer(commandBuffers[i], i);
+		endRegion(commandBuffers[i], static_cast<int>(i));
 
 
 		vkCmdEndRenderPass(commandBuffers[i]);
@@ -1281,6 +1716,13 @@ void BaseProject::createCommandBuffers() {
 	}
 }
 
+void BaseProject::rebuildCommandBuffers() {
+	vkDeviceWaitIdle(device);
+	vkFreeCommandBuffers(device, commandPool,
+		static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+	createCommandBuffers();
+}
+
 void BaseProject::createSyncObjects() {
 	imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
 	renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
@@ -1313,6 +1755,14 @@ void BaseProject::createSyncObjects() {
 }
 
 void BaseProject::mainLoop() {
+	if (offscreen) {
+		while (!closeRequested) {
+			drawOffscreenFrame();
+		}
+		vkDeviceWaitIdle(device);
+		return;
+	}
+
 	while (!glfwWindowShouldClose(window)) {
 		glfwPollEvents();
 		drawFrame();
@@ -1322,6 +1772,9 @@ void BaseProject::mainLoop() {
 }
 
 void BaseProject::drawFrame() {
+	PROFILE_SCOPE(&profiler, "drawFrame");
+	VulkanRecorder::FrameScope vulkanFrame;
+
 	vkWaitForFences(device, 1, &inFlightFences[currentFrame],
 		VK_TRUE, UINT64_MAX);
 
@@ -1344,7 +1797,13 @@ void BaseProject::drawFrame() {
 	}
 	imagesInFlight[imageIndex] = inFlightFences[currentFrame];
 
-	updateUniformBuffer(imageIndex);
+	// The last submission of this image is complete: its GPU timestamps can be read
+	profiler.collectGpu(imageIndex);
+
+	{
+		PROFILE_SCOPE(&profiler, "updateUniformBuffer");
+		updateUniformBuffer(imageIndex);
+	}
 
 	VkSubmitInfo submitInfo{};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -1362,6 +1821,7 @@ void BaseProject::drawFrame() {
 
 	vkResetFences(device, 1, &inFlightFences[currentFrame]);
 
+	profiler.markSubmit(imageIndex);
 	if (vkQueueSubmit(graphicsQueue, 1, &submitInfo,
 		inFlightFences[currentFrame]) != VK_SUCCESS) {
 		throw std::runtime_error("failed to submit draw command buffer!");
@@ -1378,7 +1838,10 @@ void BaseProject::drawFrame() {
 	presentInfo.pImageIndices = &imageIndex;
 	presentInfo.pResults = nullptr; // Optional
 
-	result = vkQueuePresentKHR(presentQueue, &presentInfo);
+	{
+		PROFILE_SCOPE(&profiler, "present");
+		result = vkQueuePresentKHR(presentQueue, &presentInfo);
+	}
 
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
 		framebufferResized) {
@@ -1392,6 +1855,138 @@ void BaseProject::drawFrame() {
 	currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
+void BaseProject::drawOffscreenFrame() {
+	PROFILE_SCOPE(&profiler, "drawFrame");
+	VulkanRecorder::FrameScope vulkanFrame;
+
+	// Without a swap chain every frame in flight renders into its own image
+	uint32_t imageIndex = static_cast<uint32_t>(currentFrame);
+	vkWaitForFences(device, 1, &inFlightFences[currentFrame],
+		VK_TRUE, UINT64_MAX);
+
+	profiler.collectGpu(imageIndex);
+
+	{
+		PROFILE_SCOPE(&profiler, "updateUniformBuffer");
+		updateUniformBuffer(imageIndex);
+	}
+
+	// The application quit during the update: the last frame is the one submitted before
+	if (closeRequested) {
+		if (offscreenFrame > 0 && capturePath.find('%') == std::string::npos) {
+			captureFrame((imageIndex + MAX_FRAMES_IN_FLIGHT - 1) % MAX_FRAMES_IN_FLIGHT, capturePath);
+		}
+		return;
+	}
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
+
+	vkResetFences(device, 1, &inFlightFences[currentFrame]);
+
+	profiler.markSubmit(imageIndex);
+	if (vkQueueSubmit(graphicsQueue, 1, &submitInfo,
+		inFlightFences[currentFrame]) != VK_SUCCESS) {
+		throw std::runtime_error("failed to submit draw command buffer!");
+	}
+	offscreenFrame++;
+
+	bool lastFrame = offscreenFrames > 0 && offscreenFrame >= offscreenFrames;
+	if (!capturePath.empty()) {
+		if (capturePath.find('%') != std::string::npos) {
+			if (offscreenFrame % captureInterval == 0) {
+				char path[1024];
+				snprintf(path, sizeof(path), capturePath.c_str(), offscreenFrame);
+				captureFrame(imageIndex, path);
+			}
+		} else if (lastFrame) {
+			captureFrame(imageIndex, capturePath);
+		}
+	}
+	if (lastFrame) {
+		closeRequested = true;
+	}
+
+	currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+}
+
+void BaseProject::captureFrame(uint32_t imageIndex, const std::string& path) {
+	PROFILE_SCOPE(&profiler, "captureFrame");
+
+	// The render pass leaves the image ready to be copied
+	vkWaitForFences(device, 1, &inFlightFences[imageIndex],
+		VK_TRUE, UINT64_MAX);
+
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+	// The fence only says the render pass is over: its writes still have to be made visible to the copy
+	VkImageMemoryBarrier imageBarrier{};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = swapChainImages[imageIndex];
+	imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageBarrier.subresourceRange.baseMipLevel = 0;
+	imageBarrier.subresourceRange.levelCount = 1;
+	imageBarrier.subresourceRange.baseArrayLayer = 0;
+	imageBarrier.subresourceRange.layerCount = 1;
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+		0, nullptr, 0, nullptr, 1, &imageBarrier);
+
+	VkBufferImageCopy region{};
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { 0, 0, 0 };
+	region.imageExtent = { swapChainExtent.width, swapChainExtent.height, 1 };
+
+	vkCmdCopyImageToBuffer(commandBuffer, swapChainImages[imageIndex],
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &region);
+
+	// And the copy visible to the host, before the buffer is mapped
+	VkBufferMemoryBarrier bufferBarrier{};
+	bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.buffer = readbackBuffer;
+	bufferBarrier.offset = 0;
+	bufferBarrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+		0, nullptr, 1, &bufferBarrier, 0, nullptr);
+
+	endSingleTimeCommands(commandBuffer);
+
+	void* data;
+	vkMapMemory(device, readbackBufferMemory, 0, VK_WHOLE_SIZE, 0, &data);
+	int written = stbi_write_png(path.c_str(), swapChainExtent.width, swapChainExtent.height, 4,
+		data, swapChainExtent.width * 4);
+	vkUnmapMemory(device, readbackBufferMemory);
+
+	if (!written) {
+		LOG_ERROR("Failed to write: %s", path.c_str());
+		throw std::runtime_error("failed to write captured frame!");
+	}
+	LOG_INFO("Frame %d written to %s", offscreenFrame, path.c_str());
+}
+
+void BaseProject::requestClose() {
+	if (offscreen) {
+		closeRequested = true;
+	} else {
+		glfwSetWindowShouldClose(window, GL_TRUE);
+	}
+}
 
 void BaseProject::recreateSwapChain() {
 	int width = 0, height = 0;
@@ -1422,11 +2017,11 @@ void BaseProject::recreateSwapChain() {
 void BaseProject::cleanupSwapChain() {
 	vkDestroyImageView(device, colorImageView, nullptr);
 	vkDestroyImage(device, colorImage, nullptr);
-	vkFreeMemory(device, colorImageMemory, nullptr);
+	freeMemory(colorImageMemory);
 
 	vkDestroyImageView(device, depthImageView, nullptr);
 	vkDestroyImage(device, depthImage, nullptr);
-	vkFreeMemory(device, depthImageMemory, nullptr);
+	freeMemory(depthImageMemory);
 
 	for (size_t i = 0; i < swapChainFramebuffers.size(); i++) {
 		vkDestroyFramebuffer(device, swapChainFramebuffers[i], nullptr);
@@ -1443,7 +2038,16 @@ void BaseProject::cleanupSwapChain() {
 		vkDestroyImageView(device, swapChainImageViews[i], nullptr);
 	}
 
-	vkDestroySwapchainKHR(device, swapChain, nullptr);
+	if (offscreen) {
+		for (size_t i = 0; i < swapChainImages.size(); i++) {
+			vkDestroyImage(device, swapChainImages[i], nullptr);
+			freeMemory(offscreenImagesMemory[i]);
+		}
+		vkDestroyBuffer(device, readbackBuffer, nullptr);
+		freeMemory(readbackBufferMemory);
+	} else {
+		vkDestroySwapchainKHR(device, swapChain, nullptr);
+	}
 
 	vkDestroyDescriptorPool(device, descriptorPool, nullptr);
 }
@@ -1461,16 +2065,23 @@ void BaseProject::cleanup() {
 
 	vkDestroyCommandPool(device, commandPool, nullptr);
 
+	profiler.cleanupGpu();
+	ResourceRegistry::instance().cleanup();
 	vkDestroyDevice(device, nullptr);
 
-	DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
+	if (validationEnabled) {
+		DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
+	}
 
-	vkDestroySurfaceKHR(instance, surface, nullptr);
+	if (!offscreen) {
+		vkDestroySurfaceKHR(instance, surface, nullptr);
+	}
 	vkDestroyInstance(instance, nullptr);
 
-	glfwDestroyWindow(window);
-
-	glfwTerminate();
+	if (!offscreen) {
+		glfwDestroyWindow(window);
+		glfwTerminate();
+	}
 }
 
 void BaseProject::RebuildPipeline() {
@@ -1610,92 +2221,66 @@ void BaseProject::printMat4(const char* Name, glm::mat4 v) {
 // Helper classes
 
 
+// Formats a loader can write for each usage, with their size: 32-bit floats, or the compact 16-bit ones
+// (quantized positions, octahedral normals and tangents, half float UVs)
+static const struct {
+	VertexDescriptorElementUsage usage;
+	VkFormat format;
+	uint32_t size;
+} vertexComponentFormats[] = {
+	{POSITION, VK_FORMAT_R32G32B32_SFLOAT, sizeof(glm::vec3)},
+	{POSITION, VK_FORMAT_R16G16B16A16_SNORM, 4 * sizeof(int16_t)},
+	{NORMAL, VK_FORMAT_R32G32B32_SFLOAT, sizeof(glm::vec3)},
+	{NORMAL, VK_FORMAT_R16G16_SNORM, 2 * sizeof(int16_t)},
+	{UV, VK_FORMAT_R32G32_SFLOAT, sizeof(glm::vec2)},
+	{UV, VK_FORMAT_R16G16_SFLOAT, 2 * sizeof(uint16_t)},
+	{COLOR, VK_FORMAT_R32G32B32_SFLOAT, sizeof(glm::vec3)},
+	{TANGENT, VK_FORMAT_R32G32B32A32_SFLOAT, sizeof(glm::vec4)},
+	{TANGENT, VK_FORMAT_R16G16B16A16_SNORM, 4 * sizeof(int16_t)},
+};
+
 void VertexDescriptor::init(BaseProject* bp, std::vector<VertexBindingDescriptorElement> B, std::vector<VertexDescriptorElement> E) {
 	BP = bp;
 	Bindings = B;
 	Layout = E;
 
-	Position.hasIt = false; Position.offset = 0;
-	Normal.hasIt = false; Normal.offset = 0;
-	UV.hasIt = false; UV.offset = 0;
-	Color.hasIt = false; Color.offset = 0;
-	Tangent.hasIt = false; Tangent.offset = 0;
+	Position = Normal = UV = Color = Tangent = VertexComponent{false, 0, VK_FORMAT_UNDEFINED, false};
 
 	if (B.size() == 1) {	// for now, read models only with every vertex information in a single binding
 		for (int i = 0; i < E.size(); i++) {
+			VertexComponent* component = nullptr;
+			const char* name = "";
 			switch (E[i].usage) {
-			case VertexDescriptorElementUsage::POSITION:
-				if (E[i].format == VK_FORMAT_R32G32B32_SFLOAT) {
-					if (E[i].size == sizeof(glm::vec3)) {
-						Position.hasIt = true;
-						Position.offset = E[i].offset;
-					}
-					else {
-						std::cout << "Vertex Position - wrong size\n";
-					}
-				}
-				else {
-					std::cout << "Vertex Position - wrong format\n";
-				}
-				break;
-			case VertexDescriptorElementUsage::NORMAL:
-				if (E[i].format == VK_FORMAT_R32G32B32_SFLOAT) {
-					if (E[i].size == sizeof(glm::vec3)) {
-						Normal.hasIt = true;
-						Normal.offset = E[i].offset;
-					}
-					else {
-						std::cout << "Vertex Normal - wrong size\n";
-					}
-				}
-				else {
-					std::cout << "Vertex Normal - wrong format\n";
-				}
-				break;
-			case VertexDescriptorElementUsage::UV:
-				if (E[i].format == VK_FORMAT_R32G32_SFLOAT) {
-					if (E[i].size == sizeof(glm::vec2)) {
-						UV.hasIt = true;
-						UV.offset = E[i].offset;
-					}
-					else {
-						std::cout << "Vertex UV - wrong size\n";
-					}
-				}
-				else {
-					std::cout << "Vertex UV - wrong format\n";
-				}
-				break;
-			case VertexDescriptorElementUsage::COLOR:
-				if (E[i].format == VK_FORMAT_R32G32B32_SFLOAT) {
-					if (E[i].size == sizeof(glm::vec3)) {
-						Color.hasIt = true;
-						Color.offset = E[i].offset;
-					}
-					else {
-						std::cout << "Vertex Color - wrong size\n";
-					}
-				}
-				else {
-					std::cout << "Vertex Color - wrong format\n";
+			case VertexDescriptorElementUsage::POSITION: component = &Position; name = "Position"; break;
+			case VertexDescriptorElementUsage::NORMAL: component = &Normal; name = "Normal"; break;
+			case VertexDescriptorElementUsage::UV: component = &UV; name = "UV"; break;
+			case VertexDescriptorElementUsage::COLOR: component = &Color; name = "Color"; break;
+			case VertexDescriptorElementUsage::TANGENT: component = &Tangent; name = "Tangent"; break;
+			default: break;
+			}
+			if (component == nullptr) {
+				continue;
+			}
+
+			bool knownFormat = false;
+			for (const auto& f : vertexComponentFormats) {
+				if (f.usage != E[i].usage || f.format != E[i].format) {
+					continue;
 				}
-				break;
-			case VertexDescriptorElementUsage::TANGENT:
-				if (E[i].format == VK_FORMAT_R32G32B32A32_SFLOAT) {
-					if (E[i].size == sizeof(glm::vec4)) {
-						Tangent.hasIt = true;
-						Tangent.offset = E[i].offset;
-					}
-					else {
-						std::cout << "Vertex Tangent - wrong size\n";
-					}
+				knownFormat = true;
+				if (E[i].size == f.size) {
+					component->hasIt = true;
+					component->offset = E[i].offset;
+					component->format = E[i].format;
+					component->octahedral = (E[i].usage == NORMAL || E[i].usage == TANGENT) &&
+						(E[i].format == VK_FORMAT_R16G16_SNORM || E[i].format == VK_FORMAT_R16G16B16A16_SNORM);
 				}
 				else {
-					std::cout << "Vertex Tangent - wrong format\n";
+					std::cout << "Vertex " << name << " - wrong size\n";
 				}
-				break;
-			default:
-				break;
+			}
+			if (!knownFormat) {
+				std::cout << "Vertex " << name << " - wrong format\n";
 			}
 		}
 	}
@@ -1704,6 +2289,57 @@ void VertexDescriptor::init(BaseProject* bp, std::vector<VertexBindingDescriptor
 	}
 }
 
+// Octahedral encoding of a unit vector, in [-1, 1]^2
+static glm::vec2 octEncode(glm::vec3 n) {
+	n /= std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+	glm::vec2 e(n.x, n.y);
+	if (n.z < 0.0f) {
+		e = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * glm::vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+	}
+	return e;
+}
+
+void VertexComponent::store(void* vertex, glm::vec4 value) const {
+	char* o = static_cast<char*>(vertex) + offset;
+	if (octahedral) {
+		glm::vec3 n(value);
+		float length = glm::length(n);
+		glm::vec2 e = length > 0.0f ? octEncode(n / length) : glm::vec2(0.0f);
+		value = glm::vec4(e, 0.0f, value.w < 0.0f ? -1.0f : 1.0f);
+	}
+
+	switch (format) {
+	case VK_FORMAT_R32G32_SFLOAT:
+		memcpy(o, &value, sizeof(glm::vec2));
+		break;
+	case VK_FORMAT_R32G32B32_SFLOAT:
+		memcpy(o, &value, sizeof(glm::vec3));
+		break;
+	case VK_FORMAT_R32G32B32A32_SFLOAT:
+		memcpy(o, &value, sizeof(glm::vec4));
+		break;
+	case VK_FORMAT_R16G16_SFLOAT:
+		{
+			uint16_t h[2] = { glm::packHalf1x16(value.x), glm::packHalf1x16(value.y) };
+			memcpy(o, h, sizeof(h));
+		}
+		break;
+	case VK_FORMAT_R16G16_SNORM:
+	case VK_FORMAT_R16G16B16A16_SNORM:
+		{
+			int n = format == VK_FORMAT_R16G16_SNORM ? 2 : 4;
+			int16_t q[4];
+			for (int k = 0; k < n; k++) {
+				q[k] = static_cast<int16_t>(glm::packSnorm1x16(value[k]));
+			}
+			memcpy(o, q, n * sizeof(int16_t));
+		}
+		break;
+	default:
+		break;
+	}
+}
+
 void VertexDescriptor::cleanup() {
 }
 
@@ -1737,14 +2373,14 @@ void Texture::createTextureImage(const char* const files[], VkFormat Fmt = VK_FO
 	stbi_uc* pixels[maxImgs];
 
 	for (int i = 0; i < imgs; i++) {
-		pixels[i] = stbi_load(files[i], &texWidth, &texHeight,
-			&texChannels, STBI_rgb_alpha);
+		std::shared_ptr<const FileData> file = ResourceRegistry::instance().file(files[i]);
+		pixels[i] = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file->data()), static_cast<int>(file->size()),
+			&texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
 		if (!pixels[i]) {
-			std::cout << "Not found: " << files[i] << "\n";
+			LOG_ERROR("Not found: %s", files[i]);
 			throw std::runtime_error("failed to load texture image!");
 		}
-		std::cout << "[" << i << "]" << files[i] << " -> size: " << texWidth
-			<< "x" << texHeight << ", ch: " << texChannels << "\n";
+		LOG_INFO("[%d]%s -> size: %dx%d, ch: %d", i, files[i], texWidth, texHeight, texChannels);
 
 		if (i == 0) {
 			curWidth = texWidth;
@@ -1760,8 +2396,15 @@ void Texture::createTextureImage(const char* const files[], VkFormat Fmt = VK_FO
 		}
 	}
 
-	VkDeviceSize imageSize = texWidth * texHeight * 4;
-	VkDeviceSize totalImageSize = texWidth * texHeight * 4 * imgs;
+	uploadTextureImage(pixels, texWidth, texHeight, 4, Fmt);
+	for (int i = 0; i < imgs; i++) {
+		stbi_image_free(pixels[i]);
+	}
+}
+
+void Texture::uploadTextureImage(const unsigned char* const pixels[], int texWidth, int texHeight, int pixelSize, VkFormat Fmt) {
+	VkDeviceSize imageSize = texWidth * texHeight * pixelSize;
+	VkDeviceSize totalImageSize = imageSize * imgs;
 	mipLevels = static_cast<uint32_t>(std::floor(
 		std::log2(std::max(texWidth, texHeight)))) + 1;
 
@@ -1771,12 +2414,11 @@ void Texture::createTextureImage(const char* const files[], VkFormat Fmt = VK_FO
 	BP->createBuffer(totalImageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
 		VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		stagingBuffer, stagingBufferMemory);
+		stagingBuffer, stagingBufferMemory, MEMORY_STAGING, name);
 	void* data;
 	vkMapMemory(BP->device, stagingBufferMemory, 0, totalImageSize, 0, &data);
 	for (int i = 0; i < imgs; i++) {
 		memcpy(static_cast<char*>(data) + imageSize * i, pixels[i], static_cast<size_t>(imageSize));
-		stbi_image_free(pixels[i]);
 	}
 	vkUnmapMemory(BP->device, stagingBufferMemory);
 
@@ -1786,7 +2428,7 @@ void Texture::createTextureImage(const char* const files[], VkFormat Fmt = VK_FO
 		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
 		imgs == 6 ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage,
-		textureImageMemory);
+		textureImageMemory, MEMORY_TEXTURE, name);
 
 	BP->transitionImageLayout(textureImage, Fmt,
 		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels, imgs);
@@ -1797,7 +2439,7 @@ void Texture::createTextureImage(const char* const files[], VkFormat Fmt = VK_FO
 		texWidth, texHeight, mipLevels, imgs);
 
 	vkDestroyBuffer(BP->device, stagingBuffer, nullptr);
-	vkFreeMemory(BP->device, stagingBufferMemory, nullptr);
+	BP->freeMemory(stagingBufferMemory);
 }
 
 void Texture::createTextureImageView(VkFormat Fmt = VK_FORMAT_R8G8B8A8_SRGB) {
@@ -1807,6 +2449,7 @@ void Texture::createTextureImageView(VkFormat Fmt = VK_FORMAT_R8G8B8A8_SRGB) {
 		mipLevels,
 		imgs == 6 ? VK_IMAGE_VIEW_TYPE_CUBE : VK_IMAGE_VIEW_TYPE_2D,
 		imgs);
+	BP->setObjectName(VK_OBJECT_TYPE_IMAGE_VIEW, textureImageView, name);
 }
 
 void Texture::createTextureSampler(
@@ -1835,44 +2478,136 @@ void Texture::createTextureSampler(
 	samplerInfo.mipmapMode = mipmapMode;
 	samplerInfo.mipLodBias = 0.0f;
 	samplerInfo.minLod = 0.0f;
-	samplerInfo.maxLod = ((maxLod == -1) ? static_cast<float>(mipLevels) : maxLod);
+	// No clamp by default: the views stop at their last mip level anyway, and the textures of any size share the sampler
+	samplerInfo.maxLod = ((maxLod == -1) ? VK_LOD_CLAMP_NONE : maxLod);
 
-	VkResult result = vkCreateSampler(BP->device, &samplerInfo, nullptr,
-		&textureSampler);
-	if (result != VK_SUCCESS) {
-		PrintVkError(result);
-		throw std::runtime_error("failed to create texture sampler!");
+	// Shared with every texture with the same settings, so it is not named after this one
+	textureSampler = ResourceRegistry::instance().acquireSampler(samplerInfo);
+}
+
+
+bool Texture::acquireImage(const std::string& key) {
+	SharedImage shared;
+	imageKey = key;
+	if (!ResourceRegistry::instance().acquire(key, shared)) {
+		return false;
 	}
+	textureImage = shared.image;
+	textureImageMemory = shared.memory;
+	textureImageView = shared.view;
+	mipLevels = shared.mipLevels;
+	LOG_INFO("%s: shared", name.c_str());
+	return true;
+}
+
+void Texture::shareImage() {
+	BaseProject* bp = BP;
+	SharedImage shared{ textureImage, textureImageMemory, textureImageView, mipLevels };
+	ResourceRegistry::instance().add(imageKey, shared, [bp, shared]() {
+		vkDestroyImageView(bp->device, shared.view, nullptr);
+		vkDestroyImage(bp->device, shared.image, nullptr);
+		bp->freeMemory(shared.memory);
+	});
 }
 
 
 
 void Texture::init(BaseProject* bp, const char* file, VkFormat Fmt, bool initSampler) {
+	PROFILE_SCOPE(&bp->profiler, "Texture::init");
 	const char* files[1] = { file };
 	BP = bp;
 	imgs = 1;
-	createTextureImage(files, Fmt);
-	createTextureImageView(Fmt);
+	name = file;
+	if (!acquireImage("texture:" + std::to_string(Fmt) + ":" + file)) {
+		createTextureImage(files, Fmt);
+		createTextureImageView(Fmt);
+		shareImage();
+	}
 	if (initSampler) {
 		createTextureSampler();
 	}
 }
 
 
+void Texture::initPacked(BaseProject* bp, const char* packedFile, const char* rgbFile, const char* alphaFile, VkFormat Fmt) {
+	if (VirtualFileSystem::instance().exists(packedFile)) {
+		init(bp, packedFile, Fmt);
+		return;
+	}
+	PROFILE_SCOPE(&bp->profiler, "Texture::init");
+	BP = bp;
+	imgs = 1;
+	name = packedFile;
+	if (acquireImage("texture:" + std::to_string(Fmt) + ":" + rgbFile + "|" + alphaFile)) {
+		createTextureSampler();
+		return;
+	}
+
+	LOG_DEBUG("%s not found (made by --pack-textures), packing %s and %s", packedFile, rgbFile, alphaFile);
+	const char* files[2] = { rgbFile, alphaFile };
+	stbi_uc* pixels[2];
+	int texWidth[2], texHeight[2], texChannels;
+	for (int i = 0; i < 2; i++) {
+		std::shared_ptr<const FileData> file = ResourceRegistry::instance().file(files[i]);
+		pixels[i] = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file->data()), static_cast<int>(file->size()),
+			&texWidth[i], &texHeight[i], &texChannels, STBI_rgb_alpha);
+		if (!pixels[i]) {
+			LOG_ERROR("Not found: %s", files[i]);
+			throw std::runtime_error("failed to load texture image!");
+		}
+		LOG_INFO("[%d]%s -> size: %dx%d, ch: %d", i, files[i], texWidth[i], texHeight[i], texChannels);
+	}
+
+	packAlpha(pixels[0], texWidth[0], texHeight[0], pixels[1], texWidth[1], texHeight[1]);
+	const unsigned char* layers[1] = { pixels[0] };
+	uploadTextureImage(layers, texWidth[0], texHeight[0], 4, Fmt);
+	stbi_image_free(pixels[0]);
+	stbi_image_free(pixels[1]);
+	createTextureImageView(Fmt);
+	shareImage();
+	createTextureSampler();
+}
+
+
+void Texture::initPixels(BaseProject* bp, const unsigned char* pixels, int width, int height, int pixelSize,
+	VkFormat Fmt, const std::string& owner) {
+	const unsigned char* layers[1] = { pixels };
+	BP = bp;
+	imgs = 1;
+	name = owner;
+	imageKey.clear();
+	uploadTextureImage(layers, width, height, pixelSize, Fmt);
+	createTextureImageView(Fmt);
+}
+
+
 void Texture::initCubic(BaseProject* bp, const char* files[6]) {
 	BP = bp;
 	imgs = 6;
-	createTextureImage(files);
-	createTextureImageView();
+	name = files[0];
+	std::string key = "cubemap:";
+	for (int i = 0; i < 6; i++) {
+		key += files[i] + std::string(i < 5 ? "|" : "");
+	}
+	if (!acquireImage(key)) {
+		createTextureImage(files);
+		createTextureImageView();
+		shareImage();
+	}
 	createTextureSampler();
 }
 
 
 void Texture::cleanup() {
-	vkDestroySampler(BP->device, textureSampler, nullptr);
+	ResourceRegistry::instance().releaseSampler(textureSampler);
+	textureSampler = VK_NULL_HANDLE;
+	// A shared image is destroyed by the registry, when the last texture using it releases it
+	if (!imageKey.empty() && ResourceRegistry::instance().release(imageKey)) {
+		return;
+	}
 	vkDestroyImageView(BP->device, textureImageView, nullptr);
 	vkDestroyImage(BP->device, textureImage, nullptr);
-	vkFreeMemory(BP->device, textureImageMemory, nullptr);
+	BP->freeMemory(textureImageMemory);
 }
 
 
@@ -1885,17 +2620,15 @@ void Pipeline::init(BaseProject* bp, VertexDescriptor* vd,
 	BP = bp;
 	VD = vd;
 
-	auto vertShaderCode = readFile(VertShader);
-	auto fragShaderCode = readFile(FragShader);
-	std::cout << "Vertex shader <" << VertShader << "> len: " <<
-		vertShaderCode.size() << "\n";
-	std::cout << "Fragment shader <" << FragShader << "> len: " <<
-		fragShaderCode.size() << "\n";
+	LOG_INFO("Vertex shader <%s>", VertShader.c_str());
+	LOG_INFO("Fragment shader <%s>", FragShader.c_str());
 
-	vertShaderModule =
-		createShaderModule(vertShaderCode);
-	fragShaderModule =
-		createShaderModule(fragShaderCode);
+	// Shared with the other pipelines that use the same code
+	vertShaderModule = ResourceRegistry::instance().acquireShaderModule(VertShader);
+	fragShaderModule = ResourceRegistry::instance().acquireShaderModule(FragShader);
+	BP->setObjectName(VK_OBJECT_TYPE_SHADER_MODULE, vertShaderModule, VertShader);
+	BP->setObjectName(VK_OBJECT_TYPE_SHADER_MODULE, fragShaderModule, FragShader);
+	name = VertShader + " + " + FragShader;
 
 	compareOp = VK_COMPARE_OP_LESS;
 	polyModel = VK_POLYGON_MODE_FILL;
@@ -1913,6 +2646,16 @@ void Pipeline::setAdvancedFeatures(VkCompareOp _compareOp, VkPolygonMode _polyMo
 	transp = _transp;
 }
 
+void Pipeline::setTarget(VkRenderPass _renderPass, VkSampleCountFlagBits _samples) {
+	renderPass = _renderPass;
+	samples = _samples;
+}
+
+void Pipeline::setAdditiveBlend(const glm::vec4& constant) {
+	additive = true;
+	blendConstant = constant;
+}
+
 
 void Pipeline::create() {
 	VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
@@ -1989,7 +2732,7 @@ void Pipeline::create() {
 	multisampling.sType =
 		VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
 	multisampling.sampleShadingEnable = VK_TRUE;
-	multisampling.rasterizationSamples = BP->msaaSamples;
+	multisampling.rasterizationSamples = renderPass != VK_NULL_HANDLE ? samples : BP->msaaSamples;
 	multisampling.minSampleShading = 1.0f; // Optional
 	multisampling.pSampleMask = nullptr; // Optional
 	multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
@@ -2014,6 +2757,13 @@ void Pipeline::create() {
 		VK_BLEND_FACTOR_ZERO; // Optional
 	colorBlendAttachment.alphaBlendOp =
 		VK_BLEND_OP_ADD; // Optional
+	if (additive) {
+		colorBlendAttachment.blendEnable = VK_TRUE;
+		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_CONSTANT_COLOR;
+		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_CONSTANT_ALPHA;
+		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	}
 
 	VkPipelineColorBlendStateCreateInfo colorBlending{};
 	colorBlending.sType =
@@ -2022,10 +2772,10 @@ void Pipeline::create() {
 	colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
 	colorBlending.attachmentCount = 1;
 	colorBlending.pAttachments = &colorBlendAttachment;
-	colorBlending.blendConstants[0] = 0.0f; // Optional
-	colorBlending.blendConstants[1] = 0.0f; // Optional
-	colorBlending.blendConstants[2] = 0.0f; // Optional
-	colorBlending.blendConstants[3] = 0.0f; // Optional
+	colorBlending.blendConstants[0] = blendConstant.r;
+	colorBlending.blendConstants[1] = blendConstant.g;
+	colorBlending.blendConstants[2] = blendConstant.b;
+	colorBlending.blendConstants[3] = blendConstant.a;
 
 	std::vector<VkDescriptorSetLayout> DSL(D.size());
 	for (int i = 0; i < D.size(); i++) {
@@ -2074,7 +2824,7 @@ void Pipeline::create() {
 	pipelineInfo.pColorBlendState = &colorBlending;
 	pipelineInfo.pDynamicState = nullptr; // Optional
 	pipelineInfo.layout = pipelineLayout;
-	pipelineInfo.renderPass = BP->renderPass;
+	pipelineInfo.renderPass = renderPass != VK_NULL_HANDLE ? renderPass : BP->renderPass;
 	pipelineInfo.subpass = 0;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
 	pipelineInfo.basePipelineIndex = -1; // Optional
@@ -2085,12 +2835,13 @@ void Pipeline::create() {
 		PrintVkError(result);
 		throw std::runtime_error("failed to create graphics pipeline!");
 	}
-
+	BP->setObjectName(VK_OBJECT_TYPE_PIPELINE_LAYOUT, pipelineLayout, name);
+	BP->setObjectName(VK_OBJECT_TYPE_PIPELINE, graphicsPipeline, name);
 }
 
 void Pipeline::destroy() {
-	vkDestroyShaderModule(BP->device, fragShaderModule, nullptr);
-	vkDestroyShaderModule(BP->device, vertShaderModule, nullptr);
+	ResourceRegistry::instance().releaseShaderModule(fragShaderModule);
+	ResourceRegistry::instance().releaseShaderModule(vertShaderModule);
 }
 
 void Pipeline::bind(VkCommandBuffer commandBuffer) {
@@ -2100,24 +2851,6 @@ void Pipeline::bind(VkCommandBuffer commandBuffer) {
 
 }
 
-VkShaderModule Pipeline::createShaderModule(const std::vector<char>& code) {
-	VkShaderModuleCreateInfo createInfo{};
-	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.codeSize = code.size();
-	createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-
-	VkShaderModule shaderModule;
-
-	VkResult result = vkCreateShaderModule(BP->device, &createInfo, nullptr,
-		&shaderModule);
-	if (result != VK_SUCCESS) {
-		PrintVkError(result);
-		throw std::runtime_error("failed to create shader module!");
-	}
-
-	return shaderModule;
-}
-
 void Pipeline::cleanup() {
 	vkDestroyPipeline(BP->device, graphicsPipeline, nullptr);
 	vkDestroyPipelineLayout(BP->device, pipelineLayout, nullptr);
@@ -2158,7 +2891,7 @@ void DescriptorSetLayout::cleanup() {
 // static int dss = 0;
 
 void DescriptorSet::init(BaseProject* bp, DescriptorSetLayout* DSL,
-	std::vector<DescriptorSetElement> E) {
+	std::vector<DescriptorSetElement> E, const std::string& owner) {
 	BP = bp;
 
 	uniformBuffers.resize(E.size());
@@ -2174,7 +2907,9 @@ void DescriptorSet::init(BaseProject* bp, DescriptorSetLayout* DSL,
 				BP->createBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
 					VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-					uniformBuffers[j][i], uniformBuffersMemory[j][i]);
+					uniformBuffers[j][i], uniformBuffersMemory[j][i], MEMORY_UNIFORM, owner);
+				BP->setObjectName(VK_OBJECT_TYPE_BUFFER, uniformBuffers[j][i],
+					owner + " binding " + std::to_string(E[j].binding) + " image " + std::to_string(i));
 			}
 			toFree[j] = true;
 		}
@@ -2199,6 +2934,9 @@ void DescriptorSet::init(BaseProject* bp, DescriptorSetLayout* DSL,
 		PrintVkError(result);
 		throw std::runtime_error("failed to allocate descriptor sets!");
 	}
+	for (size_t i = 0; i < descriptorSets.size(); i++) {
+		BP->setObjectName(VK_OBJECT_TYPE_DESCRIPTOR_SET, descriptorSets[i], owner + " image " + std::to_string(i));
+	}
 
 	for (size_t i = 0; i < BP->swapChainImages.size(); i++) {
 		std::vector<VkWriteDescriptorSet> descriptorWrites(E.size());
@@ -2248,7 +2986,7 @@ void DescriptorSet::cleanup() {
 		if (toFree[j]) {
 			for (size_t i = 0; i < BP->swapChainImages.size(); i++) {
 				vkDestroyBuffer(BP->device, uniformBuffers[j][i], nullptr);
-				vkFreeMemory(BP->device, uniformBuffersMemory[j][i], nullptr);
+				BP->freeMemory(uniformBuffersMemory[j][i]);
 			}
 		}
 	}
@@ -2269,4 +3007,5 @@ void DescriptorSet::map(int currentImage, void* src, int size, int slot) {
 		size, 0, &data);
 	memcpy(data, src, size);
 	vkUnmapMemory(BP->device, uniformBuffersMemory[slot][currentImage]);
+	BP->uploadedBytes += size;
 }
@@ -9,9 +9,12 @@
 #include <optional>
 #include <set>
 #include <cstdint>
+#include <climits>
 #include <algorithm>
 #include <fstream>
 #include <array>
+#include <memory>
+#include <typeinfo>
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
@@ -19,6 +22,7 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include <chrono>
 
@@ -36,6 +40,18 @@
 #include <plusaes.hpp>
 
 #include <sinfl.h>
+#include <sdefl.h>
+
+#include "JobSystem.hpp"
+#include "VirtualFileSystem.hpp"
+#include "GltfParser.hpp"
+#include "ObjParser.hpp"
+#include "TexturePack.hpp"
+#include "ResourceRegistry.hpp"
+#include "Profiler.hpp"
+#include "Logger.hpp"
+#include "GpuMemory.hpp"
+#include "VulkanRecorder.hpp"
 
 extern const int MAX_FRAMES_IN_FLIGHT;
 
@@ -43,8 +59,46 @@ extern const std::vector<const char*> validationLayers;
 
 extern std::vector<const char*> deviceExtensions;
 
+void PrintVkError(VkResult result);
+
+// Copy of a file, from the asset pack if mounted (see VirtualFileSystem)
 std::vector<char> readFile(const std::string& filename);
 
+// tinygltf file callbacks reading through the virtual file system, for the buffers and images of a .gltf
+tinygltf::FsCallbacks virtualFsCallbacks();
+
+// Decrypt (AES-128-CBC) and inflate the content of a .mgcg file, returning the glTF text.
+// With a job system the blocks are decrypted in parallel
+std::vector<char> decodeMGCG(const char* encoded, size_t size, JobSystem* jobs = nullptr);
+std::vector<char> decodeMGCG(const std::vector<char>& encoded, JobSystem* jobs = nullptr);
+
+// decodeMGCG of a file, read through the virtual file system
+std::vector<char> loadMGCG(const std::string& filename, JobSystem* jobs = nullptr);
+
+// A binary glTF (.glb) read through the virtual file system, in place: json and bin are its JSON and BIN chunks
+struct GlbFile {
+	FileData file;
+	const char *json = nullptr;
+	size_t jsonSize = 0;
+	const unsigned char *bin = nullptr;
+	size_t binSize = 0;
+
+	void open(const std::string& filename);
+	// The JSON chunk for tinygltf, with the buffer of the BIN chunk swapped for a one byte placeholder so that
+	// tinygltf does not copy it
+	std::string tinygltfJson() const;
+};
+
+// The geometry of an OBJ loaded by tinyobj, as the loader reads it (the fallback of ObjMesh::parse)
+ObjMesh objMeshFromTinyobj(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes);
+
+// The meshes of a document loaded by tinygltf, as the loader reads them (the fallback of GltfDocument::parse):
+// the buffers point into model, buffer 0 into glbBin if given
+GltfDocument gltfDocumentFromTinygltf(const tinygltf::Model& model, const unsigned char* glbBin, size_t glbBinSize);
+
+// The inverse of decodeMGCG: deflate and encrypt
+std::vector<char> encodeMGCG(const std::vector<char>& data);
+
 class BaseProject;
 
 struct VertexBindingDescriptorElement {
@@ -67,6 +121,11 @@ struct VertexDescriptorElement {
 struct VertexComponent {
 	bool hasIt;
 	uint32_t offset;
+	VkFormat format;
+	bool octahedral;		// 16-bit SNORM normal or tangent: octahedral encoding of the direction
+
+	// Write value to the component of vertex, converted to its format (positions must be already in [-1, 1] if SNORM)
+	void store(void *vertex, glm::vec4 value) const;
 };
 
 struct VertexDescriptor {
@@ -89,30 +148,59 @@ struct VertexDescriptor {
 						getAttributeDescriptions();
 };
 
-enum ModelType {OBJ, GLTF, MGCG};
+enum ModelType {OBJ, GLTF, MGCG, GLB};
 
 template <class Vert>
 class Model {
-	BaseProject *BP;
+	BaseProject *BP = nullptr;
 	
 	VkBuffer vertexBuffer;
 	VkDeviceMemory vertexBufferMemory;
 	VkBuffer indexBuffer;
 	VkDeviceMemory indexBufferMemory;
+	VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+	uint32_t indexCount = 0;
 	VertexDescriptor *VD;
+	std::string name;		// file it was loaded from, for the memory report and the debug names
+
+	// The buffers of the models loaded from the same file with the same vertex format are shared through the
+	// ResourceRegistry, under meshKey (empty for the meshes built by the application)
+	struct SharedMesh {
+		VkBuffer vertexBuffer;
+		VkDeviceMemory vertexBufferMemory;
+		VkBuffer indexBuffer;
+		VkDeviceMemory indexBufferMemory;
+		VkIndexType indexType;
+		uint32_t indexCount;
+		glm::mat4 dequantization;
+	};
+	std::string meshKey;
+
+	std::vector<glm::vec3> quantizedPositions;	// positions of the vertices while loading, if the format quantizes them
+	void storePosition(Vert &vertex, glm::vec3 pos);
+	void quantizePositions();
 
 	public:
 	std::vector<Vert> vertices{};
 	std::vector<uint32_t> indices{};
+	// Maps the quantized positions of the vertices to the model space (identity for float positions):
+	// the world matrices of the model must be multiplied by it
+	glm::mat4 dequantization = glm::mat4(1.0f);
 	void loadModelOBJ(std::string file);
-	void loadModelGLTF(std::string file, bool encoded);
+	void loadModelGLTF(std::string file, ModelType MT);
 	void createIndexBuffer();
 	void createVertexBuffer();
 
+	// Read the file into vertices and indices, without touching the GPU
+	void load(VertexDescriptor *VD, std::string file, ModelType MT);
+	// Load the file and create its buffers, unless another model has already done it (vertices and indices stay
+	// empty then)
 	void init(BaseProject *bp, VertexDescriptor *VD, std::string file, ModelType MT);
 	void initMesh(BaseProject *bp, VertexDescriptor *VD);
 	void cleanup();
   	void bind(VkCommandBuffer commandBuffer);
+	// Draw all the indices of the model (bind() must come first)
+	void draw(VkCommandBuffer commandBuffer);
 };
 
 struct Texture {
@@ -121,11 +209,27 @@ struct Texture {
 	VkImage textureImage;
 	VkDeviceMemory textureImageMemory;
 	VkImageView textureImageView;
-	VkSampler textureSampler;
+	VkSampler textureSampler = VK_NULL_HANDLE;		// shared with the textures with the same sampler settings
 	int imgs;
 	static const int maxImgs = 6;
+	std::string name;		// (first) file it was loaded from, for the memory report and the debug names
+	std::string imageKey;	// the image is shared with the textures loaded from the same files, empty if not
+
+	struct SharedImage {
+		VkImage image;
+		VkDeviceMemory memory;
+		VkImageView view;
+		uint32_t mipLevels;
+	};
+
+	// Take the image of key from the ResourceRegistry if another texture has loaded it, false otherwise
+	bool acquireImage(const std::string& key);
+	// Hand the image just created to the ResourceRegistry under imageKey, which destroys it on the last release
+	void shareImage();
 	
 	void createTextureImage(const char *const files[], VkFormat Fmt);
+	// Copy imgs layers of pixelSize bytes per pixel to a new image, with its mipmaps
+	void uploadTextureImage(const unsigned char *const pixels[], int texWidth, int texHeight, int pixelSize, VkFormat Fmt);
 	void createTextureImageView(VkFormat Fmt);
 	void createTextureSampler(VkFilter magFilter,
 							 VkFilter minFilter,
@@ -138,6 +242,12 @@ struct Texture {
 							);
 
 	void init(BaseProject *bp, const char * file, VkFormat Fmt = VK_FORMAT_R8G8B8A8_SRGB, bool initSampler = true);
+	// RGB of rgbFile with the first channel of alphaFile in alpha: packedFile as written by --pack-textures if
+	// it exists, packed at load time otherwise
+	void initPacked(BaseProject *bp, const char *packedFile, const char *rgbFile, const char *alphaFile, VkFormat Fmt);
+	// Texture generated by the application (the sampler has to be created by the caller)
+	void initPixels(BaseProject *bp, const unsigned char *pixels, int width, int height, int pixelSize,
+					VkFormat Fmt, const std::string& owner);
 	void initCubic(BaseProject *bp, const char * files[6]);
 	void cleanup();
 };
@@ -164,12 +274,20 @@ struct Pipeline {
  
 	VkShaderModule vertShaderModule;
 	VkShaderModule fragShaderModule;
+	std::string name;		// shaders it was built from, for the debug names
 	std::vector<DescriptorSetLayout *> D;	
 	
 	VkCompareOp compareOp;
 	VkPolygonMode polyModel;
  	VkCullModeFlagBits CM;
  	bool transp;
+
+	// Render pass and samples of the pipeline: the main render pass of the application unless set
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+	// Add the fragment color times a constant to the target, for counters
+	bool additive = false;
+	glm::vec4 blendConstant = glm::vec4(0.0f);
 	
 	VertexDescriptor *VD;
   	
@@ -178,11 +296,12 @@ struct Pipeline {
   			  std::vector<DescriptorSetLayout *> D);
   	void setAdvancedFeatures(VkCompareOp _compareOp, VkPolygonMode _polyModel,
  						VkCullModeFlagBits _CM, bool _transp);
+	void setTarget(VkRenderPass _renderPass, VkSampleCountFlagBits _samples);
+	void setAdditiveBlend(const glm::vec4& constant);
   	void create();
   	void destroy();
   	void bind(VkCommandBuffer commandBuffer);
   	
-  	VkShaderModule createShaderModule(const std::vector<char>& code);
 	void cleanup();
 };
 
@@ -205,7 +324,7 @@ struct DescriptorSet {
 	std::vector<bool> toFree;
 
 	void init(BaseProject *bp, DescriptorSetLayout *L,
-		std::vector<DescriptorSetElement> E);
+		std::vector<DescriptorSetElement> E, const std::string& owner = "descriptor sets");
 	void cleanup();
   	void bind(VkCommandBuffer commandBuffer, Pipeline &P, int setId, int currentImage);
   	void map(int currentImage, void *src, int size, int slot);
@@ -232,10 +351,24 @@ class BaseProject {
 	friend class Pipeline;
 	friend class DescriptorSetLayout;
 	friend class DescriptorSet;
+	friend class TextRenderer;
+	friend class OverdrawView;
 public:
 	virtual void setWindowParameters() = 0;
 	void run();
 
+	// Start collecting the trace from the first frame and write it to tracePath when the application closes
+	void enableProfiler(const std::string& tracePath);
+	// Start or stop the CPU scopes, the job trace and the GPU timestamps (records the command buffers again)
+	void setProfiling(bool on);
+
+	// Write the GPU memory breakdown to reportPath when the application closes (F3 writes it at any time)
+	void enableMemoryReport(const std::string& reportPath);
+
+	// Render without a window nor a swap chain, for at most frames frames (0 = until the application quits), and save
+	// the last frame to capturePath as PNG; if capturePath contains a %d, every captureInterval-th frame is saved instead
+	void enableOffscreen(int frames, const std::string& capturePath, int captureInterval = 1);
+
 protected:
 	uint32_t windowWidth;
 	uint32_t windowHeight;
@@ -268,6 +401,15 @@ protected:
  	VkDescriptorPool descriptorPool;
 
 	VkDebugUtilsMessengerEXT debugMessenger;
+
+	// VK_EXT_debug_utils entry points for object names and command buffer labels, shown by RenderDoc and
+	// similar capture tools: null when the extension is missing, and compiled out when the headers lack it
+#ifdef VK_EXT_debug_utils
+	PFN_vkSetDebugUtilsObjectNameEXT setDebugUtilsObjectName = nullptr;
+	PFN_vkCmdBeginDebugUtilsLabelEXT cmdBeginDebugUtilsLabel = nullptr;
+	PFN_vkCmdEndDebugUtilsLabelEXT cmdEndDebugUtilsLabel = nullptr;
+#endif
+	bool regionOpen = false;		// a region of the command buffer being recorded has begun and not ended yet
 	
 	VkImage depthImage;
 	VkDeviceMemory depthImageMemory;
@@ -286,6 +428,39 @@ protected:
 	std::vector<VkSemaphore> renderFinishedSemaphores;
 	std::vector<VkFence> inFlightFences;
 	std::vector<VkFence> imagesInFlight;
+
+	// Worker threads shared by the engine and the application, started in run()
+	JobSystem jobSystem;
+
+	// CPU scopes and GPU timestamps, off unless enabled
+	Profiler profiler;
+	std::string profilerTracePath;
+
+	// Khronos validation layer (skipped when missing) and vsync, both off for benchmarks
+	bool validationEnabled = true;
+	bool vsync = true;
+
+	// Statistics for the HUD: draws recorded in each command buffer, bytes copied to mapped memory since the start
+	uint32_t drawCalls = 0;
+	uint64_t uploadedBytes = 0;
+	// Index buffer bytes saved by the models with 16-bit indices
+	uint64_t indexBytesSaved = 0;
+
+	// Every device memory allocation, by category and owner
+	GpuMemoryTracker memoryTracker;
+	bool memoryBudgetEnabled = false;
+	std::string memoryReportPath;
+
+	// Offscreen rendering: the swap chain images are replaced by plain images, read back through readbackBuffer
+	bool offscreen = false;
+	bool closeRequested = false;
+	int offscreenFrames = 0;
+	int offscreenFrame = 0;								// frames submitted so far
+	int captureInterval = 1;
+	std::string capturePath;
+	std::vector<VkDeviceMemory> offscreenImagesMemory;
+	VkBuffer readbackBuffer = VK_NULL_HANDLE;
+	VkDeviceMemory readbackBufferMemory = VK_NULL_HANDLE;
 	
 	void initWindow();
 
@@ -319,6 +494,20 @@ protected:
 
 	void setupDebugMessenger();
 
+	void loadDebugUtils();
+
+	// Name a Vulkan object in GPU captures (nothing happens without VK_EXT_debug_utils)
+	void setObjectName(VkObjectType type, uint64_t handle, const std::string& name);
+	template <class Handle> void setObjectName(VkObjectType type, Handle handle, const std::string& name) {
+		setObjectName(type, (uint64_t)handle, name);
+	}
+
+	// Named region of the command buffer being recorded, in populateCommandBuffer: a GPU zone of the profiler and
+	// a debug label. Regions do not nest, beginning one ends the previous one. The profiler keeps the name, so it has
+	// to be a string literal
+	void beginRegion(VkCommandBuffer commandBuffer, int currentImage, const char* name);
+	void endRegion(VkCommandBuffer commandBuffer, int currentImage);
+
 	void createSurface();
 
 	class deviceReport {
@@ -358,6 +547,8 @@ protected:
 	
 	VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
 
+	void createOffscreenImages();
+
 	void createImageViews();
 	
 	VkImageView createImageView(VkImage image, VkFormat format,
@@ -389,7 +580,8 @@ protected:
 		VkImageTiling tiling, VkImageUsageFlags usage,
 		VkImageCreateFlags cflags,
 		VkMemoryPropertyFlags properties, VkImage& image,
-		VkDeviceMemory& imageMemory);
+		VkDeviceMemory& imageMemory,
+		MemoryCategory category, const std::string& owner);
 
 	void generateMipmaps(VkImage image, VkFormat imageFormat,
 		int32_t texWidth, int32_t texHeight,
@@ -408,7 +600,11 @@ protected:
 	
 	void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
 		VkMemoryPropertyFlags properties,
-		VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+		VkBuffer& buffer, VkDeviceMemory& bufferMemory,
+		MemoryCategory category, const std::string& owner);
+
+	// vkFreeMemory for the memory of createBuffer and createImage, keeping the tracker up to date
+	void freeMemory(VkDeviceMemory memory);
 	
 	uint32_t findMemoryType(uint32_t typeFilter,
 		VkMemoryPropertyFlags properties);
@@ -416,8 +612,12 @@ protected:
 	void createDescriptorPool();
 	
 	virtual void populateCommandBuffer(VkCommandBuffer commandBuffer, int i) = 0;
+	// Passes into the application's own targets, recorded before the main render pass
+	virtual void populateCommandBufferPrePass(VkCommandBuffer, int) {}
 
 	void createCommandBuffers();
+	// Record the command buffers again, when what populateCommandBuffer draws has changed (waits for the device)
+	void rebuildCommandBuffers();
     
 	void createSyncObjects();
 	
@@ -425,6 +625,14 @@ protected:
     
 	void drawFrame();
 
+	void drawOffscreenFrame();
+
+	// Copy a rendered image to the readback buffer and write it as PNG
+	void captureFrame(uint32_t imageIndex, const std::string& path);
+
+	// Quit at the end of the current frame (closes the window, if any)
+	void requestClose();
+
 	virtual void updateUniformBuffer(uint32_t currentImage) = 0;
 
 	virtual void pipelinesAndDescriptorSetsCleanup() = 0;
@@ -458,272 +666,279 @@ public:
 // Helper classes
 template <class Vert>
 void Model<Vert>::loadModelOBJ(std::string file) {
-	tinyobj::attrib_t attrib;
-	std::vector<tinyobj::shape_t> shapes;
-	std::vector<tinyobj::material_t> materials;
-	std::string warn, err;
-	
-	std::cout << "Loading : " << file << "[OBJ]\n";	
-	if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err,
-						  file.c_str())) {
-		throw std::runtime_error(warn + err);
+	LOG_INFO("Loading : %s[OBJ]", file.c_str());	
+	std::shared_ptr<const FileData> data = ResourceRegistry::instance().file(file);
+	JobSystem *jobs = BP != nullptr ? &BP->jobSystem : nullptr;
+
+	// The parallel parser reads triangles and quads; tinyobj loads whatever it does not support
+	ObjMesh mesh;
+	std::string error;
+	if (!mesh.parse(data->data(), data->size(), jobs, error)) {
+		LOG_DEBUG("%s: %s, loading it with tinyobj", file.c_str(), error.c_str());
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warn, err;
+		FileDataStream stream(*data);
+		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err,
+							  &stream)) {
+			throw std::runtime_error(warn + err);
+		}
+		mesh = objMeshFromTinyobj(attrib, shapes);
 	}
 	
-	std::cout << "Building\n";	
-//	std::cout << "Position " << VD->Position.hasIt << "," << VD->Position.offset << "\n";	
-//	std::cout << "UV " << VD->UV.hasIt << "," << VD->UV.offset << "\n";	
-//	std::cout << "Normal " << VD->Normal.hasIt << "," << VD->Normal.offset << "\n";	
-	for (const auto& shape : shapes) {
-		for (const auto& index : shape.mesh.indices) {
-			Vert vertex{};
-			glm::vec3 pos = {
-				attrib.vertices[3 * index.vertex_index + 0],
-				attrib.vertices[3 * index.vertex_index + 1],
-				attrib.vertices[3 * index.vertex_index + 2]
-			};
+	LOG_DEBUG("Building");	
+	// One vertex per corner, written in parallel into the arrays sized up front
+	size_t firstVertex = vertices.size();
+	size_t firstIndex = indices.size();
+	size_t count = mesh.corners.size();
+	vertices.resize(firstVertex + count);
+	indices.resize(firstIndex + count);
+	bool quantized = VD->Position.hasIt && VD->Position.format != VK_FORMAT_R32G32B32_SFLOAT;
+	if (quantized) {
+		quantizedPositions.resize(vertices.size());
+	}
+	auto build = [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			const ObjCorner &corner = mesh.corners[i];
+			Vert &vertex = vertices[firstVertex + i];
+
+			glm::vec3 pos(0.0f), color(1.0f), norm(0.0f);
+			glm::vec2 texCoord(0.0f, 1.0f);
+			if (corner.position >= 0) {
+				const float *p = &mesh.positions[3 * corner.position];
+				const float *c = &mesh.colors[3 * corner.position];
+				pos = glm::vec3(p[0], p[1], p[2]);
+				color = glm::vec3(c[0], c[1], c[2]);
+			}
+			if (corner.texCoord >= 0) {
+				texCoord = {
+					mesh.texCoords[2 * corner.texCoord + 0],
+					1 - mesh.texCoords[2 * corner.texCoord + 1]
+				};
+			}
+			if (corner.normal >= 0) {
+				const float *n = &mesh.normals[3 * corner.normal];
+				norm = glm::vec3(n[0], n[1], n[2]);
+			}
+
 			if(VD->Position.hasIt) {
-				glm::vec3 *o = (glm::vec3 *)((char*)(&vertex) + VD->Position.offset);
-				*o = pos;
+				// Written by quantizePositions, once the bounds of the model are known
+				if(quantized) {
+					quantizedPositions[firstVertex + i] = pos;
+				} else {
+					VD->Position.store(&vertex, glm::vec4(pos, 1.0f));
+				}
 			}
-			
-			glm::vec3 color = {
-				attrib.colors[3 * index.vertex_index + 0],
-				attrib.colors[3 * index.vertex_index + 1],
-				attrib.colors[3 * index.vertex_index + 2]
-			};
 			if(VD->Color.hasIt) {
-				glm::vec3 *o = (glm::vec3 *)((char*)(&vertex) + VD->Color.offset);
-				*o = color;
+				VD->Color.store(&vertex, glm::vec4(color, 1.0f));
 			}
-			
-			glm::vec2 texCoord = {
-				attrib.texcoords[2 * index.texcoord_index + 0],
-				1 - attrib.texcoords[2 * index.texcoord_index + 1] 
-			};
 			if(VD->UV.hasIt) {
-				glm::vec2 *o = (glm::vec2 *)((char*)(&vertex) + VD->UV.offset);
-				*o = texCoord;
+				VD->UV.store(&vertex, glm::vec4(texCoord, 0.0f, 0.0f));
 			}
-
-			glm::vec3 norm = {
-				attrib.normals[3 * index.normal_index + 0],
-				attrib.normals[3 * index.normal_index + 1],
-				attrib.normals[3 * index.normal_index + 2]
-			};
 			if(VD->Normal.hasIt) {
-				glm::vec3 *o = (glm::vec3 *)((char*)(&vertex) + VD->Normal.offset);
-				*o = norm;
+				VD->Normal.store(&vertex, glm::vec4(norm, 0.0f));
 			}
-			
-			vertices.push_back(vertex);
-			indices.push_back(vertices.size()-1);
+			indices[firstIndex + i] = static_cast<uint32_t>(firstVertex + i);
 		}
+	};
+	if (jobs != nullptr) {
+		jobs->parallelFor("buildObj", 0, static_cast<int>(count), 4096, build);
+	} else {
+		build(0, static_cast<int>(count));
 	}
-	std::cout << "[OBJ] Vertices: "<< vertices.size() << "\n";
-	std::cout << "Indices: "<< indices.size() << "\n";
+	LOG_INFO("[OBJ] Vertices: %zu, Indices: %zu", vertices.size(), indices.size());
 	
 }
 
 template <class Vert>
-void Model<Vert>::loadModelGLTF(std::string file, bool encoded) {
-	tinygltf::Model model;
-	tinygltf::TinyGLTF loader;
-	std::string warn, err;
+void Model<Vert>::loadModelGLTF(std::string file, ModelType MT) {
+	GlbFile glb;
+	const char *label = MT == MGCG ? "[MGCG]" : MT == GLB ? "[GLB]" : "[GLTF]";
 	
-	std::cout << "Loading : " << file << (encoded ? "[MGCG]" : "[GLTF]") << "\n";	
-	if(encoded) {
-		auto modelString = readFile(file);
-		
-		const std::vector<unsigned char> key = plusaes::key_from_string(&"CG2023SkelKey128"); // 16-char = 128-bit
-		const unsigned char iv[16] = {
-			0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
-			0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F,
-		};
-
-		// decrypt
-		unsigned long padded_size = 0;
-		std::vector<unsigned char> decrypted(modelString.size());
-
-		plusaes::decrypt_cbc((unsigned char*)modelString.data(), modelString.size(), &key[0], key.size(), &iv, &decrypted[0], decrypted.size(), &padded_size);
+	LOG_INFO("Loading : %s%s", file.c_str(), label);	
+	std::string baseDir = MT == MGCG ? "/" : file.substr(0, file.find_last_of("/\\") + 1);
+
+	// The glTF text: decrypted, the JSON chunk of the .glb, or the file as it is
+	std::vector<char> decomp;
+	std::shared_ptr<const FileData> data;
+	const char *json;
+	size_t jsonSize;
+	if(MT == MGCG) {
+		decomp = loadMGCG(file, BP != nullptr ? &BP->jobSystem : nullptr);
+		json = decomp.data();
+		jsonSize = decomp.size();
+	} else if(MT == GLB) {
+		glb.open(file);
+		json = glb.json;
+		jsonSize = glb.jsonSize;
+	} else {
+		data = ResourceRegistry::instance().file(file);
+		json = data->data();
+		jsonSize = data->size();
+	}
 
-		int size = 0;
-		void *decomp;
-		
-		sscanf(reinterpret_cast<char *const>(&decrypted[0]), "%d", &size);
-//std::cout << decrypted.size() << ", decomp: " << size << "\n";
-//for(int i=0;i<32;i++) {
-//	std::cout << (int)decrypted[i] << "\n";
-//}
-
-		decomp = calloc(size, 1);
-		int n = sinflate(decomp, (int)size, &decrypted[16], decrypted.size()-16);
-		
-		if (!loader.LoadASCIIFromString(&model, &warn, &err, 
-						reinterpret_cast<const char *>(decomp), size, "/")) {
-			throw std::runtime_error(warn + err);
+	// The streaming parser reads only what is needed below; tinygltf loads whatever it does not support
+	GltfDocument doc;
+	tinygltf::Model model;
+	std::string error;
+	if(!doc.parse(json, jsonSize, error) || !doc.loadBuffers(baseDir, glb.bin, glb.binSize, error)) {
+		LOG_DEBUG("%s: %s, loading it with tinygltf", file.c_str(), error.c_str());
+		tinygltf::TinyGLTF loader;
+		std::string warn, err;
+		loader.SetFsCallbacks(virtualFsCallbacks());
+		std::string glbJson;
+		if(MT == GLB) {
+			glbJson = glb.tinygltfJson();
+			json = glbJson.data();
+			jsonSize = glbJson.size();
 		}
-	} else {
-		if (!loader.LoadASCIIFromFile(&model, &warn, &err, 
-						file.c_str())) {
+		if (!loader.LoadASCIIFromString(&model, &warn, &err, 
+						json, (unsigned int)jsonSize, baseDir)) {
 			throw std::runtime_error(warn + err);
 		}
+		doc = gltfDocumentFromTinygltf(model, glb.bin, glb.binSize);
 	}
 
-	for (const auto& mesh :  model.meshes) {
-		std::cout << "Primitives: " << mesh.primitives.size() << "\n";
-		for (const auto& primitive :  mesh.primitives) {
-			if (primitive.indices < 0) {
-				continue;
+	// Reader of the attribute of a primitive, warning if the vertex layout has it but the file does not
+	auto attribute = [&](int accessor, const VertexComponent &component, const char *what) -> AccessorReader {
+		if(accessor < 0) {
+			if(component.hasIt) {
+				LOG_WARN("vertex layout has %s, but %s hasn't%s", what, file.c_str(),
+						 &component == &VD->Tangent ? " (add them with --bake-tangents)" : "");
 			}
+			return AccessorReader();
+		}
+		return AccessorReader(doc, accessor);
+	};
 
-			const float *bufferPos = nullptr;
-			const float *bufferNormals = nullptr;
-			const float *bufferTangents = nullptr;
-			const float *bufferTexCoords = nullptr;
-			
-			bool meshHasPos = false;
-			bool meshHasNorm = false;
-			bool meshHasTan = false;
-			bool meshHasUV = false;
-			
-			size_t cntPos = 0;
-			size_t cntNorm = 0;
-			size_t cntTan = 0;
-			size_t cntUV = 0;
-			size_t cntTot = 0;
-			
-			auto pIt = primitive.attributes.find("POSITION");
-			if(pIt != primitive.attributes.end()) {
-				const tinygltf::Accessor &posAccessor = model.accessors[pIt->second];
-				const tinygltf::BufferView &posView = model.bufferViews[posAccessor.bufferView];
-				bufferPos = reinterpret_cast<const float *>(&(model.buffers[posView.buffer].data[posAccessor.byteOffset + posView.byteOffset]));
-				meshHasPos = true;
-				cntPos = posAccessor.count;
-				if(cntPos > cntTot) cntTot = cntPos;
-			} else {
-				if(VD->Position.hasIt) {
-					std::cout << "Warning: vertex layout has position, but file hasn't\n";
-				}
-			}
-			
-			auto nIt = primitive.attributes.find("NORMAL");
-			if(nIt != primitive.attributes.end()) {
-				const tinygltf::Accessor &normAccessor = model.accessors[nIt->second];
-				const tinygltf::BufferView &normView = model.bufferViews[normAccessor.bufferView];
-				bufferNormals = reinterpret_cast<const float *>(&(model.buffers[normView.buffer].data[normAccessor.byteOffset + normView.byteOffset]));
-				meshHasNorm = true;
-				cntNorm = normAccessor.count;
-				if(cntNorm > cntTot) cntTot = cntNorm;
-			} else {
-				if(VD->Normal.hasIt) {
-					std::cout << "Warning: vertex layout has normal, but file hasn't\n";
-				}
-			}
+	for (int m = 0; m < doc.meshes.size(); m++) {
+		const GltfMesh &mesh = doc.meshes[m];
 
-			auto tIt = primitive.attributes.find("TANGENT");
-			if(tIt != primitive.attributes.end()) {
-				const tinygltf::Accessor &tanAccessor = model.accessors[tIt->second];
-				const tinygltf::BufferView &tanView = model.bufferViews[tanAccessor.bufferView];
-				bufferTangents = reinterpret_cast<const float *>(&(model.buffers[tanView.buffer].data[tanAccessor.byteOffset + tanView.byteOffset]));
-				meshHasTan = true;
-				cntTan = tanAccessor.count;
-				if(cntTan > cntTot) cntTot = cntTan;
-			} else {
-				if(VD->Tangent.hasIt) {
-					std::cout << "Warning: vertex layout has tangent, but file hasn't\n";
-				}
+		// KHR_mesh_quantization: integer positions are dequantized by the transform of the node of the mesh
+		glm::mat4 nodeTransform = glm::mat4(1.0f);
+		for (const GltfNode &node : doc.nodes) {
+			if (node.mesh == m) {
+				nodeTransform = node.transform;
+				break;
 			}
+		}
+		glm::mat3 nodeNormalTransform = glm::transpose(glm::inverse(glm::mat3(nodeTransform)));
 
-			auto uIt = primitive.attributes.find("TEXCOORD_0");
-			if(uIt != primitive.attributes.end()) {
-				const tinygltf::Accessor &uvAccessor = model.accessors[uIt->second];
-				const tinygltf::BufferView &uvView = model.bufferViews[uvAccessor.bufferView];
-				bufferTexCoords = reinterpret_cast<const float *>(&(model.buffers[uvView.buffer].data[uvAccessor.byteOffset + uvView.byteOffset]));
-				meshHasUV = true;
-				cntUV = uvAccessor.count;
-				if(cntUV > cntTot) cntTot = cntUV;
-			} else {
-				if(VD->UV.hasIt) {
-					std::cout << "Warning: vertex layout has UV, but file hasn't\n";
-				}
+		LOG_DEBUG("Primitives: %zu", mesh.primitives.size());
+		for (const auto& primitive :  mesh.primitives) {
+			if (primitive.indices < 0) {
+				continue;
 			}
+
+			AccessorReader bufferPos = attribute(primitive.position, VD->Position, "position");
+			AccessorReader bufferNormals = attribute(primitive.normal, VD->Normal, "normal");
+			AccessorReader bufferTangents = attribute(primitive.tangent, VD->Tangent, "tangent");
+			AccessorReader bufferTexCoords = attribute(primitive.texCoord0, VD->UV, "UV");
+			size_t cntTot = std::max({bufferPos.count, bufferNormals.count, bufferTangents.count, bufferTexCoords.count});
+
+			// Float positions are used as they are, like before; quantized ones need the node transform
+			bool dequantize = bufferPos.count > 0 && !bufferPos.isFloat();
 			
-			for(int i = 0; i < cntTot; i++) {
+			for(size_t i = 0; i < cntTot; i++) {
 				Vert vertex{};
 				
-				if((i < cntPos) && meshHasPos && VD->Position.hasIt) {
-					glm::vec3 pos = {
-						bufferPos[3 * i + 0],
-						bufferPos[3 * i + 1],
-						bufferPos[3 * i + 2]
-					};
-					glm::vec3 *o = (glm::vec3 *)((char*)(&vertex) + VD->Position.offset);
-					*o = pos;
+				if(VD->Position.hasIt) {
+					glm::vec3 pos = i < bufferPos.count ? glm::vec3(bufferPos[i]) : glm::vec3(0.0f);
+					if(dequantize) {
+						pos = glm::vec3(nodeTransform * glm::vec4(pos, 1.0f));
+					}
+					storePosition(vertex, pos);
 				}
 	
-				if((i < cntNorm) && meshHasNorm && VD->Normal.hasIt) {
-					glm::vec3 normal = {
-						bufferNormals[3 * i + 0],
-						bufferNormals[3 * i + 1],
-						bufferNormals[3 * i + 2]
-					};
-					glm::vec3 *o = (glm::vec3 *)((char*)(&vertex) + VD->Normal.offset);
-					*o = normal;
+				if((i < bufferNormals.count) && VD->Normal.hasIt) {
+					glm::vec3 normal = glm::vec3(bufferNormals[i]);
+					if(dequantize) {
+						normal = glm::normalize(nodeNormalTransform * normal);
+					}
+					VD->Normal.store(&vertex, glm::vec4(normal, 0.0f));
 				}
 
-				if((i < cntTan) && meshHasTan && VD->Tangent.hasIt) {
-					glm::vec4 tangent = {
-						bufferTangents[4 * i + 0],
-						bufferTangents[4 * i + 1],
-						bufferTangents[4 * i + 2],
-						bufferTangents[4 * i + 3]
-					};
-					glm::vec4 *o = (glm::vec4 *)((char*)(&vertex) + VD->Tangent.offset);
-					*o = tangent;
+				if((i < bufferTangents.count) && VD->Tangent.hasIt) {
+					glm::vec4 tangent = bufferTangents[i];
+					if(dequantize) {
+						tangent = glm::vec4(glm::normalize(glm::mat3(nodeTransform) * glm::vec3(tangent)), tangent.w);
+					}
+					VD->Tangent.store(&vertex, tangent);
 				}
 				
-				if((i < cntUV) && meshHasUV && VD->UV.hasIt) {
-					glm::vec2 texCoord = {
-						bufferTexCoords[2 * i + 0],
-						bufferTexCoords[2 * i + 1] 
-					};
-					glm::vec2 *o = (glm::vec2 *)((char*)(&vertex) + VD->UV.offset);
-					*o = texCoord;
+				if((i < bufferTexCoords.count) && VD->UV.hasIt) {
+					VD->UV.store(&vertex, bufferTexCoords[i]);
 				}
 
 				vertices.push_back(vertex);					
 			} 
-
-			const tinygltf::Accessor &accessor = model.accessors[primitive.indices];
-			const tinygltf::BufferView &bufferView = model.bufferViews[accessor.bufferView];
-			const tinygltf::Buffer &buffer = model.buffers[bufferView.buffer];
+			AccessorReader bufferIndices(doc, primitive.indices);
 			
-			switch(accessor.componentType) {
-				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
+			switch(bufferIndices.componentType) {
+				case GLTF_UNSIGNED_BYTE:
 					{
-						const uint16_t *bufferIndex = reinterpret_cast<const uint16_t *>(&(buffer.data[accessor.byteOffset + bufferView.byteOffset]));
-						for(int i = 0; i < accessor.count; i++) {
+						const uint8_t *bufferIndex = bufferIndices.data;
+						for(size_t i = 0; i < bufferIndices.count; i++) {
 							indices.push_back(bufferIndex[i]);
 						}
 					}
 					break;
-				case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
+				case GLTF_UNSIGNED_SHORT:
 					{
-						const uint32_t *bufferIndex = reinterpret_cast<const uint32_t *>(&(buffer.data[accessor.byteOffset + bufferView.byteOffset]));
-						for(int i = 0; i < accessor.count; i++) {
+						const uint16_t *bufferIndex = reinterpret_cast<const uint16_t *>(bufferIndices.data);
+						for(size_t i = 0; i < bufferIndices.count; i++) {
+							indices.push_back(bufferIndex[i]);
+						}
+					}
+					break;
+				case GLTF_UNSIGNED_INT:
+					{
+						const uint32_t *bufferIndex = reinterpret_cast<const uint32_t *>(bufferIndices.data);
+						for(size_t i = 0; i < bufferIndices.count; i++) {
 							indices.push_back(bufferIndex[i]);
 						}
 					}
 					break;
 				default:
-					std::cerr << "Index component type " << accessor.componentType << " not supported!" << std::endl;
+					LOG_ERROR("Index component type %d not supported!", bufferIndices.componentType);
 					throw std::runtime_error("Error loading GLTF component");			
 			}
 		}
 	}
 
-	std::cout << (encoded ? "[MGCG]" : "[GLTF]") << " Vertices: " << vertices.size()
-			  << "\nIndices: " << indices.size() << "\n";
+	LOG_INFO("%s Vertices: %zu, Indices: %zu", label, vertices.size(), indices.size());
+}
+
+template <class Vert>
+void Model<Vert>::storePosition(Vert &vertex, glm::vec3 pos) {
+	if(VD->Position.format == VK_FORMAT_R32G32B32_SFLOAT) {
+		VD->Position.store(&vertex, glm::vec4(pos, 1.0f));
+	} else {
+		// Written by quantizePositions, once the bounds of the model are known
+		quantizedPositions.push_back(pos);
+	}
+}
+
+template <class Vert>
+void Model<Vert>::quantizePositions() {
+	if(quantizedPositions.empty()) {
+		return;
+	}
+	glm::vec3 lo = quantizedPositions[0], hi = quantizedPositions[0];
+	for(const glm::vec3 &pos : quantizedPositions) {
+		lo = glm::min(lo, pos);
+		hi = glm::max(hi, pos);
+	}
+	glm::vec3 center = (lo + hi) * 0.5f;
+	glm::vec3 extent = glm::max((hi - lo) * 0.5f, glm::vec3(1e-6f));
+	dequantization = glm::translate(glm::mat4(1.0f), center) * glm::scale(glm::mat4(1.0f), extent);
+
+	for(size_t i = 0; i < vertices.size(); i++) {
+		VD->Position.store(&vertices[i], glm::vec4((quantizedPositions[i] - center) / extent, 1.0f));
+	}
+	quantizedPositions.clear();
+	quantizedPositions.shrink_to_fit();
 }
 
 template <class Vert>
@@ -733,7 +948,8 @@ void Model<Vert>::createVertexBuffer() {
 	BP->createBuffer(bufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 
 						VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
 						VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-						vertexBuffer, vertexBufferMemory);
+						vertexBuffer, vertexBufferMemory, MEMORY_MESH, name);
+	BP->setObjectName(VK_OBJECT_TYPE_BUFFER, vertexBuffer, name + " vertices");
 
 	void* data;
 	vkMapMemory(BP->device, vertexBufferMemory, 0, bufferSize, 0, &data);
@@ -743,16 +959,29 @@ void Model<Vert>::createVertexBuffer() {
 
 template <class Vert>
 void Model<Vert>::createIndexBuffer() {
-	VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
+	// 16-bit indices whenever they can address every vertex: half the memory and the index fetch bandwidth
+	indexType = vertices.size() <= 65536 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+	indexCount = static_cast<uint32_t>(indices.size());
+	VkDeviceSize indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	VkDeviceSize bufferSize = indexSize * indices.size();
 
 	BP->createBuffer(bufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
 							 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
 							 VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-							 indexBuffer, indexBufferMemory);
+							 indexBuffer, indexBufferMemory, MEMORY_MESH, name);
+	BP->setObjectName(VK_OBJECT_TYPE_BUFFER, indexBuffer, name + " indices");
 
 	void* data;
 	vkMapMemory(BP->device, indexBufferMemory, 0, bufferSize, 0, &data);
-	memcpy(data, indices.data(), (size_t) bufferSize);
+	if(indexType == VK_INDEX_TYPE_UINT16) {
+		uint16_t *shortIndices = static_cast<uint16_t *>(data);
+		for(size_t i = 0; i < indices.size(); i++) {
+			shortIndices[i] = static_cast<uint16_t>(indices[i]);
+		}
+		BP->indexBytesSaved += (sizeof(uint32_t) - sizeof(uint16_t)) * indices.size();
+	} else {
+		memcpy(data, indices.data(), (size_t) bufferSize);
+	}
 	vkUnmapMemory(BP->device, indexBufferMemory);
 }
 
@@ -760,34 +989,68 @@ template <class Vert>
 void Model<Vert>::initMesh(BaseProject *bp, VertexDescriptor *vd) {
 	BP = bp;
 	VD = vd;
-	std::cout << "[Manual] Vertices: " << vertices.size()
-			  << "\nIndices: " << indices.size() << "\n";
+	name = "[Manual]";
+	LOG_INFO("[Manual] Vertices: %zu, Indices: %zu", vertices.size(), indices.size());
+	meshKey.clear();
 	createVertexBuffer();
 	createIndexBuffer();
 }
 
 template <class Vert>
-void Model<Vert>::init(BaseProject *bp, VertexDescriptor *vd, std::string file, ModelType MT) {
-	BP = bp;
+void Model<Vert>::load(VertexDescriptor *vd, std::string file, ModelType MT) {
 	VD = vd;
+	name = file;
 	if(MT == OBJ) {
 		loadModelOBJ(file);
-	} else if(MT == GLTF) {
-		loadModelGLTF(file, false);
-	} else if(MT == MGCG) {
-		loadModelGLTF(file, true);
+	} else {
+		loadModelGLTF(file, MT);
 	}
-	
+	quantizePositions();
+}
+
+template <class Vert>
+void Model<Vert>::init(BaseProject *bp, VertexDescriptor *vd, std::string file, ModelType MT) {
+	PROFILE_SCOPE(&bp->profiler, "Model::init");
+	BP = bp;
+	meshKey = "model:" + file + ":" + std::to_string(MT) + ":" + typeid(Vert).name() + ":" +
+		std::to_string(reinterpret_cast<uintptr_t>(vd));
+	SharedMesh shared;
+	if (ResourceRegistry::instance().acquire(meshKey, shared)) {
+		VD = vd;
+		name = file;
+		vertexBuffer = shared.vertexBuffer;
+		vertexBufferMemory = shared.vertexBufferMemory;
+		indexBuffer = shared.indexBuffer;
+		indexBufferMemory = shared.indexBufferMemory;
+		indexType = shared.indexType;
+		indexCount = shared.indexCount;
+		dequantization = shared.dequantization;
+		LOG_INFO("Loading : %s (shared)", file.c_str());
+		return;
+	}
+
+	load(vd, file, MT);
 	createVertexBuffer();
 	createIndexBuffer();
+	SharedMesh mesh{ vertexBuffer, vertexBufferMemory, indexBuffer, indexBufferMemory, indexType, indexCount, dequantization };
+	ResourceRegistry::instance().add(meshKey, mesh, [bp, mesh]() {
+		vkDestroyBuffer(bp->device, mesh.indexBuffer, nullptr);
+		bp->freeMemory(mesh.indexBufferMemory);
+		vkDestroyBuffer(bp->device, mesh.vertexBuffer, nullptr);
+		bp->freeMemory(mesh.vertexBufferMemory);
+	});
 }
 
 template <class Vert>
 void Model<Vert>::cleanup() {
+	// A shared mesh is destroyed by the registry, when the last model using it releases it
+	if (!meshKey.empty() && ResourceRegistry::instance().release(meshKey)) {
+		return;
+	}
    	vkDestroyBuffer(BP->device, indexBuffer, nullptr);
-   	vkFreeMemory(BP->device, indexBufferMemory, nullptr);
+   	BP->freeMemory(indexBufferMemory);
 	vkDestroyBuffer(BP->device, vertexBuffer, nullptr);
-   	vkFreeMemory(BP->device, vertexBufferMemory, nullptr);
+   	BP->freeMemory(vertexBufferMemory);
 }
 
 template <class Vert>
@@ -797,6 +1060,11 @@ void Model<Vert>::bind(VkCommandBuffer commandBuffer) {
 	VkDeviceSize offsets[] = {0};
 	vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
 	// property .indexBuffer of models, contains the VkBuffer handle to its index buffer
-	vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0,
-							VK_INDEX_TYPE_UINT32);
+	vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indexType);
+}
+
+template <class Vert>
+void Model<Vert>::draw(VkCommandBuffer commandBuffer) {
+	vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+	BP->drawCalls++;
 }
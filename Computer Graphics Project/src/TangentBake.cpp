@@ -0,0 +1,334 @@
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "TangentBake.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define TANGENT_BAKE_SSE
+#endif
+
+#include "Starter.hpp"
+
+namespace {
+
+const float EPSILON = 1e-20f;
+
+// v without its component along the unit vector n, normalized (zero if nothing is left)
+glm::vec3 projectOnPlane(glm::vec3 v, glm::vec3 n) {
+	v -= n * glm::dot(n, v);
+	float length2 = glm::dot(v, v);
+	return length2 > EPSILON ? v / std::sqrt(length2) : glm::vec3(0.0f);
+}
+
+// Images are neither decoded nor written back: the bake only touches the meshes
+bool keepImage(tinygltf::Image*, const int, std::string*, std::string*, int, int, const unsigned char*, int, void*) {
+	return true;
+}
+
+bool keepImageFile(const std::string*, const std::string*, tinygltf::Image*, bool, void*) {
+	return true;
+}
+
+// Append bytes to the first buffer as a new buffer view, 4-byte aligned; returns the view
+int appendView(tinygltf::Model& model, const void* bytes, size_t size, int target) {
+	if (model.buffers.empty()) {
+		model.buffers.emplace_back();
+	}
+	std::vector<unsigned char>& data = model.buffers[0].data;
+	size_t offset = (data.size() + 3) & ~static_cast<size_t>(3);
+	data.resize(offset + size);
+	memcpy(&data[offset], bytes, size);
+
+	tinygltf::BufferView view;
+	view.buffer = 0;
+	view.byteOffset = offset;
+	view.byteLength = size;
+	view.target = target;
+	model.bufferViews.push_back(view);
+	return static_cast<int>(model.bufferViews.size()) - 1;
+}
+
+// Copy of a vertex attribute with the elements of the vertices in splitFrom appended, tightly packed in a new view;
+// returns the new accessor. The old one is left in the file, unused
+int extendAttribute(tinygltf::Model& model, int accessorIndex, const std::vector<uint32_t>& splitFrom) {
+	tinygltf::Accessor accessor = model.accessors[accessorIndex];
+	const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
+	size_t elementSize = tinygltf::GetComponentSizeInBytes(accessor.componentType) *
+		tinygltf::GetNumComponentsInType(accessor.type);
+	size_t stride = accessor.ByteStride(view);
+	const unsigned char* source = model.buffers[view.buffer].data.data() + view.byteOffset + accessor.byteOffset;
+
+	std::vector<unsigned char> bytes((accessor.count + splitFrom.size()) * elementSize);
+	for (size_t i = 0; i < accessor.count; i++) {
+		memcpy(&bytes[i * elementSize], source + i * stride, elementSize);
+	}
+	for (size_t i = 0; i < splitFrom.size(); i++) {
+		memcpy(&bytes[(accessor.count + i) * elementSize], source + splitFrom[i] * stride, elementSize);
+	}
+
+	accessor.bufferView = appendView(model, bytes.data(), bytes.size(), TINYGLTF_TARGET_ARRAY_BUFFER);
+	accessor.byteOffset = 0;
+	accessor.count += splitFrom.size();
+	model.accessors.push_back(accessor);
+	return static_cast<int>(model.accessors.size()) - 1;
+}
+
+}
+
+void computeTangents(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals,
+					 const std::vector<glm::vec2>& uvs, std::vector<uint32_t>& indices,
+					 std::vector<glm::vec4>& tangents, std::vector<uint32_t>& splitFrom, JobSystem* jobs) {
+	const size_t originalCount = positions.size();
+	const int triangleCount = static_cast<int>(indices.size() / 3);
+	auto parallelFor = [&](const char* name, int count, int grain, const std::function<void(int, int)>& fn) {
+		if (jobs != nullptr) {
+			jobs->parallelFor(name, 0, count, grain, fn);
+		} else if (count > 0) {
+			fn(0, count);
+		}
+	};
+
+	// What every corner adds to its vertex: the tangent of the triangle at the vertex times the angle of the corner,
+	// and in w the same angle, negative if the triangle is mirrored in UV space. Degenerate triangles add nothing.
+	std::vector<float> corners(indices.size() * 4, 0.0f);
+	parallelFor("tangentCorners", triangleCount, 1024, [&](int begin, int end) {
+		for (int t = begin; t < end; t++) {
+			const uint32_t* tri = &indices[3 * t];
+			if (tri[0] >= originalCount || tri[1] >= originalCount || tri[2] >= originalCount) {
+				continue;
+			}
+			glm::vec3 d1 = positions[tri[1]] - positions[tri[0]];
+			glm::vec3 d2 = positions[tri[2]] - positions[tri[0]];
+			glm::vec2 st1 = uvs[tri[1]] - uvs[tri[0]];
+			glm::vec2 st2 = uvs[tri[2]] - uvs[tri[0]];
+			float signedArea = st1.x * st2.y - st1.y * st2.x;
+			float orientation = signedArea > 0.0f ? 1.0f : -1.0f;
+			glm::vec3 faceTangent = (st2.y * d1 - st1.y * d2) * orientation;
+			if (std::fabs(signedArea) <= EPSILON || glm::dot(faceTangent, faceTangent) <= EPSILON) {
+				continue;
+			}
+
+			for (int k = 0; k < 3; k++) {
+				uint32_t v = tri[k];
+				glm::vec3 n = glm::normalize(normals[v]);
+				glm::vec3 tangent = projectOnPlane(faceTangent, n);
+				glm::vec3 e1 = projectOnPlane(positions[tri[(k + 1) % 3]] - positions[v], n);
+				glm::vec3 e2 = projectOnPlane(positions[tri[(k + 2) % 3]] - positions[v], n);
+				float angle = std::acos(glm::clamp(glm::dot(e1, e2), -1.0f, 1.0f));
+
+				float* c = &corners[4 * (3 * static_cast<size_t>(t) + k)];
+				c[0] = tangent.x * angle;
+				c[1] = tangent.y * angle;
+				c[2] = tangent.z * angle;
+				c[3] = orientation * angle;
+			}
+		}
+	});
+
+	// Split the vertices with corners of both orientations: the weight of each side decides which one keeps the vertex
+	splitFrom.clear();
+	std::vector<float> mirrored(originalCount, 0.0f), unmirrored(originalCount, 0.0f);
+	for (size_t c = 0; c < indices.size(); c++) {
+		if (indices[c] < originalCount) {
+			float w = corners[4 * c + 3];
+			(w < 0.0f ? mirrored : unmirrored)[indices[c]] += std::fabs(w);
+		}
+	}
+	std::vector<uint32_t> copyOf(originalCount, UINT32_MAX);
+	for (size_t c = 0; c < indices.size(); c++) {
+		uint32_t v = indices[c];
+		float w = corners[4 * c + 3];
+		if (v >= originalCount || w == 0.0f || mirrored[v] == 0.0f || unmirrored[v] == 0.0f ||
+			(w < 0.0f) == (mirrored[v] > unmirrored[v])) {
+			continue;
+		}
+		if (copyOf[v] == UINT32_MAX) {
+			copyOf[v] = static_cast<uint32_t>(originalCount + splitFrom.size());
+			splitFrom.push_back(v);
+		}
+		indices[c] = copyOf[v];
+	}
+	const size_t vertexCount = originalCount + splitFrom.size();
+	auto normalOf = [&](size_t v) {
+		return glm::normalize(normals[v < originalCount ? v : splitFrom[v - originalCount]]);
+	};
+
+	// The corners of every vertex, grouped by a counting sort on the indices
+	std::vector<uint32_t> first(vertexCount + 1, 0);
+	for (uint32_t v : indices) {
+		if (v < vertexCount) {
+			first[v + 1]++;
+		}
+	}
+	for (size_t v = 0; v < vertexCount; v++) {
+		first[v + 1] += first[v];
+	}
+	std::vector<uint32_t> cornersOf(first[vertexCount]);
+	std::vector<uint32_t> next(first.begin(), first.end() - 1);
+	for (size_t c = 0; c < indices.size(); c++) {
+		if (indices[c] < vertexCount) {
+			cornersOf[next[indices[c]]++] = static_cast<uint32_t>(c);
+		}
+	}
+
+	// Sum per vertex, four lanes at a time, then back on the tangent plane of the vertex
+	tangents.resize(vertexCount);
+	parallelFor("tangentVertices", static_cast<int>(vertexCount), 1024, [&](int begin, int end) {
+		for (int v = begin; v < end; v++) {
+			alignas(16) float sum[4];
+#ifdef TANGENT_BAKE_SSE
+			__m128 acc = _mm_setzero_ps();
+			for (uint32_t i = first[v]; i < first[v + 1]; i++) {
+				acc = _mm_add_ps(acc, _mm_loadu_ps(&corners[4 * static_cast<size_t>(cornersOf[i])]));
+			}
+			_mm_store_ps(sum, acc);
+#else
+			sum[0] = sum[1] = sum[2] = sum[3] = 0.0f;
+			for (uint32_t i = first[v]; i < first[v + 1]; i++) {
+				const float* c = &corners[4 * static_cast<size_t>(cornersOf[i])];
+				for (int k = 0; k < 4; k++) {
+					sum[k] += c[k];
+				}
+			}
+#endif
+			glm::vec3 n = normalOf(v);
+			glm::vec3 tangent = projectOnPlane(glm::vec3(sum[0], sum[1], sum[2]), n);
+			if (tangent == glm::vec3(0.0f)) {
+				// No usable triangle: any direction of the tangent plane
+				tangent = projectOnPlane(std::fabs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f), n);
+			}
+			// glTF UVs grow downwards in v, so a triangle that is counter-clockwise in UV space is left-handed
+			tangents[v] = glm::vec4(tangent, sum[3] < 0.0f ? 1.0f : -1.0f);
+		}
+	});
+}
+
+void bakeTangents(const std::vector<std::string>& files, JobSystem* jobs, std::ostream& out) {
+	for (const std::string& file : files) {
+		auto start = std::chrono::steady_clock::now();
+		bool binary = file.size() >= 4 && file.compare(file.size() - 4, 4, ".glb") == 0;
+
+		tinygltf::Model model;
+		tinygltf::TinyGLTF loader;
+		std::string warn, err;
+		loader.SetImageLoader(keepImage, nullptr);
+		loader.SetImageWriter(keepImageFile, nullptr);
+		bool loaded = binary ? loader.LoadBinaryFromFile(&model, &err, &warn, file) :
+			loader.LoadASCIIFromFile(&model, &err, &warn, file);
+		if (!loaded) {
+			LOG_ERROR("Failed to open: %s", file.c_str());
+			throw std::runtime_error(warn + err);
+		}
+
+		// Tangents of the primitives that lack them, computed before the buffer grows under the readers
+		struct Baked {
+			int mesh;
+			int primitive;
+			std::vector<glm::vec4> tangents;
+			std::vector<uint32_t> indices;
+			std::vector<uint32_t> splitFrom;
+		};
+		std::vector<Baked> baked;
+		size_t vertexCount = 0, splitCount = 0;
+		GltfDocument doc = gltfDocumentFromTinygltf(model, nullptr, 0);
+		for (int m = 0; m < static_cast<int>(doc.meshes.size()); m++) {
+			for (int p = 0; p < static_cast<int>(doc.meshes[m].primitives.size()); p++) {
+				const GltfPrimitive& primitive = doc.meshes[m].primitives[p];
+				if (primitive.tangent >= 0) {
+					continue;
+				}
+				if (primitive.position < 0 || primitive.normal < 0 || primitive.texCoord0 < 0 || primitive.indices < 0) {
+					LOG_WARN("%s: mesh %d primitive %d has no normals, UVs or indices, tangents not baked", file.c_str(), m, p);
+					continue;
+				}
+				AccessorReader positionReader(doc, primitive.position);
+				AccessorReader normalReader(doc, primitive.normal);
+				AccessorReader uvReader(doc, primitive.texCoord0);
+				AccessorReader indexReader(doc, primitive.indices);
+				if (normalReader.count != positionReader.count || uvReader.count != positionReader.count) {
+					LOG_WARN("%s: mesh %d primitive %d has attributes of different sizes, tangents not baked", file.c_str(), m, p);
+					continue;
+				}
+				// Split vertices would need copies in every morph target and sparse accessor too
+				const tinygltf::Primitive& source = model.meshes[m].primitives[p];
+				bool sparse = false;
+				for (const auto& [name, accessor] : source.attributes) {
+					sparse = sparse || model.accessors[accessor].sparse.isSparse;
+				}
+				if (!source.targets.empty() || sparse) {
+					LOG_WARN("%s: mesh %d primitive %d has morph targets or sparse attributes, tangents not baked", file.c_str(), m, p);
+					continue;
+				}
+
+				std::vector<glm::vec3> positions(positionReader.count), normals(positionReader.count);
+				std::vector<glm::vec2> uvs(positionReader.count);
+				std::vector<uint32_t> indices(indexReader.count);
+				for (size_t i = 0; i < positionReader.count; i++) {
+					positions[i] = glm::vec3(positionReader[i]);
+					normals[i] = glm::vec3(normalReader[i]);
+					uvs[i] = glm::vec2(uvReader[i]);
+				}
+				for (size_t i = 0; i < indexReader.count; i++) {
+					indices[i] = indexReader.index(i);
+				}
+
+				baked.push_back({ m, p, {}, std::move(indices), {} });
+				Baked& b = baked.back();
+				computeTangents(positions, normals, uvs, b.indices, b.tangents, b.splitFrom, jobs);
+				vertexCount += positions.size();
+				splitCount += b.splitFrom.size();
+			}
+		}
+		if (baked.empty()) {
+			out << file << ": no tangents to bake\n";
+			continue;
+		}
+
+		// One buffer view and accessor per primitive, at the end of the first buffer
+		for (const Baked& b : baked) {
+			tinygltf::Primitive& primitive = model.meshes[b.mesh].primitives[b.primitive];
+
+			// Split vertices: every attribute gets the copies, the indices point to them
+			if (!b.splitFrom.empty()) {
+				for (auto& [name, accessor] : primitive.attributes) {
+					accessor = extendAttribute(model, accessor, b.splitFrom);
+				}
+				tinygltf::Accessor indexAccessor;
+				indexAccessor.bufferView = appendView(model, b.indices.data(), b.indices.size() * sizeof(uint32_t),
+					TINYGLTF_TARGET_ELEMENT_ARRAY_BUFFER);
+				indexAccessor.componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
+				indexAccessor.type = TINYGLTF_TYPE_SCALAR;
+				indexAccessor.count = b.indices.size();
+				model.accessors.push_back(indexAccessor);
+				primitive.indices = static_cast<int>(model.accessors.size()) - 1;
+			}
+
+			std::vector<float> t(b.tangents.size() * 4);
+			for (size_t i = 0; i < b.tangents.size(); i++) {
+				memcpy(&t[i * 4], &b.tangents[i], 4 * sizeof(float));
+			}
+			tinygltf::Accessor accessor;
+			accessor.bufferView = appendView(model, t.data(), t.size() * sizeof(float), TINYGLTF_TARGET_ARRAY_BUFFER);
+			accessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+			accessor.type = TINYGLTF_TYPE_VEC4;
+			accessor.count = b.tangents.size();
+			model.accessors.push_back(accessor);
+			primitive.attributes["TANGENT"] = static_cast<int>(model.accessors.size()) - 1;
+		}
+
+		if (!loader.WriteGltfSceneToFile(&model, file, false, false, !binary, binary)) {
+			LOG_ERROR("Failed to write: %s", file.c_str());
+			throw std::runtime_error("failed to write baked glTF!");
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		out << file << ": tangents of " << baked.size() << " primitives (" << vertexCount << " vertices, "
+			<< splitCount << " split on UV mirror seams) baked in " << std::fixed << std::setprecision(1) << ms << " ms\n";
+	}
+}
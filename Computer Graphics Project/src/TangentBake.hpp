@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+class JobSystem;
+
+// Angle-weighted tangents of an indexed triangle mesh, in the spirit of MikkTSpace (not bit-exact with it): at every
+// corner the tangent of the triangle (the direction of increasing u) is projected on the tangent plane of the vertex
+// normal and weighted by the angle of the corner; w is the handedness in the glTF convention (bitangent =
+// cross(N, T) * w, with v growing downwards in the texture), which is what the exported models ship.
+// Vertices are not welded: the glTF vertices are already unique per position, normal and UV. A vertex shared by
+// triangles mirrored in UV space (a seam of a mirrored texture) is split instead, as a single tangent cannot serve
+// both sides: the corners of the lighter orientation move to a copy of the vertex, appended after the others.
+// indices is updated, splitFrom receives the vertex each copy was made from, tangents covers the copies too.
+// The corners are evaluated in parallel on jobs (if given) and gathered per vertex with SIMD adds.
+void computeTangents(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& normals,
+					 const std::vector<glm::vec2>& uvs, std::vector<uint32_t>& indices,
+					 std::vector<glm::vec4>& tangents, std::vector<uint32_t>& splitFrom, JobSystem* jobs);
+
+// Add TANGENT to the primitives of the .gltf/.glb files that have normals and UVs but no tangents, rewriting the files
+// (and their .bin) in place, so that the loader just reads them; prints a line per file to out
+void bakeTangents(const std::vector<std::string>& files, JobSystem* jobs, std::ostream& out);
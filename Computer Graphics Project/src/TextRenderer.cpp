@@ -0,0 +1,351 @@
+#include "TextRenderer.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// 5x7 font, ASCII 32 to 126: one byte per column, bit 0 is the top row
+const uint8_t FONT_5X7[95 * 5] = {
+	0x00, 0x00, 0x00, 0x00, 0x00,	// space
+	0x00, 0x00, 0x5F, 0x00, 0x00,	// !
+	0x00, 0x07, 0x00, 0x07, 0x00,	// "
+	0x14, 0x7F, 0x14, 0x7F, 0x14,	// #
+	0x24, 0x2A, 0x7F, 0x2A, 0x12,	// $
+	0x23, 0x13, 0x08, 0x64, 0x62,	// %
+	0x36, 0x49, 0x55, 0x22, 0x50,	// &
+	0x00, 0x05, 0x03, 0x00, 0x00,	// '
+	0x00, 0x1C, 0x22, 0x41, 0x00,	// (
+	0x00, 0x41, 0x22, 0x1C, 0x00,	// )
+	0x14, 0x08, 0x3E, 0x08, 0x14,	// *
+	0x08, 0x08, 0x3E, 0x08, 0x08,	// +
+	0x00, 0x50, 0x30, 0x00, 0x00,	// ,
+	0x08, 0x08, 0x08, 0x08, 0x08,	// -
+	0x00, 0x60, 0x60, 0x00, 0x00,	// .
+	0x20, 0x10, 0x08, 0x04, 0x02,	// /
+	0x3E, 0x51, 0x49, 0x45, 0x3E,	// 0
+	0x00, 0x42, 0x7F, 0x40, 0x00,	// 1
+	0x42, 0x61, 0x51, 0x49, 0x46,	// 2
+	0x21, 0x41, 0x45, 0x4B, 0x31,	// 3
+	0x18, 0x14, 0x12, 0x7F, 0x10,	// 4
+	0x27, 0x45, 0x45, 0x45, 0x39,	// 5
+	0x3C, 0x4A, 0x49, 0x49, 0x30,	// 6
+	0x01, 0x71, 0x09, 0x05, 0x03,	// 7
+	0x36, 0x49, 0x49, 0x49, 0x36,	// 8
+	0x06, 0x49, 0x49, 0x29, 0x1E,	// 9
+	0x00, 0x36, 0x36, 0x00, 0x00,	// :
+	0x00, 0x56, 0x36, 0x00, 0x00,	// ;
+	0x08, 0x14, 0x22, 0x41, 0x00,	// <
+	0x14, 0x14, 0x14, 0x14, 0x14,	// =
+	0x00, 0x41, 0x22, 0x14, 0x08,	// >
+	0x02, 0x01, 0x51, 0x09, 0x06,	// ?
+	0x32, 0x49, 0x79, 0x41, 0x3E,	// @
+	0x7E, 0x11, 0x11, 0x11, 0x7E,	// A
+	0x7F, 0x49, 0x49, 0x49, 0x36,	// B
+	0x3E, 0x41, 0x41, 0x41, 0x22,	// C
+	0x7F, 0x41, 0x41, 0x22, 0x1C,	// D
+	0x7F, 0x49, 0x49, 0x49, 0x41,	// E
+	0x7F, 0x09, 0x09, 0x09, 0x01,	// F
+	0x3E, 0x41, 0x49, 0x49, 0x7A,	// G
+	0x7F, 0x08, 0x08, 0x08, 0x7F,	// H
+	0x00, 0x41, 0x7F, 0x41, 0x00,	// I
+	0x20, 0x40, 0x41, 0x3F, 0x01,	// J
+	0x7F, 0x08, 0x14, 0x22, 0x41,	// K
+	0x7F, 0x40, 0x40, 0x40, 0x40,	// L
+	0x7F, 0x02, 0x0C, 0x02, 0x7F,	// M
+	0x7F, 0x04, 0x08, 0x10, 0x7F,	// N
+	0x3E, 0x41, 0x41, 0x41, 0x3E,	// O
+	0x7F, 0x09, 0x09, 0x09, 0x06,	// P
+	0x3E, 0x41, 0x51, 0x21, 0x5E,	// Q
+	0x7F, 0x09, 0x19, 0x29, 0x46,	// R
+	0x46, 0x49, 0x49, 0x49, 0x31,	// S
+	0x01, 0x01, 0x7F, 0x01, 0x01,	// T
+	0x3F, 0x40, 0x40, 0x40, 0x3F,	// U
+	0x1F, 0x20, 0x40, 0x20, 0x1F,	// V
+	0x3F, 0x40, 0x38, 0x40, 0x3F,	// W
+	0x63, 0x14, 0x08, 0x14, 0x63,	// X
+	0x07, 0x08, 0x70, 0x08, 0x07,	// Y
+	0x61, 0x51, 0x49, 0x45, 0x43,	// Z
+	0x00, 0x7F, 0x41, 0x41, 0x00,	// [
+	0x02, 0x04, 0x08, 0x10, 0x20,	// backslash
+	0x00, 0x41, 0x41, 0x7F, 0x00,	// ]
+	0x04, 0x02, 0x01, 0x02, 0x04,	// ^
+	0x40, 0x40, 0x40, 0x40, 0x40,	// _
+	0x00, 0x01, 0x02, 0x04, 0x00,	// `
+	0x20, 0x54, 0x54, 0x54, 0x78,	// a
+	0x7F, 0x48, 0x44, 0x44, 0x38,	// b
+	0x38, 0x44, 0x44, 0x44, 0x20,	// c
+	0x38, 0x44, 0x44, 0x48, 0x7F,	// d
+	0x38, 0x54, 0x54, 0x54, 0x18,	// e
+	0x08, 0x7E, 0x09, 0x01, 0x02,	// f
+	0x0C, 0x52, 0x52, 0x52, 0x3E,	// g
+	0x7F, 0x08, 0x04, 0x04, 0x78,	// h
+	0x00, 0x44, 0x7D, 0x40, 0x00,	// i
+	0x20, 0x40, 0x44, 0x3D, 0x00,	// j
+	0x7F, 0x10, 0x28, 0x44, 0x00,	// k
+	0x00, 0x41, 0x7F, 0x40, 0x00,	// l
+	0x7C, 0x04, 0x18, 0x04, 0x78,	// m
+	0x7C, 0x08, 0x04, 0x04, 0x78,	// n
+	0x38, 0x44, 0x44, 0x44, 0x38,	// o
+	0x7C, 0x14, 0x14, 0x14, 0x08,	// p
+	0x08, 0x14, 0x14, 0x18, 0x7C,	// q
+	0x7C, 0x08, 0x04, 0x04, 0x08,	// r
+	0x48, 0x54, 0x54, 0x54, 0x20,	// s
+	0x04, 0x3F, 0x44, 0x40, 0x20,	// t
+	0x3C, 0x40, 0x40, 0x20, 0x7C,	// u
+	0x1C, 0x20, 0x40, 0x20, 0x1C,	// v
+	0x3C, 0x40, 0x30, 0x40, 0x3C,	// w
+	0x44, 0x28, 0x10, 0x28, 0x44,	// x
+	0x0C, 0x50, 0x50, 0x50, 0x3C,	// y
+	0x44, 0x64, 0x54, 0x4C, 0x44,	// z
+	0x00, 0x08, 0x36, 0x41, 0x00,	// {
+	0x00, 0x00, 0x7F, 0x00, 0x00,	// |
+	0x00, 0x41, 0x36, 0x08, 0x00,	// }
+	0x08, 0x04, 0x08, 0x10, 0x08,	// ~
+};
+
+const int FIRST_CHAR = 32;
+const int GLYPHS_NUM = 95;
+const int SOLID_CELL = GLYPHS_NUM;			// one more cell fully inside the field, for the panels
+const int GLYPH_W = 5;
+const int GLYPH_H = 7;
+
+// Font pixels: every cell of the atlas is the glyph with a border wide enough for the distance field
+const float BORDER = 1.5f;
+const float CELL_W = GLYPH_W + 2 * BORDER;
+const float CELL_H = GLYPH_H + 2 * BORDER;
+const float ADVANCE = 6.0f;
+const float LINE_HEIGHT = 10.0f;
+const float SPREAD = 1.5f;					// distance mapped to the whole 0..1 range of the field
+
+// Texels: 16 x 6 cells, 3 texels per font pixel
+const int TEXELS = 3;
+const int CELLS_X = 16;
+const int CELL_TEXELS_W = static_cast<int>(CELL_W) * TEXELS;
+const int CELL_TEXELS_H = static_cast<int>(CELL_H) * TEXELS;
+const int ATLAS_W = CELLS_X * CELL_TEXELS_W;
+const int ATLAS_H = (GLYPHS_NUM / CELLS_X + 1) * CELL_TEXELS_H;
+
+// The indirect command comes first in the buffer of every image
+const VkDeviceSize VERTICES_OFFSET = sizeof(VkDrawIndirectCommand);
+
+bool fontPixel(int glyph, int x, int y) {
+	if (x < 0 || x >= GLYPH_W || y < 0 || y >= GLYPH_H) {
+		return false;
+	}
+	return (FONT_5X7[glyph * GLYPH_W + x] >> y) & 1;
+}
+
+// Distance from a point to the font pixel (x, y)
+float pixelDistance(float px, float py, int x, int y) {
+	float dx = std::max({ x - px, 0.0f, px - (x + 1) });
+	float dy = std::max({ y - py, 0.0f, py - (y + 1) });
+	return std::sqrt(dx * dx + dy * dy);
+}
+
+// Signed distance of every texel to the outline of its glyph, 0.5 on the outline and growing inside.
+// The font is tiny, so the exact distance to the pixels around is cheap enough to compute at startup
+std::vector<unsigned char> buildAtlas() {
+	std::vector<unsigned char> pixels(ATLAS_W * ATLAS_H, 0);
+	for (int glyph = 0; glyph <= GLYPHS_NUM; glyph++) {
+		int cellX = (glyph % CELLS_X) * CELL_TEXELS_W;
+		int cellY = (glyph / CELLS_X) * CELL_TEXELS_H;
+		for (int ty = 0; ty < CELL_TEXELS_H; ty++) {
+			for (int tx = 0; tx < CELL_TEXELS_W; tx++) {
+				float value = 1.0f;
+				if (glyph != SOLID_CELL) {
+					float px = (tx + 0.5f) / TEXELS - BORDER;
+					float py = (ty + 0.5f) / TEXELS - BORDER;
+					float outside = FLT_MAX, inside = FLT_MAX;
+					for (int y = -1; y <= GLYPH_H; y++) {
+						for (int x = -1; x <= GLYPH_W; x++) {
+							float d = pixelDistance(px, py, x, y);
+							if (fontPixel(glyph, x, y)) {
+								outside = std::min(outside, d);
+							} else {
+								inside = std::min(inside, d);
+							}
+						}
+					}
+					float d = outside > 0.0f ? -outside : inside;
+					value = std::clamp(0.5f + d / (2.0f * SPREAD), 0.0f, 1.0f);
+				}
+				pixels[(cellY + ty) * ATLAS_W + cellX + tx] = static_cast<unsigned char>(std::lround(value * 255.0f));
+			}
+		}
+	}
+	return pixels;
+}
+
+// Texture coordinates of the top left corner of a cell
+glm::vec2 cellUV(int cell) {
+	return glm::vec2(static_cast<float>((cell % CELLS_X) * CELL_TEXELS_W) / ATLAS_W,
+		static_cast<float>((cell / CELLS_X) * CELL_TEXELS_H) / ATLAS_H);
+}
+
+}
+
+void TextRenderer::init(BaseProject* bp) {
+	BP = bp;
+
+	DSL.init(bp, {
+		{0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT}
+	});
+
+	VD.init(bp, {
+		{0, sizeof(VertexText), VK_VERTEX_INPUT_RATE_VERTEX}
+	}, {
+		{0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(VertexText, pos),
+			sizeof(glm::vec2), OTHER},
+		{0, 1, VK_FORMAT_R32G32_SFLOAT, offsetof(VertexText, UV),
+			sizeof(glm::vec2), UV},
+		{0, 2, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(VertexText, color),
+			sizeof(glm::vec4), COLOR}
+	});
+
+	P.init(bp, &VD, "shaders/TextVert.spv", "shaders/TextFrag.spv", { &DSL });
+	P.setAdvancedFeatures(VK_COMPARE_OP_LESS_OR_EQUAL, VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, true);
+
+	std::vector<unsigned char> pixels = buildAtlas();
+	atlas.initPixels(bp, pixels.data(), ATLAS_W, ATLAS_H, 1, VK_FORMAT_R8_UNORM, "font atlas");
+	atlas.createTextureSampler(VK_FILTER_LINEAR, VK_FILTER_LINEAR,
+		VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE, VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+		VK_SAMPLER_MIPMAP_MODE_LINEAR, VK_FALSE, 1.0f, -1);
+
+	vertices.reserve(MAX_QUADS * 6);
+}
+
+void TextRenderer::create() {
+	P.create();
+	DS.init(BP, &DSL, {
+		{0, TEXTURE, 0, &atlas}
+	}, "text overlay");
+
+	size_t images = BP->swapChainImages.size();
+	buffers.resize(images);
+	buffersMemory.resize(images);
+	mapped.resize(images);
+
+	VkDeviceSize size = VERTICES_OFFSET + MAX_QUADS * 6 * sizeof(VertexText);
+	for (size_t i = 0; i < images; i++) {
+		BP->createBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			buffers[i], buffersMemory[i], MEMORY_MESH, "text overlay");
+		// Written every frame, so it stays mapped
+		vkMapMemory(BP->device, buffersMemory[i], 0, size, 0, &mapped[i]);
+
+		// Nothing to draw until the first upload
+		VkDrawIndirectCommand command{ 0, 1, 0, 0 };
+		memcpy(mapped[i], &command, sizeof(command));
+	}
+}
+
+void TextRenderer::cleanup() {
+	P.cleanup();
+	DS.cleanup();
+
+	for (size_t i = 0; i < buffers.size(); i++) {
+		vkUnmapMemory(BP->device, buffersMemory[i]);
+		vkDestroyBuffer(BP->device, buffers[i], nullptr);
+		BP->freeMemory(buffersMemory[i]);
+	}
+	buffers.clear();
+	buffersMemory.clear();
+	mapped.clear();
+}
+
+void TextRenderer::destroy() {
+	atlas.cleanup();
+	DSL.cleanup();
+	P.destroy();
+}
+
+void TextRenderer::draw(VkCommandBuffer commandBuffer, int currentImage) {
+	P.bind(commandBuffer);
+	DS.bind(commandBuffer, P, 0, currentImage);
+
+	VkDeviceSize offsets[] = { VERTICES_OFFSET };
+	vkCmdBindVertexBuffers(commandBuffer, 0, 1, &buffers[currentImage], offsets);
+	vkCmdDrawIndirect(commandBuffer, buffers[currentImage], 0, 1, sizeof(VkDrawIndirectCommand));
+	BP->drawCalls++;
+}
+
+void TextRenderer::begin() {
+	vertices.clear();
+}
+
+void TextRenderer::addText(float x, float y, float size, const glm::vec4& color, const std::string& text) {
+	float k = size / GLYPH_H;		// screen pixels per font pixel
+	glm::vec2 cellSize = glm::vec2(CELL_TEXELS_W, CELL_TEXELS_H) / glm::vec2(ATLAS_W, ATLAS_H);
+	float penX = x;
+	for (char ch : text) {
+		if (ch == '\n') {
+			penX = x;
+			y += LINE_HEIGHT * k;
+			continue;
+		}
+		int glyph = static_cast<unsigned char>(ch) - FIRST_CHAR;
+		if (glyph < 0 || glyph >= GLYPHS_NUM) {
+			glyph = '?' - FIRST_CHAR;
+		}
+		if (glyph != 0) {
+			glm::vec2 uv = cellUV(glyph);
+			float x0 = penX - BORDER * k, y0 = y - BORDER * k;
+			addQuad(x0, y0, x0 + CELL_W * k, y0 + CELL_H * k, uv, uv + cellSize, color);
+		}
+		penX += ADVANCE * k;
+	}
+}
+
+void TextRenderer::addRect(float x, float y, float w, float h, const glm::vec4& color) {
+	// Every corner samples the middle of the solid cell, where the field is 1
+	glm::vec2 uv = cellUV(SOLID_CELL) + glm::vec2(CELL_TEXELS_W, CELL_TEXELS_H) / glm::vec2(2 * ATLAS_W, 2 * ATLAS_H);
+	addQuad(x, y, x + w, y + h, uv, uv, color);
+}
+
+glm::vec2 TextRenderer::measure(float size, const std::string& text) {
+	float k = size / GLYPH_H;
+	int lines = 1, column = 0, columns = 0;
+	for (char ch : text) {
+		if (ch == '\n') {
+			lines++;
+			column = 0;
+		} else {
+			columns = std::max(columns, ++column);
+		}
+	}
+	return glm::vec2(columns > 0 ? (columns * ADVANCE - (ADVANCE - GLYPH_W)) * k : 0.0f,
+		((lines - 1) * LINE_HEIGHT + GLYPH_H) * k);
+}
+
+void TextRenderer::addQuad(float x0, float y0, float x1, float y1, glm::vec2 uv0, glm::vec2 uv1, const glm::vec4& color) {
+	if (vertices.size() + 6 > MAX_QUADS * 6) {
+		if (!full) {
+			LOG_WARN("Text overlay full: more than %u glyphs and panels in a frame", MAX_QUADS);
+			full = true;
+		}
+		return;
+	}
+
+	// From pixels to normalized device coordinates
+	glm::vec2 scale = 2.0f / glm::vec2(BP->swapChainExtent.width, BP->swapChainExtent.height);
+	glm::vec2 p0 = glm::vec2(x0, y0) * scale - 1.0f;
+	glm::vec2 p1 = glm::vec2(x1, y1) * scale - 1.0f;
+
+	vertices.push_back({ { p0.x, p0.y }, { uv0.x, uv0.y }, color });
+	vertices.push_back({ { p1.x, p0.y }, { uv1.x, uv0.y }, color });
+	vertices.push_back({ { p0.x, p1.y }, { uv0.x, uv1.y }, color });
+	vertices.push_back({ { p1.x, p0.y }, { uv1.x, uv0.y }, color });
+	vertices.push_back({ { p1.x, p1.y }, { uv1.x, uv1.y }, color });
+	vertices.push_back({ { p0.x, p1.y }, { uv0.x, uv1.y }, color });
+}
+
+void TextRenderer::upload(int currentImage) {
+	VkDrawIndirectCommand command{ static_cast<uint32_t>(vertices.size()), 1, 0, 0 };
+	size_t bytes = vertices.size() * sizeof(VertexText);
+	memcpy(mapped[currentImage], &command, sizeof(command));
+	memcpy(static_cast<char*>(mapped[currentImage]) + VERTICES_OFFSET, vertices.data(), bytes);
+	BP->uploadedBytes += sizeof(command) + bytes;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Starter.hpp"
+
+// A corner of a glyph or of a panel, in normalized device coordinates
+struct VertexText {
+	glm::vec2 pos;
+	glm::vec2 UV;
+	glm::vec4 color;
+};
+
+// Screen text drawn with a signed distance field of the built-in 5x7 font, so it stays sharp at any size.
+// The glyphs and the panels behind them are batched into a host visible vertex buffer per swap chain image
+// and drawn with a single indirect draw: the command buffers are recorded once, while the vertex count,
+// kept in the indirect buffer, changes every frame.
+class TextRenderer {
+public:
+	static const uint32_t MAX_QUADS = 4096;
+
+	// Build the atlas, the layout and the pipeline (in localInit)
+	void init(BaseProject* bp);
+	// Pipeline, descriptor set and per-image buffers, rebuilt with the swap chain
+	void create();
+	void cleanup();
+	// Everything else (in localCleanup)
+	void destroy();
+
+	// Record the draw of the text of the image (in populateCommandBuffer, after the rest of the overlay)
+	void draw(VkCommandBuffer commandBuffer, int currentImage);
+
+	// Batch of the next frame: positions and sizes in pixels from the top left corner of the screen,
+	// size is the height of a capital letter
+	void begin();
+	void addText(float x, float y, float size, const glm::vec4& color, const std::string& text);
+	void addRect(float x, float y, float w, float h, const glm::vec4& color);
+	// Width and height of the text, with one line per '\n'
+	static glm::vec2 measure(float size, const std::string& text);
+	// Copy the batch to the buffers of the image (in updateUniformBuffer)
+	void upload(int currentImage);
+
+private:
+	BaseProject* BP = nullptr;
+
+	DescriptorSetLayout DSL;
+	VertexDescriptor VD;
+	Pipeline P;
+	Texture atlas;
+	DescriptorSet DS;
+
+	// Per swap chain image: the indirect command at the beginning, then the vertices
+	std::vector<VkBuffer> buffers;
+	std::vector<VkDeviceMemory> buffersMemory;
+	std::vector<void*> mapped;
+
+	std::vector<VertexText> vertices;
+	bool full = false;				// the batch reached MAX_QUADS (reported once)
+
+	void addQuad(float x0, float y0, float x1, float y1, glm::vec2 uv0, glm::vec2 uv1, const glm::vec4& color);
+};
@@ -0,0 +1,115 @@
+#include "TexturePack.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include <stb_image.h>
+#include <stb_image_write.h>
+
+#include "JobSystem.hpp"
+#include "Logger.hpp"
+
+namespace {
+
+struct SrgbDecode {
+	float table[256];
+
+	SrgbDecode() {
+		for (int i = 0; i < 256; i++) {
+			float c = i / 255.0f;
+			table[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+	}
+};
+
+// Whether the RGBA8 pixels have the same red, green and blue, give or take the noise of the compression
+bool isGrayscale(const unsigned char* pixels, int width, int height) {
+	const int TOLERANCE = 8;
+	for (size_t i = 0; i < static_cast<size_t>(width) * height; i++) {
+		const unsigned char* p = pixels + 4 * i;
+		if (std::abs(p[0] - p[1]) > TOLERANCE || std::abs(p[0] - p[2]) > TOLERANCE) {
+			return false;
+		}
+	}
+	return true;
+}
+
+}
+
+void packAlpha(unsigned char* rgba, int width, int height, const unsigned char* source, int sourceWidth, int sourceHeight) {
+	static const SrgbDecode decode;
+	for (int y = 0; y < height; y++) {
+		// Source rows and columns [begin, end) under the pixel, at least one when the source is smaller
+		int y0 = static_cast<int>(static_cast<int64_t>(y) * sourceHeight / height);
+		int y1 = std::max(y0 + 1, static_cast<int>(static_cast<int64_t>(y + 1) * sourceHeight / height));
+		for (int x = 0; x < width; x++) {
+			int x0 = static_cast<int>(static_cast<int64_t>(x) * sourceWidth / width);
+			int x1 = std::max(x0 + 1, static_cast<int>(static_cast<int64_t>(x + 1) * sourceWidth / width));
+			float sum = 0.0f;
+			for (int sy = y0; sy < y1; sy++) {
+				for (int sx = x0; sx < x1; sx++) {
+					sum += decode.table[source[4 * (static_cast<size_t>(sy) * sourceWidth + sx)]];
+				}
+			}
+			float linear = sum / static_cast<float>((y1 - y0) * (x1 - x0));
+			rgba[4 * (static_cast<size_t>(y) * width + x) + 3] = static_cast<unsigned char>(std::lround(linear * 255.0f));
+		}
+	}
+}
+
+void packTextures(const std::vector<TexturePackSource>& sources, JobSystem* jobs, std::ostream& out) {
+	std::vector<std::string> lines(sources.size()), errors(sources.size());
+
+	auto pack = [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			const TexturePackSource& source = sources[i];
+			auto start = std::chrono::steady_clock::now();
+			int width, height, alphaWidth, alphaHeight, channels;
+			stbi_uc* rgba = stbi_load(source.rgb.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+			stbi_uc* alpha = stbi_load(source.alpha.c_str(), &alphaWidth, &alphaHeight, &channels, STBI_rgb_alpha);
+			if (rgba == nullptr || alpha == nullptr) {
+				errors[i] = "Failed to open: " + (rgba == nullptr ? source.rgb : source.alpha);
+			} else {
+				// A single channel fits in alpha: the shaders read it as a gray value (vec3(a) for the Ward specular)
+				if (!isGrayscale(alpha, alphaWidth, alphaHeight)) {
+					LOG_WARN("%s is not grayscale, only its red channel is packed into %s", source.alpha.c_str(), source.packed.c_str());
+				}
+				packAlpha(rgba, width, height, alpha, alphaWidth, alphaHeight);
+				if (!stbi_write_png(source.packed.c_str(), width, height, 4, rgba, width * 4)) {
+					errors[i] = "Failed to write: " + source.packed;
+				} else {
+					double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+					std::ostringstream line;
+					line << source.packed << ": " << width << "x" << height << " packed in "
+						<< std::fixed << std::setprecision(1) << ms << " ms\n";
+					lines[i] = line.str();
+				}
+			}
+			stbi_image_free(rgba);
+			stbi_image_free(alpha);
+		}
+	};
+	if (jobs != nullptr) {
+		jobs->parallelFor("packTextures", 0, static_cast<int>(sources.size()), 1, pack);
+	} else {
+		pack(0, static_cast<int>(sources.size()));
+	}
+
+	bool failed = false;
+	for (size_t i = 0; i < sources.size(); i++) {
+		if (!errors[i].empty()) {
+			LOG_ERROR("%s", errors[i].c_str());
+			failed = true;
+		}
+		out << lines[i];
+	}
+	if (failed) {
+		throw std::runtime_error("failed to pack textures!");
+	}
+}
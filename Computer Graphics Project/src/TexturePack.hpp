@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// Normal maps that carry a single channel map of the same material in alpha (the roughness for DRN, the specular
+// intensity for Ward), so that the fragment shaders get both from one texture with one fetch. The packed maps must be
+// grayscale: a coloured specular map would lose its tint
+
+// Set the alpha of the width x height RGBA8 pixels of rgba to the first channel of the RGBA8 pixels of source, decoded
+// from sRGB (the separate maps were sampled through sRGB views, while the alpha of the packed one is read as it is)
+// and averaged over the source pixels each pixel covers when the sizes differ
+void packAlpha(unsigned char* rgba, int width, int height, const unsigned char* source, int sourceWidth, int sourceHeight);
+
+struct TexturePackSource {
+	std::string rgb;		// RGB of the packed texture
+	std::string alpha;		// its first channel goes to alpha (a grayscale map, others get a warning)
+	std::string packed;		// PNG written
+};
+
+// Write the packed textures, one source per job if jobs is given, at the size of rgb, and print a line per texture to out
+void packTextures(const std::vector<TexturePackSource>& sources, JobSystem* jobs, std::ostream& out);
@@ -4,32 +4,13 @@
 #include "Utils.hpp"
 
 #include "BoundingBox.hpp"
+#include "Placement.hpp"
+#include "Collectibles.hpp"
+#include "World.hpp"
 
 #include <vector>
 
-// Data structure to retrieve collectibles names from their index
-std::string collectiblesNames[COLLECTIBLES_NUM] = {
-	"crystal",
-	"eye",
-	"feather",
-	"leaf",
-	"potion1",
-	"potion2",
-	"bone"
-};
-
-glm::vec3 generateRandomPosition(float squareSide) {
-	glm::vec3 randomPosition;
-
-	randomPosition = glm::vec3(
-		-squareSide + fmod(rand(), squareSide * 2 + 1),
-		0.4f,
-		-squareSide + fmod(rand(), squareSide * 2 + 1)
-	);
-
-	return randomPosition;
-}
-
+#include <glm/gtc/matrix_transform.hpp>
 
 // BOUNDING BOX FUNCTIONS
 
@@ -95,8 +76,8 @@ void createBBModel(std::vector<VertexBoundingBox>& vDef, std::vector<uint32_t>&
 	vIdx.push_back(1); vIdx.push_back(4); vIdx.push_back(5);
 }
 
-void drawBoundingBox(bool hasBoundingBox, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, glm::mat4 ViewPrj,
-	UniformBufferObject UBO_boundingBox, DescriptorSet DS_boundingBox, int currentImage) {
+void updateBoundingBox(bool hasBoundingBox, glm::vec3 position, glm::vec3 rotation, glm::vec3 scale, const glm::mat4& ViewPrj,
+	UniformBufferObject& UBO_boundingBox) {
 	glm::mat4 World;
 
 	if (hasBoundingBox) {	// set hasBoundingBox to false to not display the bounding box
@@ -112,35 +93,24 @@ void drawBoundingBox(bool hasBoundingBox, glm::vec3 position, glm::vec3 rotation
 	UBO_boundingBox.mvpMat = ViewPrj * World;
 	UBO_boundingBox.mMat = World;
 	UBO_boundingBox.nMat = glm::transpose(glm::inverse(World));
-	DS_boundingBox.map(currentImage, &UBO_boundingBox, sizeof(UBO_boundingBox), 0);
 }
 
 void emptyBBList(std::vector<BoundingBox>* BBList) {
 	BBList->clear();
 }
 
-void fillBBList(std::vector<BoundingBox>* BBList, glm::vec3* BBPosition) {
+void fillBBList(std::vector<BoundingBox>* BBList, glm::vec3* BBPosition, const std::vector<BoundingBox>& obstacles, CounterRng& rng) {
 
-	srand(static_cast<unsigned int>(time(0)));
+	// collectibles are spawned 2 units away from the walls, half a unit away from the furniture and 2 units from each
+	// other, or closer if there are too many of them for the house
+	const float halfSize = HOUSE_HALF_SIZE - 2.0f;
+	std::vector<glm::vec2> positions = placeItems(rng, COLLECTIBLES_NUM, glm::vec2(-halfSize), glm::vec2(halfSize), 2.0f, obstacles, 0.5f);
 	for (int i = 0; i < COLLECTIBLES_NUM; ++i) {
-		glm::vec3 randomPosition = generateRandomPosition(9.8f);
-
-		// make sure collectibles are not spawned in the same position or too close to each other
-		for (int j = 0; j < i; ++j) {
-			if (glm::distance(randomPosition, BBPosition[j]) < 2.0f) {
-				randomPosition = generateRandomPosition(9.8f);
-				j = -1;
-			}
-		}
-		BBPosition[i] = randomPosition;
+		BBPosition[i] = glm::vec3(positions[i].x, 0.4f, positions[i].y);
 	}
 
-	// Create the bounding boxes
-	BBList->push_back(BoundingBox("crystal", BBPosition[0], glm::vec3(0.7f)));
-	BBList->push_back(BoundingBox("eye", BBPosition[1], glm::vec3(0.5f)));
-	BBList->push_back(BoundingBox("feather", BBPosition[2], glm::vec3(0.5f, 0.6f, 0.9f)));
-	BBList->push_back(BoundingBox("leaf", BBPosition[3], glm::vec3(0.6f, 0.5f, 0.5f)));
-	BBList->push_back(BoundingBox("potion1", BBPosition[4], glm::vec3(0.5f, 1.0f, 0.5f)));
-	BBList->push_back(BoundingBox("potion2", BBPosition[5], glm::vec3(0.5f, 1.0f, 0.5f)));
-	BBList->push_back(BoundingBox("bone", BBPosition[6], glm::vec3(0.5f, 0.7f, 0.5f)));
+	// Create the bounding boxes, in CollectibleId order
+	for (int i = 0; i < COLLECTIBLES_NUM; ++i) {
+		BBList->push_back(BoundingBox(collectibleRegistry[i].name, BBPosition[i], collectibleRegistry[i].colliderSize()));
+	}
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <cstdint>
 #include <string>
 
 #define GAME_STATE_START_SCREEN 0
@@ -9,7 +10,6 @@
 #define GAME_STATE_GAME_LOSE 3
 
 #define LIGHTS_NUM 16
-#define COLLECTIBLES_NUM 7
 
 #define M_PI		3.14159265358979323846	/* pi */
 #define M_PI_2		1.57079632679489661923	/* pi/2 */
@@ -79,8 +79,18 @@ struct VertexTan {
 	glm::vec2 UV;
 };
 
-// Data structure to retrieve collectibles names from their index
-extern std::string collectiblesNames[COLLECTIBLES_NUM];
+// Compact versions of Vertex and VertexTan, half their size. The positions are 16-bit SNORM in the bounding box of
+// the model (Model::dequantization maps them back), the normals and tangents 16-bit SNORM octahedral encodings
+// (tangent handedness in the fourth component), the UVs half floats.
+struct VertexPacked {
+	int16_t pos[4];
+	uint16_t UV[2];
+	int16_t norm[2];
+};
 
-// Generate random position for the collectibles
-glm::vec3 generateRandomPosition(float squareSide);
+struct VertexTanPacked {
+	int16_t pos[4];
+	int16_t normal[2];
+	int16_t tangent[4];
+	uint16_t UV[2];
+};
@@ -0,0 +1,50 @@
+#include "VirtualFileSystem.hpp"
+
+#include <filesystem>
+
+#include "Logger.hpp"
+
+VirtualFileSystem& VirtualFileSystem::instance() {
+	static VirtualFileSystem vfs;
+	return vfs;
+}
+
+void VirtualFileSystem::mount(const std::string& path) {
+	pack.open(path);
+	LOG_INFO("Asset pack %s: %u files", path.c_str(), pack.entryCount());
+}
+
+void VirtualFileSystem::unmount() {
+	pack.close();
+}
+
+FileData VirtualFileSystem::read(const std::string& path) {
+	FileData file;
+	int entry = pack.isOpen() ? pack.find(normalizePath(path)) : -1;
+	if (entry >= 0) {
+		if (pack.compressed(entry)) {
+			file.owned = pack.read(entry);
+			file.view = file.owned.data();
+			file.viewSize = file.owned.size();
+		} else {
+			file.view = pack.storedData(entry);
+			file.viewSize = static_cast<size_t>(pack.entry(entry).size);
+		}
+		fromPack++;
+		return file;
+	}
+
+	file.mapping.open(path);
+	file.view = file.mapping.data();
+	file.viewSize = file.mapping.size();
+	fromDisk++;
+	return file;
+}
+
+bool VirtualFileSystem::exists(const std::string& path) const {
+	if (pack.isOpen() && pack.find(normalizePath(path)) >= 0) {
+		return true;
+	}
+	std::error_code ec;
+	return std::filesystem::is_regular_file(path, ec);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "AssetPack.hpp"
+#include "MappedFile.hpp"
+
+// Contents of a file read through the virtual file system: a view of the pack for the files stored as they are,
+// the inflated copy for the deflated ones, a mapping of the file for the ones read from disk
+class FileData {
+public:
+	const char* data() const { return view; }
+	size_t size() const { return viewSize; }
+	std::vector<char> copy() const { return std::vector<char>(view, view + viewSize); }
+
+private:
+	friend class VirtualFileSystem;
+
+	const char* view = nullptr;
+	size_t viewSize = 0;
+	std::vector<char> owned;
+	MappedFile mapping;
+};
+
+// Read-only stream buffer over the contents of a FileData
+class FileDataBuffer : public std::streambuf {
+public:
+	FileDataBuffer(const char* data, size_t size) {
+		char* begin = const_cast<char*>(data);
+		setg(begin, begin, begin + size);
+	}
+};
+
+// std::istream over the contents of a FileData, for the parsers that read streams (the data must outlive it).
+// The buffer is a base listed before std::istream, so it is constructed before the stream is given it
+class FileDataStream : private FileDataBuffer, public std::istream {
+public:
+	explicit FileDataStream(const FileData& file)
+		: FileDataBuffer(file.data(), file.size()), std::istream(static_cast<FileDataBuffer*>(this)) {}
+};
+
+// Every asset is read through here: from the mounted asset pack when it has the file, from disk otherwise.
+// The pack is read-only once mounted, so reads can come from any thread.
+class VirtualFileSystem {
+public:
+	static VirtualFileSystem& instance();
+
+	// Prefer the files of the pack at path (to be called before any asset is loaded)
+	void mount(const std::string& path);
+	void unmount();
+	bool isMounted() const { return pack.isOpen(); }
+
+	// Throws like readFile if the file is neither in the pack nor on disk
+	FileData read(const std::string& path);
+	bool exists(const std::string& path) const;
+
+	// Files served by the pack and by the disk since the start, for the log
+	uint32_t packReads() const { return fromPack.load(); }
+	uint32_t diskReads() const { return fromDisk.load(); }
+
+private:
+	AssetPack pack;
+	std::atomic<uint32_t> fromPack{0}, fromDisk{0};
+};
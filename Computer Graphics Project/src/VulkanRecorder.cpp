@@ -0,0 +1,439 @@
+// The wrappers below call the real Vulkan functions: the defines of the header must stay off here
+#define VULKAN_RECORDER_IMPLEMENTATION
+#include "VulkanRecorder.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <unordered_map>
+
+// Same setting of tiny_gltf in Starter.hpp, json.hpp must be compiled the same way everywhere
+#define JSON_NOEXCEPTION
+#include <json.hpp>
+
+const char* vulkanCallNames[VULKAN_CALLS_NUM] = {
+#define VULKAN_CALL_NAME(ret, name, params, args, nullDevice) #name,
+	VULKAN_CALLS(VULKAN_CALL_NAME)
+#undef VULKAN_CALL_NAME
+};
+
+VulkanRecorder& VulkanRecorder::instance() {
+	static VulkanRecorder recorder;
+	return recorder;
+}
+
+void VulkanRecorder::flushSetup() {
+	for (int c = 0; c < VULKAN_CALLS_NUM; c++) {
+		setupCalls[c] += pendingCalls[c].exchange(0, std::memory_order_relaxed);
+		setupNs[c] += pendingNs[c].exchange(0, std::memory_order_relaxed);
+	}
+}
+
+void VulkanRecorder::beginFrame() {
+	flushSetup();
+	frameStart = std::chrono::steady_clock::now();
+}
+
+void VulkanRecorder::endFrame() {
+	frameMs.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+	for (int c = 0; c < VULKAN_CALLS_NUM; c++) {
+		uint64_t calls = pendingCalls[c].exchange(0, std::memory_order_relaxed);
+		frameCalls[c] += calls;
+		frameNs[c] += pendingNs[c].exchange(0, std::memory_order_relaxed);
+		maxFrameCalls[c] = std::max(maxFrameCalls[c], calls);
+	}
+}
+
+void VulkanRecorder::report(std::ostream& out) {
+	flushSetup();
+
+	std::ios oldState(nullptr);
+	oldState.copyfmt(out);
+
+	size_t frames = frameMs.size();
+	std::vector<double> sorted = frameMs;
+	std::sort(sorted.begin(), sorted.end());
+	double avgMs = 0.0;
+	for (double ms : sorted) avgMs += ms;
+	out << std::fixed << std::setprecision(3);
+	out << "Vulkan calls (" << (currentMode == VULKAN_MODE_NULL ? "null device" : "driver") << "): " << frames << " frames";
+	if (frames > 0) {
+		out << ", CPU per frame avg " << avgMs / frames << " ms, p50 " << sorted[frames / 2]
+			<< " ms, p99 " << sorted[std::min(frames - 1, frames * 99 / 100)] << " ms";
+	}
+	out << "\n";
+
+	// Per frame calls first, then the setup ones
+	std::vector<int> order;
+	for (int c = 0; c < VULKAN_CALLS_NUM; c++) {
+		if (frameCalls[c] > 0 || setupCalls[c] > 0) {
+			order.push_back(c);
+		}
+	}
+	std::sort(order.begin(), order.end(), [&](int a, int b) {
+		return frameCalls[a] != frameCalls[b] ? frameCalls[a] > frameCalls[b] : setupCalls[a] > setupCalls[b];
+	});
+
+	out << std::left << std::setw(44) << "call" << std::right << std::setw(10) << "setup" << std::setw(12) << "per frame"
+		<< std::setw(12) << "max/frame" << std::setw(12) << "ns/call" << "\n";
+	for (int c : order) {
+		uint64_t calls = frameCalls[c] + setupCalls[c];
+		out << std::left << std::setw(44) << vulkanCallNames[c] << std::right << std::setw(10) << setupCalls[c]
+			<< std::setw(12) << std::setprecision(1) << (frames > 0 ? frameCalls[c] / static_cast<double>(frames) : 0.0)
+			<< std::setw(12) << maxFrameCalls[c]
+			<< std::setw(12) << std::setprecision(0) << static_cast<double>(frameNs[c] + setupNs[c]) / calls << "\n";
+	}
+
+	out.copyfmt(oldState);
+}
+
+void VulkanRecorder::writeReport(const std::string& path) {
+	flushSetup();
+
+	size_t frames = frameMs.size();
+	nlohmann::json calls = nlohmann::json::object();
+	for (int c = 0; c < VULKAN_CALLS_NUM; c++) {
+		if (frameCalls[c] == 0 && setupCalls[c] == 0) {
+			continue;
+		}
+		calls[vulkanCallNames[c]] = {
+			{ "setup", setupCalls[c] },
+			{ "perFrame", frames > 0 ? frameCalls[c] / static_cast<double>(frames) : 0.0 },
+			{ "maxPerFrame", maxFrameCalls[c] },
+			{ "avgNs", static_cast<double>(frameNs[c] + setupNs[c]) / (frameCalls[c] + setupCalls[c]) }
+		};
+	}
+	double avgMs = 0.0;
+	for (double ms : frameMs) avgMs += ms;
+
+	nlohmann::json doc = {
+		{ "mode", currentMode == VULKAN_MODE_NULL ? "null" : "driver" },
+		{ "frames", frames },
+		{ "frameCpuMs", frames > 0 ? avgMs / frames : 0.0 },
+		{ "calls", calls }
+	};
+	std::ofstream file(path);
+	if (!file) {
+		throw std::runtime_error("failed to open Vulkan calls report file!");
+	}
+	file << doc.dump(2) << "\n";
+}
+
+bool VulkanRecorder::checkBudget(const std::string& path, std::ostream& out) {
+	std::ifstream file(path);
+	if (!file) {
+		throw std::runtime_error("failed to open Vulkan calls budget file!");
+	}
+	nlohmann::json budget = nlohmann::json::parse(file, nullptr, false);
+	if (budget.is_discarded() || !budget.is_object()) {
+		throw std::runtime_error("failed to parse Vulkan calls budget file!");
+	}
+
+	size_t frames = std::max<size_t>(frameMs.size(), 1);
+	bool ok = true;
+	for (int c = 0; c < VULKAN_CALLS_NUM; c++) {
+		auto it = budget.find(vulkanCallNames[c]);
+		if (it == budget.end() || !it->is_number()) {
+			continue;
+		}
+		double perFrame = frameCalls[c] / static_cast<double>(frames);
+		if (perFrame > it->get<double>()) {
+			out << vulkanCallNames[c] << ": " << perFrame << " calls per frame, budget " << it->get<double>() << "\n";
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+// Null device: every object is a distinct fake handle, only host visible memory has storage behind it
+namespace {
+
+std::atomic<uint64_t> lastHandle{0};
+std::mutex nullLock;
+std::unordered_map<uint64_t, VkDeviceSize> objectSizes;					// buffers and images
+std::unordered_map<uint64_t, std::vector<char>> hostMemory;				// host visible allocations
+
+const uint32_t NULL_DEVICE_LOCAL_TYPE = 0;
+const uint32_t NULL_HOST_VISIBLE_TYPE = 1;
+
+template <class T> T newHandle() {
+	return (T)(uintptr_t)(++lastHandle);
+}
+
+template <class T> uint64_t handleKey(T handle) {
+	return (uint64_t)(handle);
+}
+
+// Vulkan two-call enumeration
+template <class T> VkResult enumerate(const std::vector<T>& items, uint32_t* count, T* out) {
+	if (out == nullptr) {
+		*count = static_cast<uint32_t>(items.size());
+		return VK_SUCCESS;
+	}
+	uint32_t n = std::min(*count, static_cast<uint32_t>(items.size()));
+	std::copy(items.begin(), items.begin() + n, out);
+	*count = n;
+	return n < items.size() ? VK_INCOMPLETE : VK_SUCCESS;
+}
+
+#define NULL_CREATE(name, Info, Handle) \
+	VkResult null_##name(VkDevice, const Info*, const VkAllocationCallbacks*, Handle* pHandle) { \
+		*pHandle = newHandle<Handle>(); \
+		return VK_SUCCESS; \
+	}
+
+NULL_CREATE(vkCreateCommandPool, VkCommandPoolCreateInfo, VkCommandPool)
+NULL_CREATE(vkCreateDescriptorPool, VkDescriptorPoolCreateInfo, VkDescriptorPool)
+NULL_CREATE(vkCreateDescriptorSetLayout, VkDescriptorSetLayoutCreateInfo, VkDescriptorSetLayout)
+NULL_CREATE(vkCreateFence, VkFenceCreateInfo, VkFence)
+NULL_CREATE(vkCreateFramebuffer, VkFramebufferCreateInfo, VkFramebuffer)
+NULL_CREATE(vkCreateImageView, VkImageViewCreateInfo, VkImageView)
+NULL_CREATE(vkCreatePipelineLayout, VkPipelineLayoutCreateInfo, VkPipelineLayout)
+NULL_CREATE(vkCreateQueryPool, VkQueryPoolCreateInfo, VkQueryPool)
+NULL_CREATE(vkCreateRenderPass, VkRenderPassCreateInfo, VkRenderPass)
+NULL_CREATE(vkCreateSampler, VkSamplerCreateInfo, VkSampler)
+NULL_CREATE(vkCreateSemaphore, VkSemaphoreCreateInfo, VkSemaphore)
+NULL_CREATE(vkCreateShaderModule, VkShaderModuleCreateInfo, VkShaderModule)
+NULL_CREATE(vkCreateSwapchainKHR, VkSwapchainCreateInfoKHR, VkSwapchainKHR)
+#undef NULL_CREATE
+
+VkResult null_vkCreateInstance(const VkInstanceCreateInfo*, const VkAllocationCallbacks*, VkInstance* pInstance) {
+	*pInstance = newHandle<VkInstance>();
+	return VK_SUCCESS;
+}
+
+VkResult null_vkCreateDevice(VkPhysicalDevice, const VkDeviceCreateInfo*, const VkAllocationCallbacks*, VkDevice* pDevice) {
+	*pDevice = newHandle<VkDevice>();
+	return VK_SUCCESS;
+}
+
+VkResult null_vkCreateBuffer(VkDevice, const VkBufferCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkBuffer* pBuffer) {
+	*pBuffer = newHandle<VkBuffer>();
+	std::lock_guard<std::mutex> guard(nullLock);
+	objectSizes[handleKey(*pBuffer)] = pCreateInfo->size;
+	return VK_SUCCESS;
+}
+
+VkResult null_vkCreateImage(VkDevice, const VkImageCreateInfo* pCreateInfo, const VkAllocationCallbacks*, VkImage* pImage) {
+	*pImage = newHandle<VkImage>();
+	// Four bytes per texel is enough for the memory report, a full mip chain adds a third
+	VkDeviceSize size = static_cast<VkDeviceSize>(pCreateInfo->extent.width) * pCreateInfo->extent.height * pCreateInfo->extent.depth *
+		pCreateInfo->arrayLayers * pCreateInfo->samples * 4;
+	if (pCreateInfo->mipLevels > 1) {
+		size += size / 3;
+	}
+	std::lock_guard<std::mutex> guard(nullLock);
+	objectSizes[handleKey(*pImage)] = size;
+	return VK_SUCCESS;
+}
+
+void null_vkDestroyBuffer(VkDevice, VkBuffer buffer, const VkAllocationCallbacks*) {
+	std::lock_guard<std::mutex> guard(nullLock);
+	objectSizes.erase(handleKey(buffer));
+}
+
+void null_vkDestroyImage(VkDevice, VkImage image, const VkAllocationCallbacks*) {
+	std::lock_guard<std::mutex> guard(nullLock);
+	objectSizes.erase(handleKey(image));
+}
+
+VkResult null_vkCreateGraphicsPipelines(VkDevice, VkPipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo*,
+	const VkAllocationCallbacks*, VkPipeline* pPipelines) {
+	for (uint32_t i = 0; i < createInfoCount; i++) {
+		pPipelines[i] = newHandle<VkPipeline>();
+	}
+	return VK_SUCCESS;
+}
+
+VkResult null_vkAllocateCommandBuffers(VkDevice, const VkCommandBufferAllocateInfo* pAllocateInfo, VkCommandBuffer* pCommandBuffers) {
+	for (uint32_t i = 0; i < pAllocateInfo->commandBufferCount; i++) {
+		pCommandBuffers[i] = newHandle<VkCommandBuffer>();
+	}
+	return VK_SUCCESS;
+}
+
+VkResult null_vkAllocateDescriptorSets(VkDevice, const VkDescriptorSetAllocateInfo* pAllocateInfo, VkDescriptorSet* pDescriptorSets) {
+	for (uint32_t i = 0; i < pAllocateInfo->descriptorSetCount; i++) {
+		pDescriptorSets[i] = newHandle<VkDescriptorSet>();
+	}
+	return VK_SUCCESS;
+}
+
+VkResult null_vkAllocateMemory(VkDevice, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks*, VkDeviceMemory* pMemory) {
+	*pMemory = newHandle<VkDeviceMemory>();
+	if (pAllocateInfo->memoryTypeIndex == NULL_HOST_VISIBLE_TYPE) {
+		std::lock_guard<std::mutex> guard(nullLock);
+		hostMemory[handleKey(*pMemory)].resize(static_cast<size_t>(pAllocateInfo->allocationSize));
+	}
+	return VK_SUCCESS;
+}
+
+void null_vkFreeMemory(VkDevice, VkDeviceMemory memory, const VkAllocationCallbacks*) {
+	std::lock_guard<std::mutex> guard(nullLock);
+	hostMemory.erase(handleKey(memory));
+}
+
+VkResult null_vkMapMemory(VkDevice, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize, VkMemoryMapFlags, void** ppData) {
+	std::lock_guard<std::mutex> guard(nullLock);
+	auto it = hostMemory.find(handleKey(memory));
+	if (it == hostMemory.end()) {
+		return VK_ERROR_MEMORY_MAP_FAILED;
+	}
+	*ppData = it->second.data() + offset;
+	return VK_SUCCESS;
+}
+
+void getMemoryRequirements(uint64_t object, VkMemoryRequirements* pMemoryRequirements) {
+	std::lock_guard<std::mutex> guard(nullLock);
+	auto it = objectSizes.find(object);
+	pMemoryRequirements->size = it != objectSizes.end() ? it->second : 0;
+	pMemoryRequirements->alignment = 256;
+	pMemoryRequirements->memoryTypeBits = (1u << NULL_DEVICE_LOCAL_TYPE) | (1u << NULL_HOST_VISIBLE_TYPE);
+}
+
+void null_vkGetBufferMemoryRequirements(VkDevice, VkBuffer buffer, VkMemoryRequirements* pMemoryRequirements) {
+	getMemoryRequirements(handleKey(buffer), pMemoryRequirements);
+}
+
+void null_vkGetImageMemoryRequirements(VkDevice, VkImage image, VkMemoryRequirements* pMemoryRequirements) {
+	getMemoryRequirements(handleKey(image), pMemoryRequirements);
+}
+
+void null_vkGetDeviceQueue(VkDevice, uint32_t, uint32_t, VkQueue* pQueue) {
+	static VkQueue queue = newHandle<VkQueue>();
+	*pQueue = queue;
+}
+
+VkResult null_vkEnumerateInstanceExtensionProperties(const char*, uint32_t* pPropertyCount, VkExtensionProperties* pProperties) {
+	return enumerate(std::vector<VkExtensionProperties>(), pPropertyCount, pProperties);
+}
+
+VkResult null_vkEnumerateInstanceLayerProperties(uint32_t* pPropertyCount, VkLayerProperties* pProperties) {
+	return enumerate(std::vector<VkLayerProperties>(), pPropertyCount, pProperties);
+}
+
+VkResult null_vkEnumerateDeviceExtensionProperties(VkPhysicalDevice, const char*, uint32_t* pPropertyCount, VkExtensionProperties* pProperties) {
+	return enumerate(std::vector<VkExtensionProperties>(), pPropertyCount, pProperties);
+}
+
+VkResult null_vkEnumeratePhysicalDevices(VkInstance, uint32_t* pPhysicalDeviceCount, VkPhysicalDevice* pPhysicalDevices) {
+	static VkPhysicalDevice device = newHandle<VkPhysicalDevice>();
+	return enumerate(std::vector<VkPhysicalDevice>{ device }, pPhysicalDeviceCount, pPhysicalDevices);
+}
+
+void null_vkGetPhysicalDeviceFeatures(VkPhysicalDevice, VkPhysicalDeviceFeatures* pFeatures) {
+	*pFeatures = VkPhysicalDeviceFeatures{};
+	pFeatures->samplerAnisotropy = VK_TRUE;
+	pFeatures->sampleRateShading = VK_TRUE;
+	pFeatures->fillModeNonSolid = VK_TRUE;
+}
+
+void null_vkGetPhysicalDeviceFormatProperties(VkPhysicalDevice, VkFormat, VkFormatProperties* pFormatProperties) {
+	pFormatProperties->linearTilingFeatures = ~0u;
+	pFormatProperties->optimalTilingFeatures = ~0u;
+	pFormatProperties->bufferFeatures = ~0u;
+}
+
+void null_vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice, VkPhysicalDeviceMemoryProperties* pMemoryProperties) {
+	*pMemoryProperties = VkPhysicalDeviceMemoryProperties{};
+	pMemoryProperties->memoryHeapCount = 1;
+	pMemoryProperties->memoryHeaps[0].size = 8ull << 30;
+	pMemoryProperties->memoryHeaps[0].flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+	pMemoryProperties->memoryTypeCount = 2;
+	pMemoryProperties->memoryTypes[NULL_DEVICE_LOCAL_TYPE].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	pMemoryProperties->memoryTypes[NULL_HOST_VISIBLE_TYPE].propertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+}
+
+void null_vkGetPhysicalDeviceProperties(VkPhysicalDevice, VkPhysicalDeviceProperties* pProperties) {
+	*pProperties = VkPhysicalDeviceProperties{};
+	pProperties->apiVersion = VK_API_VERSION_1_0;
+	pProperties->deviceType = VK_PHYSICAL_DEVICE_TYPE_CPU;
+	strncpy(pProperties->deviceName, "Null Vulkan device", VK_MAX_PHYSICAL_DEVICE_NAME_SIZE - 1);
+	pProperties->limits.framebufferColorSampleCounts = VK_SAMPLE_COUNT_1_BIT;
+	pProperties->limits.framebufferDepthSampleCounts = VK_SAMPLE_COUNT_1_BIT;
+	pProperties->limits.maxSamplerAnisotropy = 16.0f;
+	pProperties->limits.timestampPeriod = 1.0f;
+}
+
+void null_vkGetPhysicalDeviceQueueFamilyProperties(VkPhysicalDevice, uint32_t* pQueueFamilyPropertyCount, VkQueueFamilyProperties* pQueueFamilyProperties) {
+	VkQueueFamilyProperties family{};
+	family.queueFlags = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT;
+	family.queueCount = 1;
+	family.timestampValidBits = 64;
+	family.minImageTransferGranularity = { 1, 1, 1 };
+	enumerate(std::vector<VkQueueFamilyProperties>{ family }, pQueueFamilyPropertyCount, pQueueFamilyProperties);
+}
+
+// Nothing is presented on the null device (it runs offscreen): no surface formats nor present modes
+VkResult null_vkGetPhysicalDeviceSurfaceCapabilitiesKHR(VkPhysicalDevice, VkSurfaceKHR, VkSurfaceCapabilitiesKHR* pSurfaceCapabilities) {
+	*pSurfaceCapabilities = VkSurfaceCapabilitiesKHR{};
+	return VK_SUCCESS;
+}
+
+VkResult null_vkGetPhysicalDeviceSurfaceFormatsKHR(VkPhysicalDevice, VkSurfaceKHR, uint32_t* pSurfaceFormatCount, VkSurfaceFormatKHR* pSurfaceFormats) {
+	return enumerate(std::vector<VkSurfaceFormatKHR>(), pSurfaceFormatCount, pSurfaceFormats);
+}
+
+VkResult null_vkGetPhysicalDeviceSurfacePresentModesKHR(VkPhysicalDevice, VkSurfaceKHR, uint32_t* pPresentModeCount, VkPresentModeKHR* pPresentModes) {
+	return enumerate(std::vector<VkPresentModeKHR>(), pPresentModeCount, pPresentModes);
+}
+
+VkResult null_vkGetPhysicalDeviceSurfaceSupportKHR(VkPhysicalDevice, uint32_t, VkSurfaceKHR, VkBool32* pSupported) {
+	*pSupported = VK_FALSE;
+	return VK_SUCCESS;
+}
+
+VkResult null_vkGetSwapchainImagesKHR(VkDevice, VkSwapchainKHR, uint32_t* pSwapchainImageCount, VkImage* pSwapchainImages) {
+	return enumerate(std::vector<VkImage>(), pSwapchainImageCount, pSwapchainImages);
+}
+
+VkResult null_vkAcquireNextImageKHR(VkDevice, VkSwapchainKHR, uint64_t, VkSemaphore, VkFence, uint32_t* pImageIndex) {
+	*pImageIndex = 0;
+	return VK_SUCCESS;
+}
+
+// Every GPU zone takes no time
+VkResult null_vkGetQueryPoolResults(VkDevice, VkQueryPool, uint32_t, uint32_t, size_t dataSize, void* pData, VkDeviceSize, VkQueryResultFlags) {
+	memset(pData, 0, dataSize);
+	return VK_SUCCESS;
+}
+
+// What the calls that do nothing on the null device return
+template <class T> T nullResult() { return T(); }
+template <> VkResult nullResult<VkResult>() { return VK_SUCCESS; }
+template <> void nullResult<void>() {}
+
+// Times a call into the counters of the recorder
+class CallTimer {
+public:
+	CallTimer(VulkanRecorder& recorder, VulkanCall call) : recorder(recorder), call(call), start(std::chrono::steady_clock::now()) {}
+	~CallTimer() {
+		recorder.record(call, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+private:
+	VulkanRecorder& recorder;
+	VulkanCall call;
+	std::chrono::steady_clock::time_point start;
+};
+
+}
+
+#define NULL_NOOP(ret, name, args) nullResult<ret>()
+#define NULL_STUB(ret, name, args) null_##name args
+
+#define VULKAN_CALL_WRAPPER(ret, name, params, args, nullDevice) \
+	ret recorded_##name params { \
+		VulkanRecorder& recorder = VulkanRecorder::instance(); \
+		if (recorder.mode() == VULKAN_MODE_DIRECT) { \
+			return name args; \
+		} \
+		CallTimer timer(recorder, VULKAN_CALL_##name); \
+		if (recorder.mode() == VULKAN_MODE_NULL) { \
+			return nullDevice(ret, name, args); \
+		} \
+		return name args; \
+	}
+VULKAN_CALLS(VULKAN_CALL_WRAPPER)
+#undef VULKAN_CALL_WRAPPER
@@ -0,0 +1,379 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+// Every Vulkan function the application calls, with its parameters and arguments, and what the null device does for it:
+// NULL_NOOP returns VK_SUCCESS (or nothing), NULL_STUB calls a null_ function that fills in the outputs
+//
+//  return type, name, parameters, arguments, null device
+#define VULKAN_CALLS(X) \
+	X(VkResult, vkAcquireNextImageKHR, (VkDevice device, VkSwapchainKHR swapchain, uint64_t timeout, VkSemaphore semaphore, VkFence fence, uint32_t* pImageIndex), \
+		(device, swapchain, timeout, semaphore, fence, pImageIndex), NULL_STUB) \
+	X(VkResult, vkAllocateCommandBuffers, (VkDevice device, const VkCommandBufferAllocateInfo* pAllocateInfo, VkCommandBuffer* pCommandBuffers), \
+		(device, pAllocateInfo, pCommandBuffers), NULL_STUB) \
+	X(VkResult, vkAllocateDescriptorSets, (VkDevice device, const VkDescriptorSetAllocateInfo* pAllocateInfo, VkDescriptorSet* pDescriptorSets), \
+		(device, pAllocateInfo, pDescriptorSets), NULL_STUB) \
+	X(VkResult, vkAllocateMemory, (VkDevice device, const VkMemoryAllocateInfo* pAllocateInfo, const VkAllocationCallbacks* pAllocator, VkDeviceMemory* pMemory), \
+		(device, pAllocateInfo, pAllocator, pMemory), NULL_STUB) \
+	X(VkResult, vkBeginCommandBuffer, (VkCommandBuffer commandBuffer, const VkCommandBufferBeginInfo* pBeginInfo), \
+		(commandBuffer, pBeginInfo), NULL_NOOP) \
+	X(VkResult, vkBindBufferMemory, (VkDevice device, VkBuffer buffer, VkDeviceMemory memory, VkDeviceSize memoryOffset), \
+		(device, buffer, memory, memoryOffset), NULL_NOOP) \
+	X(VkResult, vkBindImageMemory, (VkDevice device, VkImage image, VkDeviceMemory memory, VkDeviceSize memoryOffset), \
+		(device, image, memory, memoryOffset), NULL_NOOP) \
+	X(void, vkCmdBeginRenderPass, (VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo* pRenderPassBegin, VkSubpassContents contents), \
+		(commandBuffer, pRenderPassBegin, contents), NULL_NOOP) \
+	X(void, vkCmdBindDescriptorSets, (VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipelineLayout layout, uint32_t firstSet, \
+		uint32_t descriptorSetCount, const VkDescriptorSet* pDescriptorSets, uint32_t dynamicOffsetCount, const uint32_t* pDynamicOffsets), \
+		(commandBuffer, pipelineBindPoint, layout, firstSet, descriptorSetCount, pDescriptorSets, dynamicOffsetCount, pDynamicOffsets), NULL_NOOP) \
+	X(void, vkCmdBindIndexBuffer, (VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType), \
+		(commandBuffer, buffer, offset, indexType), NULL_NOOP) \
+	X(void, vkCmdBindPipeline, (VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline), \
+		(commandBuffer, pipelineBindPoint, pipeline), NULL_NOOP) \
+	X(void, vkCmdBindVertexBuffers, (VkCommandBuffer commandBuffer, uint32_t firstBinding, uint32_t bindingCount, const VkBuffer* pBuffers, const VkDeviceSize* pOffsets), \
+		(commandBuffer, firstBinding, bindingCount, pBuffers, pOffsets), NULL_NOOP) \
+	X(void, vkCmdBlitImage, (VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcImageLayout, VkImage dstImage, VkImageLayout dstImageLayout, \
+		uint32_t regionCount, const VkImageBlit* pRegions, VkFilter filter), \
+		(commandBuffer, srcImage, srcImageLayout, dstImage, dstImageLayout, regionCount, pRegions, filter), NULL_NOOP) \
+	X(void, vkCmdCopyBufferToImage, (VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkImage dstImage, VkImageLayout dstImageLayout, \
+		uint32_t regionCount, const VkBufferImageCopy* pRegions), \
+		(commandBuffer, srcBuffer, dstImage, dstImageLayout, regionCount, pRegions), NULL_NOOP) \
+	X(void, vkCmdCopyImageToBuffer, (VkCommandBuffer commandBuffer, VkImage srcImage, VkImageLayout srcImageLayout, VkBuffer dstBuffer, \
+		uint32_t regionCount, const VkBufferImageCopy* pRegions), \
+		(commandBuffer, srcImage, srcImageLayout, dstBuffer, regionCount, pRegions), NULL_NOOP) \
+	X(void, vkCmdDraw, (VkCommandBuffer commandBuffer, uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance), \
+		(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance), NULL_NOOP) \
+	X(void, vkCmdDrawIndexed, (VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance), \
+		(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance), NULL_NOOP) \
+	X(void, vkCmdDrawIndirect, (VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, uint32_t drawCount, uint32_t stride), \
+		(commandBuffer, buffer, offset, drawCount, stride), NULL_NOOP) \
+	X(void, vkCmdEndRenderPass, (VkCommandBuffer commandBuffer), \
+		(commandBuffer), NULL_NOOP) \
+	X(void, vkCmdPipelineBarrier, (VkCommandBuffer commandBuffer, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask, VkDependencyFlags dependencyFlags, \
+		uint32_t memoryBarrierCount, const VkMemoryBarrier* pMemoryBarriers, uint32_t bufferMemoryBarrierCount, const VkBufferMemoryBarrier* pBufferMemoryBarriers, \
+		uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier* pImageMemoryBarriers), \
+		(commandBuffer, srcStageMask, dstStageMask, dependencyFlags, memoryBarrierCount, pMemoryBarriers, bufferMemoryBarrierCount, pBufferMemoryBarriers, \
+		imageMemoryBarrierCount, pImageMemoryBarriers), NULL_NOOP) \
+	X(void, vkCmdResetQueryPool, (VkCommandBuffer commandBuffer, VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount), \
+		(commandBuffer, queryPool, firstQuery, queryCount), NULL_NOOP) \
+	X(void, vkCmdWriteTimestamp, (VkCommandBuffer commandBuffer, VkPipelineStageFlagBits pipelineStage, VkQueryPool queryPool, uint32_t query), \
+		(commandBuffer, pipelineStage, queryPool, query), NULL_NOOP) \
+	X(VkResult, vkCreateBuffer, (VkDevice device, const VkBufferCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkBuffer* pBuffer), \
+		(device, pCreateInfo, pAllocator, pBuffer), NULL_STUB) \
+	X(VkResult, vkCreateCommandPool, (VkDevice device, const VkCommandPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkCommandPool* pCommandPool), \
+		(device, pCreateInfo, pAllocator, pCommandPool), NULL_STUB) \
+	X(VkResult, vkCreateDescriptorPool, (VkDevice device, const VkDescriptorPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDescriptorPool* pDescriptorPool), \
+		(device, pCreateInfo, pAllocator, pDescriptorPool), NULL_STUB) \
+	X(VkResult, vkCreateDescriptorSetLayout, (VkDevice device, const VkDescriptorSetLayoutCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDescriptorSetLayout* pSetLayout), \
+		(device, pCreateInfo, pAllocator, pSetLayout), NULL_STUB) \
+	X(VkResult, vkCreateDevice, (VkPhysicalDevice physicalDevice, const VkDeviceCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDevice* pDevice), \
+		(physicalDevice, pCreateInfo, pAllocator, pDevice), NULL_STUB) \
+	X(VkResult, vkCreateFence, (VkDevice device, const VkFenceCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkFence* pFence), \
+		(device, pCreateInfo, pAllocator, pFence), NULL_STUB) \
+	X(VkResult, vkCreateFramebuffer, (VkDevice device, const VkFramebufferCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkFramebuffer* pFramebuffer), \
+		(device, pCreateInfo, pAllocator, pFramebuffer), NULL_STUB) \
+	X(VkResult, vkCreateGraphicsPipelines, (VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo* pCreateInfos, \
+		const VkAllocationCallbacks* pAllocator, VkPipeline* pPipelines), \
+		(device, pipelineCache, createInfoCount, pCreateInfos, pAllocator, pPipelines), NULL_STUB) \
+	X(VkResult, vkCreateImage, (VkDevice device, const VkImageCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkImage* pImage), \
+		(device, pCreateInfo, pAllocator, pImage), NULL_STUB) \
+	X(VkResult, vkCreateImageView, (VkDevice device, const VkImageViewCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkImageView* pView), \
+		(device, pCreateInfo, pAllocator, pView), NULL_STUB) \
+	X(VkResult, vkCreateInstance, (const VkInstanceCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkInstance* pInstance), \
+		(pCreateInfo, pAllocator, pInstance), NULL_STUB) \
+	X(VkResult, vkCreatePipelineLayout, (VkDevice device, const VkPipelineLayoutCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkPipelineLayout* pPipelineLayout), \
+		(device, pCreateInfo, pAllocator, pPipelineLayout), NULL_STUB) \
+	X(VkResult, vkCreateQueryPool, (VkDevice device, const VkQueryPoolCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkQueryPool* pQueryPool), \
+		(device, pCreateInfo, pAllocator, pQueryPool), NULL_STUB) \
+	X(VkResult, vkCreateRenderPass, (VkDevice device, const VkRenderPassCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkRenderPass* pRenderPass), \
+		(device, pCreateInfo, pAllocator, pRenderPass), NULL_STUB) \
+	X(VkResult, vkCreateSampler, (VkDevice device, const VkSamplerCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSampler* pSampler), \
+		(device, pCreateInfo, pAllocator, pSampler), NULL_STUB) \
+	X(VkResult, vkCreateSemaphore, (VkDevice device, const VkSemaphoreCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSemaphore* pSemaphore), \
+		(device, pCreateInfo, pAllocator, pSemaphore), NULL_STUB) \
+	X(VkResult, vkCreateShaderModule, (VkDevice device, const VkShaderModuleCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkShaderModule* pShaderModule), \
+		(device, pCreateInfo, pAllocator, pShaderModule), NULL_STUB) \
+	X(VkResult, vkCreateSwapchainKHR, (VkDevice device, const VkSwapchainCreateInfoKHR* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkSwapchainKHR* pSwapchain), \
+		(device, pCreateInfo, pAllocator, pSwapchain), NULL_STUB) \
+	X(void, vkDestroyBuffer, (VkDevice device, VkBuffer buffer, const VkAllocationCallbacks* pAllocator), \
+		(device, buffer, pAllocator), NULL_STUB) \
+	X(void, vkDestroyCommandPool, (VkDevice device, VkCommandPool commandPool, const VkAllocationCallbacks* pAllocator), \
+		(device, commandPool, pAllocator), NULL_NOOP) \
+	X(void, vkDestroyDescriptorPool, (VkDevice device, VkDescriptorPool descriptorPool, const VkAllocationCallbacks* pAllocator), \
+		(device, descriptorPool, pAllocator), NULL_NOOP) \
+	X(void, vkDestroyDescriptorSetLayout, (VkDevice device, VkDescriptorSetLayout descriptorSetLayout, const VkAllocationCallbacks* pAllocator), \
+		(device, descriptorSetLayout, pAllocator), NULL_NOOP) \
+	X(void, vkDestroyDevice, (VkDevice device, const VkAllocationCallbacks* pAllocator), \
+		(device, pAllocator), NULL_NOOP) \
+	X(void, vkDestroyFence, (VkDevice device, VkFence fence, const VkAllocationCallbacks* pAllocator), \
+		(device, fence, pAllocator), NULL_NOOP) \
+	X(void, vkDestroyFramebuffer, (VkDevice device, VkFramebuffer framebuffer, const VkAllocationCallbacks* pAllocator), \
+		(device, framebuffer, pAllocator), NULL_NOOP) \
+	X(void, vkDestroyImage, (VkDevice device, VkImage image, const VkAllocationCallbacks* pAllocator), \
+		(device, image, pAllocator), NULL_STUB) \
+	X(void, vkDestroyImageView, (VkDevice device, VkImageView imageView, const VkAllocationCallbacks* pAllocator), \
+		(device, imageView, pAllocator), NULL_NOOP) \
+	X(void, vkDestroyInstance, (VkInstance instance, const VkAllocationCallbacks* pAllocator), \
+		(instance, pAllocator), NULL_NOOP) \
+	X(void, vkDestroyPipeline, (VkDevice device, VkPipeline pipeline, const VkAllocationCallbacks* pAllocator), \
+		(device, pipeline, pAllocator), NULL_NOOP) \
+	X(void, vkDestroyPipelineLayout, (VkDevice device, VkPipelineLayout pipelineLayout, const VkAllocationCallbacks* pAllocator), \
+		(device, pipelineLayout, pAllocator), NULL_NOOP) \
+	X(void, vkDestroyQueryPool, (VkDevice device, VkQueryPool queryPool, const VkAllocationCallbacks* pAllocator), \
+		(device, queryPool, pAllocator), NULL_NOOP) \
+	X(void, vkDestroyRenderPass, (VkDevice device, VkRenderPass renderPass, const VkAllocationCallbacks* pAllocator), \
+		(device, renderPass, pAllocator), NULL_NOOP) \
+	X(void, vkDestroySampler, (VkDevice device, VkSampler sampler, const VkAllocationCallbacks* pAllocator), \
+		(device, sampler, pAllocator), NULL_NOOP) \
+	X(void, vkDestroySemaphore, (VkDevice device, VkSemaphore semaphore, const VkAllocationCallbacks* pAllocator), \
+		(device, semaphore, pAllocator), NULL_NOOP) \
+	X(void, vkDestroyShaderModule, (VkDevice device, VkShaderModule shaderModule, const VkAllocationCallbacks* pAllocator), \
+		(device, shaderModule, pAllocator), NULL_NOOP) \
+	X(void, vkDestroySurfaceKHR, (VkInstance instance, VkSurfaceKHR surface, const VkAllocationCallbacks* pAllocator), \
+		(instance, surface, pAllocator), NULL_NOOP) \
+	X(void, vkDestroySwapchainKHR, (VkDevice device, VkSwapchainKHR swapchain, const VkAllocationCallbacks* pAllocator), \
+		(device, swapchain, pAllocator), NULL_NOOP) \
+	X(VkResult, vkDeviceWaitIdle, (VkDevice device), \
+		(device), NULL_NOOP) \
+	X(VkResult, vkEndCommandBuffer, (VkCommandBuffer commandBuffer), \
+		(commandBuffer), NULL_NOOP) \
+	X(VkResult, vkEnumerateDeviceExtensionProperties, (VkPhysicalDevice physicalDevice, const char* pLayerName, uint32_t* pPropertyCount, VkExtensionProperties* pProperties), \
+		(physicalDevice, pLayerName, pPropertyCount, pProperties), NULL_STUB) \
+	X(VkResult, vkEnumerateInstanceExtensionProperties, (const char* pLayerName, uint32_t* pPropertyCount, VkExtensionProperties* pProperties), \
+		(pLayerName, pPropertyCount, pProperties), NULL_STUB) \
+	X(VkResult, vkEnumerateInstanceLayerProperties, (uint32_t* pPropertyCount, VkLayerProperties* pProperties), \
+		(pPropertyCount, pProperties), NULL_STUB) \
+	X(VkResult, vkEnumeratePhysicalDevices, (VkInstance instance, uint32_t* pPhysicalDeviceCount, VkPhysicalDevice* pPhysicalDevices), \
+		(instance, pPhysicalDeviceCount, pPhysicalDevices), NULL_STUB) \
+	X(void, vkFreeCommandBuffers, (VkDevice device, VkCommandPool commandPool, uint32_t commandBufferCount, const VkCommandBuffer* pCommandBuffers), \
+		(device, commandPool, commandBufferCount, pCommandBuffers), NULL_NOOP) \
+	X(void, vkFreeMemory, (VkDevice device, VkDeviceMemory memory, const VkAllocationCallbacks* pAllocator), \
+		(device, memory, pAllocator), NULL_STUB) \
+	X(void, vkGetBufferMemoryRequirements, (VkDevice device, VkBuffer buffer, VkMemoryRequirements* pMemoryRequirements), \
+		(device, buffer, pMemoryRequirements), NULL_STUB) \
+	X(void, vkGetDeviceQueue, (VkDevice device, uint32_t queueFamilyIndex, uint32_t queueIndex, VkQueue* pQueue), \
+		(device, queueFamilyIndex, queueIndex, pQueue), NULL_STUB) \
+	X(void, vkGetImageMemoryRequirements, (VkDevice device, VkImage image, VkMemoryRequirements* pMemoryRequirements), \
+		(device, image, pMemoryRequirements), NULL_STUB) \
+	X(PFN_vkVoidFunction, vkGetInstanceProcAddr, (VkInstance instance, const char* pName), \
+		(instance, pName), NULL_NOOP) \
+	X(void, vkGetPhysicalDeviceFeatures, (VkPhysicalDevice physicalDevice, VkPhysicalDeviceFeatures* pFeatures), \
+		(physicalDevice, pFeatures), NULL_STUB) \
+	X(void, vkGetPhysicalDeviceFormatProperties, (VkPhysicalDevice physicalDevice, VkFormat format, VkFormatProperties* pFormatProperties), \
+		(physicalDevice, format, pFormatProperties), NULL_STUB) \
+	X(void, vkGetPhysicalDeviceMemoryProperties, (VkPhysicalDevice physicalDevice, VkPhysicalDeviceMemoryProperties* pMemoryProperties), \
+		(physicalDevice, pMemoryProperties), NULL_STUB) \
+	X(void, vkGetPhysicalDeviceProperties, (VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties* pProperties), \
+		(physicalDevice, pProperties), NULL_STUB) \
+	X(void, vkGetPhysicalDeviceQueueFamilyProperties, (VkPhysicalDevice physicalDevice, uint32_t* pQueueFamilyPropertyCount, VkQueueFamilyProperties* pQueueFamilyProperties), \
+		(physicalDevice, pQueueFamilyPropertyCount, pQueueFamilyProperties), NULL_STUB) \
+	X(VkResult, vkGetPhysicalDeviceSurfaceCapabilitiesKHR, (VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, VkSurfaceCapabilitiesKHR* pSurfaceCapabilities), \
+		(physicalDevice, surface, pSurfaceCapabilities), NULL_STUB) \
+	X(VkResult, vkGetPhysicalDeviceSurfaceFormatsKHR, (VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t* pSurfaceFormatCount, VkSurfaceFormatKHR* pSurfaceFormats), \
+		(physicalDevice, surface, pSurfaceFormatCount, pSurfaceFormats), NULL_STUB) \
+	X(VkResult, vkGetPhysicalDeviceSurfacePresentModesKHR, (VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, uint32_t* pPresentModeCount, VkPresentModeKHR* pPresentModes), \
+		(physicalDevice, surface, pPresentModeCount, pPresentModes), NULL_STUB) \
+	X(VkResult, vkGetPhysicalDeviceSurfaceSupportKHR, (VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex, VkSurfaceKHR surface, VkBool32* pSupported), \
+		(physicalDevice, queueFamilyIndex, surface, pSupported), NULL_STUB) \
+	X(VkResult, vkGetQueryPoolResults, (VkDevice device, VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount, size_t dataSize, void* pData, \
+		VkDeviceSize stride, VkQueryResultFlags flags), \
+		(device, queryPool, firstQuery, queryCount, dataSize, pData, stride, flags), NULL_STUB) \
+	X(VkResult, vkGetSwapchainImagesKHR, (VkDevice device, VkSwapchainKHR swapchain, uint32_t* pSwapchainImageCount, VkImage* pSwapchainImages), \
+		(device, swapchain, pSwapchainImageCount, pSwapchainImages), NULL_STUB) \
+	X(VkResult, vkMapMemory, (VkDevice device, VkDeviceMemory memory, VkDeviceSize offset, VkDeviceSize size, VkMemoryMapFlags flags, void** ppData), \
+		(device, memory, offset, size, flags, ppData), NULL_STUB) \
+	X(VkResult, vkQueuePresentKHR, (VkQueue queue, const VkPresentInfoKHR* pPresentInfo), \
+		(queue, pPresentInfo), NULL_NOOP) \
+	X(VkResult, vkQueueSubmit, (VkQueue queue, uint32_t submitCount, const VkSubmitInfo* pSubmits, VkFence fence), \
+		(queue, submitCount, pSubmits, fence), NULL_NOOP) \
+	X(VkResult, vkQueueWaitIdle, (VkQueue queue), \
+		(queue), NULL_NOOP) \
+	X(VkResult, vkResetFences, (VkDevice device, uint32_t fenceCount, const VkFence* pFences), \
+		(device, fenceCount, pFences), NULL_NOOP) \
+	X(void, vkUnmapMemory, (VkDevice device, VkDeviceMemory memory), \
+		(device, memory), NULL_NOOP) \
+	X(void, vkUpdateDescriptorSets, (VkDevice device, uint32_t descriptorWriteCount, const VkWriteDescriptorSet* pDescriptorWrites, \
+		uint32_t descriptorCopyCount, const VkCopyDescriptorSet* pDescriptorCopies), \
+		(device, descriptorWriteCount, pDescriptorWrites, descriptorCopyCount, pDescriptorCopies), NULL_NOOP) \
+	X(VkResult, vkWaitForFences, (VkDevice device, uint32_t fenceCount, const VkFence* pFences, VkBool32 waitAll, uint64_t timeout), \
+		(device, fenceCount, pFences, waitAll, timeout), NULL_NOOP)
+
+enum VulkanCall {
+#define VULKAN_CALL_ENUM(ret, name, params, args, nullDevice) VULKAN_CALL_##name,
+	VULKAN_CALLS(VULKAN_CALL_ENUM)
+#undef VULKAN_CALL_ENUM
+	VULKAN_CALLS_NUM
+};
+extern const char* vulkanCallNames[VULKAN_CALLS_NUM];
+
+enum VulkanMode {
+	VULKAN_MODE_DIRECT,		// straight to the driver, nothing is counted
+	VULKAN_MODE_RECORD,		// to the driver, counting and timing every call
+	VULKAN_MODE_NULL		// counting and timing every call, no driver: a stand-in device that renders nothing
+};
+
+// Counts and times every Vulkan call, per frame and during setup. On the null device the calls never reach
+// a driver, so the CPU cost of recording, binding and mapping can be measured (and checked) on any machine.
+// The mode must be chosen before the instance is created.
+class VulkanRecorder {
+public:
+	static VulkanRecorder& instance();
+
+	void setMode(VulkanMode m) { currentMode = m; }
+	VulkanMode mode() const { return currentMode; }
+
+	// Calls between beginFrame() and endFrame() are counted for the frame, all the others as setup
+	void beginFrame();
+	void endFrame();
+
+	void record(VulkanCall call, uint64_t ns) {
+		pendingCalls[call].fetch_add(1, std::memory_order_relaxed);
+		pendingNs[call].fetch_add(ns, std::memory_order_relaxed);
+	}
+
+	// Print the calls per frame and the CPU time of every call type
+	void report(std::ostream& out);
+	void writeReport(const std::string& path);
+
+	// Compare the average calls per frame with the maximums in a JSON file ({ "vkMapMemory": 60, ... }),
+	// print the calls over budget and return false if there are any
+	bool checkBudget(const std::string& path, std::ostream& out);
+
+	// Counts the calls of a frame while in scope (nothing in direct mode)
+	class FrameScope {
+	public:
+		FrameScope() : active(VulkanRecorder::instance().mode() != VULKAN_MODE_DIRECT) {
+			if (active) VulkanRecorder::instance().beginFrame();
+		}
+		~FrameScope() {
+			if (active) VulkanRecorder::instance().endFrame();
+		}
+	private:
+		bool active;
+	};
+
+private:
+	VulkanRecorder() = default;
+
+	// Move the pending calls to the setup totals
+	void flushSetup();
+
+	VulkanMode currentMode = VULKAN_MODE_DIRECT;
+
+	std::atomic<uint64_t> pendingCalls[VULKAN_CALLS_NUM] = {};
+	std::atomic<uint64_t> pendingNs[VULKAN_CALLS_NUM] = {};
+
+	uint64_t setupCalls[VULKAN_CALLS_NUM] = {};
+	uint64_t setupNs[VULKAN_CALLS_NUM] = {};
+	uint64_t frameCalls[VULKAN_CALLS_NUM] = {};
+	uint64_t frameNs[VULKAN_CALLS_NUM] = {};
+	uint64_t maxFrameCalls[VULKAN_CALLS_NUM] = {};
+	std::vector<double> frameMs;
+	std::chrono::steady_clock::time_point frameStart;
+};
+
+// The application calls these in place of the Vulkan functions (see the defines below)
+#define VULKAN_CALL_DECLARATION(ret, name, params, args, nullDevice) ret recorded_##name params;
+VULKAN_CALLS(VULKAN_CALL_DECLARATION)
+#undef VULKAN_CALL_DECLARATION
+
+#ifndef VULKAN_RECORDER_IMPLEMENTATION
+#define vkAcquireNextImageKHR recorded_vkAcquireNextImageKHR
+#define vkAllocateCommandBuffers recorded_vkAllocateCommandBuffers
+#define vkAllocateDescriptorSets recorded_vkAllocateDescriptorSets
+#define vkAllocateMemory recorded_vkAllocateMemory
+#define vkBeginCommandBuffer recorded_vkBeginCommandBuffer
+#define vkBindBufferMemory recorded_vkBindBufferMemory
+#define vkBindImageMemory recorded_vkBindImageMemory
+#define vkCmdBeginRenderPass recorded_vkCmdBeginRenderPass
+#define vkCmdBindDescriptorSets recorded_vkCmdBindDescriptorSets
+#define vkCmdBindIndexBuffer recorded_vkCmdBindIndexBuffer
+#define vkCmdBindPipeline recorded_vkCmdBindPipeline
+#define vkCmdBindVertexBuffers recorded_vkCmdBindVertexBuffers
+#define vkCmdBlitImage recorded_vkCmdBlitImage
+#define vkCmdCopyBufferToImage recorded_vkCmdCopyBufferToImage
+#define vkCmdCopyImageToBuffer recorded_vkCmdCopyImageToBuffer
+#define vkCmdDraw recorded_vkCmdDraw
+#define vkCmdDrawIndexed recorded_vkCmdDrawIndexed
+#define vkCmdDrawIndirect recorded_vkCmdDrawIndirect
+#define vkCmdEndRenderPass recorded_vkCmdEndRenderPass
+#define vkCmdPipelineBarrier recorded_vkCmdPipelineBarrier
+#define vkCmdResetQueryPool recorded_vkCmdResetQueryPool
+#define vkCmdWriteTimestamp recorded_vkCmdWriteTimestamp
+#define vkCreateBuffer recorded_vkCreateBuffer
+#define vkCreateCommandPool recorded_vkCreateCommandPool
+#define vkCreateDescriptorPool recorded_vkCreateDescriptorPool
+#define vkCreateDescriptorSetLayout recorded_vkCreateDescriptorSetLayout
+#define vkCreateDevice recorded_vkCreateDevice
+#define vkCreateFence recorded_vkCreateFence
+#define vkCreateFramebuffer recorded_vkCreateFramebuffer
+#define vkCreateGraphicsPipelines recorded_vkCreateGraphicsPipelines
+#define vkCreateImage recorded_vkCreateImage
+#define vkCreateImageView recorded_vkCreateImageView
+#define vkCreateInstance recorded_vkCreateInstance
+#define vkCreatePipelineLayout recorded_vkCreatePipelineLayout
+#define vkCreateQueryPool recorded_vkCreateQueryPool
+#define vkCreateRenderPass recorded_vkCreateRenderPass
+#define vkCreateSampler recorded_vkCreateSampler
+#define vkCreateSemaphore recorded_vkCreateSemaphore
+#define vkCreateShaderModule recorded_vkCreateShaderModule
+#define vkCreateSwapchainKHR recorded_vkCreateSwapchainKHR
+#define vkDestroyBuffer recorded_vkDestroyBuffer
+#define vkDestroyCommandPool recorded_vkDestroyCommandPool
+#define vkDestroyDescriptorPool recorded_vkDestroyDescriptorPool
+#define vkDestroyDescriptorSetLayout recorded_vkDestroyDescriptorSetLayout
+#define vkDestroyDevice recorded_vkDestroyDevice
+#define vkDestroyFence recorded_vkDestroyFence
+#define vkDestroyFramebuffer recorded_vkDestroyFramebuffer
+#define vkDestroyImage recorded_vkDestroyImage
+#define vkDestroyImageView recorded_vkDestroyImageView
+#define vkDestroyInstance recorded_vkDestroyInstance
+#define vkDestroyPipeline recorded_vkDestroyPipeline
+#define vkDestroyPipelineLayout recorded_vkDestroyPipelineLayout
+#define vkDestroyQueryPool recorded_vkDestroyQueryPool
+#define vkDestroyRenderPass recorded_vkDestroyRenderPass
+#define vkDestroySampler recorded_vkDestroySampler
+#define vkDestroySemaphore recorded_vkDestroySemaphore
+#define vkDestroyShaderModule recorded_vkDestroyShaderModule
+#define vkDestroySurfaceKHR recorded_vkDestroySurfaceKHR
+#define vkDestroySwapchainKHR recorded_vkDestroySwapchainKHR
+#define vkDeviceWaitIdle recorded_vkDeviceWaitIdle
+#define vkEndCommandBuffer recorded_vkEndCommandBuffer
+#define vkEnumerateDeviceExtensionProperties recorded_vkEnumerateDeviceExtensionProperties
+#define vkEnumerateInstanceExtensionProperties recorded_vkEnumerateInstanceExtensionProperties
+#define vkEnumerateInstanceLayerProperties recorded_vkEnumerateInstanceLayerProperties
+#define vkEnumeratePhysicalDevices recorded_vkEnumeratePhysicalDevices
+#define vkFreeCommandBuffers recorded_vkFreeCommandBuffers
+#define vkFreeMemory recorded_vkFreeMemory
+#define vkGetBufferMemoryRequirements recorded_vkGetBufferMemoryRequirements
+#define vkGetDeviceQueue recorded_vkGetDeviceQueue
+#define vkGetImageMemoryRequirements recorded_vkGetImageMemoryRequirements
+#define vkGetInstanceProcAddr recorded_vkGetInstanceProcAddr
+#define vkGetPhysicalDeviceFeatures recorded_vkGetPhysicalDeviceFeatures
+#define vkGetPhysicalDeviceFormatProperties recorded_vkGetPhysicalDeviceFormatProperties
+#define vkGetPhysicalDeviceMemoryProperties recorded_vkGetPhysicalDeviceMemoryProperties
+#define vkGetPhysicalDeviceProperties recorded_vkGetPhysicalDeviceProperties
+#define vkGetPhysicalDeviceQueueFamilyProperties recorded_vkGetPhysicalDeviceQueueFamilyProperties
+#define vkGetPhysicalDeviceSurfaceCapabilitiesKHR recorded_vkGetPhysicalDeviceSurfaceCapabilitiesKHR
+#define vkGetPhysicalDeviceSurfaceFormatsKHR recorded_vkGetPhysicalDeviceSurfaceFormatsKHR
+#define vkGetPhysicalDeviceSurfacePresentModesKHR recorded_vkGetPhysicalDeviceSurfacePresentModesKHR
+#define vkGetPhysicalDeviceSurfaceSupportKHR recorded_vkGetPhysicalDeviceSurfaceSupportKHR
+#define vkGetQueryPoolResults recorded_vkGetQueryPoolResults
+#define vkGetSwapchainImagesKHR recorded_vkGetSwapchainImagesKHR
+#define vkMapMemory recorded_vkMapMemory
+#define vkQueuePresentKHR recorded_vkQueuePresentKHR
+#define vkQueueSubmit recorded_vkQueueSubmit
+#define vkQueueWaitIdle recorded_vkQueueWaitIdle
+#define vkResetFences recorded_vkResetFences
+#define vkUnmapMemory recorded_vkUnmapMemory
+#define vkUpdateDescriptorSets recorded_vkUpdateDescriptorSets
+#define vkWaitForFences recorded_vkWaitForFences
+#endif
@@ -10,6 +10,9 @@ struct Transform {
 
 // Define as an inline variable to make only one instance of it
 
+// The house is a square centered on the origin: how far from the center the cat can walk
+inline constexpr float HOUSE_HALF_SIZE = 11.8f;
+
 //House
 inline Transform houseFloor = {
     glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(1.0f)